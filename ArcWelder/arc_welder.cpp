@@ -35,9 +35,199 @@
 #include <iomanip>
 #include <sstream>
 #include <version.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include "spsc_queue.h"
+#include "arc_welder_cache.h"
+
+// Shards waiting to be welded by the worker threads.  Shards are welded in any order, but are always written in file order.
+struct arc_welder_shard_queue
+{
+  arc_welder_shard_queue()
+  {
+    is_finished = false;
+  }
+  std::mutex mutex;
+  std::condition_variable shard_added;
+  std::condition_variable shard_completed;
+  std::deque<arc_welder_shard*> pending_shards;
+  bool is_finished;
+};
+
+// The queues connecting the stages of the pipelined welding mode.  The reader hands batches to the parsers in turn, and
+// the welder collects them from the parsers in the same order, which keeps the lines in file order while every queue has
+// exactly one producer and one consumer.  Welded batches are returned to the reader through free_batches.
+struct arc_welder_pipeline
+{
+  arc_welder_pipeline(int parser_threads) :
+    batches(parser_threads * PIPELINE_BATCHES_PER_PARSER),
+    free_batches(parser_threads * PIPELINE_BATCHES_PER_PARSER),
+    parser_seconds_busy(parser_threads, 0.0),
+    parser_timing(parser_threads)
+  {
+    is_stopped = false;
+    reader_seconds_busy = 0;
+    for (int index = 0; index < parser_threads; index++)
+    {
+      parser_input.push_back(new spsc_queue<arc_welder_pipeline_batch*>(PIPELINE_BATCHES_PER_PARSER));
+      parser_output.push_back(new spsc_queue<arc_welder_pipeline_batch*>(PIPELINE_BATCHES_PER_PARSER));
+    }
+    for (std::vector<arc_welder_pipeline_batch>::iterator it = batches.begin(); it != batches.end(); ++it)
+    {
+      free_batches.try_push(&(*it));
+    }
+  }
+  ~arc_welder_pipeline()
+  {
+    for (size_t index = 0; index < parser_input.size(); index++)
+    {
+      delete parser_input[index];
+      delete parser_output[index];
+    }
+  }
+  std::vector<arc_welder_pipeline_batch> batches;
+  spsc_queue<arc_welder_pipeline_batch*> free_batches;
+  std::vector<spsc_queue<arc_welder_pipeline_batch*>*> parser_input;
+  std::vector<spsc_queue<arc_welder_pipeline_batch*>*> parser_output;
+  // Set by the welder once it is done, which stops the reader and parsers even if they are waiting on a queue.
+  std::atomic<bool> is_stopped;
+  // Each of these is only written by its own stage, and is read after the stage has been joined.
+  double reader_seconds_busy;
+  std::vector<double> parser_seconds_busy;
+  stage_timer_statistic reader_timing;
+  std::vector<stage_timer_statistic> parser_timing;
+};
+
+// Called each time a pipeline queue is found to be full or empty.  Yield for a while, then sleep so that idle stages
+// don't keep a core busy.
+static void wait_for_pipeline(int& attempts)
+{
+  if (++attempts < PIPELINE_SPIN_ATTEMPTS)
+  {
+    std::this_thread::yield();
+  }
+  else
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(PIPELINE_SLEEP_MICROSECONDS));
+  }
+}
 
+static double get_seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  return duration.count();
+}
 
+static bool try_parse_feature_policy_bool(const std::string& value, bool& result)
+{
+  if (value == "true" || value == "True" || value == "1")
+  {
+    result = true;
+    return true;
+  }
+  if (value == "false" || value == "False" || value == "0")
+  {
+    result = false;
+    return true;
+  }
+  return false;
+}
+
+static bool try_parse_feature_policy_double(const std::string& value, double& result)
+{
+  char* p_end;
+  result = std::strtod(value.c_str(), &p_end);
+  return !value.empty() && *p_end == '\0';
+}
+
+bool arc_welder_feature_policy::try_parse(const std::string& text, arc_welder_feature_policy& policy, std::string& error)
+{
+  policy = arc_welder_feature_policy();
+  size_t separator = text.find(':');
+  std::string feature_name = utilities::trim(text.substr(0, separator));
+  bool found_feature = false;
+  for (int index = 0; index < NUM_FEATURE_TYPES; index++)
+  {
+    if (feature_name == feature_type_name[index] || feature_name + "_feature" == feature_type_name[index])
+    {
+      policy.feature = static_cast<feature_type>(index);
+      found_feature = true;
+      break;
+    }
+  }
+  if (!found_feature)
+  {
+    error = "Unknown feature type '" + feature_name + "'.";
+    return false;
+  }
+  if (separator == std::string::npos)
+  {
+    return true;
+  }
+
+  std::stringstream settings(text.substr(separator + 1));
+  std::string setting;
+  while (std::getline(settings, setting, ','))
+  {
+    size_t equals = setting.find('=');
+    std::string name = utilities::trim(setting.substr(0, equals));
+    std::string value = equals == std::string::npos ? "" : utilities::trim(setting.substr(equals + 1));
+    bool is_valid;
+    if (name == "enabled")
+    {
+      is_valid = try_parse_feature_policy_bool(value, policy.enabled);
+    }
+    else if (name == "resolution_mm")
+    {
+      is_valid = try_parse_feature_policy_double(value, policy.resolution_mm) && policy.resolution_mm > 0;
+    }
+    else if (name == "extrusion_rate_variance_percent")
+    {
+      is_valid = try_parse_feature_policy_double(value, policy.extrusion_rate_variance_percent) && policy.extrusion_rate_variance_percent >= 0;
+    }
+    else if (name == "allow_travel_arcs")
+    {
+      bool allow_travel_arcs;
+      is_valid = try_parse_feature_policy_bool(value, allow_travel_arcs);
+      policy.allow_travel_arcs = allow_travel_arcs ? 1 : 0;
+    }
+    else
+    {
+      error = "Unknown feature policy setting '" + name + "'.";
+      return false;
+    }
+    if (!is_valid)
+    {
+      error = "The value '" + value + "' is not valid for the feature policy setting '" + name + "'.";
+      return false;
+    }
+  }
+  return true;
+}
 
+std::string arc_welder_feature_policy::str() const
+{
+  std::stringstream stream;
+  stream << feature_type_name[feature] << ":enabled=" << (enabled ? "true" : "false");
+  if (resolution_mm >= 0)
+  {
+    stream << ",resolution_mm=" << resolution_mm;
+  }
+  if (extrusion_rate_variance_percent >= 0)
+  {
+    stream << ",extrusion_rate_variance_percent=" << extrusion_rate_variance_percent;
+  }
+  if (allow_travel_arcs >= 0)
+  {
+    stream << ",allow_travel_arcs=" << (allow_travel_arcs > 0 ? "true" : "false");
+  }
+  return stream.str();
+}
 
 arc_welder::arc_welder(arc_welder_args args) : current_arc_(
         DEFAULT_MIN_SEGMENTS,
@@ -50,7 +240,8 @@ arc_welder::arc_welder(arc_welder_args args) : current_arc_(
         args.allow_3d_arcs,
         args.default_xyz_precision,
         args.default_e_precision,
-        args.max_gcode_length
+        args.max_gcode_length,
+        args.exact_arc_fitting
     ),
     segment_statistics_(
         segment_statistic_lengths,
@@ -69,6 +260,11 @@ arc_welder::arc_welder(arc_welder_args args) : current_arc_(
     )
 {
     p_logger_ = args.log;
+    args_ = args;
+    threads_ = args.threads;
+    pipeline_ = args.pipeline;
+    num_shard_firmware_compensations_ = 0;
+    num_shard_gcode_length_exceptions_ = 0;
     debug_logging_enabled_ = false;
     info_logging_enabled_ = false;
     error_logging_enabled_ = false;
@@ -76,18 +272,48 @@ arc_welder::arc_welder(arc_welder_args args) : current_arc_(
 
     logger_type_ = 0;
     resolution_mm_ = args.resolution_mm;
+    target_commands_per_second_ = args.target_commands_per_second;
+    // The command rates are only reported when they're used to pick the resolution, or when profiling.
+    command_rate_statistics_enabled_ = target_commands_per_second_ > 0 || stage_statistics_.enabled;
+    max_resolution_mm_ = args.max_resolution_mm;
+    current_resolution_mm_ = args.resolution_mm;
     progress_callback_ = args.callback;
     verbose_output_ = false;
     source_path_ = args.source_path;
     target_path_ = args.target_path;
+    index_path_ = args.index_path;
+    meatpack_mode_ = args.meatpack_mode;
+    meatpack_encoder_ = meatpack_encoder(meatpack_mode_ == meatpack_mode_packed);
     gcode_position_args_ = get_args_(args.g90_g91_influences_extruder, args.buffer_size);
     allow_3d_arcs_ = args.allow_3d_arcs;
     allow_travel_arcs_ = args.allow_travel_arcs;
     allow_dynamic_precision_ = args.allow_dynamic_precision;
     extrusion_rate_variance_percent_ = args.extrusion_rate_variance_percent;
+    for (int index = 0; index < NUM_FEATURE_TYPES; index++)
+    {
+      feature_policies_[index].feature = static_cast<feature_type>(index);
+    }
+    feature_policy_args_ = args.feature_policies;
+    for (std::vector<arc_welder_feature_policy>::const_iterator it = args.feature_policies.begin(); it != args.feature_policies.end(); ++it)
+    {
+      feature_policies_[it->feature] = *it;
+    }
+    for (int index = 0; index < NUM_FEATURE_TYPES; index++)
+    {
+      arc_welder_feature_policy& policy = feature_policies_[index];
+      policy.resolution_mm = policy.resolution_mm < 0 ? args.resolution_mm : policy.resolution_mm;
+      policy.extrusion_rate_variance_percent = policy.extrusion_rate_variance_percent < 0 ? args.extrusion_rate_variance_percent : policy.extrusion_rate_variance_percent;
+      policy.allow_travel_arcs = policy.allow_travel_arcs < 0 ? args.allow_travel_arcs : policy.allow_travel_arcs;
+      if (policy.allow_travel_arcs > 0)
+      {
+        // Track the travel statistics if any feature allows travel arcs.
+        allow_travel_arcs_ = true;
+      }
+    }
     lines_processed_ = 0;
     gcodes_processed_ = 0;
     file_size_ = 0;
+    is_streaming_source_ = false;
     notification_period_seconds_ = args.notification_period_seconds;
     last_gcode_line_written_ = 0;
     points_compressed_ = 0;
@@ -109,6 +335,7 @@ arc_welder::arc_welder(arc_welder_args args) : current_arc_(
     // We don't care about the printer settings, except for g91 influences extruder.
 
     p_source_position_ = new gcode_position(gcode_position_args_);
+    p_shard_output_ = NULL;
 }
 
 gcode_position_args arc_welder::get_args_(bool g90_g91_influences_extruder, int buffer_size)
@@ -167,6 +394,11 @@ void arc_welder::reset()
   file_size_ = 0;
   points_compressed_ = 0;
   arcs_created_ = 0;
+  num_shard_firmware_compensations_ = 0;
+  num_shard_gcode_length_exceptions_ = 0;
+  pipeline_statistics_ = arc_welder_pipeline_statistics();
+  stage_statistics_ = arc_welder_stage_statistics();
+  command_rate_statistics_ = source_target_command_rate_statistics();
   waiting_for_arc_ = false;
 }
 
@@ -210,17 +442,88 @@ arc_welder_results arc_welder::process()
   int read_lines_before_clock_check = 1000;
   double next_update_time = get_next_update_time();
   const clock_t start_clock = clock();
-  p_logger_->log(logger_type_, log_levels::DEBUG, "Getting source file size.");
-  file_size_ = get_file_size(source_path_);
-  stream.clear();
-  stream.str("");
-  stream << "Source file size: " << file_size_;
-  p_logger_->log(logger_type_, log_levels::DEBUG, stream.str());
+  is_streaming_source_ = source_path_ == ARC_WELDER_STANDARD_STREAM_PATH;
+  bool is_streaming_target = target_path_ == ARC_WELDER_STANDARD_STREAM_PATH;
+  if (is_streaming_source_)
+  {
+    p_logger_->log(logger_type_, log_levels::DEBUG, "The source is standard input, so the size is unknown.");
+  }
+  else
+  {
+    p_logger_->log(logger_type_, log_levels::DEBUG, "Getting source file size.");
+    file_size_ = get_file_size(source_path_);
+    stream.clear();
+    stream.str("");
+    stream << "Source file size: " << file_size_;
+    p_logger_->log(logger_type_, log_levels::DEBUG, stream.str());
+  }
+
+  // Load the layer index, or build it if it is missing or was built from a different source file.  This is done before
+  // checking the result cache, so the index is kept up to date even when the conversion is skipped.
+  index_.clear();
+  if (!index_path_.empty())
+  {
+    if (is_streaming_source_)
+    {
+      p_logger_->log(logger_type_, log_levels::WARNING, "The source is standard input, so the layer index will not be used.");
+    }
+    else if (index_path_ == source_path_ || index_path_ == target_path_)
+    {
+      p_logger_->log(logger_type_, log_levels::WARNING, "The layer index path is the same as the source or target path, so the layer index will not be used.");
+    }
+    else if (index_.load(index_path_) && index_.matches(source_path_, args_.g90_g91_influences_extruder))
+    {
+      p_logger_->log(logger_type_, log_levels::DEBUG, "Loaded the layer index.");
+    }
+    else
+    {
+      p_logger_->log(logger_type_, log_levels::DEBUG, "The layer index is missing or stale, building it from the source file.");
+      if (!index_.build(source_path_, args_.g90_g91_influences_extruder))
+      {
+        p_logger_->log(logger_type_, log_levels::WARNING, "Unable to build the layer index.");
+      }
+      else if (!index_.save(index_path_))
+      {
+        p_logger_->log(logger_type_, log_levels::WARNING, "Unable to save the layer index.");
+      }
+    }
+    stream.clear();
+    stream.str("");
+    stream << "The layer index contains " << index_.get_layers().size() << " layers" << (index_.are_layers_from_comments() ? ", which were taken from layer comments." : ".");
+    p_logger_->log(logger_type_, log_levels::DEBUG, stream.str());
+  }
+
+  // Check the result cache before doing any work.  Streams can't be cached, since they can only be read once.
+  bool use_cache = !args_.cache_directory.empty() && !is_streaming_source_ && !is_streaming_target;
+  arc_welder_cache cache(args_.cache_directory, args_.cache_max_megabytes * 1048576LL);
+  std::string cache_key;
+  if (use_cache)
+  {
+    p_logger_->log(logger_type_, log_levels::DEBUG, "Hashing the source file to search the result cache.");
+    if (!cache.get_key(source_path_, args_, cache_key))
+    {
+      p_logger_->log(logger_type_, log_levels::DEBUG, "Unable to hash the source file, so the result cache will not be used.");
+      use_cache = false;
+    }
+    else if (cache.try_get(cache_key, target_path_, results))
+    {
+      p_logger_->log(logger_type_, log_levels::INFO, "The source file was found in the result cache, so the cached target file was copied instead of converting the source file.");
+      results.progress.seconds_elapsed = get_time_elapsed(static_cast<double>(start_clock), clock());
+      results.progress.box_encoding = box_encoding_;
+      if (!index_.get_layers().empty())
+      {
+        results.progress.num_layers = static_cast<int>(index_.get_layers().size());
+        results.progress.layer = results.progress.num_layers;
+      }
+      on_progress_(results.progress);
+      return results;
+    }
+  }
 
   // Determine if we need to overwrite the source file
   bool overwrite_source_file = false;
   std::string temp_file_path;
-  if (source_path_ == target_path_)
+  if (source_path_ == target_path_ && !is_streaming_source_)
   {
     overwrite_source_file = true;
     if (!utilities::get_temp_file_path_for_file(source_path_, temp_file_path))
@@ -238,23 +541,21 @@ arc_welder_results arc_welder::process()
     target_path_ = temp_file_path;
   }
 
-  // Create the source file read stream and target write stream
-  std::ifstream gcodeFile;
+  // Create the source file reader and target write stream
+  line_reader gcodeFile;
   p_logger_->log(logger_type_, log_levels::DEBUG, "Opening the source file for reading.");
-  gcodeFile.open(source_path_.c_str(), std::ifstream::in);
-  if (!gcodeFile.is_open())
+  if (!(is_streaming_source_ ? gcodeFile.open_standard_input() : gcodeFile.open(source_path_)))
   {
     results.success = false;
     results.message = "Unable to open the source file.";
     p_logger_->log_exception(logger_type_, results.message);
     return results;
   }
-  p_logger_->log(logger_type_, log_levels::DEBUG, "Source file opened successfully.");
+  p_logger_->log(logger_type_, log_levels::DEBUG, gcodeFile.is_memory_mapped() ? "Source file opened successfully, and is memory mapped." : "Source file opened successfully.");
 
   p_logger_->log(logger_type_, log_levels::DEBUG, "Opening the target file for writing.");
 
-  output_file_.open(target_path_.c_str(), std::ios_base::binary | std::ios_base::out);
-  if (!output_file_.is_open())
+  if (!(is_streaming_target ? output_file_.open_standard_output() : output_file_.open(target_path_)))
   {
     results.success = false;
     results.message = "Unable to open the target file.";
@@ -264,34 +565,57 @@ arc_welder_results arc_welder::process()
   }
 
   p_logger_->log(logger_type_, log_levels::DEBUG, "Target file opened successfully.");
-  std::string line;
+  if (meatpack_mode_ != meatpack_mode_none)
+  {
+    // Enable packing before anything else is written.
+    meatpack_output_.clear();
+    meatpack_encoder_.begin(meatpack_output_);
+    output_file_.write(meatpack_output_);
+  }
+  // Each line stays valid until it is released.
+  const char* line;
+  long line_length;
+  long long line_position;
   int lines_with_no_commands = 0;
   parsed_command cmd;
   // Communicate every second
   p_logger_->log(logger_type_, log_levels::DEBUG, "Sending initial progress update.");
-  continue_processing = on_progress_(get_progress_(static_cast<long>(gcodeFile.tellg()), static_cast<double>(start_clock)));
+  continue_processing = on_progress_(get_progress_(gcodeFile.get_position(), static_cast<double>(start_clock)));
   p_logger_->log(logger_type_, log_levels::DEBUG, "Processing source file.");
 
   bool arc_Welder_comment_added = false;
-  while (std::getline(gcodeFile, line) && continue_processing)
+  bool is_single_threaded = !pipeline_ && threads_ < 2;
+  if (pipeline_)
+  {
+    stream.clear();
+    stream.str("");
+    stream << "Welding with a pipeline using " << threads_ << " parser threads.";
+    p_logger_->log(logger_type_, log_levels::DEBUG, stream.str());
+    continue_processing = process_pipelined_(gcodeFile, cmd, static_cast<double>(start_clock));
+  }
+  else if (threads_ > 1)
   {
+    stream.clear();
+    stream.str("");
+    stream << "Welding with " << threads_ << " threads.";
+    p_logger_->log(logger_type_, log_levels::DEBUG, stream.str());
+    continue_processing = process_threaded_(gcodeFile, static_cast<double>(start_clock));
+  }
+  while (is_single_threaded && continue_processing)
+  {
+    STAGE_TIMER_START(read_start);
+    line_position = gcodeFile.get_position();
+    bool has_line = gcodeFile.read_line(line, line_length);
+    STAGE_TIMER_STOP(read_start, stage_statistics_.stages[arc_welder_stage_read]);
+    if (!has_line)
+    {
+      break;
+    }
     lines_processed_++;
-    // Check the first line of gcode and see if it = ;FLAVOR:UltiGCode
-// This comment MUST be preserved as the first line for ultimakers, else things won't work
-    if (lines_processed_ == 1)
+    if (lines_processed_ == 1 && process_first_line_(line, line_length))
     {
-      bool isUltiGCode = line == ";FLAVOR:UltiGCode";
-      bool isPrusaSlicer = line.rfind("; generated by PrusaSlicer", 0) == 0;
-      if (isUltiGCode || isPrusaSlicer)
-      {
-        write_gcode_to_file(line);
-      }
-      add_arcwelder_comment_to_target();
-      if (isUltiGCode || isPrusaSlicer)
-      {
-        lines_with_no_commands++;
-        continue;
-      }
+      lines_with_no_commands++;
+      continue;
     }
 
 
@@ -300,10 +624,13 @@ arc_welder_results arc_welder::process()
     {
       stream.clear();
       stream.str("");
-      stream << "Parsing: " << line;
+      stream << "Parsing: ";
+      stream.write(line, line_length);
       p_logger_->log(logger_type_, log_levels::VERBOSE, stream.str());
     }
-    parser_.try_parse_gcode(line.c_str(), cmd, true);
+    STAGE_TIMER_START(parse_start);
+    parser_.try_parse_source_line(line, static_cast<size_t>(line_length), cmd);
+    STAGE_TIMER_STOP(parse_start, stage_statistics_.stages[arc_welder_stage_parse]);
     bool has_gcode = false;
     if (cmd.gcode.length() > 0)
     {
@@ -319,6 +646,11 @@ arc_welder_results arc_welder::process()
     // This is important so that comments can be analyzed
     //std::cout << "stabilization::process_file - updating position...";
     process_gcode(cmd, false, false);
+    if (unwritten_commands_.count() <= 1)
+    {
+      // The only unwritten command, if any, is the current one, so the earlier lines aren't referenced anymore.
+      gcodeFile.release(line_position);
+    }
 
     // Only continue to process if we've found a command and either a progress_callback_ is supplied, or debug loggin is enabled.
     if (has_gcode)
@@ -329,7 +661,7 @@ arc_welder_results arc_welder::process()
         {
           p_logger_->log(logger_type_, log_levels::VERBOSE, "Sending progress update.");
         }
-        continue_processing = on_progress_(get_progress_(static_cast<long>(gcodeFile.tellg()), static_cast<double>(start_clock)));
+        continue_processing = on_progress_(get_progress_(gcodeFile.get_position(), static_cast<double>(start_clock)));
         next_update_time = get_next_update_time();
       }
     }
@@ -343,9 +675,15 @@ arc_welder_results arc_welder::process()
   p_logger_->log(logger_type_, log_levels::DEBUG, "Writing all unwritten gcodes to the target file.");
   write_unwritten_gcodes_to_file();
 
+  if (meatpack_mode_ != meatpack_mode_none)
+  {
+    meatpack_output_.clear();
+    meatpack_encoder_.end(meatpack_output_);
+    output_file_.write(meatpack_output_);
+  }
   p_logger_->log(logger_type_, log_levels::DEBUG, "Fetching the final progress struct.");
 
-  arc_welder_progress final_progress = get_progress_(static_cast<long>(file_size_), static_cast<double>(start_clock));
+  arc_welder_progress final_progress = get_progress_(is_streaming_source_ ? gcodeFile.get_position() : file_size_, static_cast<double>(start_clock));
   if (debug_logging_enabled_)
   {
     p_logger_->log(logger_type_, log_levels::DEBUG, "Sending final progress update message.");
@@ -353,8 +691,30 @@ arc_welder_results arc_welder::process()
   on_progress_(final_progress);
 
   p_logger_->log(logger_type_, log_levels::DEBUG, "Closing source and target files.");
-  output_file_.close();
+  bool target_written = output_file_.close();
+  bool source_read = !gcodeFile.has_error();
   gcodeFile.close();
+  if (final_progress.stage_statistics.enabled)
+  {
+    // The rest of the target file was written while closing it.
+    final_progress.stage_statistics.disk_seconds = output_file_.get_seconds_writing();
+  }
+  if (!target_written)
+  {
+    results.success = false;
+    results.message = "Unable to write to the target file.";
+    results.progress = final_progress;
+    p_logger_->log_exception(logger_type_, results.message);
+    return results;
+  }
+  if (!source_read)
+  {
+    results.success = false;
+    results.message = "Unable to read from standard input.";
+    results.progress = final_progress;
+    p_logger_->log_exception(logger_type_, results.message);
+    return results;
+  }
 
   if (overwrite_source_file)
   {
@@ -373,11 +733,558 @@ arc_welder_results arc_welder::process()
   results.success = continue_processing;
   results.cancelled = !continue_processing;
   results.progress = final_progress;
+  results.pipeline_statistics = pipeline_statistics_;
+  if (use_cache && results.success)
+  {
+    p_logger_->log(logger_type_, log_levels::DEBUG, "Adding the target file to the result cache.");
+    if (!cache.add(cache_key, overwrite_source_file ? source_path_ : target_path_, results))
+    {
+      p_logger_->log(logger_type_, log_levels::WARNING, "Unable to add the target file to the result cache.");
+    }
+  }
   p_logger_->log(logger_type_, log_levels::DEBUG, "Returning processing results.");
 
   return results;
 }
 
+bool arc_welder::process_first_line_(const char* line, long length)
+{
+  // Check the first line of gcode and see if it = ;FLAVOR:UltiGCode
+  // This comment MUST be preserved as the first line for ultimakers, else things won't work
+  std::string first_line(line, static_cast<size_t>(length));
+  bool isUltiGCode = first_line == ";FLAVOR:UltiGCode";
+  bool isPrusaSlicer = first_line.compare(0, 26, "; generated by PrusaSlicer") == 0;
+  if (isUltiGCode || isPrusaSlicer)
+  {
+    write_gcode_to_file(first_line);
+  }
+  add_arcwelder_comment_to_target();
+  return isUltiGCode || isPrusaSlicer;
+}
+
+bool arc_welder::process_threaded_(line_reader& gcode_file, double start_clock)
+{
+  bool continue_processing = true;
+  int read_lines_before_clock_check = 1000;
+  double next_update_time = get_next_update_time();
+  size_t max_pending_shards = static_cast<size_t>(threads_) * THREADED_MAX_PENDING_SHARDS_PER_THREAD;
+  std::exception_ptr exception;
+
+  arc_welder_shard_queue queue;
+  std::vector<std::thread> workers;
+  for (int index = 0; index < threads_; index++)
+  {
+    workers.push_back(std::thread(&arc_welder::weld_shards_, this, &queue));
+  }
+  // Shards that have been queued but not yet written, in file order.
+  std::deque<arc_welder_shard*> shards;
+  arc_welder_shard* p_shard = new arc_welder_shard(*p_source_position_->get_current_position_ptr(), *p_source_position_->get_gcode_comment_processor(), current_arc_.get_xyz_precision(), current_arc_.get_e_precision());
+  bool is_layer_change_pending = false;
+  const std::vector<arc_welder_index_layer>& index_layers = index_.get_layers();
+  size_t next_index_layer = 0;
+  bool is_reading = true;
+  const char* line;
+  long line_length;
+  while (is_reading)
+  {
+    STAGE_TIMER_START(read_start);
+    is_reading = !exception && continue_processing && gcode_file.read_line(line, line_length);
+    STAGE_TIMER_STOP(read_start, stage_statistics_.stages[arc_welder_stage_read]);
+    if (is_reading)
+    {
+      lines_processed_++;
+      if (lines_processed_ == 1 && process_first_line_(line, line_length))
+      {
+        p_shard->source_position = gcode_file.get_position();
+        continue;
+      }
+      if (p_shard->commands.empty())
+      {
+        p_shard->lines_processed = lines_processed_ - 1;
+        p_shard->gcodes_processed = gcodes_processed_;
+      }
+      // Parse directly into the shard to avoid copying the command
+      p_shard->commands.push_back(parsed_command());
+      parsed_command& cmd = p_shard->commands.back();
+      STAGE_TIMER_START(parse_start);
+      parser_.try_parse_source_line(line, static_cast<size_t>(line_length), cmd);
+      STAGE_TIMER_STOP(parse_start, stage_statistics_.stages[arc_welder_stage_parse]);
+      bool has_gcode = cmd.gcode.length() > 0;
+      if (has_gcode)
+      {
+        gcodes_processed_++;
+      }
+
+      // Track the position and precision so that the next shard can start where this one leaves off.
+      STAGE_TIMER_START(position_start);
+      p_source_position_->update(cmd, lines_processed_, gcodes_processed_, -1);
+      STAGE_TIMER_STOP(position_start, stage_statistics_.stages[arc_welder_stage_position]);
+      position* p_cur_pos = p_source_position_->get_current_position_ptr();
+      position* p_pre_pos = p_source_position_->get_previous_position_ptr();
+      if (allow_dynamic_precision_ && (cmd.opcode == gcode_opcode_g0 || cmd.opcode == gcode_opcode_g1))
+      {
+        for (std::vector<parsed_command_parameter>::iterator it = cmd.parameters.begin(); it != cmd.parameters.end(); ++it)
+        {
+          switch ((*it).name[0])
+          {
+          case 'X':
+          case 'Y':
+          case 'Z':
+            current_arc_.update_xyz_precision((*it).double_precision);
+            break;
+          case 'E':
+            current_arc_.update_e_precision((*it).double_precision);
+            break;
+          }
+        }
+      }
+      if (!index_layers.empty())
+      {
+        // Split at the layers in the index rather than the layers detected by the position tracker.
+        while (next_index_layer < index_layers.size() && index_layers[next_index_layer].offset < gcode_file.get_position())
+        {
+          is_layer_change_pending = true;
+          next_index_layer++;
+        }
+      }
+      else if (p_cur_pos->is_layer_change)
+      {
+        is_layer_change_pending = true;
+      }
+
+      if (
+        !is_layer_change_pending ||
+        p_shard->commands.size() < THREADED_MIN_SHARD_LINES ||
+        !is_shard_boundary_(cmd, p_cur_pos, p_pre_pos)
+      )
+      {
+        if (has_gcode && (lines_processed_ % read_lines_before_clock_check) == 0 && next_update_time < clock())
+        {
+          continue_processing = on_progress_(get_progress_(gcode_file.get_position(), start_clock));
+          next_update_time = get_next_update_time();
+        }
+        continue;
+      }
+      is_layer_change_pending = false;
+    }
+    else
+    {
+      p_shard->is_last = true;
+    }
+
+    // Queue the current shard for welding
+    {
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      queue.pending_shards.push_back(p_shard);
+      shards.push_back(p_shard);
+    }
+    queue.shard_added.notify_one();
+    if (is_reading)
+    {
+      p_shard = new arc_welder_shard(*p_source_position_->get_current_position_ptr(), *p_source_position_->get_gcode_comment_processor(), current_arc_.get_xyz_precision(), current_arc_.get_e_precision());
+      p_shard->source_position = gcode_file.get_position();
+    }
+
+    // Write any shards that are complete, and wait for the oldest shard if too many are waiting to be written.
+    // Once reading is complete, wait for everything.
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (!shards.empty() && (shards.front()->is_complete || shards.size() > max_pending_shards || !is_reading))
+    {
+      arc_welder_shard* p_oldest_shard = shards.front();
+      while (!p_oldest_shard->is_complete)
+      {
+        queue.shard_completed.wait(lock);
+      }
+      shards.pop_front();
+      lock.unlock();
+      if (p_oldest_shard->exception && !exception)
+      {
+        exception = p_oldest_shard->exception;
+      }
+      if (!exception)
+      {
+        write_shard_(*p_oldest_shard);
+      }
+      delete p_oldest_shard;
+      lock.lock();
+      if (is_reading)
+      {
+        // The lines of the shards that have been written aren't referenced anymore.
+        gcode_file.release(shards.empty() ? p_shard->source_position : shards.front()->source_position);
+      }
+    }
+    if (is_reading && next_update_time < clock())
+    {
+      lock.unlock();
+      continue_processing = on_progress_(get_progress_(gcode_file.get_position(), start_clock));
+      next_update_time = get_next_update_time();
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.is_finished = true;
+  }
+  queue.shard_added.notify_all();
+  for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it)
+  {
+    (*it).join();
+  }
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+  return continue_processing;
+}
+
+bool arc_welder::process_pipelined_(line_reader& gcode_file, parsed_command& last_command, double start_clock)
+{
+  bool continue_processing = true;
+  double next_update_time = get_next_update_time();
+  std::exception_ptr exception;
+
+  // The first line may need to be written before the arc welder comment, so handle it before starting the pipeline.
+  const char* line;
+  long line_length;
+  if (gcode_file.read_line(line, line_length))
+  {
+    lines_processed_++;
+    if (!process_first_line_(line, line_length))
+    {
+      STAGE_TIMER_START(parse_start);
+      parser_.try_parse_source_line(line, static_cast<size_t>(line_length), last_command);
+      STAGE_TIMER_STOP(parse_start, stage_statistics_.stages[arc_welder_stage_parse]);
+      if (last_command.gcode.length() > 0)
+      {
+        gcodes_processed_++;
+      }
+      process_gcode(last_command, false, false);
+    }
+  }
+
+  int parser_threads = threads_;
+  arc_welder_pipeline pipeline(parser_threads);
+  double writer_seconds_start = output_file_.get_seconds_writing();
+  std::chrono::steady_clock::time_point pipeline_start = std::chrono::steady_clock::now();
+  std::thread reader(&arc_welder::read_batches_, &pipeline, &gcode_file);
+  std::vector<std::thread> parsers;
+  for (int index = 0; index < parser_threads; index++)
+  {
+    parsers.push_back(std::thread(&arc_welder::parse_batches_, &pipeline, index));
+  }
+
+  // Position tracking and welding must see every line in order, so they run here.
+  double welder_seconds_waiting = 0;
+  long long batch_start_position = gcode_file.get_position();
+  int parser_index = 0;
+  bool is_last = false;
+  while (!is_last && continue_processing && !exception)
+  {
+    arc_welder_pipeline_batch* p_batch;
+    if (!pipeline.parser_output[parser_index]->try_pop(p_batch))
+    {
+      std::chrono::steady_clock::time_point wait_start = std::chrono::steady_clock::now();
+      int attempts = 0;
+      do
+      {
+        wait_for_pipeline(attempts);
+      } while (!pipeline.parser_output[parser_index]->try_pop(p_batch));
+      welder_seconds_waiting += get_seconds_since(wait_start);
+    }
+    parser_index = (parser_index + 1) % parser_threads;
+    is_last = p_batch->is_last;
+    if (p_batch->exception)
+    {
+      exception = p_batch->exception;
+      break;
+    }
+
+    try
+    {
+      for (int index = 0; index < p_batch->num_lines; index++)
+      {
+        lines_processed_++;
+        parsed_command& cmd = p_batch->commands[index];
+        if (cmd.gcode.length() > 0)
+        {
+          gcodes_processed_++;
+        }
+        process_gcode(cmd, false, false);
+      }
+    }
+    catch (...)
+    {
+      exception = std::current_exception();
+      break;
+    }
+    if (p_batch->num_lines > 0)
+    {
+      // The final command may need to be reprocessed once the file has been read, but the batch is about to be reused.
+      last_command = p_batch->commands[p_batch->num_lines - 1];
+    }
+    long long source_file_position = p_batch->source_file_position;
+    // There is room for every batch, so this can't fail.
+    pipeline.free_batches.try_push(p_batch);
+    if (unwritten_commands_.count() <= 1)
+    {
+      // The only unwritten command, if any, is the last one in this batch, so the earlier batches aren't referenced
+      // anymore.
+      gcode_file.release(batch_start_position);
+    }
+    batch_start_position = source_file_position;
+
+    if (!is_last && next_update_time < clock())
+    {
+      continue_processing = on_progress_(get_progress_(source_file_position, start_clock));
+      next_update_time = get_next_update_time();
+    }
+  }
+
+  pipeline.is_stopped = true;
+  reader.join();
+  for (std::vector<std::thread>::iterator it = parsers.begin(); it != parsers.end(); ++it)
+  {
+    (*it).join();
+  }
+
+  stage_statistics_.stages[arc_welder_stage_read].add(pipeline.reader_timing);
+  for (std::vector<stage_timer_statistic>::iterator it = pipeline.parser_timing.begin(); it != pipeline.parser_timing.end(); ++it)
+  {
+    stage_statistics_.stages[arc_welder_stage_parse].add(*it);
+  }
+
+  double seconds_elapsed = get_seconds_since(pipeline_start);
+  if (seconds_elapsed > 0)
+  {
+    double parser_seconds_busy = 0;
+    for (std::vector<double>::iterator it = pipeline.parser_seconds_busy.begin(); it != pipeline.parser_seconds_busy.end(); ++it)
+    {
+      parser_seconds_busy += *it;
+    }
+    pipeline_statistics_.parser_threads = parser_threads;
+    pipeline_statistics_.seconds_elapsed = seconds_elapsed;
+    pipeline_statistics_.reader_utilization_percent = pipeline.reader_seconds_busy / seconds_elapsed * 100.0;
+    pipeline_statistics_.parser_utilization_percent = parser_seconds_busy / (seconds_elapsed * parser_threads) * 100.0;
+    pipeline_statistics_.welder_utilization_percent = (seconds_elapsed - welder_seconds_waiting) / seconds_elapsed * 100.0;
+    pipeline_statistics_.writer_utilization_percent = (output_file_.get_seconds_writing() - writer_seconds_start) / seconds_elapsed * 100.0;
+  }
+  if (info_logging_enabled_)
+  {
+    p_logger_->log(logger_type_, log_levels::INFO, pipeline_statistics_.str());
+  }
+
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+  return continue_processing;
+}
+
+void arc_welder::read_batches_(arc_welder_pipeline* p_pipeline, line_reader* p_gcode_file)
+{
+  int parser_index = 0;
+  int parser_threads = static_cast<int>(p_pipeline->parser_input.size());
+  bool is_reading = true;
+  while (is_reading)
+  {
+    arc_welder_pipeline_batch* p_batch;
+    int attempts = 0;
+    while (!p_pipeline->free_batches.try_pop(p_batch))
+    {
+      if (p_pipeline->is_stopped)
+      {
+        return;
+      }
+      wait_for_pipeline(attempts);
+    }
+
+    // Split the lines.  The parsers reference the lines in the reader's memory, so only the pointers are copied.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    STAGE_TIMER_START(read_start);
+    const char* line;
+    long line_length;
+    p_batch->num_lines = 0;
+    while (p_batch->num_lines < PIPELINE_BATCH_LINES && (is_reading = p_gcode_file->read_line(line, line_length)))
+    {
+      p_batch->lines[p_batch->num_lines] = line;
+      p_batch->line_lengths[p_batch->num_lines++] = line_length;
+    }
+    STAGE_TIMER_STOP_CALLS(read_start, p_pipeline->reader_timing, p_batch->num_lines);
+    p_batch->source_file_position = p_gcode_file->get_position();
+    p_batch->is_last = !is_reading;
+    p_pipeline->reader_seconds_busy += get_seconds_since(start);
+
+    attempts = 0;
+    while (!p_pipeline->parser_input[parser_index]->try_push(p_batch))
+    {
+      if (p_pipeline->is_stopped)
+      {
+        return;
+      }
+      wait_for_pipeline(attempts);
+    }
+    parser_index = (parser_index + 1) % parser_threads;
+  }
+}
+
+void arc_welder::parse_batches_(arc_welder_pipeline* p_pipeline, int parser_index)
+{
+  gcode_parser parser;
+  spsc_queue<arc_welder_pipeline_batch*>* p_input = p_pipeline->parser_input[parser_index];
+  spsc_queue<arc_welder_pipeline_batch*>* p_output = p_pipeline->parser_output[parser_index];
+  while (true)
+  {
+    arc_welder_pipeline_batch* p_batch;
+    int attempts = 0;
+    while (!p_input->try_pop(p_batch))
+    {
+      if (p_pipeline->is_stopped)
+      {
+        return;
+      }
+      wait_for_pipeline(attempts);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    STAGE_TIMER_START(parse_start);
+    try
+    {
+      if (p_batch->commands.size() < static_cast<size_t>(p_batch->num_lines))
+      {
+        p_batch->commands.resize(p_batch->num_lines);
+      }
+      for (int index = 0; index < p_batch->num_lines; index++)
+      {
+        parsed_command& cmd = p_batch->commands[index];
+        cmd.clear();
+        parser.try_parse_source_line(p_batch->lines[index], static_cast<size_t>(p_batch->line_lengths[index]), cmd);
+      }
+    }
+    catch (...)
+    {
+      p_batch->exception = std::current_exception();
+    }
+    STAGE_TIMER_STOP_CALLS(parse_start, p_pipeline->parser_timing[parser_index], p_batch->num_lines);
+    p_pipeline->parser_seconds_busy[parser_index] += get_seconds_since(start);
+
+    attempts = 0;
+    while (!p_output->try_push(p_batch))
+    {
+      if (p_pipeline->is_stopped)
+      {
+        return;
+      }
+      wait_for_pipeline(attempts);
+    }
+  }
+}
+
+bool arc_welder::is_shard_boundary_(const parsed_command& cmd, const position* p_cur_pos, const position* p_pre_pos) const
+{
+  // Blank lines are the only lines that can't end an arc.
+  if (cmd.is_empty && cmd.comment.length() == 0)
+  {
+    return false;
+  }
+  // Every other line ends the current arc unless it is a G0/G1 that might be added to it.  Note that a line that ends an
+  // arc is reprocessed, but a line that could not be added to an arc will not start a new one either.
+  bool is_g0_g1 = cmd.opcode == gcode_opcode_g0 || cmd.opcode == gcode_opcode_g1;
+  bool z_axis_ok = allow_3d_arcs_ || utilities::is_equal(p_cur_pos->z, p_pre_pos->z);
+  return !(cmd.is_known_command && !cmd.is_empty && is_g0_g1 && z_axis_ok);
+}
+
+void arc_welder::weld_shards_(arc_welder_shard_queue* p_queue)
+{
+  while (true)
+  {
+    arc_welder_shard* p_shard;
+    {
+      std::unique_lock<std::mutex> lock(p_queue->mutex);
+      while (p_queue->pending_shards.empty() && !p_queue->is_finished)
+      {
+        p_queue->shard_added.wait(lock);
+      }
+      if (p_queue->pending_shards.empty())
+      {
+        return;
+      }
+      p_shard = p_queue->pending_shards.front();
+      p_queue->pending_shards.pop_front();
+    }
+
+    try
+    {
+      arc_welder shard_welder(args_);
+      shard_welder.weld_shard_(*p_shard);
+    }
+    catch (...)
+    {
+      p_shard->exception = std::current_exception();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(p_queue->mutex);
+      p_shard->is_complete = true;
+    }
+    p_queue->shard_completed.notify_all();
+  }
+}
+
+void arc_welder::weld_shard_(arc_welder_shard& shard)
+{
+  // Logging is disabled here since the logger isn't thread safe.
+  p_shard_output_ = &shard.output;
+  p_source_position_->restore(shard.start_position, shard.comment_processor);
+  current_arc_.update_xyz_precision(shard.xyz_precision);
+  current_arc_.update_e_precision(shard.e_precision);
+  lines_processed_ = shard.lines_processed;
+  gcodes_processed_ = shard.gcodes_processed;
+
+  for (std::vector<parsed_command>::iterator it = shard.commands.begin(); it != shard.commands.end(); ++it)
+  {
+    lines_processed_++;
+    if ((*it).gcode.length() > 0)
+    {
+      gcodes_processed_++;
+    }
+    process_gcode(*it, false, false);
+  }
+  if (shard.is_last && current_arc_.is_shape() && waiting_for_arc_)
+  {
+    process_gcode(shard.commands.back(), true, false);
+  }
+  write_unwritten_gcodes_to_file();
+  // The commands are no longer needed, so free them before the shard is written.
+  std::vector<parsed_command>().swap(shard.commands);
+
+  shard.points_compressed = points_compressed_;
+  shard.arcs_created = arcs_created_;
+  shard.arcs_aborted_by_flow_rate = arcs_aborted_by_flow_rate_;
+  shard.num_firmware_compensations = current_arc_.get_num_firmware_compensations();
+  shard.num_gcode_length_exceptions = current_arc_.get_num_gcode_length_exceptions();
+  shard.segment_statistics = segment_statistics_;
+  shard.segment_retraction_statistics = segment_retraction_statistics_;
+  shard.travel_statistics = travel_statistics_;
+  shard.stage_statistics = get_stage_statistics_();
+  shard.command_rate_statistics = command_rate_statistics_;
+  p_shard_output_ = NULL;
+}
+
+void arc_welder::write_shard_(const arc_welder_shard& shard)
+{
+  write_output_(shard.output);
+  points_compressed_ += shard.points_compressed;
+  arcs_created_ += shard.arcs_created;
+  arcs_aborted_by_flow_rate_ += shard.arcs_aborted_by_flow_rate;
+  num_shard_firmware_compensations_ += shard.num_firmware_compensations;
+  num_shard_gcode_length_exceptions_ += shard.num_gcode_length_exceptions;
+  segment_statistics_ = source_target_segment_statistics::add(segment_statistics_, shard.segment_statistics);
+  segment_retraction_statistics_ = source_target_segment_statistics::add(segment_retraction_statistics_, shard.segment_retraction_statistics);
+  travel_statistics_ = source_target_segment_statistics::add(travel_statistics_, shard.travel_statistics);
+  stage_statistics_.add(shard.stage_statistics);
+  command_rate_statistics_.add(shard.command_rate_statistics);
+}
+
 bool arc_welder::on_progress_(const arc_welder_progress& progress)
 {
   if (progress_callback_ != NULL)
@@ -392,7 +1299,7 @@ bool arc_welder::on_progress_(const arc_welder_progress& progress)
   return true;
 }
 
-arc_welder_progress arc_welder::get_progress_(long source_file_position, double start_clock)
+arc_welder_progress arc_welder::get_progress_(long long source_file_position, double start_clock)
 {
   arc_welder_progress progress;
   progress.gcodes_processed = gcodes_processed_;
@@ -400,14 +1307,37 @@ arc_welder_progress arc_welder::get_progress_(long source_file_position, double
   progress.points_compressed = points_compressed_;
   progress.arcs_created = arcs_created_;
   progress.arcs_aborted_by_flow_rate = arcs_aborted_by_flow_rate_;
-  progress.source_file_position = source_file_position;
-  progress.target_file_size = static_cast<long>(output_file_.tellp());
-  progress.source_file_size = file_size_;
-  long bytesRemaining = file_size_ - static_cast<long>(source_file_position);
-  progress.percent_complete = static_cast<double>(source_file_position) / static_cast<double>(file_size_) * 100.0;
+  progress.source_file_position = static_cast<long>(source_file_position);
+  progress.target_file_size = static_cast<long>(output_file_.get_bytes_written());
   progress.seconds_elapsed = get_time_elapsed(start_clock, clock());
-  double bytesPerSecond = static_cast<double>(source_file_position) / progress.seconds_elapsed;
-  progress.seconds_remaining = bytesRemaining / bytesPerSecond;
+  if (is_streaming_source_)
+  {
+    // The size of the stream isn't known until it ends, so there is no way to estimate the remaining time.
+    progress.is_streaming = true;
+    progress.source_file_size = source_file_position;
+  }
+  else
+  {
+    progress.source_file_size = file_size_;
+    long bytesRemaining = file_size_ - static_cast<long>(source_file_position);
+    progress.percent_complete = static_cast<double>(source_file_position) / static_cast<double>(file_size_) * 100.0;
+    double bytesPerSecond = static_cast<double>(source_file_position) / progress.seconds_elapsed;
+    progress.seconds_remaining = bytesRemaining / bytesPerSecond;
+  }
+  if (meatpack_mode_ != meatpack_mode_none)
+  {
+    progress.transmitted_bytes = meatpack_encoder_.get_packed_bytes();
+    if (source_file_position > 0)
+    {
+      progress.transmitted_reduction_percent = (1.0 - static_cast<double>(progress.transmitted_bytes) / static_cast<double>(source_file_position)) * 100.0;
+    }
+  }
+  if (!index_.get_layers().empty())
+  {
+    // The position is just past the last line read, so find the layer of the byte before it.
+    progress.num_layers = static_cast<int>(index_.get_layers().size());
+    progress.layer = index_.find_layer(static_cast<long long>(source_file_position) - 1) + 1;
+  }
   
   if (source_file_position > 0) {
     progress.compression_ratio = (static_cast<float>(source_file_position) / static_cast<float>(progress.target_file_size));
@@ -417,31 +1347,55 @@ arc_welder_progress arc_welder::get_progress_(long source_file_position, double
     progress.compression_ratio = 0;
     progress.compression_percent = 0;
   }
-  progress.num_firmware_compensations = current_arc_.get_num_firmware_compensations();
-  progress.num_gcode_length_exceptions = current_arc_.get_num_gcode_length_exceptions();
+  progress.num_firmware_compensations = current_arc_.get_num_firmware_compensations() + num_shard_firmware_compensations_;
+  progress.num_gcode_length_exceptions = current_arc_.get_num_gcode_length_exceptions() + num_shard_gcode_length_exceptions_;
   progress.segment_statistics = segment_statistics_;
   progress.segment_retraction_statistics = segment_retraction_statistics_;
   progress.travel_statistics = travel_statistics_;
+  progress.stage_statistics = get_stage_statistics_();
+  if (command_rate_statistics_enabled_)
+  {
+    progress.command_rate_summary = source_target_command_rate_summary(command_rate_statistics_);
+  }
+  if (progress.stage_statistics.enabled)
+  {
+    progress.stage_statistics.disk_seconds = output_file_.get_seconds_writing();
+  }
   progress.box_encoding = box_encoding_;
   return progress;
 
 }
 
-int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess)
+arc_welder_stage_statistics arc_welder::get_stage_statistics_() const
+{
+  arc_welder_stage_statistics statistics = stage_statistics_;
+  // Comments are processed while the position is updated, so move that time out of the position stage.
+  const stage_timer_statistic& comment_timing = p_source_position_->get_comment_timing();
+  stage_timer_statistic& position_timing = statistics.stages[arc_welder_stage_position];
+  position_timing.ticks = position_timing.ticks > comment_timing.ticks ? position_timing.ticks - comment_timing.ticks : 0;
+  statistics.stages[arc_welder_stage_comments].add(comment_timing);
+  return statistics;
+}
+
+int arc_welder::process_gcode(const parsed_command& cmd, bool is_end, bool is_reprocess)
 {
 
   
   // Update the position for the source gcode file
+  STAGE_TIMER_START(position_start);
   p_source_position_->update(cmd, lines_processed_, gcodes_processed_, -1);
+  STAGE_TIMER_STOP(position_start, stage_statistics_.stages[arc_welder_stage_position]);
   position* p_cur_pos = p_source_position_->get_current_position_ptr();
   position* p_pre_pos = p_source_position_->get_previous_position_ptr();
   bool is_previous_extruder_relative = p_pre_pos->is_extruder_relative;
   extruder extruder_current = p_cur_pos->get_current_extruder();
   extruder previous_extruder = p_pre_pos->get_current_extruder();
+  // The positions can be reallocated when an arc grows, so keep a copy of the feedrate for the unwritten command.
+  double feedrate = p_cur_pos->f;
 
   // Determine if this is a G0, G1, G2 or G3
-  bool is_g0_g1 = cmd.command == "G0" || cmd.command == "G1";
-  bool is_g2_g3 = cmd.command == "G2" || cmd.command == "G3";
+  bool is_g0_g1 = cmd.opcode == gcode_opcode_g0 || cmd.opcode == gcode_opcode_g1;
+  bool is_g2_g3 = cmd.opcode == gcode_opcode_g2 || cmd.opcode == gcode_opcode_g3;
   //std::cout << lines_processed_ << " - " << cmd.gcode << ", CurrentEAbsolute: " << cur_extruder.e <<", ExtrusionLength: " << cur_extruder.extrusion_length << ", Retraction Length: " << cur_extruder.retraction_length << ", IsExtruding: " << cur_extruder.is_extruding << ", IsRetracting: " << cur_extruder.is_retracting << ".\n";
 
   int lines_written = 0;
@@ -466,7 +1420,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
       double j = 0;
       double r = 0;
       // Iterate through the parameters and fill in I, J and R;
-      for (std::vector<parsed_command_parameter>::iterator it = cmd.parameters.begin(); it != cmd.parameters.end(); ++it)
+      for (std::vector<parsed_command_parameter>::const_iterator it = cmd.parameters.begin(); it != cmd.parameters.end(); ++it)
       {
         switch ((*it).name[0])
         {
@@ -489,7 +1443,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
         r = utilities::sqrt(i * i + j * j);
       }
       // Now we know the radius and the chord length;
-      movement_length_mm = utilities::get_arc_distance(p_pre_pos->x, p_pre_pos->y, p_pre_pos->z, p_cur_pos->x, p_cur_pos->y, p_cur_pos->z, i, j, r, p_cur_pos->command.command == "G2");
+      movement_length_mm = utilities::get_arc_distance(p_pre_pos->x, p_pre_pos->y, p_pre_pos->z, p_cur_pos->x, p_cur_pos->y, p_cur_pos->z, i, j, r, cmd.opcode == gcode_opcode_g2);
 
     }
     else if (allow_3d_arcs_) {
@@ -515,16 +1469,27 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
         {
           travel_statistics_.update(movement_length_mm, true);
         }
-
+        if (command_rate_statistics_enabled_)
+        {
+          command_rate_statistics_.update(movement_length_mm, p_cur_pos->f, true);
+        }
       }
     }
   }
 
+  // Look up the policy for the feature being printed.  Commands without a known feature use the unknown policy.
+  int feature_index = p_cur_pos->feature_type_tag;
+  if (feature_index < 0 || feature_index >= NUM_FEATURE_TYPES)
+  {
+    feature_index = feature_type_unknown_feature;
+  }
+  const arc_welder_feature_policy& policy = feature_policies_[feature_index];
+
   // calculate the extrusion rate (mm/mm) and see how much it changes
   double mm_extruded_per_mm_travel = 0;
   double extrusion_rate_change_percent = 0;
   bool aborted_by_flow_rate = false;
-  if (extrusion_rate_variance_percent_ != 0)
+  if (policy.extrusion_rate_variance_percent != 0)
   {
       // TODO:  MAKE SURE THIS WORKS FOR TRANSITIONS FROM TRAVEL TO NON TRAVEL MOVES
       if (movement_length_mm > 0 && (is_extrusion || is_retraction))
@@ -535,7 +1500,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
               extrusion_rate_change_percent = utilities::abs(utilities::get_percent_change(previous_extrusion_rate_, mm_extruded_per_mm_travel));
           }
       }
-      if (previous_extrusion_rate_ != 0 && utilities::greater_than(extrusion_rate_change_percent, extrusion_rate_variance_percent_))
+      if (previous_extrusion_rate_ != 0 && utilities::greater_than(extrusion_rate_change_percent, policy.extrusion_rate_variance_percent))
       {
           arcs_aborted_by_flow_rate_++;
           aborted_by_flow_rate = true;
@@ -548,7 +1513,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
   
   if (allow_dynamic_precision_ && is_g0_g1)
   {
-    for (std::vector<parsed_command_parameter>::iterator it = cmd.parameters.begin(); it != cmd.parameters.end(); ++it)
+    for (std::vector<parsed_command_parameter>::const_iterator it = cmd.parameters.begin(); it != cmd.parameters.end(); ++it)
     {
       switch ((*it).name[0])
       {
@@ -569,21 +1534,21 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
   
   if (
     !is_end && cmd.is_known_command && !cmd.is_empty && (
-      is_g0_g1 && z_axis_ok &&
+      is_g0_g1 && z_axis_ok && policy.enabled &&
       utilities::is_equal(p_cur_pos->x_offset, p_pre_pos->x_offset) &&
       utilities::is_equal(p_cur_pos->y_offset, p_pre_pos->y_offset) &&
       utilities::is_equal(p_cur_pos->z_offset, p_pre_pos->z_offset) &&
       utilities::is_equal(p_cur_pos->x_firmware_offset, p_pre_pos->x_firmware_offset) &&
       utilities::is_equal(p_cur_pos->y_firmware_offset, p_pre_pos->y_firmware_offset) &&
       utilities::is_equal(p_cur_pos->z_firmware_offset, p_pre_pos->z_firmware_offset) &&
-      (previous_extrusion_rate_ == 0 || utilities::less_than_or_equal(extrusion_rate_change_percent, extrusion_rate_variance_percent_)) &&
+      (previous_extrusion_rate_ == 0 || utilities::less_than_or_equal(extrusion_rate_change_percent, policy.extrusion_rate_variance_percent)) &&
       !p_cur_pos->is_relative &&
       (
         !waiting_for_arc_ ||
         extruder_current.is_extruding ||
         extruder_current.is_retracting ||
         // Test for travel conversion
-        (allow_travel_arcs_ && p_cur_pos->is_travel())
+        (policy.allow_travel_arcs > 0 && p_cur_pos->is_travel())
         //|| (previous_extruder.is_extruding && extruder_current.is_extruding) // Test to see if 
         // we can get more arcs.
         // || (previous_extruder.is_retracting && extruder_current.is_retracting) // Test to see if 
@@ -598,6 +1563,19 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
     // Record the extrusion rate
     previous_extrusion_rate_ = mm_extruded_per_mm_travel;
     printer_point p(p_cur_pos->get_gcode_x(), p_cur_pos->get_gcode_y(), p_cur_pos->get_gcode_z(), extruder_current.get_offset_e(), extruder_current.e_relative, p_cur_pos->f, movement_length_mm, p_pre_pos->is_extruder_relative);
+    double target_resolution_mm = policy.resolution_mm;
+    if (target_commands_per_second_ > 0)
+    {
+      target_resolution_mm = get_target_resolution_mm_(policy.resolution_mm, movement_length_mm, p.f);
+    }
+    // The resolution is only raised while an arc is being built, since the points that are already part of the arc
+    // were checked against the current resolution.
+    if (target_resolution_mm != current_resolution_mm_ && (!waiting_for_arc_ || target_resolution_mm > current_resolution_mm_))
+    {
+      current_resolution_mm_ = target_resolution_mm;
+      // The shape stores the allowed deviation, which is half of the resolution.
+      current_arc_.set_resolution_mm(current_resolution_mm_ / 2.0);
+    }
     if (!waiting_for_arc_)
     {
       if (debug_logging_enabled_)
@@ -610,12 +1588,16 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
       // Don't add any extrusion, or you will over extrude!
       //std::cout << "Trying to add first point (" << p.x << "," << p.y << "," << p.z << ")...";
 
+      STAGE_TIMER_START(first_point_start);
       current_arc_.try_add_point(previous_p);
+      STAGE_TIMER_STOP(first_point_start, stage_statistics_.stages[arc_welder_stage_arc_fitting]);
     }
 
     double e_relative = extruder_current.e_relative;
     int num_points = current_arc_.get_num_segments();
+    STAGE_TIMER_START(arc_fitting_start);
     arc_added = current_arc_.try_add_point(p);
+    STAGE_TIMER_STOP(arc_fitting_start, stage_statistics_.stages[arc_welder_stage_arc_fitting]);
     if (arc_added)
     {
       // Make sure our position list is large enough to handle all the segments
@@ -654,7 +1636,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
         {
           p_logger_->log(logger_type_, log_levels::DEBUG, "Command '" + cmd.command + "' is Unknown.  Gcode:" + cmd.gcode);
         }
-        else if (cmd.command != "G0" && cmd.command != "G1")
+        else if (cmd.opcode != gcode_opcode_g0 && cmd.opcode != gcode_opcode_g1)
         {
           p_logger_->log(logger_type_, log_levels::DEBUG, "Command '" + cmd.command + "' is not G0/G1, skipping.  Gcode:" + cmd.gcode);
         }
@@ -662,6 +1644,10 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
         {
           p_logger_->log(logger_type_, log_levels::DEBUG, "Z axis position changed, cannot convert:" + cmd.gcode);
         }
+        else if (!policy.enabled)
+        {
+          p_logger_->log(logger_type_, log_levels::DEBUG, "Welding is disabled for the current feature, cannot convert:" + cmd.gcode);
+        }
         else if (p_cur_pos->is_relative)
         {
           p_logger_->log(logger_type_, log_levels::DEBUG, "XYZ Axis is in relative mode, cannot convert:" + cmd.gcode);
@@ -719,7 +1705,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
         {
           std::stringstream stream;
           stream << std::fixed << std::setprecision(5);
-          stream << "Arc Canceled - The extrusion rate variance of " << extrusion_rate_variance_percent_ << "% exceeded by " << extrusion_rate_change_percent - extrusion_rate_variance_percent_ << "% on line " << lines_processed_ << ".  Extruded " << extruder_current.e_relative << "mm over " << movement_length_mm << "mm of travel (" << mm_extruded_per_mm_travel << "mm/mm).  Previous rate: " << previous_extrusion_rate_ << "mm/mm.";
+          stream << "Arc Canceled - The extrusion rate variance of " << policy.extrusion_rate_variance_percent << "% exceeded by " << extrusion_rate_change_percent - policy.extrusion_rate_variance_percent << "% on line " << lines_processed_ << ".  Extruded " << extruder_current.e_relative << "mm over " << movement_length_mm << "mm of travel (" << mm_extruded_per_mm_travel << "mm/mm).  Previous rate: " << previous_extrusion_rate_ << "mm/mm.";
           p_logger_->log(logger_type_, log_levels::DEBUG, stream.str());
         }
         else
@@ -756,6 +1742,9 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
         // update our statistics
         points_compressed_ += current_arc_.get_num_segments() - 1;
         arcs_created_++; // increment the number of generated arcs
+#ifdef STAGE_TIMING
+        stage_statistics_.add_arc(current_arc_.get_num_shape_arc_fit_attempts());
+#endif
         write_arc_gcodes(p_pre_pos->f);
         // Now clear the arc and flag the processor as not waiting for an arc
         waiting_for_arc_ = false;
@@ -799,7 +1788,7 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
   {
     // This might not work....
     //position* cur_pos = p_source_position_->get_current_position_ptr();
-    unwritten_commands_.push_back(unwritten_command(cmd, is_previous_extruder_relative, is_extrusion, is_retraction, is_travel, movement_length_mm));
+    unwritten_commands_.append().assign(cmd, is_previous_extruder_relative, is_extrusion, is_retraction, is_travel, movement_length_mm, feedrate);
 
   }
   else if (!waiting_for_arc_)
@@ -812,8 +1801,10 @@ int arc_welder::process_gcode(parsed_command cmd, bool is_end, bool is_reprocess
 
 void arc_welder::write_arc_gcodes(double current_feedrate)
 {
-
-  std::string comment = get_comment_for_arc();
+  // The arc comment and the arc gcode are formatted separately, but only count as a single call.
+  STAGE_TIMER_START(arc_comment_start);
+  get_comment_for_arc(arc_comment_);
+  STAGE_TIMER_STOP_CALLS(arc_comment_start, stage_statistics_.stages[arc_welder_stage_gcode_formatting], 0);
   // remove the same number of unwritten gcodes as there are arc segments, minus 1 for the start point
   // Which isn't a movement
   // note, skip the first point, it is the starting point
@@ -826,13 +1817,20 @@ void arc_welder::write_arc_gcodes(double current_feedrate)
   // Undo the current command, since it isn't included in the arc
   p_source_position_->undo_update();
 
+  if (command_rate_statistics_enabled_)
+  {
+    command_rate_statistics_.update(current_arc_.get_shape_length(), current_feedrate, false);
+  }
+
   // Set the current feedrate if it is different, else set to 0 to indicate that no feedrate should be included
   if (previous_feedrate_ > 0 && previous_feedrate_ == current_feedrate) {
     current_feedrate = 0;
   }
 
   // Craete the arc gcode
-  std::string gcode = get_arc_gcode(comment);
+  STAGE_TIMER_START(gcode_start);
+  get_arc_gcode(arc_comment_, arc_gcode_);
+  STAGE_TIMER_STOP(gcode_start, stage_statistics_.stages[arc_welder_stage_gcode_formatting]);
 
   if (debug_logging_enabled_)
   {
@@ -841,7 +1839,7 @@ void arc_welder::write_arc_gcodes(double current_feedrate)
     sprintf(buffer, "%d", current_arc_.get_num_segments());
     message += buffer;
     message += " segments: ";
-    message += gcode;
+    message += arc_gcode_;
     p_logger_->log(logger_type_, log_levels::DEBUG, message);
   }
 
@@ -865,18 +1863,19 @@ void arc_welder::write_arc_gcodes(double current_feedrate)
     travel_statistics_.update(current_arc_.get_shape_length(), false);
   }
   // now write the current arc to the file 
-  write_gcode_to_file(gcode);
+  arc_gcode_.push_back('\n');
+  write_to_target_(arc_gcode_);
 }
 
-std::string arc_welder::get_comment_for_arc()
+void arc_welder::get_comment_for_arc(std::string& comment)
 {
   // build a comment string from the commands making up the arc
         // We need to start with the first command entered.
   int comment_index = unwritten_commands_.count() - (current_arc_.get_num_segments() - 1);
-  std::string comment;
+  comment.clear();
   for (; comment_index < unwritten_commands_.count(); comment_index++)
   {
-    std::string old_comment = unwritten_commands_[comment_index].comment;
+    const std::string& old_comment = unwritten_commands_[comment_index].comment;
     if (old_comment != comment && old_comment.length() > 0)
     {
       if (comment.length() > 0)
@@ -886,7 +1885,6 @@ std::string arc_welder::get_comment_for_arc()
       comment += old_comment;
     }
   }
-  return comment;
 }
 
 std::string arc_welder::create_g92_e(double absolute_e)
@@ -899,19 +1897,21 @@ std::string arc_welder::create_g92_e(double absolute_e)
 
 int arc_welder::write_gcode_to_file(std::string gcode)
 {
-  output_file_ << gcode << "\n";
+  gcode.push_back('\n');
+  write_to_target_(gcode);
   return 1;
 }
 
 int arc_welder::write_unwritten_gcodes_to_file()
 {
   int size = unwritten_commands_.count();
-  std::string lines_to_write;
+  lines_to_write_.clear();
 
+  STAGE_TIMER_START(gcode_start);
   for (int index = 0; index < size; index++)
   {
     // The the current unwritten position and remove it from the list
-    unwritten_command p = unwritten_commands_.pop_front();
+    const unwritten_command& p = unwritten_commands_.pop_front();
     if ((p.is_g0_g1 || p.is_g2_g3) && p.length > 0)
     {
 
@@ -926,27 +1926,33 @@ int arc_welder::write_unwritten_gcodes_to_file()
       else if (p.is_travel && allow_travel_arcs_) {
         travel_statistics_.update(p.length, false);
       }
+      if (command_rate_statistics_enabled_)
+      {
+        command_rate_statistics_.update(p.length, p.feedrate, false);
+      }
     }
-    lines_to_write.append(p.to_string()).append("\n");
+    p.append_to(lines_to_write_);
+    lines_to_write_.push_back('\n');
   }
+  STAGE_TIMER_STOP_CALLS(gcode_start, stage_statistics_.stages[arc_welder_stage_gcode_formatting], size);
 
-  output_file_ << lines_to_write;
+  write_to_target_(lines_to_write_);
   return size;
 }
 
-std::string arc_welder::get_arc_gcode(const std::string comment)
+void arc_welder::get_arc_gcode(const std::string& comment, std::string& gcode)
 {
   // Write gcode to file
-  std::string gcode;
+  gcode.clear();
+  gcode.reserve(96 + comment.length());
 
-  gcode = current_arc_.get_shape_gcode();
+  current_arc_.append_shape_gcode(gcode);
 
   if (comment.length() > 0)
   {
-    gcode += ";" + comment;
+    gcode += ';';
+    gcode += comment;
   }
-  return gcode;
-
 }
 
 void arc_welder::add_arcwelder_comment_to_target()
@@ -982,15 +1988,68 @@ void arc_welder::add_arcwelder_comment_to_target()
   {
     stream << "; allow_dynamic_precision=True\n";
   }
+  if (current_arc_.get_exact_arc_fitting())
+  {
+    stream << "; exact_arc_fitting=True\n";
+  }
   stream << "; default_xyz_precision=" << std::setprecision(0) << static_cast<int>(current_arc_.get_xyz_precision()) << "\n";
   stream << "; default_e_precision=" << std::setprecision(0) << static_cast<int>(current_arc_.get_e_precision()) << "\n";
   if (extrusion_rate_variance_percent_ > 0)
   {
       stream << "; extrusion_rate_variance=" << std::setprecision(1) << (extrusion_rate_variance_percent_ * 100.0) << "%\n";
   }
+  for (std::vector<arc_welder_feature_policy>::const_iterator it = feature_policy_args_.begin(); it != feature_policy_args_.end(); ++it)
+  {
+    stream << "; feature_policy=" << it->str() << "\n";
+  }
+  if (target_commands_per_second_ > 0)
+  {
+    stream << "; target_commands_per_second=" << std::setprecision(1) << target_commands_per_second_ << "\n";
+    stream << "; max_resolution=" << std::setprecision(2) << max_resolution_mm_ << "mm\n";
+  }
   stream << "\n";
 
-  output_file_ << stream.str();
+  write_to_target_(stream.str());
+}
+
+double arc_welder::get_target_resolution_mm_(double resolution_mm, double length_mm, double feedrate) const
+{
+  double commands_per_second = source_target_command_rate_statistics::get_commands_per_second(length_mm, feedrate);
+  if (commands_per_second <= target_commands_per_second_)
+  {
+    return resolution_mm;
+  }
+  // Loosen the resolution in proportion to how far over the target the move is, so that more of the short, fast moves
+  // can be combined into a single arc.  A feature policy may already be looser than the maximum, so never tighten it.
+  double max_resolution_mm = max_resolution_mm_ > resolution_mm ? max_resolution_mm_ : resolution_mm;
+  double target_resolution_mm = resolution_mm * commands_per_second / target_commands_per_second_;
+  return target_resolution_mm < max_resolution_mm ? target_resolution_mm : max_resolution_mm;
+}
+
+void arc_welder::write_to_target_(const std::string& text)
+{
+  STAGE_TIMER_START(write_start);
+  if (p_shard_output_ != NULL)
+  {
+    p_shard_output_->append(text);
+  }
+  else
+  {
+    write_output_(text);
+  }
+  STAGE_TIMER_STOP(write_start, stage_statistics_.stages[arc_welder_stage_write]);
+}
+
+void arc_welder::write_output_(const std::string& text)
+{
+  if (meatpack_mode_ == meatpack_mode_none)
+  {
+    output_file_.write(text);
+    return;
+  }
+  meatpack_output_.clear();
+  meatpack_encoder_.encode(text, meatpack_output_);
+  output_file_.write(meatpack_output_);
 }
 
 
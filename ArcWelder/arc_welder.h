@@ -27,15 +27,21 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <exception>
 #include "gcode_position.h"
 #include "position.h"
 #include "gcode_parser.h"
+#include "line_reader.h"
+#include "async_file_writer.h"
 #include "segmented_arc.h"
 #include <iostream>
 #include <fstream>
 #include "array_list.h"
 #include "unwritten_command.h"
 #include "logger.h"
+#include "stage_timer.h"
+#include "arc_welder_index.h"
+#include "meatpack_encoder.h"
 #include <cmath>
 #include <iomanip>
 #include <sstream>
@@ -452,6 +458,369 @@ private:
 	int logger_type_;
 };
 
+// The stages of welding that are timed when STAGE_TIMING is defined.
+enum arc_welder_stage_type
+{
+	arc_welder_stage_read = 0,
+	arc_welder_stage_parse = 1,
+	arc_welder_stage_position = 2,
+	arc_welder_stage_comments = 3,
+	arc_welder_stage_arc_fitting = 4,
+	arc_welder_stage_gcode_formatting = 5,
+	arc_welder_stage_write = 6
+};
+#define NUM_ARC_WELDER_STAGES 7
+static const std::string arc_welder_stage_names[NUM_ARC_WELDER_STAGES] = {
+	"read", "parse", "position", "comments", "arc_fitting", "gcode_formatting", "write"
+};
+// The number of arcs fit to each shape before it was written as an arc is counted in power of two buckets (1, 2-3, 4-7...).
+// The last bucket holds everything larger.
+#define ARC_FIT_ATTEMPT_BUCKETS 10
+
+// Where the welder spends its time.  Stage times are the sum of every thread that ran the stage, and the disk time is
+// the time the target file writer thread spent writing.  Everything stays at zero unless STAGE_TIMING is defined.
+struct arc_welder_stage_statistics
+{
+	arc_welder_stage_statistics()
+	{
+#ifdef STAGE_TIMING
+		enabled = true;
+#else
+		enabled = false;
+#endif
+		disk_seconds = 0;
+		arcs = 0;
+		arc_fit_attempts = 0;
+		max_arc_fit_attempts = 0;
+		for (int index = 0; index < ARC_FIT_ATTEMPT_BUCKETS; index++)
+		{
+			arc_fit_attempt_counts[index] = 0;
+		}
+	}
+	bool enabled;
+	stage_timer_statistic stages[NUM_ARC_WELDER_STAGES];
+	double disk_seconds;
+	// The number of times try_create_arc was called for each arc that was written.
+	int arcs;
+	long long arc_fit_attempts;
+	int max_arc_fit_attempts;
+	int arc_fit_attempt_counts[ARC_FIT_ATTEMPT_BUCKETS];
+
+	void add_arc(int attempts)
+	{
+		arcs++;
+		arc_fit_attempts += attempts;
+		if (attempts > max_arc_fit_attempts)
+		{
+			max_arc_fit_attempts = attempts;
+		}
+		arc_fit_attempt_counts[get_arc_fit_attempt_bucket(attempts)]++;
+	}
+
+	void add(const arc_welder_stage_statistics& other)
+	{
+		for (int index = 0; index < NUM_ARC_WELDER_STAGES; index++)
+		{
+			stages[index].add(other.stages[index]);
+		}
+		disk_seconds += other.disk_seconds;
+		arcs += other.arcs;
+		arc_fit_attempts += other.arc_fit_attempts;
+		if (other.max_arc_fit_attempts > max_arc_fit_attempts)
+		{
+			max_arc_fit_attempts = other.max_arc_fit_attempts;
+		}
+		for (int index = 0; index < ARC_FIT_ATTEMPT_BUCKETS; index++)
+		{
+			arc_fit_attempt_counts[index] += other.arc_fit_attempt_counts[index];
+		}
+	}
+
+	double get_average_arc_fit_attempts() const
+	{
+		return arcs == 0 ? 0 : static_cast<double>(arc_fit_attempts) / arcs;
+	}
+
+	static int get_arc_fit_attempt_bucket(int attempts)
+	{
+		int bucket = 0;
+		while (attempts > 1 && bucket < ARC_FIT_ATTEMPT_BUCKETS - 1)
+		{
+			attempts >>= 1;
+			bucket++;
+		}
+		return bucket;
+	}
+
+	static std::string get_arc_fit_attempt_bucket_label(int bucket)
+	{
+		std::stringstream stream;
+		int min_attempts = 1 << bucket;
+		if (bucket == 0)
+		{
+			stream << min_attempts;
+		}
+		else if (bucket == ARC_FIT_ATTEMPT_BUCKETS - 1)
+		{
+			stream << min_attempts << "+";
+		}
+		else
+		{
+			stream << min_attempts << "-" << (min_attempts << 1) - 1;
+		}
+		return stream.str();
+	}
+
+	std::string str() const {
+		std::stringstream stream;
+		stream << std::fixed << std::setprecision(3);
+		stream << "stage_seconds: {";
+		for (int index = 0; index < NUM_ARC_WELDER_STAGES; index++)
+		{
+			stream << (index == 0 ? "" : ", ") << arc_welder_stage_names[index] << ": " << stages[index].get_seconds();
+		}
+		stream << ", disk: " << disk_seconds << "}";
+		stream << std::setprecision(2) << ", arc_fit_attempts_per_arc: " << get_average_arc_fit_attempts();
+		stream << ", max_arc_fit_attempts: " << max_arc_fit_attempts;
+		return stream.str();
+	}
+
+	std::string detail_str() const {
+		std::stringstream stream;
+		stream << std::fixed;
+		stream << "Stage Timing\n";
+		for (int index = 0; index < NUM_ARC_WELDER_STAGES; index++)
+		{
+			const stage_timer_statistic& stage = stages[index];
+			double seconds = stage.get_seconds();
+			stream << "\t" << std::left << std::setw(17) << arc_welder_stage_names[index] << std::right << ": ";
+			stream << std::setprecision(3) << std::setw(9) << seconds << "s, " << std::setw(10) << stage.calls << " calls";
+			if (stage.calls > 0)
+			{
+				stream << ", " << std::setprecision(3) << seconds / stage.calls * 1000000.0 << "us per call";
+			}
+			stream << "\n";
+		}
+		stream << "\t" << std::left << std::setw(17) << "disk" << std::right << ": " << std::setprecision(3) << std::setw(9) << disk_seconds << "s\n";
+		stream << "Arc Fit Attempts Per Arc - Arcs: " << arcs << ", Attempts: " << arc_fit_attempts;
+		stream << ", Average: " << std::setprecision(2) << get_average_arc_fit_attempts() << ", Max: " << max_arc_fit_attempts << "\n";
+		for (int index = 0; index < ARC_FIT_ATTEMPT_BUCKETS; index++)
+		{
+			stream << "\t" << std::left << std::setw(9) << get_arc_fit_attempt_bucket_label(index) << std::right << ": " << arc_fit_attempt_counts[index];
+			if (index < ARC_FIT_ATTEMPT_BUCKETS - 1)
+			{
+				stream << "\n";
+			}
+		}
+		return stream.str();
+	}
+};
+
+// The rate each move has to be sent at to keep up with its feedrate (feedrate / length), in commands per second.  The
+// time spent moving at each rate is counted in buckets COMMAND_RATE_BUCKET_WIDTH commands/s wide, and the last bucket
+// holds everything faster.
+#define COMMAND_RATE_BUCKET_WIDTH 5
+#define COMMAND_RATE_BUCKETS 400
+
+struct source_target_command_rate_statistics
+{
+	source_target_command_rate_statistics()
+	{
+		total_count_source = 0;
+		total_count_target = 0;
+		max_source = 0;
+		max_target = 0;
+		for (int index = 0; index < COMMAND_RATE_BUCKETS; index++)
+		{
+			source_seconds[index] = 0;
+			target_seconds[index] = 0;
+		}
+	}
+	int total_count_source;
+	int total_count_target;
+	double max_source;
+	double max_target;
+	double source_seconds[COMMAND_RATE_BUCKETS];
+	double target_seconds[COMMAND_RATE_BUCKETS];
+
+	/// <summary>
+	/// Returns the number of commands per second needed to keep up with a move, or 0 if the move has no length or
+	/// feedrate.
+	/// </summary>
+	static double get_commands_per_second(double length_mm, double feedrate_mm_per_minute)
+	{
+		if (length_mm <= 0 || feedrate_mm_per_minute <= 0)
+		{
+			return 0;
+		}
+		return feedrate_mm_per_minute / 60.0 / length_mm;
+	}
+
+	void update(double length_mm, double feedrate_mm_per_minute, bool is_source)
+	{
+		double commands_per_second = get_commands_per_second(length_mm, feedrate_mm_per_minute);
+		if (commands_per_second <= 0)
+			return;
+
+		int bucket = static_cast<int>(commands_per_second / COMMAND_RATE_BUCKET_WIDTH);
+		if (bucket >= COMMAND_RATE_BUCKETS)
+		{
+			bucket = COMMAND_RATE_BUCKETS - 1;
+		}
+		if (is_source)
+		{
+			total_count_source++;
+			source_seconds[bucket] += 1.0 / commands_per_second;
+			if (commands_per_second > max_source)
+			{
+				max_source = commands_per_second;
+			}
+		}
+		else
+		{
+			total_count_target++;
+			target_seconds[bucket] += 1.0 / commands_per_second;
+			if (commands_per_second > max_target)
+			{
+				max_target = commands_per_second;
+			}
+		}
+	}
+
+	void add(const source_target_command_rate_statistics& other)
+	{
+		total_count_source += other.total_count_source;
+		total_count_target += other.total_count_target;
+		if (other.max_source > max_source)
+		{
+			max_source = other.max_source;
+		}
+		if (other.max_target > max_target)
+		{
+			max_target = other.max_target;
+		}
+		for (int index = 0; index < COMMAND_RATE_BUCKETS; index++)
+		{
+			source_seconds[index] += other.source_seconds[index];
+			target_seconds[index] += other.target_seconds[index];
+		}
+	}
+
+	/// <summary>
+	/// Returns the command rate that the moves stay at or under for the given percent of the time spent moving.  The
+	/// top of the bucket is returned, so the result is rounded up to the next COMMAND_RATE_BUCKET_WIDTH.
+	/// </summary>
+	double get_percentile(double percent, bool is_source) const
+	{
+		const double* seconds = is_source ? source_seconds : target_seconds;
+		double max = is_source ? max_source : max_target;
+		double total_seconds = 0;
+		for (int index = 0; index < COMMAND_RATE_BUCKETS; index++)
+		{
+			total_seconds += seconds[index];
+		}
+		if (total_seconds <= 0)
+		{
+			return 0;
+		}
+		double percentile_seconds = total_seconds * percent / 100.0;
+		double current_seconds = 0;
+		for (int index = 0; index < COMMAND_RATE_BUCKETS - 1; index++)
+		{
+			current_seconds += seconds[index];
+			if (current_seconds >= percentile_seconds)
+			{
+				double commands_per_second = static_cast<double>((index + 1) * COMMAND_RATE_BUCKET_WIDTH);
+				return commands_per_second < max ? commands_per_second : max;
+			}
+		}
+		return max;
+	}
+};
+
+// The percentiles reported for the command rates.
+#define COMMAND_RATE_PERCENTILES 3
+static const double command_rate_percentiles[COMMAND_RATE_PERCENTILES] = { 99, 95, 50 };
+
+// The command rates reported with the progress.  The welder keeps the histogram, and only the maximum and percentiles
+// are copied into each progress update.  Only filled in when a target commands per second is set or STAGE_TIMING is
+// defined, otherwise enabled is false and everything is zero.
+struct source_target_command_rate_summary
+{
+	source_target_command_rate_summary()
+	{
+		enabled = false;
+		total_count_source = 0;
+		total_count_target = 0;
+		max_source = 0;
+		max_target = 0;
+		for (int index = 0; index < COMMAND_RATE_PERCENTILES; index++)
+		{
+			source_percentiles[index] = 0;
+			target_percentiles[index] = 0;
+		}
+	}
+	explicit source_target_command_rate_summary(const source_target_command_rate_statistics& statistics)
+	{
+		enabled = true;
+		total_count_source = statistics.total_count_source;
+		total_count_target = statistics.total_count_target;
+		max_source = statistics.max_source;
+		max_target = statistics.max_target;
+		for (int index = 0; index < COMMAND_RATE_PERCENTILES; index++)
+		{
+			source_percentiles[index] = statistics.get_percentile(command_rate_percentiles[index], true);
+			target_percentiles[index] = statistics.get_percentile(command_rate_percentiles[index], false);
+		}
+	}
+	bool enabled;
+	int total_count_source;
+	int total_count_target;
+	double max_source;
+	double max_target;
+	double source_percentiles[COMMAND_RATE_PERCENTILES];
+	double target_percentiles[COMMAND_RATE_PERCENTILES];
+
+	/// <summary>
+	/// Returns the percentile, which must be one of the command_rate_percentiles, or 0 if it isn't.
+	/// </summary>
+	double get_percentile(double percent, bool is_source) const
+	{
+		for (int index = 0; index < COMMAND_RATE_PERCENTILES; index++)
+		{
+			if (command_rate_percentiles[index] == percent)
+			{
+				return is_source ? source_percentiles[index] : target_percentiles[index];
+			}
+		}
+		return 0;
+	}
+
+	std::string str() const {
+		std::stringstream stream;
+		stream << std::fixed << std::setprecision(1);
+		stream << "max_commands_per_second: " << max_target << ", p95_commands_per_second: " << get_percentile(95, false);
+		return stream.str();
+	}
+
+	std::string detail_str() const {
+		std::stringstream stream;
+		stream << std::fixed << std::setprecision(1);
+		stream << "Command Rate (commands/s needed to keep up with each move's feedrate, weighted by time)\n";
+		stream << "\t" << std::left << std::setw(9) << "" << std::right << std::setw(10) << "Source" << std::setw(10) << "Target" << "\n";
+		stream << "\t" << std::left << std::setw(9) << "Max" << std::right << std::setw(10) << max_source << std::setw(10) << max_target << "\n";
+		for (int index = 0; index < COMMAND_RATE_PERCENTILES; index++)
+		{
+			std::stringstream label;
+			label << std::fixed << std::setprecision(0) << command_rate_percentiles[index] << "th";
+			stream << "\t" << std::left << std::setw(9) << label.str() << std::right;
+			stream << std::setw(10) << source_percentiles[index] << std::setw(10) << target_percentiles[index] << "\n";
+		}
+		stream << "\t" << std::left << std::setw(9) << "Moves" << std::right << std::setw(10) << total_count_source << std::setw(10) << total_count_target;
+		return stream.str();
+	}
+};
+
 // Struct to hold the progress, statistics, and return values
 struct arc_welder_progress {
 	arc_welder_progress() :  segment_statistics(segment_statistic_lengths, segment_statistic_lengths_count, NULL), segment_retraction_statistics(segment_statistic_lengths, segment_statistic_lengths_count, NULL), travel_statistics(segment_statistic_lengths, segment_statistic_lengths_count, NULL) {
@@ -471,6 +840,11 @@ struct arc_welder_progress {
 		compression_ratio = 0;
 		compression_percent = 0;
 		combine_extrusion_and_retraction = true;
+		is_streaming = false;
+		layer = 0;
+		num_layers = 0;
+		transmitted_bytes = 0;
+		transmitted_reduction_percent = 0;
 		box_encoding = utilities::box_drawing::BoxEncodingEnum::ASCII;
 	}
 	double percent_complete;
@@ -489,15 +863,30 @@ struct arc_welder_progress {
 	long source_file_size;
 	long target_file_size;
 	bool combine_extrusion_and_retraction;
+	// True when the source is standard input.  The size isn't known, so percent_complete and seconds_remaining are
+	// always 0, and source_file_size is the number of bytes received so far.
+	bool is_streaming;
+	// The layer being processed and the number of layers, which are only known when a layer index is used.
+	int layer;
+	int num_layers;
+	// The bytes sent over serial for the target when it is packed with MeatPack, and how much smaller that is than
+	// the source.  Only set when a MeatPack mode is enabled.
+	long long transmitted_bytes;
+	double transmitted_reduction_percent;
 	utilities::box_drawing::BoxEncodingEnum box_encoding;
 
 	source_target_segment_statistics segment_statistics;
 	source_target_segment_statistics segment_retraction_statistics;
 	source_target_segment_statistics travel_statistics;
+	arc_welder_stage_statistics stage_statistics;
+	source_target_command_rate_summary command_rate_summary;
 
 	std::string simple_progress_str() const {
 		std::stringstream stream;
-		if (percent_complete == 0) {
+		if (is_streaming) {
+			stream << " " << std::fixed << std::setprecision(1) << static_cast<double>(source_file_position) / 1048576.0 << " MB read - " << seconds_elapsed << " seconds elapsed.";
+		}
+		else if (percent_complete == 0) {
 			stream << " 00.0% complete - Estimating remaining time.";
 		}
 		else if (percent_complete == 100)
@@ -507,6 +896,10 @@ struct arc_welder_progress {
 		else {
 			stream << " " << std::fixed << std::setprecision(1) << std::setfill('0') << std::setw(4) << percent_complete << "% complete - Estimated " << std::setprecision(0) << std::setw(-1) << seconds_remaining << " of " << seconds_elapsed + seconds_remaining << " seconds remaing.";
 		}
+		if (num_layers > 0 && percent_complete != 100)
+		{
+			stream << " Layer " << layer << " of " << num_layers << ".";
+		}
 		
 		return stream.str();
 	}
@@ -516,9 +909,20 @@ struct arc_welder_progress {
 		std::stringstream stream;
 		stream << std::fixed << std::setprecision(2);
 
-		stream << " percent_complete:" << percent_complete << ", seconds_elapsed:" << seconds_elapsed << ", seconds_remaining:" << seconds_remaining;
+		if (is_streaming)
+		{
+			stream << " bytes_read:" << source_file_position << ", seconds_elapsed:" << seconds_elapsed;
+		}
+		else
+		{
+			stream << " percent_complete:" << percent_complete << ", seconds_elapsed:" << seconds_elapsed << ", seconds_remaining:" << seconds_remaining;
+		}
 		stream << ", gcodes_processed: " << gcodes_processed;
 		stream << ", current_file_line: " << lines_processed;
+		if (num_layers > 0)
+		{
+			stream << ", layer: " << layer << " of " << num_layers;
+		}
 		stream << ", points_compressed: " << points_compressed;
 		stream << ", arcs_created: " << arcs_created;
 		stream << ", arcs_aborted_by_flowrate: " << arcs_aborted_by_flow_rate;
@@ -526,6 +930,18 @@ struct arc_welder_progress {
 		stream << ", num_gcode_length_exceptions: " << num_gcode_length_exceptions;
 		stream << ", compression_ratio: " << compression_ratio;
 		stream << ", size_reduction: " << compression_percent << "% " ;
+		if (transmitted_bytes > 0)
+		{
+			stream << ", meatpack_transmitted_bytes: " << transmitted_bytes << ", transmitted_reduction: " << transmitted_reduction_percent << "%";
+		}
+		if (command_rate_summary.enabled && command_rate_summary.total_count_target > 0)
+		{
+			stream << ", " << command_rate_summary.str();
+		}
+		if (stage_statistics.enabled)
+		{
+			stream << ", " << stage_statistics.str();
+		}
 		return stream.str();
 	}
 	std::string detail_str() const {
@@ -552,6 +968,10 @@ struct arc_welder_progress {
 
 			wstream << segment_statistics.str("Target File Extrusion Statistics", box_encoding) << "\n";
 		}
+		if (command_rate_summary.enabled)
+		{
+			wstream << command_rate_summary.detail_str() << "\n";
+		}
 		return wstream.str();
 	}
 	
@@ -560,6 +980,8 @@ struct arc_welder_progress {
 typedef bool(*progress_callback)(arc_welder_progress, logger* p_logger, int logger_type);
 // LOGGER_NAME
 #define ARC_WELDER_LOGGER_NAME "arc_welder.gcode_conversion"
+// A source or target path of "-" reads from standard input or writes to standard output.
+#define ARC_WELDER_STANDARD_STREAM_PATH "-"
 // Default argument values
 #define DEFAULT_G90_G91_INFLUENCES_EXTRUDER false
 #define DEFAULT_GCODE_BUFFER_SIZE 10
@@ -568,6 +990,67 @@ typedef bool(*progress_callback)(arc_welder_progress, logger* p_logger, int logg
 #define DEFAULT_ALLOW_TRAVEL_ARCS false
 #define DEFAULT_EXTRUSION_RATE_VARIANCE_PERCENT 0.05
 #define DEFAULT_NOTIFICATION_PERIOD_SECONDS 0.5
+#define DEFAULT_THREADS 1
+// When welding with more than one thread, shards are only split once they contain at least this many lines.
+#define THREADED_MIN_SHARD_LINES 1000
+// The maximum number of shards per thread that can be read ahead of the shard currently being written.
+#define THREADED_MAX_PENDING_SHARDS_PER_THREAD 4
+#define DEFAULT_PIPELINE false
+// The number of source lines in each batch passed between the stages of the pipelined welding mode.
+#define PIPELINE_BATCH_LINES 4096
+// The number of batches each parser thread can hold, which bounds how far the reader can get ahead of the welder.
+#define PIPELINE_BATCHES_PER_PARSER 4
+// The number of times a pipeline stage yields while waiting on a queue before it starts sleeping.
+#define PIPELINE_SPIN_ATTEMPTS 64
+#define PIPELINE_SLEEP_MICROSECONDS 100
+// How the target is encoded for serial hosts that use MeatPack (see meatpack_encoder).  MINIMIZED writes gcode with
+// the comments and spaces removed, and PACKED writes the packed bytes a MeatPack host would send.
+enum arc_welder_meatpack_mode
+{
+	meatpack_mode_none = 0,
+	meatpack_mode_minimized = 1,
+	meatpack_mode_packed = 2
+};
+#define NUM_MEATPACK_MODES 3
+static const std::string meatpack_mode_names[NUM_MEATPACK_MODES] = { "NONE", "MINIMIZED", "PACKED" };
+#define DEFAULT_MEATPACK_MODE meatpack_mode_none
+// A target of 0 commands per second welds every move with the same resolution.
+#define DEFAULT_TARGET_COMMANDS_PER_SECOND 0
+#define DEFAULT_MAX_RESOLUTION_MM 0.2
+// Overrides the welding settings for one of the feature types detected by the gcode_comment_processor.  Settings that
+// are below 0 use the value from arc_welder_args.  Policies are written as
+// <feature>[:<setting>=<value>[,<setting>=<value>...]], for example "infill:resolution_mm=0.1,allow_travel_arcs=true"
+// or "bridge:enabled=false".  The feature is a feature_type_name, with or without the _feature suffix.
+struct arc_welder_feature_policy
+{
+	arc_welder_feature_policy()
+	{
+		feature = feature_type_unknown_feature;
+		enabled = true;
+		resolution_mm = -1;
+		extrusion_rate_variance_percent = -1;
+		allow_travel_arcs = -1;
+	}
+	feature_type feature;
+	// False to copy every command in the feature to the target without welding it.
+	bool enabled;
+	double resolution_mm;
+	double extrusion_rate_variance_percent;
+	// 1 to allow travel arcs, 0 to prevent them.
+	int allow_travel_arcs;
+
+	/// <summary>
+	/// Parses a policy.  Returns false and sets the error if the text isn't a valid policy.
+	/// </summary>
+	static bool try_parse(const std::string& text, arc_welder_feature_policy& policy, std::string& error);
+	std::string str() const;
+};
+
+// An empty index path disables the layer index.
+#define DEFAULT_INDEX_PATH ""
+// An empty cache directory disables the result cache.
+#define DEFAULT_CACHE_DIRECTORY ""
+#define DEFAULT_CACHE_MAX_MEGABYTES 1024
 
 struct arc_welder_args
 {
@@ -600,6 +1083,27 @@ struct arc_welder_args
 		double extrusion_rate_variance_percent;
 		int buffer_size;
 		int max_gcode_length;
+		bool exact_arc_fitting;
+		int threads;
+		bool pipeline;
+		// Converted files are stored here, and a source that has already been converted with the same arguments is
+		// copied from the cache instead of being converted again.  Empty to disable.
+		std::string cache_directory;
+		// The least recently used files are removed from the cache once it holds more than this.
+		long long cache_max_megabytes;
+		// A layer index sidecar (see arc_welder_index), which is built and saved here if it is missing or stale.  The
+		// index is used to split the threaded mode into shards at layer boundaries, and to report the current layer
+		// with each progress update.  Empty to disable.
+		std::string index_path;
+		arc_welder_meatpack_mode meatpack_mode;
+		// When above 0, the resolution is loosened for moves that would need to be sent faster than this many commands
+		// per second at their feedrate, in proportion to how far over the target they are, but never beyond
+		// max_resolution_mm.  Slow moves are still welded with resolution_mm.
+		double target_commands_per_second;
+		double max_resolution_mm;
+		// Welding settings for specific feature types.  When more than one policy has the same feature, the last one is
+		// used.
+		std::vector<arc_welder_feature_policy> feature_policies;
 		double notification_period_seconds;
 		utilities::box_drawing::BoxEncodingEnum box_encoding;
 		
@@ -615,7 +1119,7 @@ struct arc_welder_args
 			stream << "Arc Welder Arguments\n";
 			stream << std::fixed << std::setprecision(2);
 			stream << "\tSource File Path             : " << source_path << "\n";
-			if (source_path == target_path)
+			if (source_path == target_path && source_path != ARC_WELDER_STANDARD_STREAM_PATH)
 			{
 				stream << "\tTarget File Path (overwrite) : " << target_path << "\n";
 			}
@@ -658,6 +1162,35 @@ struct arc_welder_args
 			else {
 				stream << "\tMax Gcode Length             : " << std::setprecision(0) << max_gcode_length << " characters\n";
 			}
+			stream << "\tExact Arc Fitting            : " << (exact_arc_fitting ? "True" : "False") << "\n";
+			stream << "\tThreads                      : " << std::setprecision(0) << threads << "\n";
+			stream << "\tPipeline                     : " << (pipeline ? "True" : "False") << "\n";
+			if (cache_directory.empty())
+			{
+				stream << "\tCache                        : Disabled\n";
+			}
+			else
+			{
+				stream << "\tCache                        : " << cache_directory << " (" << cache_max_megabytes << "MB)\n";
+			}
+			stream << "\tLayer Index                  : " << (index_path.empty() ? "Disabled" : index_path) << "\n";
+			stream << "\tMeatPack Mode                : " << meatpack_mode_names[meatpack_mode] << "\n";
+			if (target_commands_per_second > 0)
+			{
+				stream << "\tTarget Commands Per Second   : " << std::setprecision(1) << target_commands_per_second << " (max resolution " << std::setprecision(2) << max_resolution_mm << "mm)\n";
+			}
+			else
+			{
+				stream << "\tTarget Commands Per Second   : Disabled\n";
+			}
+			if (feature_policies.empty())
+			{
+				stream << "\tFeature Policies             : None\n";
+			}
+			for (std::vector<arc_welder_feature_policy>::const_iterator it = feature_policies.begin(); it != feature_policies.end(); ++it)
+			{
+				stream << "\tFeature Policy               : " << it->str() << "\n";
+			}
 			stream << "\tLog Level                    : " << log_level_name << "\n";
 			stream << "\tHide Progress Updates        : " << (callback == NULL ? "True" : "False") << "\n";
 			stream << "\tProgress Notification Period : " << std::setprecision(2) << notification_period_seconds << " seconds";
@@ -683,6 +1216,15 @@ private:
 			default_e_precision = DEFAULT_E_PRECISION,
 			extrusion_rate_variance_percent = DEFAULT_EXTRUSION_RATE_VARIANCE_PERCENT,
 			max_gcode_length = DEFAULT_MAX_GCODE_LENGTH,
+			exact_arc_fitting = DEFAULT_EXACT_ARC_FITTING,
+			threads = DEFAULT_THREADS,
+			pipeline = DEFAULT_PIPELINE,
+			cache_directory = DEFAULT_CACHE_DIRECTORY,
+			cache_max_megabytes = DEFAULT_CACHE_MAX_MEGABYTES,
+			index_path = DEFAULT_INDEX_PATH,
+			meatpack_mode = DEFAULT_MEATPACK_MODE,
+			target_commands_per_second = DEFAULT_TARGET_COMMANDS_PER_SECOND,
+			max_resolution_mm = DEFAULT_MAX_RESOLUTION_MM,
 			buffer_size = DEFAULT_GCODE_BUFFER_SIZE,
 			notification_period_seconds = DEFAULT_NOTIFICATION_PERIOD_SECONDS,
 			callback = NULL;
@@ -691,19 +1233,132 @@ private:
 
 };
 
+// How busy each stage of the pipelined welding mode was, as a percent of the time the pipeline ran.  The stage that
+// is close to 100% is the bottleneck.
+struct arc_welder_pipeline_statistics
+{
+	arc_welder_pipeline_statistics()
+	{
+		parser_threads = 0;
+		seconds_elapsed = 0;
+		reader_utilization_percent = 0;
+		parser_utilization_percent = 0;
+		welder_utilization_percent = 0;
+		writer_utilization_percent = 0;
+	}
+	int parser_threads;
+	double seconds_elapsed;
+	double reader_utilization_percent;
+	// The average of every parser thread.
+	double parser_utilization_percent;
+	double welder_utilization_percent;
+	double writer_utilization_percent;
+
+	std::string str() const {
+		std::stringstream stream;
+		stream << std::fixed << std::setprecision(1);
+		stream << "Pipeline Utilization - Seconds: " << std::setprecision(2) << seconds_elapsed << std::setprecision(1);
+		stream << ", Reader: " << reader_utilization_percent << "%";
+		stream << ", Parsers (" << parser_threads << "): " << parser_utilization_percent << "%";
+		stream << ", Welder: " << welder_utilization_percent << "%";
+		stream << ", Writer: " << writer_utilization_percent << "%";
+		return stream.str();
+	}
+};
+
 struct arc_welder_results {
-	arc_welder_results() : progress()
+	arc_welder_results() : progress(), pipeline_statistics()
 	{
 		success = false;
 		cancelled = false;
+		from_cache = false;
 		message = "";
 	}
 	bool success;
 	bool cancelled;
+	// True if the target was copied from the result cache instead of being converted.
+	bool from_cache;
 	std::string message;
 	arc_welder_progress progress;
+	// Only filled in by the pipelined welding mode.
+	arc_welder_pipeline_statistics pipeline_statistics;
 };
 
+// A run of source lines that is welded on a worker thread.  Shards always end on a line that can't be added to an arc,
+// so the welder is never waiting for an arc at the end of a shard, and the next shard can start from the position,
+// comment processor and precision state that was tracked while reading the file.
+struct arc_welder_shard
+{
+	arc_welder_shard(const position& start, const gcode_comment_processor& comments, unsigned char xyz, unsigned char e) :
+		start_position(start),
+		comment_processor(comments),
+		segment_statistics(segment_statistic_lengths, segment_statistic_lengths_count),
+		segment_retraction_statistics(segment_statistic_lengths, segment_statistic_lengths_count),
+		travel_statistics(segment_statistic_lengths, segment_statistic_lengths_count)
+	{
+		xyz_precision = xyz;
+		e_precision = e;
+		lines_processed = 0;
+		gcodes_processed = 0;
+		source_position = 0;
+		is_last = false;
+		is_complete = false;
+		points_compressed = 0;
+		arcs_created = 0;
+		arcs_aborted_by_flow_rate = 0;
+		num_firmware_compensations = 0;
+		num_gcode_length_exceptions = 0;
+	}
+	// Inputs
+	std::vector<parsed_command> commands;
+	position start_position;
+	gcode_comment_processor comment_processor;
+	unsigned char xyz_precision;
+	unsigned char e_precision;
+	int lines_processed;
+	int gcodes_processed;
+	// The offset of the shard's first line in the source file.  The lines stay referenced until the shard is written.
+	long long source_position;
+	bool is_last;
+	// Results
+	bool is_complete;
+	std::exception_ptr exception;
+	std::string output;
+	int points_compressed;
+	int arcs_created;
+	int arcs_aborted_by_flow_rate;
+	int num_firmware_compensations;
+	int num_gcode_length_exceptions;
+	source_target_segment_statistics segment_statistics;
+	source_target_segment_statistics segment_retraction_statistics;
+	source_target_segment_statistics travel_statistics;
+	arc_welder_stage_statistics stage_statistics;
+	source_target_command_rate_statistics command_rate_statistics;
+};
+
+// A block of source lines that is split by the reader, parsed by one of the parser threads, and then welded in the
+// pipelined welding mode.  Batches are recycled, so the parsed commands only allocate until they reach their largest size.
+struct arc_welder_pipeline_batch
+{
+	arc_welder_pipeline_batch() : lines(PIPELINE_BATCH_LINES), line_lengths(PIPELINE_BATCH_LINES)
+	{
+		num_lines = 0;
+		source_file_position = 0;
+		is_last = false;
+	}
+	std::vector<const char*> lines;
+	std::vector<long> line_lengths;
+	std::vector<parsed_command> commands;
+	int num_lines;
+	// The position of the reader after the last line in the batch was read, which is used for progress updates.
+	long long source_file_position;
+	bool is_last;
+	std::exception_ptr exception;
+};
+
+struct arc_welder_shard_queue;
+struct arc_welder_pipeline;
+
 class arc_welder
 {
 public:
@@ -719,26 +1374,53 @@ protected:
 	virtual bool on_progress_(const arc_welder_progress& progress);
 private:
 	
-	arc_welder_progress get_progress_(long source_file_position, double start_clock);
+	arc_welder_progress get_progress_(long long source_file_position, double start_clock);
+	arc_welder_stage_statistics get_stage_statistics_() const;
 	void add_arcwelder_comment_to_target();
 	void reset();
 	static gcode_position_args get_args_(bool g90_g91_influences_extruder, int buffer_size);
 	progress_callback progress_callback_;
-	int process_gcode(parsed_command cmd, bool is_end, bool is_reprocess);
+	int process_gcode(const parsed_command& cmd, bool is_end, bool is_reprocess);
+	bool process_first_line_(const char* line, long length);
+	bool process_threaded_(line_reader& gcode_file, double start_clock);
+	bool is_shard_boundary_(const parsed_command& cmd, const position* p_cur_pos, const position* p_pre_pos) const;
+	void weld_shards_(arc_welder_shard_queue* p_queue);
+	void weld_shard_(arc_welder_shard& shard);
+	void write_shard_(const arc_welder_shard& shard);
+	bool process_pipelined_(line_reader& gcode_file, parsed_command& last_command, double start_clock);
+	static void read_batches_(arc_welder_pipeline* p_pipeline, line_reader* p_gcode_file);
+	static void parse_batches_(arc_welder_pipeline* p_pipeline, int parser_index);
 	void write_arc_gcodes(double current_feedrate);
 	int write_gcode_to_file(std::string gcode);
-	std::string get_arc_gcode(const std::string comment);
-	std::string get_comment_for_arc();
+	void get_arc_gcode(const std::string& comment, std::string& gcode);
+	void get_comment_for_arc(std::string& comment);
 	int write_unwritten_gcodes_to_file();
+	void write_to_target_(const std::string& text);
+	void write_output_(const std::string& text);
 	std::string create_g92_e(double absolute_e);
+	double get_target_resolution_mm_(double resolution_mm, double length_mm, double feedrate) const;
 	std::string source_path_;
 	std::string target_path_;
 	double resolution_mm_;
+	double target_commands_per_second_;
+	double max_resolution_mm_;
+	// The resolution of the arc being built, which differs from resolution_mm_ when a feature policy or target command rate applies.
+	double current_resolution_mm_;
+	// The settings used for each feature type, with every setting that wasn't overridden filled in from the args.
+	arc_welder_feature_policy feature_policies_[NUM_FEATURE_TYPES];
+	// The policies as they were configured, before unset values were inherited from the args.
+	std::vector<arc_welder_feature_policy> feature_policy_args_;
 	gcode_position_args gcode_position_args_;
 	bool allow_dynamic_precision_;
 	bool allow_3d_arcs_;
 	bool allow_travel_arcs_;
 	long file_size_;
+	bool is_streaming_source_;
+	std::string index_path_;
+	arc_welder_index index_;
+	arc_welder_meatpack_mode meatpack_mode_;
+	meatpack_encoder meatpack_encoder_;
+	std::string meatpack_output_;
 	int lines_processed_;
 	int gcodes_processed_;
 	int last_gcode_line_written_;
@@ -749,13 +1431,29 @@ private:
 	source_target_segment_statistics segment_statistics_;
 	source_target_segment_statistics segment_retraction_statistics_;
 	source_target_segment_statistics travel_statistics_;
+	source_target_command_rate_statistics command_rate_statistics_;
+	bool command_rate_statistics_enabled_;
 	long get_file_size(const std::string& file_path);
 	double get_time_elapsed(double start_clock, double end_clock);
 	double get_next_update_time() const;
 	bool waiting_for_arc_;
 	array_list<unwritten_command> unwritten_commands_;
+	// Reused for every arc and every flush so that, once they have grown, writing gcode doesn't allocate.
+	std::string arc_comment_;
+	std::string arc_gcode_;
+	std::string lines_to_write_;
 	segmented_arc current_arc_;
-	std::ofstream output_file_;
+	async_file_writer output_file_;
+	// Shards are welded into a string instead of the target file.
+	std::string* p_shard_output_;
+	arc_welder_args args_;
+	int threads_;
+	bool pipeline_;
+	arc_welder_pipeline_statistics pipeline_statistics_;
+	// The position stage includes the comment processing done by p_source_position_, which is split out when reported.
+	arc_welder_stage_statistics stage_statistics_;
+	int num_shard_firmware_compensations_;
+	int num_shard_gcode_length_exceptions_;
 
 	// We don't care about the printer settings, except for g91 influences extruder.
 	gcode_position* p_source_position_;
@@ -0,0 +1,648 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "arc_welder_cache.h"
+#include "utilities.h"
+#include <version.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <functional>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <direct.h>
+#include <sys/utime.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+#endif
+
+#define XXH64_PRIME_1 0x9E3779B185EBCA87ULL
+#define XXH64_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define XXH64_PRIME_3 0x165667B19E3779F9ULL
+#define XXH64_PRIME_4 0x85EBCA77C2B2CA63ULL
+#define XXH64_PRIME_5 0x27D4EB2F165667C5ULL
+
+// A cache entry, which is made up of a target file and a results file with the same key.
+struct arc_welder_cache_entry
+{
+  arc_welder_cache_entry()
+  {
+    bytes = 0;
+    last_used = 0;
+    has_results = false;
+  }
+  std::string key;
+  long long bytes;
+  time_t last_used;
+  bool has_results;
+  bool operator<(const arc_welder_cache_entry& other) const
+  {
+    return last_used < other.last_used;
+  }
+};
+
+static inline uint64_t rotate_left(uint64_t value, int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t read_uint64(const unsigned char* p_data)
+{
+  uint64_t value;
+  memcpy(&value, p_data, sizeof(value));
+  return value;
+}
+
+static inline uint32_t read_uint32(const unsigned char* p_data)
+{
+  uint32_t value;
+  memcpy(&value, p_data, sizeof(value));
+  return value;
+}
+
+static inline uint64_t xxh64_round(uint64_t accumulator, uint64_t input)
+{
+  accumulator += input * XXH64_PRIME_2;
+  accumulator = rotate_left(accumulator, 31);
+  return accumulator * XXH64_PRIME_1;
+}
+
+static inline uint64_t xxh64_merge_round(uint64_t accumulator, uint64_t value)
+{
+  accumulator ^= xxh64_round(0, value);
+  return accumulator * XXH64_PRIME_1 + XXH64_PRIME_4;
+}
+
+static bool get_file_stat(const std::string& path, long long& size, time_t& modified)
+{
+#ifdef _WIN32
+  struct _stat64 file_stat;
+  if (_stat64(path.c_str(), &file_stat) != 0)
+  {
+    return false;
+  }
+#else
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0)
+  {
+    return false;
+  }
+#endif
+  size = static_cast<long long>(file_stat.st_size);
+  modified = file_stat.st_mtime;
+  return true;
+}
+
+static void touch_file(const std::string& path)
+{
+#ifdef _WIN32
+  _utime(path.c_str(), NULL);
+#else
+  utime(path.c_str(), NULL);
+#endif
+}
+
+static bool make_directory(const std::string& path)
+{
+#ifdef _WIN32
+  return _mkdir(path.c_str()) == 0 || utilities::is_directory(path);
+#else
+  return mkdir(path.c_str(), 0777) == 0 || utilities::is_directory(path);
+#endif
+}
+
+// Returns a temporary path next to the supplied path that is unique to this process and thread, since the cache can
+// be shared.
+static std::string get_temp_path(const std::string& path)
+{
+#ifdef _WIN32
+  unsigned long process_id = GetCurrentProcessId();
+#else
+  unsigned long process_id = static_cast<unsigned long>(getpid());
+#endif
+  std::stringstream stream;
+  stream << path << "." << process_id << "-" << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+  return stream.str();
+}
+
+static bool move_file(const std::string& source_path, const std::string& target_path)
+{
+#ifdef _WIN32
+  // rename won't replace an existing file on Windows.
+  std::remove(target_path.c_str());
+#endif
+  return std::rename(source_path.c_str(), target_path.c_str()) == 0;
+}
+
+template <typename T>
+static bool read_value(std::istream& stream, const char* name, T& value)
+{
+  std::string value_name;
+  return (stream >> value_name >> value) && value_name == name;
+}
+
+static void write_statistics(std::ostream& stream, const char* name, const source_target_segment_statistics& statistics)
+{
+  stream << name << " " << statistics.total_length_source << " " << statistics.total_length_target;
+  stream << " " << statistics.total_count_source << " " << statistics.total_count_target << " " << statistics.source_segments.size();
+  for (size_t index = 0; index < statistics.source_segments.size(); index++)
+  {
+    stream << " " << statistics.source_segments[index].count << " " << statistics.target_segments[index].count;
+  }
+  stream << "\n";
+}
+
+static bool read_statistics(std::istream& stream, const char* name, source_target_segment_statistics& statistics)
+{
+  std::string statistics_name;
+  size_t num_segments;
+  if (!(stream >> statistics_name >> statistics.total_length_source >> statistics.total_length_target >> statistics.total_count_source >> statistics.total_count_target >> num_segments))
+  {
+    return false;
+  }
+  if (statistics_name != name || num_segments != statistics.source_segments.size())
+  {
+    return false;
+  }
+  for (size_t index = 0; index < num_segments; index++)
+  {
+    if (!(stream >> statistics.source_segments[index].count >> statistics.target_segments[index].count))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void write_command_rate_summary(std::ostream& stream, const char* name, const source_target_command_rate_summary& summary)
+{
+  stream << name << " " << (summary.enabled ? 1 : 0) << " " << summary.total_count_source << " " << summary.total_count_target;
+  stream << " " << summary.max_source << " " << summary.max_target << " " << COMMAND_RATE_PERCENTILES;
+  for (int index = 0; index < COMMAND_RATE_PERCENTILES; index++)
+  {
+    stream << " " << summary.source_percentiles[index] << " " << summary.target_percentiles[index];
+  }
+  stream << "\n";
+}
+
+static bool read_command_rate_summary(std::istream& stream, const char* name, source_target_command_rate_summary& summary)
+{
+  std::string summary_name;
+  int enabled;
+  int num_percentiles;
+  if (!(stream >> summary_name >> enabled >> summary.total_count_source >> summary.total_count_target >> summary.max_source >> summary.max_target >> num_percentiles))
+  {
+    return false;
+  }
+  if (summary_name != name || num_percentiles != COMMAND_RATE_PERCENTILES)
+  {
+    return false;
+  }
+  summary.enabled = enabled != 0;
+  for (int index = 0; index < num_percentiles; index++)
+  {
+    if (!(stream >> summary.source_percentiles[index] >> summary.target_percentiles[index]))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+arc_welder_cache::arc_welder_cache(const std::string& directory, long long max_bytes)
+{
+  directory_ = directory;
+  max_bytes_ = max_bytes;
+}
+
+uint64_t arc_welder_cache::hash(const void* data, size_t length, uint64_t seed)
+{
+  const unsigned char* p_data = static_cast<const unsigned char*>(data);
+  const unsigned char* p_end = p_data + length;
+  uint64_t result;
+  if (length >= 32)
+  {
+    const unsigned char* p_limit = p_end - 32;
+    uint64_t v1 = seed + XXH64_PRIME_1 + XXH64_PRIME_2;
+    uint64_t v2 = seed + XXH64_PRIME_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - XXH64_PRIME_1;
+    do
+    {
+      v1 = xxh64_round(v1, read_uint64(p_data));
+      v2 = xxh64_round(v2, read_uint64(p_data + 8));
+      v3 = xxh64_round(v3, read_uint64(p_data + 16));
+      v4 = xxh64_round(v4, read_uint64(p_data + 24));
+      p_data += 32;
+    } while (p_data <= p_limit);
+    result = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+    result = xxh64_merge_round(result, v1);
+    result = xxh64_merge_round(result, v2);
+    result = xxh64_merge_round(result, v3);
+    result = xxh64_merge_round(result, v4);
+  }
+  else
+  {
+    result = seed + XXH64_PRIME_5;
+  }
+  result += static_cast<uint64_t>(length);
+  while (p_data + 8 <= p_end)
+  {
+    result ^= xxh64_round(0, read_uint64(p_data));
+    result = rotate_left(result, 27) * XXH64_PRIME_1 + XXH64_PRIME_4;
+    p_data += 8;
+  }
+  if (p_data + 4 <= p_end)
+  {
+    result ^= static_cast<uint64_t>(read_uint32(p_data)) * XXH64_PRIME_1;
+    result = rotate_left(result, 23) * XXH64_PRIME_2 + XXH64_PRIME_3;
+    p_data += 4;
+  }
+  while (p_data < p_end)
+  {
+    result ^= static_cast<uint64_t>(*p_data) * XXH64_PRIME_5;
+    result = rotate_left(result, 11) * XXH64_PRIME_1;
+    p_data++;
+  }
+  result ^= result >> 33;
+  result *= XXH64_PRIME_2;
+  result ^= result >> 29;
+  result *= XXH64_PRIME_3;
+  result ^= result >> 32;
+  return result;
+}
+
+std::string arc_welder_cache::get_args_key(const arc_welder_args& args)
+{
+  // The build date is part of the header written to every target file, so it has to be part of the key.  Settings that
+  // only change how the file is converted or how progress is reported, like the threads, the pipeline, the progress
+  // period and the box encoding, produce the same target file and are left out.
+  std::stringstream stream;
+  stream << std::setprecision(17);
+  stream << "version=" << GIT_TAGGED_VERSION << ";commit=" << GIT_COMMIT_HASH << ";branch=" << GIT_BRANCH << ";build_date=" << BUILD_DATE;
+  stream << ";resolution_mm=" << args.resolution_mm;
+  stream << ";path_tolerance_percent=" << args.path_tolerance_percent;
+  stream << ";max_radius_mm=" << args.max_radius_mm;
+  stream << ";min_arc_segments=" << args.min_arc_segments;
+  stream << ";mm_per_arc_segment=" << args.mm_per_arc_segment;
+  stream << ";g90_g91_influences_extruder=" << args.g90_g91_influences_extruder;
+  stream << ";allow_3d_arcs=" << args.allow_3d_arcs;
+  stream << ";allow_travel_arcs=" << args.allow_travel_arcs;
+  stream << ";allow_dynamic_precision=" << args.allow_dynamic_precision;
+  stream << ";default_xyz_precision=" << static_cast<int>(args.default_xyz_precision);
+  stream << ";default_e_precision=" << static_cast<int>(args.default_e_precision);
+  stream << ";extrusion_rate_variance_percent=" << args.extrusion_rate_variance_percent;
+  stream << ";buffer_size=" << args.buffer_size;
+  stream << ";max_gcode_length=" << args.max_gcode_length;
+  stream << ";exact_arc_fitting=" << args.exact_arc_fitting;
+  stream << ";meatpack_mode=" << static_cast<int>(args.meatpack_mode);
+  stream << ";target_commands_per_second=" << args.target_commands_per_second;
+  stream << ";max_resolution_mm=" << args.max_resolution_mm;
+  for (std::vector<arc_welder_feature_policy>::const_iterator it = args.feature_policies.begin(); it != args.feature_policies.end(); ++it)
+  {
+    stream << ";feature_policy=" << it->str();
+  }
+  return stream.str();
+}
+
+bool arc_welder_cache::get_key(const std::string& source_path, const arc_welder_args& args, std::string& key) const
+{
+  // Two hashes with different seeds make a 128 bit key, so a collision between different files isn't a concern.
+  std::string args_key = get_args_key(args);
+  uint64_t hashes[2];
+  hashes[0] = hash(args_key.c_str(), args_key.length(), 1);
+  hashes[1] = hash(args_key.c_str(), args_key.length(), 2);
+
+  FILE* p_file = fopen(source_path.c_str(), "rb");
+  if (p_file == NULL)
+  {
+    return false;
+  }
+  std::vector<char> buffer(ARC_WELDER_CACHE_BLOCK_SIZE);
+  uint64_t length = 0;
+  while (true)
+  {
+    size_t bytes_read = fread(&buffer[0], 1, buffer.size(), p_file);
+    if (bytes_read > 0)
+    {
+      hashes[0] = hash(&buffer[0], bytes_read, hashes[0]);
+      hashes[1] = hash(&buffer[0], bytes_read, hashes[1]);
+      length += bytes_read;
+    }
+    if (bytes_read < buffer.size())
+    {
+      break;
+    }
+  }
+  bool success = ferror(p_file) == 0;
+  fclose(p_file);
+  if (!success)
+  {
+    return false;
+  }
+  hashes[0] = hash(&length, sizeof(length), hashes[0]);
+  hashes[1] = hash(&length, sizeof(length), hashes[1]);
+
+  std::stringstream stream;
+  stream << std::hex << std::setfill('0') << std::setw(16) << hashes[0] << std::setw(16) << hashes[1];
+  key = stream.str();
+  return true;
+}
+
+bool arc_welder_cache::try_get(const std::string& key, const std::string& target_path, arc_welder_results& results) const
+{
+  std::string results_path = get_entry_path_(key, ARC_WELDER_CACHE_RESULTS_EXTENSION);
+  if (!read_results_(results_path, results))
+  {
+    return false;
+  }
+  if (!replace_file_(get_entry_path_(key, ARC_WELDER_CACHE_TARGET_EXTENSION), target_path))
+  {
+    return false;
+  }
+  // Mark the entry as recently used.
+  touch_file(results_path);
+  results.success = true;
+  results.cancelled = false;
+  results.from_cache = true;
+  return true;
+}
+
+bool arc_welder_cache::add(const std::string& key, const std::string& target_path, const arc_welder_results& results) const
+{
+  if (!make_directory(directory_))
+  {
+    return false;
+  }
+  // Write the target first, since an entry is only used once its results file exists.
+  if (!replace_file_(target_path, get_entry_path_(key, ARC_WELDER_CACHE_TARGET_EXTENSION)))
+  {
+    return false;
+  }
+  std::string results_path = get_entry_path_(key, ARC_WELDER_CACHE_RESULTS_EXTENSION);
+  std::string temp_results_path = get_temp_path(results_path);
+  if (!write_results_(temp_results_path, results) || !move_file(temp_results_path, results_path))
+  {
+    std::remove(temp_results_path.c_str());
+    return false;
+  }
+  remove_least_recently_used_(key);
+  return true;
+}
+
+std::string arc_welder_cache::get_entry_path_(const std::string& key, const char* extension) const
+{
+  return utilities::join_path(directory_, key + extension);
+}
+
+void arc_welder_cache::remove_least_recently_used_(const std::string& new_key) const
+{
+  std::vector<std::string> file_names;
+  if (!utilities::get_directory_file_names(directory_, file_names))
+  {
+    return;
+  }
+  // Gather the entries.  Temporary files, and anything else in the directory, are left alone.
+  std::map<std::string, arc_welder_cache_entry> entries;
+  long long total_bytes = 0;
+  size_t target_extension_length = strlen(ARC_WELDER_CACHE_TARGET_EXTENSION);
+  size_t results_extension_length = strlen(ARC_WELDER_CACHE_RESULTS_EXTENSION);
+  for (std::vector<std::string>::iterator it = file_names.begin(); it != file_names.end(); ++it)
+  {
+    bool is_results = utilities::is_wildcard_match(*it, "*" ARC_WELDER_CACHE_RESULTS_EXTENSION);
+    if (!is_results && !utilities::is_wildcard_match(*it, "*" ARC_WELDER_CACHE_TARGET_EXTENSION))
+    {
+      continue;
+    }
+    long long bytes;
+    time_t modified;
+    if (!get_file_stat(utilities::join_path(directory_, *it), bytes, modified))
+    {
+      continue;
+    }
+    std::string key = it->substr(0, it->length() - (is_results ? results_extension_length : target_extension_length));
+    arc_welder_cache_entry& entry = entries[key];
+    entry.key = key;
+    entry.bytes += bytes;
+    total_bytes += bytes;
+    // The results file is touched when the entry is used.  A target without a results file is left over from an
+    // interrupted add, so it is removed first.
+    if (is_results)
+    {
+      entry.has_results = true;
+      entry.last_used = modified;
+    }
+  }
+  if (total_bytes <= max_bytes_)
+  {
+    return;
+  }
+
+  std::vector<arc_welder_cache_entry> sorted_entries;
+  for (std::map<std::string, arc_welder_cache_entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+  {
+    // Modification times only have a resolution of one second, so make sure the new entry is never the one removed.
+    if (it->first != new_key)
+    {
+      sorted_entries.push_back(it->second);
+    }
+  }
+  std::stable_sort(sorted_entries.begin(), sorted_entries.end());
+  for (std::vector<arc_welder_cache_entry>::iterator it = sorted_entries.begin(); it != sorted_entries.end() && total_bytes > max_bytes_; ++it)
+  {
+    // Remove the results first so that nobody uses the entry while its target is being removed.
+    std::remove(get_entry_path_(it->key, ARC_WELDER_CACHE_RESULTS_EXTENSION).c_str());
+    std::remove(get_entry_path_(it->key, ARC_WELDER_CACHE_TARGET_EXTENSION).c_str());
+    total_bytes -= it->bytes;
+  }
+}
+
+bool arc_welder_cache::copy_file_(const std::string& source_path, const std::string& target_path)
+{
+#ifdef _WIN32
+  return CopyFileA(source_path.c_str(), target_path.c_str(), FALSE) != 0;
+#else
+  int source_descriptor = open(source_path.c_str(), O_RDONLY);
+  if (source_descriptor < 0)
+  {
+    return false;
+  }
+  int target_descriptor = open(target_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (target_descriptor < 0)
+  {
+    close(source_descriptor);
+    return false;
+  }
+  bool success = false;
+#ifdef FICLONE
+  // On file systems that support it (btrfs and xfs, for example) the copy shares the cached file's blocks, which takes
+  // no time and no space.
+  success = ioctl(target_descriptor, FICLONE, source_descriptor) == 0;
+#endif
+  if (!success)
+  {
+    std::vector<char> buffer(ARC_WELDER_CACHE_BLOCK_SIZE);
+    success = true;
+    while (success)
+    {
+      ssize_t bytes_read = read(source_descriptor, &buffer[0], buffer.size());
+      if (bytes_read < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (bytes_read <= 0)
+      {
+        success = bytes_read == 0;
+        break;
+      }
+      const char* p_data = &buffer[0];
+      while (bytes_read > 0)
+      {
+        ssize_t bytes_written = write(target_descriptor, p_data, static_cast<size_t>(bytes_read));
+        if (bytes_written < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (bytes_written <= 0)
+        {
+          success = false;
+          break;
+        }
+        p_data += bytes_written;
+        bytes_read -= bytes_written;
+      }
+    }
+  }
+  close(source_descriptor);
+  if (close(target_descriptor) != 0)
+  {
+    success = false;
+  }
+  return success;
+#endif
+}
+
+bool arc_welder_cache::replace_file_(const std::string& source_path, const std::string& target_path)
+{
+  // Copy to a temporary file next to the target and rename it, so the target is never left partially written.
+  std::string temp_path = get_temp_path(target_path);
+  if (!copy_file_(source_path, temp_path) || !move_file(temp_path, target_path))
+  {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool arc_welder_cache::write_results_(const std::string& path, const arc_welder_results& results)
+{
+  std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  const arc_welder_progress& progress = results.progress;
+  file << std::setprecision(17);
+  file << ARC_WELDER_CACHE_RESULTS_HEADER << "\n";
+  file << "gcodes_processed " << progress.gcodes_processed << "\n";
+  file << "lines_processed " << progress.lines_processed << "\n";
+  file << "points_compressed " << progress.points_compressed << "\n";
+  file << "arcs_created " << progress.arcs_created << "\n";
+  file << "arcs_aborted_by_flow_rate " << progress.arcs_aborted_by_flow_rate << "\n";
+  file << "num_firmware_compensations " << progress.num_firmware_compensations << "\n";
+  file << "num_gcode_length_exceptions " << progress.num_gcode_length_exceptions << "\n";
+  file << "compression_ratio " << progress.compression_ratio << "\n";
+  file << "compression_percent " << progress.compression_percent << "\n";
+  file << "source_file_size " << progress.source_file_size << "\n";
+  file << "target_file_size " << progress.target_file_size << "\n";
+  file << "transmitted_bytes " << progress.transmitted_bytes << "\n";
+  file << "transmitted_reduction_percent " << progress.transmitted_reduction_percent << "\n";
+  write_statistics(file, "segment_statistics", progress.segment_statistics);
+  write_statistics(file, "segment_retraction_statistics", progress.segment_retraction_statistics);
+  write_statistics(file, "travel_statistics", progress.travel_statistics);
+  write_command_rate_summary(file, "command_rate_summary", progress.command_rate_summary);
+  file.close();
+  return !file.fail();
+}
+
+bool arc_welder_cache::read_results_(const std::string& path, arc_welder_results& results)
+{
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  std::string header;
+  if (!std::getline(file, header) || header != ARC_WELDER_CACHE_RESULTS_HEADER)
+  {
+    return false;
+  }
+  arc_welder_progress progress;
+  bool success =
+    read_value(file, "gcodes_processed", progress.gcodes_processed)
+    && read_value(file, "lines_processed", progress.lines_processed)
+    && read_value(file, "points_compressed", progress.points_compressed)
+    && read_value(file, "arcs_created", progress.arcs_created)
+    && read_value(file, "arcs_aborted_by_flow_rate", progress.arcs_aborted_by_flow_rate)
+    && read_value(file, "num_firmware_compensations", progress.num_firmware_compensations)
+    && read_value(file, "num_gcode_length_exceptions", progress.num_gcode_length_exceptions)
+    && read_value(file, "compression_ratio", progress.compression_ratio)
+    && read_value(file, "compression_percent", progress.compression_percent)
+    && read_value(file, "source_file_size", progress.source_file_size)
+    && read_value(file, "target_file_size", progress.target_file_size)
+    && read_value(file, "transmitted_bytes", progress.transmitted_bytes)
+    && read_value(file, "transmitted_reduction_percent", progress.transmitted_reduction_percent)
+    && read_statistics(file, "segment_statistics", progress.segment_statistics)
+    && read_statistics(file, "segment_retraction_statistics", progress.segment_retraction_statistics)
+    && read_statistics(file, "travel_statistics", progress.travel_statistics)
+    && read_command_rate_summary(file, "command_rate_summary", progress.command_rate_summary);
+  if (!success)
+  {
+    return false;
+  }
+  progress.source_file_position = progress.source_file_size;
+  progress.percent_complete = 100.0;
+  results.progress = progress;
+  return true;
+}
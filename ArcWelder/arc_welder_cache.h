@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "arc_welder.h"
+#include <string>
+#include <cstdint>
+
+// The size of each block read while hashing the source file.
+#define ARC_WELDER_CACHE_BLOCK_SIZE 1048576
+#define ARC_WELDER_CACHE_TARGET_EXTENSION ".gcode"
+#define ARC_WELDER_CACHE_RESULTS_EXTENSION ".results"
+// Written at the top of each results file.  Change it whenever the format of the results file changes.
+#define ARC_WELDER_CACHE_RESULTS_HEADER "arc_welder_cache_results 3"
+
+// An on disk cache of converted files.  Each entry is keyed by a hash of the source file contents, every argument that
+// can change the output, and the library version, so an entry is only used when converting again would produce the
+// same file.  An entry is a copy of the target file plus the results of the conversion.  The modification time of the
+// results file records when the entry was last used, and the least recently used entries are removed whenever the
+// cache grows past its size limit.  Several processes (or threads) can share a cache directory, since entries are
+// written to a temporary file and renamed into place.
+class arc_welder_cache
+{
+public:
+	arc_welder_cache(const std::string& directory, long long max_bytes);
+	/// <summary>
+	/// Computes the key of a source file converted with the supplied arguments.
+	/// </summary>
+	/// <returns>False if the source file could not be read.</returns>
+	bool get_key(const std::string& source_path, const arc_welder_args& args, std::string& key) const;
+	/// <summary>
+	/// Copies the cached target to target_path, which may be the source file, and loads the stored results.
+	/// </summary>
+	/// <returns>False if there is no usable entry for the key.</returns>
+	bool try_get(const std::string& key, const std::string& target_path, arc_welder_results& results) const;
+	/// <summary>
+	/// Stores a converted file, then removes the least recently used entries until the cache fits within its size limit.
+	/// </summary>
+	/// <returns>False if the entry could not be written.</returns>
+	bool add(const std::string& key, const std::string& target_path, const arc_welder_results& results) const;
+	/// <summary>
+	/// Returns every argument that can change the output, along with the library version, as a string.
+	/// </summary>
+	static std::string get_args_key(const arc_welder_args& args);
+	/// <summary>
+	/// A 64 bit hash (XXH64) of a block of memory.
+	/// </summary>
+	static uint64_t hash(const void* data, size_t length, uint64_t seed);
+private:
+	std::string get_entry_path_(const std::string& key, const char* extension) const;
+	void remove_least_recently_used_(const std::string& new_key) const;
+	static bool copy_file_(const std::string& source_path, const std::string& target_path);
+	static bool replace_file_(const std::string& source_path, const std::string& target_path);
+	static bool write_results_(const std::string& path, const arc_welder_results& results);
+	static bool read_results_(const std::string& path, arc_welder_results& results);
+	std::string directory_;
+	long long max_bytes_;
+};
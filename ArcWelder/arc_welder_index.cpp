@@ -0,0 +1,665 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "arc_welder_index.h"
+#include "arc_welder_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#define ARC_WELDER_INDEX_FLAG_LAYERS_FROM_COMMENTS 1
+#define ARC_WELDER_INDEX_FLAG_G90_G91_INFLUENCES_EXTRUDER 2
+#define ARC_WELDER_INDEX_LAYER_FLAG_RELATIVE_EXTRUSION 1
+#define ARC_WELDER_INDEX_LAYER_FLAG_HAS_Z 2
+
+static const double powers_of_ten[] = {
+  1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0, 10000000.0, 100000000.0, 1000000000.0
+};
+
+static void write_uint32(std::string& buffer, uint32_t value)
+{
+  for (int index = 0; index < 4; index++)
+  {
+    buffer.push_back(static_cast<char>((value >> (index * 8)) & 0xFF));
+  }
+}
+
+static void write_uint64(std::string& buffer, uint64_t value)
+{
+  for (int index = 0; index < 8; index++)
+  {
+    buffer.push_back(static_cast<char>((value >> (index * 8)) & 0xFF));
+  }
+}
+
+static void write_double(std::string& buffer, double value)
+{
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  write_uint64(buffer, bits);
+}
+
+static uint32_t read_uint32(const unsigned char* p_data)
+{
+  uint32_t value = 0;
+  for (int index = 3; index >= 0; index--)
+  {
+    value = (value << 8) | p_data[index];
+  }
+  return value;
+}
+
+static uint64_t read_uint64(const unsigned char* p_data)
+{
+  uint64_t value = 0;
+  for (int index = 7; index >= 0; index--)
+  {
+    value = (value << 8) | p_data[index];
+  }
+  return value;
+}
+
+static double read_double(const unsigned char* p_data)
+{
+  uint64_t bits = read_uint64(p_data);
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline bool is_space(char c)
+{
+  return c == ' ' || c == '\t';
+}
+
+static inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static inline bool starts_with(const char* p_line, const char* p_end, const char* prefix, size_t prefix_length)
+{
+  return static_cast<size_t>(p_end - p_line) >= prefix_length && memcmp(p_line, prefix, prefix_length) == 0;
+}
+
+// Parses a gcode parameter value.  This is much faster than strtod, and gcode never contains exponents.
+static bool parse_value(const char*& p_cur, const char* p_end, double& value)
+{
+  while (p_cur < p_end && is_space(*p_cur))
+  {
+    p_cur++;
+  }
+  bool is_negative = false;
+  if (p_cur < p_end && (*p_cur == '-' || *p_cur == '+'))
+  {
+    is_negative = *p_cur == '-';
+    p_cur++;
+  }
+  bool has_digits = false;
+  double result = 0;
+  while (p_cur < p_end && is_digit(*p_cur))
+  {
+    result = result * 10.0 + (*p_cur - '0');
+    has_digits = true;
+    p_cur++;
+  }
+  if (p_cur < p_end && *p_cur == '.')
+  {
+    p_cur++;
+    uint64_t fraction = 0;
+    int fraction_digits = 0;
+    while (p_cur < p_end && is_digit(*p_cur))
+    {
+      if (fraction_digits < 9)
+      {
+        fraction = fraction * 10 + (*p_cur - '0');
+        fraction_digits++;
+      }
+      has_digits = true;
+      p_cur++;
+    }
+    result += static_cast<double>(fraction) / powers_of_ten[fraction_digits];
+  }
+  value = is_negative ? -result : result;
+  return has_digits;
+}
+
+arc_welder_index::arc_welder_index()
+{
+  clear();
+}
+
+void arc_welder_index::clear()
+{
+  layers_.clear();
+  z_layers_.clear();
+  are_layers_from_comments_ = false;
+  g90_g91_influences_extruder_ = false;
+  source_size_ = 0;
+  source_hash_ = 0;
+  offset_ = 0;
+  line_number_ = 0;
+  z_ = 0;
+  e_ = 0;
+  has_z_ = false;
+  is_relative_extrusion_ = false;
+  is_relative_xyz_ = false;
+  layer_z_ = 0;
+  z_change_state_ = arc_welder_index_layer();
+  has_z_change_ = false;
+}
+
+const std::vector<arc_welder_index_layer>& arc_welder_index::get_layers() const
+{
+  return layers_;
+}
+
+bool arc_welder_index::are_layers_from_comments() const
+{
+  return are_layers_from_comments_;
+}
+
+long long arc_welder_index::get_source_size() const
+{
+  return source_size_;
+}
+
+int arc_welder_index::find_layer(long long offset) const
+{
+  int low = 0;
+  int high = static_cast<int>(layers_.size());
+  // Find the first layer that starts after the offset.
+  while (low < high)
+  {
+    int middle = low + (high - low) / 2;
+    if (layers_[middle].offset <= offset)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return low - 1;
+}
+
+bool arc_welder_index::is_layer_comment(const char* p_line, const char* p_end)
+{
+  if (p_line >= p_end || *p_line != ';')
+  {
+    return false;
+  }
+  p_line++;
+  // Simplify3D: "; layer 1, Z = 0.200"
+  if (starts_with(p_line, p_end, " layer ", 7))
+  {
+    return p_line + 7 < p_end && is_digit(p_line[7]);
+  }
+  while (p_line < p_end && is_space(*p_line))
+  {
+    p_line++;
+  }
+  // Cura and ideaMaker: ";LAYER:0", PrusaSlicer and SuperSlicer: ";LAYER_CHANGE", KISSlicer: "; BEGIN_LAYER_OBJECT z=0.200"
+  return starts_with(p_line, p_end, "LAYER:", 6) ||
+    starts_with(p_line, p_end, "LAYER_CHANGE", 12) ||
+    starts_with(p_line, p_end, "BEGIN_LAYER", 11);
+}
+
+arc_welder_index_layer arc_welder_index::get_state_() const
+{
+  arc_welder_index_layer state;
+  state.offset = offset_;
+  state.line_number = line_number_;
+  state.z = z_;
+  state.e = e_;
+  state.is_relative_extrusion = is_relative_extrusion_;
+  state.has_z = has_z_;
+  return state;
+}
+
+void arc_welder_index::scan_move_(const char* p_parameters, const char* p_end, arc_welder_index_layer& state)
+{
+  bool has_xy = false;
+  bool has_z = false;
+  bool has_e = false;
+  double z = 0;
+  double e = 0;
+  for (const char* p_cur = p_parameters; p_cur < p_end; p_cur++)
+  {
+    char c = *p_cur;
+    if (c == ';')
+    {
+      break;
+    }
+    if (c == 'Z' || c == 'z')
+    {
+      p_cur++;
+      has_z = parse_value(p_cur, p_end, z);
+      p_cur--;
+    }
+    else if (c == 'E' || c == 'e')
+    {
+      p_cur++;
+      has_e = parse_value(p_cur, p_end, e);
+      p_cur--;
+    }
+    else if (c == 'X' || c == 'x' || c == 'Y' || c == 'y')
+    {
+      has_xy = true;
+    }
+  }
+
+  if (has_z)
+  {
+    double new_z = is_relative_xyz_ ? z_ + z : z;
+    if (!has_z_ || new_z != z_)
+    {
+      z_change_state_ = state;
+      has_z_change_ = true;
+    }
+    z_ = new_z;
+    has_z_ = true;
+  }
+  if (has_e)
+  {
+    bool is_extruding;
+    if (is_relative_extrusion_)
+    {
+      is_extruding = e > 0;
+      e_ += e;
+    }
+    else
+    {
+      is_extruding = e > e_;
+      e_ = e;
+    }
+    // A layer starts at the first extrusion at a new height, but the move that raised Z belongs to the layer too.
+    // Moves without X or Y, like deretractions after a Z hop, don't extrude anything onto the part.
+    if (is_extruding && has_xy && has_z_ && (z_layers_.empty() || z_ > layer_z_ + ARC_WELDER_INDEX_MIN_LAYER_HEIGHT))
+    {
+      z_layers_.push_back(has_z_change_ ? z_change_state_ : state);
+      layer_z_ = z_;
+      has_z_change_ = false;
+    }
+  }
+}
+
+void arc_welder_index::scan_set_position_(const char* p_parameters, const char* p_end)
+{
+  bool has_parameters = false;
+  for (const char* p_cur = p_parameters; p_cur < p_end; p_cur++)
+  {
+    char c = *p_cur;
+    if (c == ';')
+    {
+      break;
+    }
+    double value;
+    if (c == 'Z' || c == 'z')
+    {
+      p_cur++;
+      if (parse_value(p_cur, p_end, value))
+      {
+        z_ = value;
+        has_z_ = true;
+      }
+      p_cur--;
+      has_parameters = true;
+    }
+    else if (c == 'E' || c == 'e')
+    {
+      p_cur++;
+      if (parse_value(p_cur, p_end, value))
+      {
+        e_ = value;
+      }
+      p_cur--;
+      has_parameters = true;
+    }
+    else if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+    {
+      has_parameters = true;
+    }
+  }
+  // A G92 without parameters zeroes every axis.
+  if (!has_parameters)
+  {
+    z_ = 0;
+    e_ = 0;
+    has_z_ = true;
+  }
+}
+
+void arc_welder_index::scan_line_(const char* p_line, const char* p_end)
+{
+  while (p_line < p_end && is_space(*p_line))
+  {
+    p_line++;
+  }
+  if (p_line == p_end)
+  {
+    return;
+  }
+  char command = *p_line;
+  if (command == ';')
+  {
+    if (is_layer_comment(p_line, p_end))
+    {
+      layers_.push_back(get_state_());
+    }
+    return;
+  }
+  if (command != 'G' && command != 'g' && command != 'M' && command != 'm')
+  {
+    return;
+  }
+  const char* p_cur = p_line + 1;
+  int number = 0;
+  bool has_number = false;
+  while (p_cur < p_end && is_digit(*p_cur))
+  {
+    number = number * 10 + (*p_cur - '0');
+    has_number = true;
+    p_cur++;
+  }
+  // Skip subcodes (G1.1) and anything that isn't a command.
+  if (!has_number || (p_cur < p_end && *p_cur == '.'))
+  {
+    return;
+  }
+  if (command == 'G' || command == 'g')
+  {
+    switch (number)
+    {
+    case 0:
+    case 1:
+    {
+      arc_welder_index_layer state = get_state_();
+      scan_move_(p_cur, p_end, state);
+      break;
+    }
+    case 90:
+      is_relative_xyz_ = false;
+      if (g90_g91_influences_extruder_)
+      {
+        is_relative_extrusion_ = false;
+      }
+      break;
+    case 91:
+      is_relative_xyz_ = true;
+      if (g90_g91_influences_extruder_)
+      {
+        is_relative_extrusion_ = true;
+      }
+      break;
+    case 92:
+      scan_set_position_(p_cur, p_end);
+      break;
+    }
+  }
+  else if (number == 82)
+  {
+    is_relative_extrusion_ = false;
+  }
+  else if (number == 83)
+  {
+    is_relative_extrusion_ = true;
+  }
+}
+
+bool arc_welder_index::build(const std::string& source_path, bool g90_g91_influences_extruder)
+{
+  clear();
+  g90_g91_influences_extruder_ = g90_g91_influences_extruder;
+  FILE* p_file = fopen(source_path.c_str(), "rb");
+  if (p_file == NULL)
+  {
+    return false;
+  }
+  // Lines that cross a block boundary are moved to the front of the buffer before the next block is read, so the
+  // buffer has room for one block plus one partial line.
+  std::vector<char> buffer(ARC_WELDER_INDEX_BLOCK_SIZE * 2);
+  size_t partial_line_length = 0;
+  uint64_t hash = 0;
+  while (true)
+  {
+    if (buffer.size() - partial_line_length < ARC_WELDER_INDEX_BLOCK_SIZE)
+    {
+      buffer.resize(partial_line_length + ARC_WELDER_INDEX_BLOCK_SIZE);
+    }
+    char* p_block = &buffer[0] + partial_line_length;
+    size_t bytes_read = fread(p_block, 1, ARC_WELDER_INDEX_BLOCK_SIZE, p_file);
+    if (bytes_read > 0)
+    {
+      hash = arc_welder_cache::hash(p_block, bytes_read, hash);
+      source_size_ += bytes_read;
+    }
+    const char* p_line = &buffer[0];
+    const char* p_end = p_block + bytes_read;
+    const char* p_newline;
+    while ((p_newline = static_cast<const char*>(memchr(p_line, '\n', p_end - p_line))) != NULL)
+    {
+      line_number_++;
+      scan_line_(p_line, p_newline > p_line && p_newline[-1] == '\r' ? p_newline - 1 : p_newline);
+      offset_ += (p_newline + 1) - p_line;
+      p_line = p_newline + 1;
+    }
+    partial_line_length = p_end - p_line;
+    if (bytes_read < ARC_WELDER_INDEX_BLOCK_SIZE)
+    {
+      // The last line may not end with a newline.
+      if (partial_line_length > 0)
+      {
+        line_number_++;
+        scan_line_(p_line, p_end);
+      }
+      break;
+    }
+    memmove(&buffer[0], p_line, partial_line_length);
+  }
+  bool success = ferror(p_file) == 0;
+  fclose(p_file);
+  if (!success)
+  {
+    clear();
+    return false;
+  }
+  source_hash_ = arc_welder_cache::hash(&source_size_, sizeof(source_size_), hash);
+
+  are_layers_from_comments_ = !layers_.empty();
+  if (!are_layers_from_comments_)
+  {
+    layers_.swap(z_layers_);
+  }
+  z_layers_.clear();
+  for (size_t index = 0; index < layers_.size(); index++)
+  {
+    layers_[index].layer = static_cast<int>(index) + 1;
+  }
+  return true;
+}
+
+bool arc_welder_index::hash_file_(const std::string& source_path, long long& size, uint64_t& hash)
+{
+  FILE* p_file = fopen(source_path.c_str(), "rb");
+  if (p_file == NULL)
+  {
+    return false;
+  }
+  std::vector<char> buffer(ARC_WELDER_INDEX_BLOCK_SIZE);
+  size = 0;
+  hash = 0;
+  while (true)
+  {
+    size_t bytes_read = fread(&buffer[0], 1, buffer.size(), p_file);
+    if (bytes_read > 0)
+    {
+      hash = arc_welder_cache::hash(&buffer[0], bytes_read, hash);
+      size += bytes_read;
+    }
+    if (bytes_read < buffer.size())
+    {
+      break;
+    }
+  }
+  bool success = ferror(p_file) == 0;
+  fclose(p_file);
+  hash = arc_welder_cache::hash(&size, sizeof(size), hash);
+  return success;
+}
+
+bool arc_welder_index::matches(const std::string& source_path, bool g90_g91_influences_extruder) const
+{
+  if (g90_g91_influences_extruder != g90_g91_influences_extruder_)
+  {
+    return false;
+  }
+  long long size;
+  uint64_t hash;
+  return hash_file_(source_path, size, hash) && size == source_size_ && hash == source_hash_;
+}
+
+bool arc_welder_index::save(const std::string& path) const
+{
+  std::string buffer;
+  buffer.reserve(ARC_WELDER_INDEX_HEADER_SIZE + layers_.size() * ARC_WELDER_INDEX_RECORD_SIZE);
+  buffer.append(ARC_WELDER_INDEX_MAGIC, sizeof(ARC_WELDER_INDEX_MAGIC));
+  write_uint32(buffer, ARC_WELDER_INDEX_VERSION);
+  uint32_t flags = 0;
+  if (are_layers_from_comments_)
+  {
+    flags |= ARC_WELDER_INDEX_FLAG_LAYERS_FROM_COMMENTS;
+  }
+  if (g90_g91_influences_extruder_)
+  {
+    flags |= ARC_WELDER_INDEX_FLAG_G90_G91_INFLUENCES_EXTRUDER;
+  }
+  write_uint32(buffer, flags);
+  write_uint64(buffer, static_cast<uint64_t>(source_size_));
+  write_uint64(buffer, source_hash_);
+  write_uint64(buffer, layers_.size());
+  write_uint32(buffer, ARC_WELDER_INDEX_RECORD_SIZE);
+  write_uint32(buffer, 0);
+  for (std::vector<arc_welder_index_layer>::const_iterator it = layers_.begin(); it != layers_.end(); ++it)
+  {
+    write_uint64(buffer, static_cast<uint64_t>(it->offset));
+    write_uint64(buffer, static_cast<uint64_t>(it->line_number));
+    write_double(buffer, it->z);
+    write_double(buffer, it->e);
+    write_uint32(buffer, static_cast<uint32_t>(it->layer));
+    uint32_t layer_flags = 0;
+    if (it->is_relative_extrusion)
+    {
+      layer_flags |= ARC_WELDER_INDEX_LAYER_FLAG_RELATIVE_EXTRUSION;
+    }
+    if (it->has_z)
+    {
+      layer_flags |= ARC_WELDER_INDEX_LAYER_FLAG_HAS_Z;
+    }
+    write_uint32(buffer, layer_flags);
+  }
+
+  FILE* p_file = fopen(path.c_str(), "wb");
+  if (p_file == NULL)
+  {
+    return false;
+  }
+  bool success = fwrite(buffer.c_str(), 1, buffer.size(), p_file) == buffer.size();
+  success = fclose(p_file) == 0 && success;
+  if (!success)
+  {
+    remove(path.c_str());
+  }
+  return success;
+}
+
+bool arc_welder_index::load(const std::string& path)
+{
+  clear();
+  FILE* p_file = fopen(path.c_str(), "rb");
+  if (p_file == NULL)
+  {
+    return false;
+  }
+  unsigned char header[ARC_WELDER_INDEX_HEADER_SIZE];
+  bool success = fread(header, 1, sizeof(header), p_file) == sizeof(header) &&
+    memcmp(header, ARC_WELDER_INDEX_MAGIC, sizeof(ARC_WELDER_INDEX_MAGIC)) == 0 &&
+    read_uint32(header + 8) == ARC_WELDER_INDEX_VERSION &&
+    read_uint32(header + 40) == ARC_WELDER_INDEX_RECORD_SIZE;
+  if (success)
+  {
+    uint32_t flags = read_uint32(header + 12);
+    are_layers_from_comments_ = (flags & ARC_WELDER_INDEX_FLAG_LAYERS_FROM_COMMENTS) != 0;
+    g90_g91_influences_extruder_ = (flags & ARC_WELDER_INDEX_FLAG_G90_G91_INFLUENCES_EXTRUDER) != 0;
+    source_size_ = static_cast<long long>(read_uint64(header + 16));
+    source_hash_ = read_uint64(header + 24);
+    uint64_t num_layers = read_uint64(header + 32);
+    // Don't trust the layer count from the header.  Every record must be in the file, which also limits how much
+    // memory a corrupt index can reserve.
+    long records_start = ftell(p_file);
+    long file_size = -1;
+    if (records_start >= 0 && fseek(p_file, 0, SEEK_END) == 0)
+    {
+      file_size = ftell(p_file);
+    }
+    success = file_size >= records_start && fseek(p_file, records_start, SEEK_SET) == 0 &&
+      num_layers <= static_cast<uint64_t>(file_size - records_start) / ARC_WELDER_INDEX_RECORD_SIZE;
+    if (success)
+    {
+      layers_.reserve(static_cast<size_t>(num_layers));
+    }
+    unsigned char record[ARC_WELDER_INDEX_RECORD_SIZE];
+    for (uint64_t index = 0; success && index < num_layers; index++)
+    {
+      if (fread(record, 1, sizeof(record), p_file) != sizeof(record))
+      {
+        success = false;
+        break;
+      }
+      arc_welder_index_layer layer;
+      layer.offset = static_cast<long long>(read_uint64(record));
+      layer.line_number = static_cast<long long>(read_uint64(record + 8));
+      layer.z = read_double(record + 16);
+      layer.e = read_double(record + 24);
+      layer.layer = static_cast<int>(read_uint32(record + 32));
+      uint32_t layer_flags = read_uint32(record + 36);
+      layer.is_relative_extrusion = (layer_flags & ARC_WELDER_INDEX_LAYER_FLAG_RELATIVE_EXTRUSION) != 0;
+      layer.has_z = (layer_flags & ARC_WELDER_INDEX_LAYER_FLAG_HAS_Z) != 0;
+      if (layer.offset < 0 || layer.offset > source_size_)
+      {
+        success = false;
+        break;
+      }
+      layers_.push_back(layer);
+    }
+  }
+  fclose(p_file);
+  if (!success)
+  {
+    clear();
+  }
+  return success;
+}
@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// The default extension of an index file, which is appended to the name of the source file.
+#define ARC_WELDER_INDEX_EXTENSION ".awidx"
+// Written at the start of every index file.  Change the version whenever the format of the file changes.
+#define ARC_WELDER_INDEX_MAGIC "AWINDEX"
+#define ARC_WELDER_INDEX_VERSION 1
+#define ARC_WELDER_INDEX_HEADER_SIZE 48
+#define ARC_WELDER_INDEX_RECORD_SIZE 40
+// The source file is read and hashed in blocks of this size.
+#define ARC_WELDER_INDEX_BLOCK_SIZE 1048576
+// An extruding move must be at least this much higher than the current layer to start a new layer.
+#define ARC_WELDER_INDEX_MIN_LAYER_HEIGHT 0.000005
+
+// The state of the printer at the start of a layer, before the first line of the layer is processed.
+struct arc_welder_index_layer
+{
+	arc_welder_index_layer()
+	{
+		offset = 0;
+		line_number = 0;
+		z = 0;
+		e = 0;
+		layer = 0;
+		is_relative_extrusion = false;
+		has_z = false;
+	}
+	// The byte offset of the first line of the layer.
+	long long offset;
+	// The line number (starting at 1) of the first line of the layer.
+	long long line_number;
+	double z;
+	// The absolute position of the extruder, even when relative extrusion is enabled.
+	double e;
+	// The layer number, starting at 1.
+	int layer;
+	bool is_relative_extrusion;
+	// False if no Z position has been set before the layer starts.
+	bool has_z;
+};
+
+// A list of the layers within a gcode file, along with the offset of each layer, which is built by a fast scan of the
+// file and stored in a compact binary sidecar file.  The scan only looks at layer comments (Cura, PrusaSlicer,
+// Simplify3D and KISSlicer), Z moves and extruder positions, so it runs at close to the speed the file can be read.
+// Layers are taken from the layer comments when the file contains any.  Otherwise, a layer starts at the move that
+// raises Z before the first extrusion at a new height.  The index stores the size and a hash of the source file, so
+// a stale index is never used.
+//
+// The file is little endian.  The header contains the magic string, version, flags, the source size, the source
+// hash, the number of layers and the record size.  Each record contains the offset, line number, Z, absolute E,
+// layer number and flags of one layer.
+class arc_welder_index
+{
+public:
+	arc_welder_index();
+	/// <summary>
+	/// Scans the source file and replaces the current layers.
+	/// </summary>
+	/// <returns>False if the source file could not be read.</returns>
+	bool build(const std::string& source_path, bool g90_g91_influences_extruder);
+	/// <summary>
+	/// Writes the index to a sidecar file.
+	/// </summary>
+	/// <returns>False if the file could not be written.</returns>
+	bool save(const std::string& path) const;
+	/// <summary>
+	/// Reads an index from a sidecar file.
+	/// </summary>
+	/// <returns>False if the file could not be read, or is not an index file of the current version.</returns>
+	bool load(const std::string& path);
+	/// <summary>
+	/// Returns true if the index was built from the current contents of the source file with the same extruder settings.
+	/// </summary>
+	bool matches(const std::string& source_path, bool g90_g91_influences_extruder) const;
+	/// <summary>
+	/// Returns the position within get_layers() of the layer containing the byte offset, or -1 if the offset is before
+	/// the first layer.
+	/// </summary>
+	int find_layer(long long offset) const;
+	const std::vector<arc_welder_index_layer>& get_layers() const;
+	bool are_layers_from_comments() const;
+	long long get_source_size() const;
+	void clear();
+	/// <summary>
+	/// Returns true if the line is a layer comment written by one of the supported slicers.
+	/// </summary>
+	static bool is_layer_comment(const char* p_line, const char* p_end);
+private:
+	void scan_line_(const char* p_line, const char* p_end);
+	void scan_move_(const char* p_parameters, const char* p_end, arc_welder_index_layer& state);
+	void scan_set_position_(const char* p_parameters, const char* p_end);
+	arc_welder_index_layer get_state_() const;
+	static bool hash_file_(const std::string& source_path, long long& size, uint64_t& hash);
+	std::vector<arc_welder_index_layer> layers_;
+	bool are_layers_from_comments_;
+	bool g90_g91_influences_extruder_;
+	long long source_size_;
+	uint64_t source_hash_;
+	// The state of the scan
+	std::vector<arc_welder_index_layer> z_layers_;
+	long long offset_;
+	long long line_number_;
+	double z_;
+	double e_;
+	bool has_z_;
+	bool is_relative_extrusion_;
+	bool is_relative_xyz_;
+	double layer_z_;
+	// The state before the most recent line that changed Z.
+	arc_welder_index_layer z_change_state_;
+	bool has_z_change_;
+};
@@ -0,0 +1,221 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "async_file_writer.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+async_file_writer::async_file_writer()
+{
+  buffer_size_ = ASYNC_FILE_WRITER_BUFFER_SIZE;
+  capacity_ = buffer_size_;
+  p_file_ = NULL;
+  is_standard_output_ = false;
+  bytes_written_ = 0;
+  is_writing_ = false;
+  is_closing_ = false;
+  has_error_ = false;
+  seconds_writing_ = 0;
+}
+
+async_file_writer::async_file_writer(size_t buffer_size)
+{
+  buffer_size_ = buffer_size > 0 ? buffer_size : 1;
+  capacity_ = buffer_size_;
+  p_file_ = NULL;
+  is_standard_output_ = false;
+  bytes_written_ = 0;
+  is_writing_ = false;
+  is_closing_ = false;
+  has_error_ = false;
+  seconds_writing_ = 0;
+}
+
+async_file_writer::~async_file_writer()
+{
+  close();
+}
+
+bool async_file_writer::open(const std::string& path)
+{
+  close();
+  p_file_ = fopen(path.c_str(), "wb");
+  if (p_file_ == NULL)
+  {
+    return false;
+  }
+  // The buffers are already large, so don't buffer again.
+  setvbuf(p_file_, NULL, _IONBF, 0);
+  is_standard_output_ = false;
+  capacity_ = buffer_size_;
+  start_();
+  return true;
+}
+
+bool async_file_writer::open_standard_output()
+{
+  close();
+#ifdef _WIN32
+  // Don't translate line endings, so the output matches a file written in binary mode.
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+  p_file_ = stdout;
+  is_standard_output_ = true;
+  capacity_ = buffer_size_ < ASYNC_FILE_WRITER_STREAM_BUFFER_SIZE ? buffer_size_ : ASYNC_FILE_WRITER_STREAM_BUFFER_SIZE;
+  start_();
+  return true;
+}
+
+void async_file_writer::start_()
+{
+  bytes_written_ = 0;
+  is_writing_ = false;
+  is_closing_ = false;
+  has_error_ = false;
+  seconds_writing_ = 0;
+  filling_buffer_.clear();
+  filling_buffer_.reserve(capacity_);
+  writing_buffer_.clear();
+  writing_buffer_.reserve(capacity_);
+  io_thread_ = std::thread(&async_file_writer::write_buffers_, this);
+}
+
+bool async_file_writer::close()
+{
+  if (p_file_ == NULL)
+  {
+    return true;
+  }
+  flush_buffer_();
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    is_closing_ = true;
+  }
+  buffer_ready_.notify_one();
+  io_thread_.join();
+  if ((is_standard_output_ ? fflush(p_file_) : fclose(p_file_)) != 0)
+  {
+    has_error_ = true;
+  }
+  p_file_ = NULL;
+  is_standard_output_ = false;
+  std::vector<char>().swap(filling_buffer_);
+  std::vector<char>().swap(writing_buffer_);
+  return !has_error_;
+}
+
+bool async_file_writer::is_open() const
+{
+  return p_file_ != NULL;
+}
+
+void async_file_writer::write(const std::string& text)
+{
+  write(text.c_str(), text.length());
+}
+
+void async_file_writer::write(const char* data, size_t length)
+{
+  bytes_written_ += static_cast<long long>(length);
+  while (length > 0)
+  {
+    size_t available = capacity_ - filling_buffer_.size();
+    size_t to_copy = length < available ? length : available;
+    filling_buffer_.insert(filling_buffer_.end(), data, data + to_copy);
+    data += to_copy;
+    length -= to_copy;
+    if (filling_buffer_.size() == capacity_)
+    {
+      flush_buffer_();
+    }
+  }
+}
+
+long long async_file_writer::get_bytes_written() const
+{
+  return bytes_written_;
+}
+
+double async_file_writer::get_seconds_writing()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  return seconds_writing_;
+}
+
+void async_file_writer::flush_buffer_()
+{
+  if (filling_buffer_.empty())
+  {
+    return;
+  }
+  {
+    // Wait for the previous buffer to be written, then swap buffers.
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (is_writing_)
+    {
+      buffer_written_.wait(lock);
+    }
+    filling_buffer_.swap(writing_buffer_);
+    filling_buffer_.clear();
+    is_writing_ = true;
+  }
+  buffer_ready_.notify_one();
+}
+
+void async_file_writer::write_buffers_()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    while (!is_writing_ && !is_closing_)
+    {
+      buffer_ready_.wait(lock);
+    }
+    if (!is_writing_)
+    {
+      return;
+    }
+    // Only this thread touches writing_buffer_ while is_writing_ is set, so the lock isn't needed to write it.
+    lock.unlock();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool success = fwrite(&writing_buffer_[0], 1, writing_buffer_.size(), p_file_) == writing_buffer_.size();
+    if (success && is_standard_output_)
+    {
+      // Pass the text on now, rather than when the stdio buffer fills.
+      success = fflush(p_file_) == 0;
+    }
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    lock.lock();
+    seconds_writing_ += duration.count();
+    if (!success)
+    {
+      has_error_ = true;
+    }
+    is_writing_ = false;
+    buffer_written_.notify_one();
+  }
+}
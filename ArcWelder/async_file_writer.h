@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// The size of each of the two output buffers.
+#define ASYNC_FILE_WRITER_BUFFER_SIZE 4194304
+// The largest buffer used for standard output, so that whoever is reading the output doesn't wait for megabytes of it.
+#define ASYNC_FILE_WRITER_STREAM_BUFFER_SIZE 65536
+
+// Writes a file on a dedicated I/O thread.  Text is copied into one of two preallocated buffers, and each full
+// buffer is handed to the I/O thread while the other is filled, so slow writes (network shares, for example)
+// overlap with processing.  Only one thread may call write.
+class async_file_writer
+{
+public:
+	async_file_writer();
+	async_file_writer(size_t buffer_size);
+	~async_file_writer();
+	bool open(const std::string& path);
+	/// <summary>
+	/// Writes to standard output instead of a file.  Smaller buffers are used, and standard output is flushed after each
+	/// one is written.  Standard output is not closed by close.
+	/// </summary>
+	bool open_standard_output();
+	/// <summary>
+	/// Writes any buffered text, waits for the I/O thread to finish, and closes the file.
+	/// </summary>
+	/// <returns>False if any write failed.</returns>
+	bool close();
+	bool is_open() const;
+	void write(const char* data, size_t length);
+	void write(const std::string& text);
+	/// <summary>
+	/// Returns the number of bytes passed to write since the file was opened, including bytes that are still buffered.
+	/// </summary>
+	long long get_bytes_written() const;
+	/// <summary>
+	/// Returns the total time the I/O thread has spent writing to the file.
+	/// </summary>
+	double get_seconds_writing();
+private:
+	async_file_writer(const async_file_writer& source);
+	async_file_writer& operator=(const async_file_writer& source);
+	void flush_buffer_();
+	void write_buffers_();
+	void start_();
+	size_t buffer_size_;
+	// The size of the buffers for the open file, which is smaller than buffer_size_ for standard output.
+	size_t capacity_;
+	FILE* p_file_;
+	bool is_standard_output_;
+	long long bytes_written_;
+	// The buffer being filled by write.
+	std::vector<char> filling_buffer_;
+	// The buffer being written by the I/O thread.
+	std::vector<char> writing_buffer_;
+	bool is_writing_;
+	bool is_closing_;
+	bool has_error_;
+	double seconds_writing_;
+	std::mutex mutex_;
+	std::condition_variable buffer_ready_;
+	std::condition_variable buffer_written_;
+	std::thread io_thread_;
+};
@@ -0,0 +1,480 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "deviation_kernels.h"
+#include "utilities.h"
+
+#if defined(DEVIATION_KERNELS_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(DEVIATION_KERNELS_AVX)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define DEVIATION_KERNELS_AVX_TARGET
+#else
+#define DEVIATION_KERNELS_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+// Note:  The vectorized kernels perform exactly the same operations in exactly the same order as the scalar
+// functions below, which in turn match segment::get_closest_perpendicular_point and utilities::get_cartesian_distance.
+// Do not reorder the arithmetic, or the results may differ in the last bit.
+
+#pragma region Scalar Kernels
+static inline double get_point_deviation_scalar(double x, double y, double center_x, double center_y, double radius)
+{
+  double x_dif = x - center_x;
+  double y_dif = y - center_y;
+  return utilities::abs(utilities::sqrt(x_dif * x_dif + y_dif * y_dif) - radius);
+}
+
+static inline double get_segment_deviation_scalar(double x1, double y1, double x2, double y2, double center_x, double center_y, double radius)
+{
+  double num = (center_x - x1) * (x2 - x1) + (center_y - y1) * (y2 - y1);
+  double x_dif = x2 - x1;
+  double y_dif = y2 - y1;
+  double denom = (x_dif * x_dif) + (y_dif * y_dif);
+  double t = num / denom;
+  // The closest point is one of the endpoints, which are tested separately.
+  if (t < 0 || utilities::abs(t) < ZERO_TOLERANCE || t > 1 || utilities::abs(t - 1) < ZERO_TOLERANCE)
+  {
+    return DEVIATION_KERNELS_NO_DEVIATION;
+  }
+  return get_point_deviation_scalar(x1 + t * (x2 - x1), y1 + t * (y2 - y1), center_x, center_y, radius);
+}
+
+static bool get_max_point_deviation_scalar(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  for (int index = start_index; index < end_index; index++)
+  {
+    double deviation = get_point_deviation_scalar(x[index], y[index], center_x, center_y, radius);
+    if (deviation > resolution_mm)
+    {
+      return false;
+    }
+    if (deviation > max_deviation)
+    {
+      max_deviation = deviation;
+    }
+  }
+  return true;
+}
+
+static bool get_max_segment_deviation_scalar(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  for (int index = start_index; index < end_index; index++)
+  {
+    double deviation = get_segment_deviation_scalar(x[index], y[index], x[index + 1], y[index + 1], center_x, center_y, radius);
+    if (deviation > resolution_mm)
+    {
+      return false;
+    }
+    if (deviation > max_deviation)
+    {
+      max_deviation = deviation;
+    }
+  }
+  return true;
+}
+#pragma endregion Scalar Kernels
+
+#if defined(DEVIATION_KERNELS_SSE2)
+#pragma region SSE2 Kernels
+static inline __m128d get_point_deviation_sse2(__m128d x, __m128d y, __m128d center_x, __m128d center_y, __m128d radius, __m128d sign_mask)
+{
+  __m128d x_dif = _mm_sub_pd(x, center_x);
+  __m128d y_dif = _mm_sub_pd(y, center_y);
+  __m128d distance = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x_dif, x_dif), _mm_mul_pd(y_dif, y_dif)));
+  return _mm_andnot_pd(sign_mask, _mm_sub_pd(distance, radius));
+}
+
+static inline __m128d get_segment_deviation_sse2(__m128d x1, __m128d y1, __m128d x2, __m128d y2, __m128d center_x, __m128d center_y, __m128d radius, __m128d sign_mask)
+{
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d zero_tolerance = _mm_set1_pd(ZERO_TOLERANCE);
+  __m128d x_dif = _mm_sub_pd(x2, x1);
+  __m128d y_dif = _mm_sub_pd(y2, y1);
+  __m128d num = _mm_add_pd(_mm_mul_pd(_mm_sub_pd(center_x, x1), x_dif), _mm_mul_pd(_mm_sub_pd(center_y, y1), y_dif));
+  __m128d denom = _mm_add_pd(_mm_mul_pd(x_dif, x_dif), _mm_mul_pd(y_dif, y_dif));
+  __m128d t = _mm_div_pd(num, denom);
+  __m128d skip = _mm_or_pd(
+    _mm_or_pd(_mm_cmplt_pd(t, zero), _mm_cmplt_pd(_mm_andnot_pd(sign_mask, t), zero_tolerance)),
+    _mm_or_pd(_mm_cmpgt_pd(t, one), _mm_cmplt_pd(_mm_andnot_pd(sign_mask, _mm_sub_pd(t, one)), zero_tolerance))
+  );
+  __m128d deviation = get_point_deviation_sse2(
+    _mm_add_pd(x1, _mm_mul_pd(t, x_dif)), _mm_add_pd(y1, _mm_mul_pd(t, y_dif)), center_x, center_y, radius, sign_mask
+  );
+  return _mm_or_pd(_mm_and_pd(skip, _mm_set1_pd(DEVIATION_KERNELS_NO_DEVIATION)), _mm_andnot_pd(skip, deviation));
+}
+
+static inline void update_max_deviation_sse2(__m128d max_deviations, double& max_deviation)
+{
+  double values[2];
+  _mm_storeu_pd(values, max_deviations);
+  for (int index = 0; index < 2; index++)
+  {
+    if (values[index] > max_deviation)
+    {
+      max_deviation = values[index];
+    }
+  }
+}
+
+static bool get_max_point_deviation_sse2(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  const __m128d sign_mask = _mm_set1_pd(-0.0);
+  const __m128d v_center_x = _mm_set1_pd(center_x);
+  const __m128d v_center_y = _mm_set1_pd(center_y);
+  const __m128d v_radius = _mm_set1_pd(radius);
+  const __m128d v_resolution = _mm_set1_pd(resolution_mm);
+  __m128d max_deviations = _mm_setzero_pd();
+  int index = start_index;
+  for (; index + 2 <= end_index; index += 2)
+  {
+    __m128d deviation = get_point_deviation_sse2(_mm_loadu_pd(x + index), _mm_loadu_pd(y + index), v_center_x, v_center_y, v_radius, sign_mask);
+    if (_mm_movemask_pd(_mm_cmpgt_pd(deviation, v_resolution)) != 0)
+    {
+      return false;
+    }
+    // The previous maximum is the second operand so that NaN deviations are ignored, just like the scalar comparison.
+    max_deviations = _mm_max_pd(deviation, max_deviations);
+  }
+  update_max_deviation_sse2(max_deviations, max_deviation);
+  return get_max_point_deviation_scalar(x, y, index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+}
+
+static bool get_max_segment_deviation_sse2(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  const __m128d sign_mask = _mm_set1_pd(-0.0);
+  const __m128d v_center_x = _mm_set1_pd(center_x);
+  const __m128d v_center_y = _mm_set1_pd(center_y);
+  const __m128d v_radius = _mm_set1_pd(radius);
+  const __m128d v_resolution = _mm_set1_pd(resolution_mm);
+  __m128d max_deviations = _mm_setzero_pd();
+  int index = start_index;
+  for (; index + 2 <= end_index; index += 2)
+  {
+    __m128d deviation = get_segment_deviation_sse2(
+      _mm_loadu_pd(x + index), _mm_loadu_pd(y + index), _mm_loadu_pd(x + index + 1), _mm_loadu_pd(y + index + 1),
+      v_center_x, v_center_y, v_radius, sign_mask
+    );
+    if (_mm_movemask_pd(_mm_cmpgt_pd(deviation, v_resolution)) != 0)
+    {
+      return false;
+    }
+    max_deviations = _mm_max_pd(deviation, max_deviations);
+  }
+  update_max_deviation_sse2(max_deviations, max_deviation);
+  return get_max_segment_deviation_scalar(x, y, index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+}
+
+static int get_point_deviations_sse2(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations)
+{
+  const __m128d sign_mask = _mm_set1_pd(-0.0);
+  const __m128d v_center_x = _mm_set1_pd(center_x);
+  const __m128d v_center_y = _mm_set1_pd(center_y);
+  const __m128d v_radius = _mm_set1_pd(radius);
+  int index = start_index;
+  for (; index + 2 <= end_index; index += 2)
+  {
+    _mm_storeu_pd(deviations + index - start_index, get_point_deviation_sse2(_mm_loadu_pd(x + index), _mm_loadu_pd(y + index), v_center_x, v_center_y, v_radius, sign_mask));
+  }
+  return index;
+}
+
+static int get_segment_deviations_sse2(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations)
+{
+  const __m128d sign_mask = _mm_set1_pd(-0.0);
+  const __m128d v_center_x = _mm_set1_pd(center_x);
+  const __m128d v_center_y = _mm_set1_pd(center_y);
+  const __m128d v_radius = _mm_set1_pd(radius);
+  int index = start_index;
+  for (; index + 2 <= end_index; index += 2)
+  {
+    _mm_storeu_pd(deviations + index - start_index, get_segment_deviation_sse2(
+      _mm_loadu_pd(x + index), _mm_loadu_pd(y + index), _mm_loadu_pd(x + index + 1), _mm_loadu_pd(y + index + 1),
+      v_center_x, v_center_y, v_radius, sign_mask
+    ));
+  }
+  return index;
+}
+#pragma endregion SSE2 Kernels
+#endif
+
+#if defined(DEVIATION_KERNELS_AVX)
+#pragma region AVX Kernels
+DEVIATION_KERNELS_AVX_TARGET static inline __m256d get_point_deviation_avx(__m256d x, __m256d y, __m256d center_x, __m256d center_y, __m256d radius, __m256d sign_mask)
+{
+  __m256d x_dif = _mm256_sub_pd(x, center_x);
+  __m256d y_dif = _mm256_sub_pd(y, center_y);
+  __m256d distance = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(x_dif, x_dif), _mm256_mul_pd(y_dif, y_dif)));
+  return _mm256_andnot_pd(sign_mask, _mm256_sub_pd(distance, radius));
+}
+
+DEVIATION_KERNELS_AVX_TARGET static inline __m256d get_segment_deviation_avx(__m256d x1, __m256d y1, __m256d x2, __m256d y2, __m256d center_x, __m256d center_y, __m256d radius, __m256d sign_mask)
+{
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d zero_tolerance = _mm256_set1_pd(ZERO_TOLERANCE);
+  __m256d x_dif = _mm256_sub_pd(x2, x1);
+  __m256d y_dif = _mm256_sub_pd(y2, y1);
+  __m256d num = _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(center_x, x1), x_dif), _mm256_mul_pd(_mm256_sub_pd(center_y, y1), y_dif));
+  __m256d denom = _mm256_add_pd(_mm256_mul_pd(x_dif, x_dif), _mm256_mul_pd(y_dif, y_dif));
+  __m256d t = _mm256_div_pd(num, denom);
+  __m256d skip = _mm256_or_pd(
+    _mm256_or_pd(_mm256_cmp_pd(t, zero, _CMP_LT_OQ), _mm256_cmp_pd(_mm256_andnot_pd(sign_mask, t), zero_tolerance, _CMP_LT_OQ)),
+    _mm256_or_pd(_mm256_cmp_pd(t, one, _CMP_GT_OQ), _mm256_cmp_pd(_mm256_andnot_pd(sign_mask, _mm256_sub_pd(t, one)), zero_tolerance, _CMP_LT_OQ))
+  );
+  __m256d deviation = get_point_deviation_avx(
+    _mm256_add_pd(x1, _mm256_mul_pd(t, x_dif)), _mm256_add_pd(y1, _mm256_mul_pd(t, y_dif)), center_x, center_y, radius, sign_mask
+  );
+  return _mm256_blendv_pd(deviation, _mm256_set1_pd(DEVIATION_KERNELS_NO_DEVIATION), skip);
+}
+
+DEVIATION_KERNELS_AVX_TARGET static inline void update_max_deviation_avx(__m256d max_deviations, double& max_deviation)
+{
+  double values[4];
+  _mm256_storeu_pd(values, max_deviations);
+  for (int index = 0; index < 4; index++)
+  {
+    if (values[index] > max_deviation)
+    {
+      max_deviation = values[index];
+    }
+  }
+}
+
+DEVIATION_KERNELS_AVX_TARGET static bool get_max_point_deviation_avx(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  const __m256d sign_mask = _mm256_set1_pd(-0.0);
+  const __m256d v_center_x = _mm256_set1_pd(center_x);
+  const __m256d v_center_y = _mm256_set1_pd(center_y);
+  const __m256d v_radius = _mm256_set1_pd(radius);
+  const __m256d v_resolution = _mm256_set1_pd(resolution_mm);
+  __m256d max_deviations = _mm256_setzero_pd();
+  int index = start_index;
+  for (; index + 4 <= end_index; index += 4)
+  {
+    __m256d deviation = get_point_deviation_avx(_mm256_loadu_pd(x + index), _mm256_loadu_pd(y + index), v_center_x, v_center_y, v_radius, sign_mask);
+    if (_mm256_movemask_pd(_mm256_cmp_pd(deviation, v_resolution, _CMP_GT_OQ)) != 0)
+    {
+      return false;
+    }
+    max_deviations = _mm256_max_pd(deviation, max_deviations);
+  }
+  update_max_deviation_avx(max_deviations, max_deviation);
+  return get_max_point_deviation_scalar(x, y, index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+}
+
+DEVIATION_KERNELS_AVX_TARGET static bool get_max_segment_deviation_avx(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  const __m256d sign_mask = _mm256_set1_pd(-0.0);
+  const __m256d v_center_x = _mm256_set1_pd(center_x);
+  const __m256d v_center_y = _mm256_set1_pd(center_y);
+  const __m256d v_radius = _mm256_set1_pd(radius);
+  const __m256d v_resolution = _mm256_set1_pd(resolution_mm);
+  __m256d max_deviations = _mm256_setzero_pd();
+  int index = start_index;
+  for (; index + 4 <= end_index; index += 4)
+  {
+    __m256d deviation = get_segment_deviation_avx(
+      _mm256_loadu_pd(x + index), _mm256_loadu_pd(y + index), _mm256_loadu_pd(x + index + 1), _mm256_loadu_pd(y + index + 1),
+      v_center_x, v_center_y, v_radius, sign_mask
+    );
+    if (_mm256_movemask_pd(_mm256_cmp_pd(deviation, v_resolution, _CMP_GT_OQ)) != 0)
+    {
+      return false;
+    }
+    max_deviations = _mm256_max_pd(deviation, max_deviations);
+  }
+  update_max_deviation_avx(max_deviations, max_deviation);
+  return get_max_segment_deviation_scalar(x, y, index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+}
+
+DEVIATION_KERNELS_AVX_TARGET static int get_point_deviations_avx(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations)
+{
+  const __m256d sign_mask = _mm256_set1_pd(-0.0);
+  const __m256d v_center_x = _mm256_set1_pd(center_x);
+  const __m256d v_center_y = _mm256_set1_pd(center_y);
+  const __m256d v_radius = _mm256_set1_pd(radius);
+  int index = start_index;
+  for (; index + 4 <= end_index; index += 4)
+  {
+    _mm256_storeu_pd(deviations + index - start_index, get_point_deviation_avx(_mm256_loadu_pd(x + index), _mm256_loadu_pd(y + index), v_center_x, v_center_y, v_radius, sign_mask));
+  }
+  return index;
+}
+
+DEVIATION_KERNELS_AVX_TARGET static int get_segment_deviations_avx(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations)
+{
+  const __m256d sign_mask = _mm256_set1_pd(-0.0);
+  const __m256d v_center_x = _mm256_set1_pd(center_x);
+  const __m256d v_center_y = _mm256_set1_pd(center_y);
+  const __m256d v_radius = _mm256_set1_pd(radius);
+  int index = start_index;
+  for (; index + 4 <= end_index; index += 4)
+  {
+    _mm256_storeu_pd(deviations + index - start_index, get_segment_deviation_avx(
+      _mm256_loadu_pd(x + index), _mm256_loadu_pd(y + index), _mm256_loadu_pd(x + index + 1), _mm256_loadu_pd(y + index + 1),
+      v_center_x, v_center_y, v_radius, sign_mask
+    ));
+  }
+  return index;
+}
+#pragma endregion AVX Kernels
+#endif
+
+static deviation_kernels::instruction_set detect_instruction_set()
+{
+#if defined(DEVIATION_KERNELS_AVX)
+#if defined(_MSC_VER)
+  int cpu_info[4];
+  __cpuid(cpu_info, 1);
+  // AVX requires both CPU support and an OS that saves the YMM registers (OSXSAVE + XCR0 bits 1 and 2).
+  bool has_osxsave = (cpu_info[2] & (1 << 27)) != 0;
+  bool has_avx = (cpu_info[2] & (1 << 28)) != 0;
+  if (has_osxsave && has_avx && (_xgetbv(0) & 0x6) == 0x6)
+  {
+    return deviation_kernels::AVX;
+  }
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx"))
+  {
+    return deviation_kernels::AVX;
+  }
+#endif
+#endif
+#if defined(DEVIATION_KERNELS_SSE2)
+  return deviation_kernels::SSE2;
+#else
+  return deviation_kernels::SCALAR;
+#endif
+}
+
+deviation_kernels::instruction_set deviation_kernels::get_instruction_set()
+{
+  static const instruction_set detected_instruction_set = detect_instruction_set();
+  return detected_instruction_set;
+}
+
+const char* deviation_kernels::get_instruction_set_name(instruction_set value)
+{
+  switch (value)
+  {
+  case AVX:
+    return "AVX";
+  case SSE2:
+    return "SSE2";
+  default:
+    return "SCALAR";
+  }
+}
+
+bool deviation_kernels::get_max_point_deviation(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  switch (get_instruction_set())
+  {
+#if defined(DEVIATION_KERNELS_AVX)
+  case AVX:
+    return get_max_point_deviation_avx(x, y, start_index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+#endif
+#if defined(DEVIATION_KERNELS_SSE2)
+  case SSE2:
+    return get_max_point_deviation_sse2(x, y, start_index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+#endif
+  default:
+    return get_max_point_deviation_scalar(x, y, start_index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+  }
+}
+
+bool deviation_kernels::get_max_segment_deviation(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation)
+{
+  switch (get_instruction_set())
+  {
+#if defined(DEVIATION_KERNELS_AVX)
+  case AVX:
+    return get_max_segment_deviation_avx(x, y, start_index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+#endif
+#if defined(DEVIATION_KERNELS_SSE2)
+  case SSE2:
+    return get_max_segment_deviation_sse2(x, y, start_index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+#endif
+  default:
+    return get_max_segment_deviation_scalar(x, y, start_index, end_index, center_x, center_y, radius, resolution_mm, max_deviation);
+  }
+}
+
+void deviation_kernels::get_point_deviations(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations)
+{
+  int index = start_index;
+  switch (get_instruction_set())
+  {
+#if defined(DEVIATION_KERNELS_AVX)
+  case AVX:
+    index = get_point_deviations_avx(x, y, start_index, end_index, center_x, center_y, radius, deviations);
+    break;
+#endif
+#if defined(DEVIATION_KERNELS_SSE2)
+  case SSE2:
+    index = get_point_deviations_sse2(x, y, start_index, end_index, center_x, center_y, radius, deviations);
+    break;
+#endif
+  default:
+    break;
+  }
+  // Finish any remaining points
+  for (; index < end_index; index++)
+  {
+    deviations[index - start_index] = get_point_deviation_scalar(x[index], y[index], center_x, center_y, radius);
+  }
+}
+
+void deviation_kernels::get_segment_deviations(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations)
+{
+  int index = start_index;
+  switch (get_instruction_set())
+  {
+#if defined(DEVIATION_KERNELS_AVX)
+  case AVX:
+    index = get_segment_deviations_avx(x, y, start_index, end_index, center_x, center_y, radius, deviations);
+    break;
+#endif
+#if defined(DEVIATION_KERNELS_SSE2)
+  case SSE2:
+    index = get_segment_deviations_sse2(x, y, start_index, end_index, center_x, center_y, radius, deviations);
+    break;
+#endif
+  default:
+    break;
+  }
+  // Finish any remaining segments
+  for (; index < end_index; index++)
+  {
+    deviations[index - start_index] = get_segment_deviation_scalar(x[index], y[index], x[index + 1], y[index + 1], center_x, center_y, radius);
+  }
+}
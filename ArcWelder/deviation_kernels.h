@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+// Vectorized kernels that measure how far a list of points, and the segments between them, deviate from a circle.
+// The coordinates are read from separate x and y arrays.  SSE2 is used on all x86/x64 builds, AVX is used when the
+// CPU supports it, and everything else falls back to plain scalar code.  Every kernel produces exactly the same
+// results as the scalar code, so the selected instruction set never changes the generated gcode.
+// Define DEVIATION_KERNELS_SCALAR_ONLY to disable the vectorized kernels.
+
+#if !defined(DEVIATION_KERNELS_SCALAR_ONLY) && (defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DEVIATION_KERNELS_SSE2
+#if (defined(_MSC_FULL_VER) && _MSC_FULL_VER >= 160040219) || (defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 8))) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define DEVIATION_KERNELS_AVX
+#endif
+#endif
+
+// The number of deviations calculated at a time when the results must be summed in order.
+#define DEVIATION_KERNELS_BLOCK_SIZE 64
+// Returned by get_segment_deviations when the perpendicular point falls outside of the segment.
+#define DEVIATION_KERNELS_NO_DEVIATION -1.0
+
+namespace deviation_kernels
+{
+	enum instruction_set { SCALAR = 0, SSE2 = 1, AVX = 2 };
+
+	/// <summary>
+	/// Returns the instruction set used by the kernels, which is detected once.
+	/// </summary>
+	instruction_set get_instruction_set();
+
+	/// <summary>
+	/// Returns a displayable name for an instruction set.
+	/// </summary>
+	const char* get_instruction_set_name(instruction_set value);
+
+	/// <summary>
+	/// Finds the maximum distance between the circle and the points in the range [start_index, end_index).
+	/// max_deviation is only ever increased, so it can be shared between calls.
+	/// </summary>
+	/// <returns>False if any point deviates more than resolution_mm, else true.</returns>
+	bool get_max_point_deviation(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation);
+
+	/// <summary>
+	/// Finds the maximum distance between the circle and the point on each segment closest to the circle's center.  Segment i
+	/// runs from point i to point i + 1, and segments in the range [start_index, end_index) are tested.  Segments whose closest
+	/// point is one of their endpoints are skipped.  max_deviation is only ever increased.
+	/// </summary>
+	/// <returns>False if any segment deviates more than resolution_mm, else true.</returns>
+	bool get_max_segment_deviation(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double resolution_mm, double& max_deviation);
+
+	/// <summary>
+	/// Writes the distance between the circle and each point in the range [start_index, end_index) to deviations,
+	/// starting at deviations[0].
+	/// </summary>
+	void get_point_deviations(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations);
+
+	/// <summary>
+	/// Writes the segment deviation for each segment in the range [start_index, end_index) to deviations, starting at
+	/// deviations[0].  Segments that are skipped are set to DEVIATION_KERNELS_NO_DEVIATION.
+	/// </summary>
+	void get_segment_deviations(const double* x, const double* y, int start_index, int end_index, double center_x, double center_y, double radius, double* deviations);
+}
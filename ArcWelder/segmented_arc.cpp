@@ -39,7 +39,8 @@ segmented_arc::segmented_arc() : segmented_shape(DEFAULT_MIN_SEGMENTS, DEFAULT_M
   max_gcode_length_ = DEFAULT_MAX_GCODE_LENGTH;
   num_gcode_length_exceptions_ = 0;
   num_firmware_compensations_ = 0;
-  
+  exact_arc_fitting_ = DEFAULT_EXACT_ARC_FITTING;
+  num_shape_arc_fit_attempts_ = 0;
 }
 
 segmented_arc::segmented_arc(
@@ -53,7 +54,8 @@ segmented_arc::segmented_arc(
   bool allow_3d_arcs,
   unsigned char default_xyz_precision,
   unsigned char default_e_precision,
-  int max_gcode_length
+  int max_gcode_length,
+  bool exact_arc_fitting
 ) : segmented_shape(min_segments, max_segments, resolution_mm, path_tolerance_percent, default_xyz_precision, default_e_precision)
 {
   max_radius_mm_ = max_radius_mm;
@@ -78,14 +80,20 @@ segmented_arc::segmented_arc(
   }
   num_firmware_compensations_ = 0;
   num_gcode_length_exceptions_ = 0;
-  
-
+  exact_arc_fitting_ = exact_arc_fitting;
+  num_shape_arc_fit_attempts_ = 0;
 }
 
 segmented_arc::~segmented_arc()
 {
 }
 
+void segmented_arc::clear()
+{
+  segmented_shape::clear();
+  num_shape_arc_fit_attempts_ = 0;
+}
+
 printer_point segmented_arc::pop_front(double e_relative)
 {
   e_relative_ -= e_relative;
@@ -93,12 +101,12 @@ printer_point segmented_arc::pop_front(double e_relative)
   {
     set_is_shape(false);
   }
-  return points_.pop_front();
+  return segmented_shape::pop_front();
 }
 printer_point segmented_arc::pop_back(double e_relative)
 {
   e_relative_ -= e_relative;
-  return points_.pop_back();
+  return segmented_shape::pop_back();
   if (points_.count() == get_min_segments())
   {
     set_is_shape(false);
@@ -122,11 +130,21 @@ int segmented_arc::get_num_gcode_length_exceptions() const
 {
   return num_gcode_length_exceptions_;
 }
+
+int segmented_arc::get_num_shape_arc_fit_attempts() const
+{
+  return num_shape_arc_fit_attempts_;
+}
 double segmented_arc::get_mm_per_arc_segment() const
 {
   return mm_per_arc_segment_;
 }
 
+bool segmented_arc::get_exact_arc_fitting() const
+{
+  return exact_arc_fitting_;
+}
+
 bool segmented_arc::is_shape() const
 {
   return is_shape_;
@@ -184,6 +202,8 @@ bool segmented_arc::try_add_point(printer_point p)
   {
     point_added = true;
     points_.push_back(p);
+    coordinates_.push_back(p);
+    circle_fit_.add(p);
     original_shape_length_ += p.distance;
   }
   else
@@ -205,7 +225,7 @@ bool segmented_arc::try_add_point(printer_point p)
   {
     // If we haven't added a point, and we have exactly min_segments_,
     // pull off the initial arc point and try again
-    points_.pop_front();
+    segmented_shape::pop_front();
     // Get the new initial point
     printer_point new_initial_point = points_[0];
     // The length and e_relative distance of the arc has been reduced 
@@ -226,10 +246,42 @@ bool segmented_arc::try_add_point_internal_(printer_point p)
 
   // the circle is new..  we have to test it now, which is expensive :(
   points_.push_back(p);
+  coordinates_.push_back(p);
+  circle_fit_sums previous_circle_fit = circle_fit_;
+  circle_fit_.add(p);
   double previous_shape_length = original_shape_length_;
   original_shape_length_ += p.distance;
   arc original_arc = current_arc_;
-  if (arc::try_create_arc(points_, current_arc_, original_shape_length_, max_radius_mm_, resolution_mm_, path_tolerance_percent_, min_arc_segments_, mm_per_arc_segment_, get_xyz_tolerance(), allow_3d_arcs_))
+  bool arc_created;
+#ifdef STAGE_TIMING
+  num_shape_arc_fit_attempts_++;
+#endif
+  if (exact_arc_fitting_ || points_.count() <= INCREMENTAL_FIT_MIN_POINTS)
+  {
+    // Searching every point is cheap for short shapes, and finds more arcs than the least squares fit.
+    arc_created = arc::try_create_arc(points_, coordinates_, current_arc_, original_shape_length_, max_radius_mm_, resolution_mm_, path_tolerance_percent_, min_arc_segments_, mm_per_arc_segment_, get_xyz_tolerance(), allow_3d_arcs_, true);
+    if (arc_created)
+    {
+      // Every point is within our resolution of this circle, which is all the incremental fit needs to know.
+      current_arc_.max_deviation = resolution_mm_;
+    }
+  }
+  else
+  {
+    arc_created = try_create_arc_incremental_();
+    if (!arc_created)
+    {
+      // The running circle isn't always the one that fits, so try a few other circles before ending the arc.  Each
+      // is tested once, so this stays linear in the number of points.  Unlike the exact search, this can end some
+      // arcs sooner.
+      arc_created = arc::try_create_arc(points_, coordinates_, current_arc_, original_shape_length_, max_radius_mm_, resolution_mm_, path_tolerance_percent_, min_arc_segments_, mm_per_arc_segment_, get_xyz_tolerance(), allow_3d_arcs_, false);
+      if (arc_created)
+      {
+        current_arc_.max_deviation = resolution_mm_;
+      }
+    }
+  }
+  if (arc_created)
   {
     bool abort_arc = false;
     if (max_gcode_length_ > 0 && get_shape_gcode_length() > max_gcode_length_)
@@ -285,13 +337,71 @@ bool segmented_arc::try_add_point_internal_(printer_point p)
   }
   // Can't create the arc.  Remove the point and remove the previous segment length.
   points_.pop_back();
+  coordinates_.pop_back();
+  circle_fit_ = previous_circle_fit;
   original_shape_length_ = previous_shape_length;
   return false;
 }
 
+bool segmented_arc::try_create_arc_incremental_()
+{
+  // Get the best fit circle through the first and last point from the running sums.  This is constant time
+  // regardless of the number of points in the shape.
+  int count = points_.count();
+  circle test_circle;
+  if (!circle_fit_.try_get_circle(points_[count - 1], max_radius_mm_, test_circle))
+  {
+    return false;
+  }
+
+  // Test the most recent point and segment first, which rejects most bad points without visiting the whole shape.
+  double max_deviation;
+  if (!test_circle.get_max_deviation(coordinates_, count - 2, resolution_mm_, get_xyz_tolerance(), false, max_deviation))
+  {
+    return false;
+  }
+
+  // Every other point was within current_arc_.max_deviation of the previous circle.  Moving the center and
+  // changing the radius can add at most the distance moved plus the change in radius to that deviation, so
+  // if the sum is still within our resolution there is no need to test the other points again.
+  double bound = resolution_mm_ + 1;
+  if (is_shape() && !allow_3d_arcs_)
+  {
+    bound = current_arc_.max_deviation
+      + utilities::get_cartesian_distance(test_circle.center.x, test_circle.center.y, current_arc_.center.x, current_arc_.center.y)
+      + utilities::abs(test_circle.radius - current_arc_.radius);
+  }
+  if (bound <= resolution_mm_)
+  {
+    if (bound > max_deviation)
+    {
+      max_deviation = bound;
+    }
+  }
+  else if (!test_circle.get_max_deviation(coordinates_, 0, resolution_mm_, get_xyz_tolerance(), allow_3d_arcs_, max_deviation))
+  {
+    return false;
+  }
+
+  arc test_arc;
+  if (!arc::try_create_arc(test_circle, points_, test_arc, original_shape_length_, resolution_mm_, path_tolerance_percent_, allow_3d_arcs_))
+  {
+    return false;
+  }
+  test_arc.max_deviation = max_deviation;
+  current_arc_ = test_arc;
+  return true;
+}
+
 std::string segmented_arc::get_shape_gcode() const
 {
   std::string gcode;
+  append_shape_gcode(gcode);
+  return gcode;
+}
+
+void segmented_arc::append_shape_gcode(std::string& gcode) const
+{
   double e = current_arc_.end_point.is_extruder_relative ? e_relative_ : current_arc_.end_point.e_offset;
   double f = current_arc_.start_point.f == current_arc_.end_point.f ? 0 : current_arc_.end_point.f;
   bool has_e = e_relative_ != 0;
@@ -299,60 +409,60 @@ std::string segmented_arc::get_shape_gcode() const
   bool has_z = allow_3d_arcs_ && !utilities::is_equal(
     current_arc_.start_point.z, current_arc_.end_point.z, get_xyz_tolerance()
   );
-  gcode.reserve(96);
+  unsigned char xyz_precision = get_xyz_precision();
 
-  if (current_arc_.angle_radians < 0)
-  {
-    gcode += "G2";
-  }
-  else
-  {
-    gcode += "G3";
-
-  }
+  // Every parameter is formatted directly into this buffer, which easily holds the longest possible command.
+  char buffer[GCODE_CHAR_BUFFER_SIZE];
+  char* p = buffer;
+  *p++ = 'G';
+  *p++ = current_arc_.angle_radians < 0 ? '2' : '3';
   // TODO: Limit Gcode Precision based on max_gcode_length
 
 
   // Add X, Y, I and J
-  gcode += " X";
-  gcode += utilities::dtos(current_arc_.end_point.x, get_xyz_precision());
+  *p++ = ' ';
+  *p++ = 'X';
+  utilities::append_fixed(p, current_arc_.end_point.x, xyz_precision);
   
-  gcode += " Y";
-  gcode += utilities::dtos(current_arc_.end_point.y, get_xyz_precision());
+  *p++ = ' ';
+  *p++ = 'Y';
+  utilities::append_fixed(p, current_arc_.end_point.y, xyz_precision);
   
   if (has_z)
   {
-    gcode += " Z";
-    gcode += utilities::dtos(current_arc_.end_point.z, get_xyz_precision());
+    *p++ = ' ';
+    *p++ = 'Z';
+    utilities::append_fixed(p, current_arc_.end_point.z, xyz_precision);
   }
 
   // Output I and J, but do NOT check for 0.  
   // Simplify 3d has issues visualizing G2/G3 with 0 for I or J
   // and until it is fixed, it is not worth the hassle.
-  double i = current_arc_.get_i();
-  gcode += " I";
-  gcode += utilities::dtos(i, get_xyz_precision());
+  *p++ = ' ';
+  *p++ = 'I';
+  utilities::append_fixed(p, current_arc_.get_i(), xyz_precision);
 
-  double j = current_arc_.get_j();
-  gcode += " J";
-  gcode += utilities::dtos(j, get_xyz_precision());
+  *p++ = ' ';
+  *p++ = 'J';
+  utilities::append_fixed(p, current_arc_.get_j(), xyz_precision);
 
   // Add E if it appears
   if (has_e)
   {
-    gcode += " E";
-    gcode += utilities::dtos(e, get_e_precision());
+    *p++ = ' ';
+    *p++ = 'E';
+    utilities::append_fixed(p, e, get_e_precision());
   }
 
   // Add F if it appears
   if (has_f)
   {
-    gcode += " F";
-    gcode += utilities::dtos(f, 0);
+    *p++ = ' ';
+    *p++ = 'F';
+    utilities::append_fixed(p, f, 0);
   }
 
-  return gcode;
-
+  gcode.append(buffer, p - buffer);
 }
 
 int segmented_arc::get_shape_gcode_length()
@@ -26,6 +26,8 @@
 #pragma once
 #include "segmented_shape.h"
 #define GCODE_CHAR_BUFFER_SIZE 1000
+// Shapes with this many points or fewer are always fit by searching every point.
+#define INCREMENTAL_FIT_MIN_POINTS 10
 
 class segmented_arc :
 	public segmented_shape
@@ -43,12 +45,18 @@ public:
 		bool allow_3d_arcs = DEFAULT_ALLOW_3D_ARCS,
 		unsigned char default_xyz_precision = DEFAULT_XYZ_PRECISION,
 		unsigned char default_e_precision = DEFAULT_E_PRECISION,
-		int max_gcode_length = DEFAULT_MAX_GCODE_LENGTH
+		int max_gcode_length = DEFAULT_MAX_GCODE_LENGTH,
+		bool exact_arc_fitting = DEFAULT_EXACT_ARC_FITTING
 	);
 	virtual ~segmented_arc();
 	virtual bool try_add_point(printer_point p);
+	virtual void clear();
 	virtual double get_shape_length();
 	std::string get_shape_gcode() const;
+	/// <summary>
+	/// Appends the G2/G3 command for the current arc to gcode without creating any intermediate strings.
+	/// </summary>
+	void append_shape_gcode(std::string& gcode) const;
 	int get_shape_gcode_length();
 	virtual bool is_shape() const;
 	printer_point pop_front(double e_relative);
@@ -58,8 +66,15 @@ public:
 	double get_mm_per_arc_segment() const;
 	int get_num_firmware_compensations() const;
 	int get_num_gcode_length_exceptions() const;
+	bool get_exact_arc_fitting() const;
+	/// <summary>
+	/// The number of times an arc was fit to the current shape since it was cleared.  Only counted when STAGE_TIMING is
+	/// defined.
+	/// </summary>
+	int get_num_shape_arc_fit_attempts() const;
 private:
 	bool try_add_point_internal_(printer_point p);
+	bool try_create_arc_incremental_();
 	arc current_arc_;
 	double max_radius_mm_;
 	int min_arc_segments_;
@@ -68,5 +83,7 @@ private:
 	bool allow_3d_arcs_;
 	int max_gcode_length_;
 	int num_gcode_length_exceptions_;
+	bool exact_arc_fitting_;
+	int num_shape_arc_fit_attempts_;
 };															
 
@@ -24,9 +24,11 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "segmented_shape.h"
+#include "deviation_kernels.h"
 #include <stdio.h>
 #include "utilities.h"
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #pragma region Operators for Vector and Point
 
@@ -151,6 +153,75 @@ double vector::cross_product_magnitude(vector v1, vector v2)
 #pragma endregion Distance Calculation Source
 
 
+#pragma region Coordinate Buffer Functions
+coordinate_buffer::coordinate_buffer()
+{
+  front_index_ = 0;
+}
+
+void coordinate_buffer::push_back(const point& p)
+{
+  x_.push_back(p.x);
+  y_.push_back(p.y);
+  z_.push_back(p.z);
+}
+
+void coordinate_buffer::pop_front()
+{
+  // Removing points from the front is rare, so just move the front index.  The space is reclaimed by clear().
+  front_index_++;
+  if (front_index_ >= static_cast<int>(x_.size()))
+  {
+    clear();
+  }
+}
+
+void coordinate_buffer::pop_back()
+{
+  x_.pop_back();
+  y_.pop_back();
+  z_.pop_back();
+  if (front_index_ >= static_cast<int>(x_.size()))
+  {
+    clear();
+  }
+}
+
+void coordinate_buffer::clear()
+{
+  // clear() does not release the memory, so the buffer stops allocating once it has grown to the longest shape.
+  x_.clear();
+  y_.clear();
+  z_.clear();
+  front_index_ = 0;
+}
+
+int coordinate_buffer::count() const
+{
+  return static_cast<int>(x_.size()) - front_index_;
+}
+
+point coordinate_buffer::get_point(int index) const
+{
+  return point(x_[front_index_ + index], y_[front_index_ + index], z_[front_index_ + index]);
+}
+
+const double* coordinate_buffer::x() const
+{
+  return x_.empty() ? NULL : &x_[front_index_];
+}
+
+const double* coordinate_buffer::y() const
+{
+  return y_.empty() ? NULL : &y_[front_index_];
+}
+
+const double* coordinate_buffer::z() const
+{
+  return z_.empty() ? NULL : &z_[front_index_];
+}
+#pragma endregion Coordinate Buffer Functions
+
 #pragma region Circle Functions
 
 bool circle::try_create_circle(const point& p1, const point& p2, const point& p3, const double max_radius, circle& new_circle)
@@ -195,19 +266,46 @@ bool circle::try_create_circle(const point& p1, const point& p2, const point& p3
   return true;
 }
 
-bool circle::try_create_circle(const array_list<printer_point>& points, const double max_radius, const double resolution_mm, const double xyz_tolerance, bool allow_3d_arcs, circle& new_circle)
+bool circle::try_create_circle(const coordinate_buffer& coordinates, const double max_radius, const double resolution_mm, const double xyz_tolerance, bool allow_3d_arcs, bool exact_arc_fitting, circle& new_circle)
 {
-  int count = points.count();
+  int count = coordinates.count();
   int middle_index = count / 2;
   int end_index = count - 1;
   
 
   
-  if (circle::try_create_circle(points[0], points[middle_index], points[end_index], max_radius, new_circle) && !new_circle.is_over_deviation(points, resolution_mm, xyz_tolerance, allow_3d_arcs))
+  point start_point = coordinates.get_point(0);
+  point end_point = coordinates.get_point(end_index);
+  if (circle::try_create_circle(start_point, coordinates.get_point(middle_index), end_point, max_radius, new_circle) && !new_circle.is_over_deviation(coordinates, resolution_mm, xyz_tolerance, allow_3d_arcs))
   {
     return true;
   }
   
+  if (!exact_arc_fitting)
+  {
+    // Fit a single circle to every point, then try a few more circles through the end points.  Each circle is tested
+    // once, so this is linear in the number of points.
+    circle fit_circle;
+    if (circle::try_fit_circle(coordinates, max_radius, fit_circle) && !fit_circle.is_over_deviation(coordinates, resolution_mm, xyz_tolerance, allow_3d_arcs))
+    {
+      new_circle = fit_circle;
+      return true;
+    }
+    for (int candidate = 1; candidate <= CIRCLE_FIT_CANDIDATES; candidate++)
+    {
+      int index = candidate * count / (CIRCLE_FIT_CANDIDATES + 1);
+      if (index <= 0 || index >= end_index || index == middle_index)
+        continue;
+      circle test_circle;
+      if (circle::try_create_circle(start_point, coordinates.get_point(index), end_point, max_radius, test_circle) && !test_circle.is_over_deviation(coordinates, resolution_mm, xyz_tolerance, allow_3d_arcs))
+      {
+        new_circle = test_circle;
+        return true;
+      }
+    }
+    return false;
+  }
+
        /*
   // This could be a near complete circle.  In that case, the endpoints might be too close together to generate an accurate circle with the 
   // precision we have to work with.  Let's adjust our circle into thirds and test those points as a last ditch effort.
@@ -223,7 +321,7 @@ bool circle::try_create_circle(const array_list<printer_point>& points, const do
   }
   return false;
          */
-  
+
   // Find the circle with the least deviation, if one exists.
   // Note, this could possibly take a LONG time in the worst case, but it's a pretty unlikely.
   // However, if the midpoint check doesn't pass, it's worth it to spend a bit more time 
@@ -242,7 +340,7 @@ bool circle::try_create_circle(const array_list<printer_point>& points, const do
     }
     circle test_circle;
     double current_deviation;
-    if (circle::try_create_circle(points[0], points[index], points[count - 1], max_radius, test_circle) && test_circle.get_deviation_sum_squared(points, resolution_mm, xyz_tolerance, allow_3d_arcs, current_deviation))
+    if (circle::try_create_circle(start_point, coordinates.get_point(index), end_point, max_radius, test_circle) && test_circle.get_deviation_sum_squared(coordinates, resolution_mm, xyz_tolerance, allow_3d_arcs, current_deviation))
     {
       
       if (!found_circle || current_deviation < least_deviation)
@@ -257,6 +355,117 @@ bool circle::try_create_circle(const array_list<printer_point>& points, const do
   
 }
 
+bool circle::try_fit_circle(const coordinate_buffer& coordinates, const double max_radius, circle& new_circle)
+{
+  // Taubin's algebraic fit, solved with Newton's method as described by Chernov in 'Circular and Linear Regression:
+  // Fitting Circles and Lines by Least Squares'.  The moments are taken about the centroid to limit rounding errors.
+  int count = coordinates.count();
+  if (count < 3)
+  {
+    return false;
+  }
+  const double* x = coordinates.x();
+  const double* y = coordinates.y();
+  double mean_x = 0;
+  double mean_y = 0;
+  for (int index = 0; index < count; index++)
+  {
+    mean_x += x[index];
+    mean_y += y[index];
+  }
+  mean_x /= count;
+  mean_y /= count;
+
+  double m_xx = 0, m_yy = 0, m_xy = 0, m_xz = 0, m_yz = 0, m_zz = 0;
+  for (int index = 0; index < count; index++)
+  {
+    double xi = x[index] - mean_x;
+    double yi = y[index] - mean_y;
+    double zi = xi * xi + yi * yi;
+    m_xx += xi * xi;
+    m_yy += yi * yi;
+    m_xy += xi * yi;
+    m_xz += xi * zi;
+    m_yz += yi * zi;
+    m_zz += zi * zi;
+  }
+  m_xx /= count;
+  m_yy /= count;
+  m_xy /= count;
+  m_xz /= count;
+  m_yz /= count;
+  m_zz /= count;
+
+  // The coefficients of the characteristic polynomial, whose smallest positive root gives the circle.
+  double m_z = m_xx + m_yy;
+  double cov_xy = m_xx * m_yy - m_xy * m_xy;
+  double var_z = m_zz - m_z * m_z;
+  double a3 = 4.0 * m_z;
+  double a2 = -3.0 * m_z * m_z - m_zz;
+  double a1 = var_z * m_z + 4.0 * cov_xy * m_z - m_xz * m_xz - m_yz * m_yz;
+  double a0 = m_xz * (m_xz * m_yy - m_yz * m_xy) + m_yz * (m_yz * m_xx - m_xz * m_xy) - var_z * cov_xy;
+
+  // Newton's method starting at zero converges to the root within a few iterations.
+  double root = 0;
+  double value = a0;
+  for (int iteration = 0; iteration < CIRCLE_FIT_MAX_ITERATIONS; iteration++)
+  {
+    double derivative = a1 + root * (2.0 * a2 + 3.0 * a3 * root);
+    double new_root = root - value / derivative;
+    if (new_root == root || !std::isfinite(new_root))
+    {
+      break;
+    }
+    double new_value = a0 + new_root * (a1 + new_root * (a2 + new_root * a3));
+    if (utilities::abs(new_value) >= utilities::abs(value))
+    {
+      break;
+    }
+    root = new_root;
+    value = new_value;
+  }
+
+  double determinant = root * root - root * m_z + cov_xy;
+  if (utilities::is_zero(determinant, 0.000000001))
+  {
+    // The points are colinear.
+    return false;
+  }
+  double center_x = (m_xz * (m_yy - root) - m_yz * m_xy) / determinant / 2.0 + mean_x;
+  double center_y = (m_yz * (m_xx - root) - m_xz * m_xy) / determinant / 2.0 + mean_y;
+
+  // The arc runs from the first point to the last point, so both must be on the circle.  Move the center to the
+  // closest point on their perpendicular bisector.
+  double start_x = x[0];
+  double start_y = y[0];
+  double chord_x = x[count - 1] - start_x;
+  double chord_y = y[count - 1] - start_y;
+  double chord_length_squared = chord_x * chord_x + chord_y * chord_y;
+  if (chord_length_squared > 0)
+  {
+    double mid_x = start_x + chord_x / 2.0;
+    double mid_y = start_y + chord_y / 2.0;
+    // Remove the component of the offset from the midpoint that runs along the chord.
+    double t = ((center_x - mid_x) * chord_x + (center_y - mid_y) * chord_y) / chord_length_squared;
+    center_x -= t * chord_x;
+    center_y -= t * chord_y;
+  }
+  if (!std::isfinite(center_x) || !std::isfinite(center_y))
+  {
+    return false;
+  }
+  double radius = utilities::get_cartesian_distance(center_x, center_y, start_x, start_y);
+  if (radius > max_radius)
+  {
+    return false;
+  }
+  new_circle.center.x = center_x;
+  new_circle.center.y = center_y;
+  new_circle.center.z = coordinates.z()[0];
+  new_circle.radius = radius;
+  return true;
+}
+
 double circle::get_polar_radians(const point& p1) const
 {
   double polar_radians = utilities::atan2(p1.y - center.y, p1.x - center.x);
@@ -265,49 +474,48 @@ double circle::get_polar_radians(const point& p1) const
   return polar_radians;
 }
 
-bool circle::get_deviation_sum_squared(const array_list<printer_point>& points, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs, double &total_deviation)
+bool circle::get_deviation_sum_squared(const coordinate_buffer& coordinates, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs, double &total_deviation)
 {
   // We need to ensure that the Z steps are constand per linear travel unit
-  double z_step_per_distance = 0;
+  if (allow_3d_arcs && !is_z_step_constant(coordinates, 1, xyz_tolerance))
+  {
+    return false;
+  }
+  // The deviations are calculated a block at a time, but are summed in order so that the total
+  // is the same no matter which instruction set is used.
+  double deviations[DEVIATION_KERNELS_BLOCK_SIZE];
+  const double* x = coordinates.x();
+  const double* y = coordinates.y();
+  int count = coordinates.count();
   total_deviation = 0;
   // Skip the first and last points since they will fit perfectly.
-  for (int index = 1; index < points.count() - 1; index++)
-  {
-    // Make sure the length from the center of our circle to the test point is 
-    // at or below our max distance.
-    double distance_from_center = utilities::get_cartesian_distance(points[index].x, points[index].y, center.x, center.y);
-    if (allow_3d_arcs) {
-      double z1 = points[index - 1].z;
-      double z2 = points[index].z;
-
-      double current_z_stepper_distance = (z2 - z1) / distance_from_center;
-      if (index == 1) {
-        z_step_per_distance = current_z_stepper_distance;
-      }
-      else if (!utilities::is_equal(z_step_per_distance, current_z_stepper_distance, xyz_tolerance))
+  for (int block_start = 1; block_start < count - 1; block_start += DEVIATION_KERNELS_BLOCK_SIZE)
+  {
+    int block_end = std::min(block_start + DEVIATION_KERNELS_BLOCK_SIZE, count - 1);
+    deviation_kernels::get_point_deviations(x, y, block_start, block_end, center.x, center.y, radius, deviations);
+    for (int index = 0; index < block_end - block_start; index++)
+    {
+      total_deviation += deviations[index] * deviations[index];
+      if (deviations[index] > resolution_mm)
       {
-        // The z step is uneven, can't create arc				
+        // Too much deviation
         return false;
       }
     }
-    double deviation = utilities::abs(distance_from_center - radius);
-    total_deviation += deviation * deviation;
-    if (deviation > resolution_mm)
-    {
-      // Too much deviation
-      return false;
-    }
   }
   // Check the point perpendicular from the segment to the circle's center, if any such point exists
-  for (int index = 0; index < points.count() - 1; index++)
+  for (int block_start = 0; block_start < count - 1; block_start += DEVIATION_KERNELS_BLOCK_SIZE)
   {
-    point point_to_test;
-    if (segment::get_closest_perpendicular_point(points[index], points[index + 1], center, point_to_test))
+    int block_end = std::min(block_start + DEVIATION_KERNELS_BLOCK_SIZE, count - 1);
+    deviation_kernels::get_segment_deviations(x, y, block_start, block_end, center.x, center.y, radius, deviations);
+    for (int index = 0; index < block_end - block_start; index++)
     {
-      double distance = utilities::get_cartesian_distance(point_to_test.x, point_to_test.y, center.x, center.y);
-      double deviation = utilities::abs(distance - radius);
-      total_deviation += deviation * deviation;
-      if (deviation > resolution_mm)
+      if (deviations[index] == DEVIATION_KERNELS_NO_DEVIATION)
+      {
+        continue;
+      }
+      total_deviation += deviations[index] * deviations[index];
+      if (deviations[index] > resolution_mm)
       {
         return false;
       }
@@ -316,57 +524,154 @@ bool circle::get_deviation_sum_squared(const array_list<printer_point>& points,
   return true;
 }
 
-bool circle::is_over_deviation(const array_list<printer_point>& points, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs)
+bool circle::is_over_deviation(const coordinate_buffer& coordinates, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs)
 {
+  double max_deviation;
+  return !get_max_deviation(coordinates, 0, resolution_mm, xyz_tolerance, allow_3d_arcs, max_deviation);
+}
+
+bool circle::get_max_deviation(const coordinate_buffer& coordinates, const int start_index, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs, double& max_deviation) const
+{
+  int count = coordinates.count();
+  max_deviation = 0;
+  // Skip the first and last points since they will fit perfectly.
+  if (!deviation_kernels::get_max_point_deviation(coordinates.x(), coordinates.y(), start_index == 0 ? 1 : start_index, count - 1, center.x, center.y, radius, resolution_mm, max_deviation))
+  {
+    return false;
+  }
+  // Check the point perpendicular from the segment to the circle's center, if any such point exists
+  if (!deviation_kernels::get_max_segment_deviation(coordinates.x(), coordinates.y(), start_index, count - 1, center.x, center.y, radius, resolution_mm, max_deviation))
+  {
+    return false;
+  }
   // We need to ensure that the Z steps are constand per linear travel unit
+  return !allow_3d_arcs || is_z_step_constant(coordinates, start_index, xyz_tolerance);
+}
+
+bool circle::is_z_step_constant(const coordinate_buffer& coordinates, const int start_index, const double xyz_tolerance) const
+{
+  const double* x = coordinates.x();
+  const double* y = coordinates.y();
+  const double* z = coordinates.z();
+  int first_index = start_index == 0 ? 1 : start_index;
   double z_step_per_distance = 0;
-  // shared point to test
-  point point_to_test;
-  int max_index = points.count() - 1;
-  // Skip the first and last points since they will fit perfectly.
-  for (int index = 0; index < max_index; index++)
+  for (int index = first_index; index < coordinates.count() - 1; index++)
   {
-    point current_point(points[index]);
-    if (index != 0)
-    {
-      // Make sure the length from the center of our circle to the test point is 
-      // at or below our max distance.
-      double distance_from_center = utilities::get_cartesian_distance(current_point.x, current_point.y, center.x, center.y);
-      if (allow_3d_arcs) {
-        double z1 = points[index - 1].z;
-        double z2 = current_point.z;
-
-        double current_z_stepper_distance = (z2 - z1) / distance_from_center;
-        if (index == 1) {
-          z_step_per_distance = current_z_stepper_distance;
-        }
-        else if (!utilities::is_equal(z_step_per_distance, current_z_stepper_distance, xyz_tolerance))
-        {
-          // The z step is uneven, can't create arc				
-          return true;
-        }
-      }
-      if (utilities::abs(distance_from_center - radius) > resolution_mm)
-      {
-        return true;
-      }
+    double distance_from_center = utilities::get_cartesian_distance(x[index], y[index], center.x, center.y);
+    double current_z_stepper_distance = (z[index] - z[index - 1]) / distance_from_center;
+    if (index == first_index) {
+      z_step_per_distance = current_z_stepper_distance;
     }
-    
-    // Check the point perpendicular from the segment to the circle's center, if any such point exists
-    
-    if (segment::get_closest_perpendicular_point(current_point, points[index + 1], center, point_to_test))
+    else if (!utilities::is_equal(z_step_per_distance, current_z_stepper_distance, xyz_tolerance))
     {
-      double distance = utilities::get_cartesian_distance(point_to_test.x, point_to_test.y, center.x, center.y);
-      if (utilities::abs(distance - radius) > resolution_mm)
-      {
-       return true;
-      }
+      // The z step is uneven, can't create arc
+      return false;
     }
   }
-  return false;
+  return true;
 }
 #pragma endregion Circle Functions
 
+#pragma region Circle Fit Sums Functions
+void circle_fit_sums::clear()
+{
+  count = 0;
+  origin.x = 0;
+  origin.y = 0;
+  origin.z = 0;
+  sum_xx = 0;
+  sum_xy = 0;
+  sum_yy = 0;
+  sum_xxx = 0;
+  sum_xxy = 0;
+  sum_xyy = 0;
+  sum_yyy = 0;
+}
+
+void circle_fit_sums::add(const point& p)
+{
+  if (count == 0)
+  {
+    // The first point becomes the origin, and contributes nothing to the sums.
+    origin.x = p.x;
+    origin.y = p.y;
+    origin.z = p.z;
+    count = 1;
+    return;
+  }
+  double x = p.x - origin.x;
+  double y = p.y - origin.y;
+  double xx = x * x;
+  double yy = y * y;
+  sum_xx += xx;
+  sum_xy += x * y;
+  sum_yy += yy;
+  sum_xxx += xx * x;
+  sum_xxy += xx * y;
+  sum_xyy += x * yy;
+  sum_yyy += yy * y;
+  count++;
+}
+
+void circle_fit_sums::remove(const point& p)
+{
+  if (count < 2)
+  {
+    clear();
+    return;
+  }
+  double x = p.x - origin.x;
+  double y = p.y - origin.y;
+  double xx = x * x;
+  double yy = y * y;
+  sum_xx -= xx;
+  sum_xy -= x * y;
+  sum_yy -= yy;
+  sum_xxx -= xx * x;
+  sum_xxy -= xx * y;
+  sum_xyy -= x * yy;
+  sum_yyy -= yy * y;
+  count--;
+}
+
+bool circle_fit_sums::try_get_circle(const point& end_point, const double max_radius, circle& new_circle) const
+{
+  if (count < 3)
+  {
+    return false;
+  }
+  // The center lies on the perpendicular bisector of the origin and the end point:  c = m + t * n,
+  // where m is the chord midpoint and n is the chord rotated by 90 degrees.  For each point p the
+  // algebraic error is |p|^2 - 2c.p = a - t * b with a = |p|^2 - e.p and b = 2n.p, so the least
+  // squares value of t is sum(a * b) / sum(b * b), which can be expanded into the stored sums.
+  double ex = end_point.x - origin.x;
+  double ey = end_point.y - origin.y;
+  double sum_b_squared = 4.0 * (ey * ey * sum_xx - 2.0 * ex * ey * sum_xy + ex * ex * sum_yy);
+  if (utilities::is_zero(sum_b_squared, 0.000000001))
+  {
+    // The points are colinear.
+    return false;
+  }
+  double sum_a_b = 2.0 * (
+    -ey * sum_xxx + ex * sum_xxy - ey * sum_xyy + ex * sum_yyy
+    + ex * ey * (sum_xx - sum_yy) + (ey * ey - ex * ex) * sum_xy
+  );
+  double t = sum_a_b / sum_b_squared;
+  double center_x = ex / 2.0 - t * ey;
+  double center_y = ey / 2.0 + t * ex;
+  double radius = utilities::sqrt(center_x * center_x + center_y * center_y);
+  if (radius > max_radius)
+  {
+    return false;
+  }
+  new_circle.center.x = origin.x + center_x;
+  new_circle.center.y = origin.y + center_y;
+  new_circle.center.z = origin.z;
+  new_circle.radius = radius;
+  return true;
+}
+#pragma endregion Circle Fit Sums Functions
+
 #pragma region Arc Functions
 double arc::get_i() const
 {
@@ -509,6 +814,7 @@ bool arc::try_create_arc(
 
 bool arc::try_create_arc(
   const array_list<printer_point>& points,
+  const coordinate_buffer& coordinates,
   arc& target_arc,
   double approximate_length,
   double max_radius_mm,
@@ -517,20 +823,33 @@ bool arc::try_create_arc(
   int min_arc_segments,
   double mm_per_arc_segment,
   double xyz_tolerance,
-  bool allow_3d_arcs)
+  bool allow_3d_arcs,
+  bool exact_arc_fitting)
 {
   circle test_circle = (circle)target_arc;
 
-  if (!circle::try_create_circle(points, max_radius_mm, resolution_mm, xyz_tolerance, allow_3d_arcs, test_circle))
+  if (!circle::try_create_circle(coordinates, max_radius_mm, resolution_mm, xyz_tolerance, allow_3d_arcs, exact_arc_fitting, test_circle))
   {
     return false;
   }
   
   // We could save a bit of processing power and do our firmware compensation here, but we won't be able to track statistics for this easily.
   // moved check to segmented_arc.cpp
+  return arc::try_create_arc(test_circle, points, target_arc, approximate_length, resolution_mm, path_tolerance_percent, allow_3d_arcs);
+}
+
+bool arc::try_create_arc(
+  const circle& c,
+  const array_list<printer_point>& points,
+  arc& target_arc,
+  double approximate_length,
+  double resolution,
+  double path_tolerance_percent,
+  bool allow_3d_arcs)
+{
   int mid_point_index = ((points.count() - 2) / 2) + 1;
   arc test_arc;
-  if (!arc::try_create_arc(test_circle, points[0], points[mid_point_index], points[points.count() - 1], test_arc, approximate_length, resolution_mm, path_tolerance_percent, allow_3d_arcs))
+  if (!arc::try_create_arc(c, points[0], points[mid_point_index], points[points.count() - 1], test_arc, approximate_length, resolution, path_tolerance_percent, allow_3d_arcs))
   {
     return false;
   }
@@ -767,6 +1086,8 @@ segmented_shape& segmented_shape::operator=(const segmented_shape& obj)
     points_.resize(max_segments_);
   }
   points_.copy(obj.points_);
+  coordinates_ = obj.coordinates_;
+  circle_fit_ = obj.circle_fit_;
 
   original_shape_length_ = obj.original_shape_length_;
   e_relative_ = obj.e_relative_;
@@ -794,6 +1115,8 @@ double segmented_shape::get_shape_e_relative()
 void segmented_shape::clear()
 {
   points_.clear();
+  coordinates_.clear();
+  circle_fit_.clear();
   is_shape_ = false;
   e_relative_ = 0;
   original_shape_length_ = 0;
@@ -834,11 +1157,27 @@ void segmented_shape::set_resolution_mm(double resolution_mm)
 }
 printer_point segmented_shape::pop_front()
 {
-  return points_.pop_front();
+  printer_point p = points_.pop_front();
+  coordinates_.pop_front();
+  reset_circle_fit_();
+  return p;
 }
 printer_point segmented_shape::pop_back()
 {
-  return points_.pop_back();
+  printer_point p = points_.pop_back();
+  coordinates_.pop_back();
+  circle_fit_.remove(p);
+  return p;
+}
+
+void segmented_shape::reset_circle_fit_()
+{
+  // The fit sums are relative to the first point, so they must be rebuilt whenever it changes.
+  circle_fit_.clear();
+  for (int index = 0; index < points_.count(); index++)
+  {
+    circle_fit_.add(points_[index]);
+  }
 }
 
 bool segmented_shape::try_add_point(printer_point p, double e_relative)
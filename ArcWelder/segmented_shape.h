@@ -27,6 +27,7 @@
 #include <limits>
 
 #include <list> 
+#include <vector>
 #include "utilities.h"
 #include "array_list.h"
 // The minimum theta value allowed between any two arc in order for an arc to be
@@ -103,7 +104,34 @@ struct vector : point
 	
 };
 
+// A structure of arrays copy of a shape's point coordinates, kept in the same order as the points themselves
+// so that the deviation kernels can read each axis from contiguous memory.
+class coordinate_buffer
+{
+public:
+	coordinate_buffer();
+	void push_back(const point& p);
+	void pop_front();
+	void pop_back();
+	void clear();
+	int count() const;
+	point get_point(int index) const;
+	const double* x() const;
+	const double* y() const;
+	const double* z() const;
+private:
+	std::vector<double> x_;
+	std::vector<double> y_;
+	std::vector<double> z_;
+	int front_index_;
+};
+
 #define DEFAULT_MAX_RADIUS_MM 9999.0 // 9.999m
+#define DEFAULT_EXACT_ARC_FITTING false
+// The maximum number of Newton iterations used when fitting a circle.  The fit usually converges in fewer than ten.
+#define CIRCLE_FIT_MAX_ITERATIONS 20
+// The number of evenly spaced points whose circles are tested when the fitted circle does not fit.
+#define CIRCLE_FIT_CANDIDATES 4
 struct circle {
 	circle() {
 		center.x = 0;
@@ -123,15 +151,51 @@ struct circle {
 
 	static bool try_create_circle(const point &p1, const point &p2, const point &p3, const double max_radius, circle& new_circle);
 	
-	static bool try_create_circle(const array_list<printer_point>& points, const double max_radius, const double resolutino_mm, const double xyz_tolerance, bool allow_3d_arcs, circle& new_circle);
+	// Finds a circle through the first and last coordinates that is within resolution_mm of every coordinate.  The
+	// circle through the middle coordinate is tried first, then a single least squares fit, then the circles through
+	// CIRCLE_FIT_CANDIDATES other coordinates.  When exact_arc_fitting is true, the circle through every coordinate
+	// is tested instead, which takes quadratic time.
+	static bool try_create_circle(const coordinate_buffer& coordinates, const double max_radius, const double resolutino_mm, const double xyz_tolerance, bool allow_3d_arcs, bool exact_arc_fitting, circle& new_circle);
+
+	// Fits a circle to the coordinates, then moves its center so that it passes through the first and last
+	// coordinates.  The deviation is not checked.
+	static bool try_fit_circle(const coordinate_buffer& coordinates, const double max_radius, circle& new_circle);
 
 	double get_polar_radians(const point& p1) const;
 
 	point get_closest_point(const point& p) const;
 
-	bool is_over_deviation(const array_list<printer_point>& points, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs);
+	bool is_over_deviation(const coordinate_buffer& coordinates, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs);
 	
-	bool get_deviation_sum_squared(const array_list<printer_point>& points, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs, double& sum_deviation);
+	bool get_deviation_sum_squared(const coordinate_buffer& coordinates, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs, double& sum_deviation);
+
+	bool get_max_deviation(const coordinate_buffer& coordinates, const int start_index, const double resolution_mm, const double xyz_tolerance, const bool allow_3d_arcs, double& max_deviation) const;
+private:
+	bool is_z_step_constant(const coordinate_buffer& coordinates, const int start_index, const double xyz_tolerance) const;
+};
+
+// Running sums used to fit a circle to a growing list of points in constant time per point.
+// The fitted circle always passes through the first and last points, and its center is the point
+// on their perpendicular bisector that minimizes the algebraic (Kasa) error of every other point.
+// All coordinates are stored relative to the first point added.
+struct circle_fit_sums
+{
+	circle_fit_sums() {
+		clear();
+	}
+	void clear();
+	void add(const point& p);
+	void remove(const point& p);
+	bool try_get_circle(const point& end_point, const double max_radius, circle& new_circle) const;
+	int count;
+	point origin;
+	double sum_xx;
+	double sum_xy;
+	double sum_yy;
+	double sum_xxx;
+	double sum_xxy;
+	double sum_xyy;
+	double sum_yyy;
 };
 
 #define DEFAULT_RESOLUTION_MM 0.05
@@ -174,6 +238,7 @@ struct arc : circle
 	double get_j() const;
 	static bool try_create_arc(
 		const array_list<printer_point>& points, 
+		const coordinate_buffer& coordinates,
 		arc& target_arc, 
 		double approximate_length, 
 		double max_radius = DEFAULT_MAX_RADIUS_MM,
@@ -182,6 +247,15 @@ struct arc : circle
 		int min_arc_segments = DEFAULT_MIN_ARC_SEGMENTS,
 		double mm_per_arc_segment = DEFAULT_MM_PER_ARC_SEGMENT,
 		double xyz_tolerance = DEFAULT_XYZ_TOLERANCE,
+		bool allow_3d_arcs = DEFAULT_ALLOW_3D_ARCS,
+		bool exact_arc_fitting = DEFAULT_EXACT_ARC_FITTING);
+	static bool try_create_arc(
+		const circle& c,
+		const array_list<printer_point>& points,
+		arc& target_arc,
+		double approximate_length,
+		double resolution = DEFAULT_RESOLUTION_MM,
+		double path_tolerance_percent = ARC_LENGTH_PERCENT_TOLERANCE_DEFAULT,
 		bool allow_3d_arcs = DEFAULT_ALLOW_3D_ARCS);
 	static bool are_points_within_slice(const arc& test_arc, const array_list<printer_point>& points);
 	static bool ray_intersects_segment(const point rayOrigin, const point rayDirection, const printer_point point1, const printer_point point2);
@@ -239,6 +313,9 @@ public:
 	double get_xyz_tolerance() const;
 protected:
 	array_list<printer_point> points_;
+	coordinate_buffer coordinates_;
+	circle_fit_sums circle_fit_;
+	void reset_circle_fit_();
 	void set_is_shape(bool value);
 	double original_shape_length_;	
 	double e_relative_;
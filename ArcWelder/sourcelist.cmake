@@ -1,5 +1,9 @@
 set(ArcWelderSources ${ArcWelderSources}
     arc_welder.cpp
+    arc_welder_cache.cpp
+    arc_welder_index.cpp
+    async_file_writer.cpp
+    deviation_kernels.cpp
     segmented_arc.cpp
     segmented_shape.cpp
 )
\ No newline at end of file
@@ -30,18 +30,34 @@ struct unwritten_command
 	unwritten_command() {
 		is_extruder_relative = false;
 		length = 0;
+		feedrate = 0;
 		is_g0_g1 = false;
 		is_g2_g3 = false;
 		is_travel = false;
 		is_extrusion = false;
 		is_retraction = false;
-		gcode = "";
 		comment = "";
 	}
-	unwritten_command(parsed_command &cmd, bool is_relative, bool is_extrusion, bool is_retraction, bool is_travel, double command_length) 
-		: is_extruder_relative(is_relative), is_extrusion(is_extrusion), is_retraction(is_retraction), is_travel(is_travel), is_g0_g1(cmd.command == "G0" || cmd.command == "G1"), is_g2_g3(cmd.command == "G2" || cmd.command == "G3"), gcode(cmd.gcode), comment(cmd.comment), length(command_length)
+	unwritten_command(const parsed_command &cmd, bool is_relative, bool is_extrusion, bool is_retraction, bool is_travel, double command_length, double command_feedrate) 
 	{
-
+		assign(cmd, is_relative, is_extrusion, is_retraction, is_travel, command_length, command_feedrate);
+	}
+	/// <summary>
+	/// Overwrites every field.  The comment reuses its existing capacity, so a command already held by an array_list can be
+	/// refilled without allocating.
+	/// </summary>
+	void assign(const parsed_command &cmd, bool is_relative, bool command_is_extrusion, bool command_is_retraction, bool command_is_travel, double command_length, double command_feedrate)
+	{
+		is_extruder_relative = is_relative;
+		is_extrusion = command_is_extrusion;
+		is_retraction = command_is_retraction;
+		is_travel = command_is_travel;
+		is_g0_g1 = cmd.opcode == gcode_opcode_g0 || cmd.opcode == gcode_opcode_g1;
+		is_g2_g3 = cmd.opcode == gcode_opcode_g2 || cmd.opcode == gcode_opcode_g3;
+		gcode = cmd.gcode;
+		comment.assign(cmd.comment);
+		length = command_length;
+		feedrate = command_feedrate;
 	}
 	bool is_g0_g1;
 	bool is_g2_g3;
@@ -50,16 +66,26 @@ struct unwritten_command
 	bool is_extrusion;
 	bool is_retraction;
 	double length;
-	std::string gcode;
+	double feedrate;
+	// References the source line when the command was parsed from a line_reader.
+	gcode_text gcode;
 	std::string comment;
 
-	std::string to_string()
+	std::string to_string() const
+	{
+		std::string text;
+		append_to(text);
+		return text;
+	}
+
+	void append_to(std::string& text) const
 	{
+		text.append(gcode.data(), gcode.length());
 		if (comment.size() > 0)
 		{
-			return gcode + ";" + comment;
+			text.push_back(';');
+			text.append(comment);
 		}
-		return gcode;
 	}
 };
 
@@ -0,0 +1,436 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if _MSC_VER > 1200
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#include "ArcWelderBench.h"
+#include "allocation_counter.h"
+// arc_welder.h and arc_interpolation.h both define a default gcode buffer size.  Only arc_interpolation.cpp uses the
+// inverse processor's value, so drop the welder's definition here rather than redefining it.
+#undef DEFAULT_GCODE_BUFFER_SIZE
+#include "arc_interpolation.h"
+#include "marlin_2.h"
+#include "line_reader.h"
+#include "logger.h"
+#include "utilities.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <tclap/CmdLine.h>
+#include <tclap/tclap_version.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Discards everything written to it.  arc_interpolation::process writes progress to std::cout, which would add console
+// time to the measurements.
+class null_buffer : public std::streambuf
+{
+protected:
+  virtual int overflow(int c)
+  {
+    return c;
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  std::string info = "Arc Welder Bench\nGenerates synthetic gcode workloads and measures how quickly they are welded by arc_welder::process and interpolated again by arc_interpolation::process.";
+  info.append("\nVersion: ").append(GIT_TAGGED_VERSION);
+  info.append(", Branch: ").append(GIT_BRANCH);
+  info.append(", BuildDate: ").append(BUILD_DATE);
+  info.append("\n").append("Copyright(C) ").append(COPYRIGHT_DATE).append(" - ").append(AUTHOR);
+  info.append("\n").append("Includes TCLAP v").append(TCLAP_VERSION_STRING).append(". ").append(TCLAP_COPYRIGHT_STRING);
+
+  std::stringstream arg_description_stream;
+  TCLAP::CmdLine cmd(info, '=', GIT_TAGGED_VERSION);
+
+  // -w --workload
+  std::vector<std::string> workload_vector;
+  workload_vector.push_back(BENCH_WORKLOAD_ALL);
+  for (int index = 0; index < NUM_WORKLOAD_TYPES; index++)
+  {
+    workload_vector.push_back(workload_type_names[index]);
+  }
+  TCLAP::ValuesConstraint<std::string> workload_constraint(workload_vector);
+  arg_description_stream << "The workload to benchmark. Default Value: " << BENCH_WORKLOAD_ALL;
+  TCLAP::ValueArg<std::string> workload_arg("w", "workload", arg_description_stream.str(), false, BENCH_WORKLOAD_ALL, &workload_constraint);
+
+  // -n --lines
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The minimum number of lines generated for each workload. Whole layers are generated, so the files are slightly larger. Default Value: " << DEFAULT_BENCH_LINES;
+  TCLAP::ValueArg<long> lines_arg("n", "lines", arg_description_stream.str(), false, DEFAULT_BENCH_LINES, "int");
+
+  // -s --seed
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The seed used to generate the workloads. The same seed always generates the same files. Default Value: " << DEFAULT_BENCH_SEED;
+  TCLAP::ValueArg<unsigned int> seed_arg("s", "seed", arg_description_stream.str(), false, DEFAULT_BENCH_SEED, "unsigned int");
+
+  // -i --iterations
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The number of times each workload is processed. The fastest run is reported. Default Value: " << DEFAULT_BENCH_ITERATIONS;
+  TCLAP::ValueArg<int> iterations_arg("i", "iterations", arg_description_stream.str(), false, DEFAULT_BENCH_ITERATIONS, "int");
+
+  // -o --output-directory
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The directory where the generated, welded and interpolated files are written. Default Value: " << DEFAULT_BENCH_OUTPUT_DIRECTORY;
+  TCLAP::ValueArg<std::string> output_directory_arg("o", "output-directory", arg_description_stream.str(), false, DEFAULT_BENCH_OUTPUT_DIRECTORY, "path");
+
+  // -k --keep-files
+  TCLAP::SwitchArg keep_files_arg("k", "keep-files", "If supplied, the generated, welded and interpolated files are not deleted.", false);
+
+  // -j --threads
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The number of threads passed to arc_welder. Default Value: " << DEFAULT_THREADS;
+  TCLAP::ValueArg<int> threads_arg("j", "threads", arg_description_stream.str(), false, DEFAULT_THREADS, "int");
+
+  // --pipeline
+  TCLAP::SwitchArg pipeline_arg("", "pipeline", "If supplied, arc_welder uses the pipelined welding mode.", DEFAULT_PIPELINE);
+
+  cmd.add(workload_arg);
+  cmd.add(lines_arg);
+  cmd.add(seed_arg);
+  cmd.add(iterations_arg);
+  cmd.add(output_directory_arg);
+  cmd.add(keep_files_arg);
+  cmd.add(threads_arg);
+  cmd.add(pipeline_arg);
+
+  std::string workload_string;
+  long target_lines;
+  unsigned int seed;
+  int iterations;
+  std::string output_directory;
+  bool keep_files;
+  int threads;
+  bool pipeline;
+  try
+  {
+    cmd.parse(argc, argv);
+    workload_string = workload_arg.getValue();
+    target_lines = lines_arg.getValue();
+    seed = seed_arg.getValue();
+    iterations = iterations_arg.getValue();
+    output_directory = output_directory_arg.getValue();
+    keep_files = keep_files_arg.getValue();
+    threads = threads_arg.getValue();
+    pipeline = pipeline_arg.getValue();
+    if (target_lines < 1)
+    {
+      throw TCLAP::ArgException("The provided value is less than 1.", lines_arg.toString());
+    }
+    if (iterations < 1)
+    {
+      throw TCLAP::ArgException("The provided value is less than 1.", iterations_arg.toString());
+    }
+    if (threads < 1)
+    {
+      throw TCLAP::ArgException("The provided value is less than 1.", threads_arg.toString());
+    }
+  }
+  catch (TCLAP::ArgException& e)
+  {
+    cmd.getOutput()->failure(cmd, e);
+    return 1;
+  }
+
+  std::vector<std::string> log_names;
+  log_names.push_back(ARC_WELDER_LOGGER_NAME);
+  std::vector<int> log_levels;
+  log_levels.push_back((int)log_levels::ERROR);
+  logger* p_logger = new logger(log_names, log_levels);
+  p_logger->set_log_level(log_levels::ERROR);
+
+  // arc_interpolation::process calls sync_with_stdio(false), which replaces the buffers of the standard streams.  Do
+  // it up front so the buffer restored after redirecting std::cout is still the one std::cout uses.
+  std::ios::sync_with_stdio(false);
+  gcode_generator generator(seed);
+  bool success = true;
+  print_result_header();
+  for (int index = 0; index < NUM_WORKLOAD_TYPES && success; index++)
+  {
+    workload_type workload = static_cast<workload_type>(index);
+    std::string workload_name = workload_type_names[index];
+    if (workload_string != BENCH_WORKLOAD_ALL && workload_string != workload_name)
+    {
+      continue;
+    }
+    std::string file_name = output_directory + "/bench_" + workload_name;
+    std::string source_path = file_name + ".gcode";
+    std::string welded_path = file_name + ".welded.gcode";
+    std::string interpolated_path = file_name + ".interpolated.gcode";
+    std::string warm_up_path = file_name + ".warm_up.gcode";
+    std::string warm_up_welded_path = file_name + ".warm_up.welded.gcode";
+
+    if (!generator.generate(workload, source_path, target_lines))
+    {
+      std::cerr << "Unable to write the generated workload to '" << source_path << "'.\n";
+      success = false;
+      break;
+    }
+
+    arc_welder_args args(source_path, welded_path, p_logger);
+    args.allow_3d_arcs = gcode_generator::requires_3d_arcs(workload);
+    args.threads = threads;
+    args.pipeline = pipeline;
+    args.callback = on_progress_bench;
+    bench_result welder_result;
+    bench_result interpolation_result;
+    for (int iteration = 0; iteration < iterations && success; iteration++)
+    {
+      bench_result result;
+      success = run_arc_welder(args, result);
+      if (iteration == 0 || result.seconds < welder_result.seconds)
+      {
+        welder_result = result;
+      }
+    }
+    // Weld a file with half as many lines.  Setting up the welder costs the same number of allocations regardless of
+    // the file's length, so the difference between the two runs is what welding each additional line allocates.
+    if (success && target_lines > 1)
+    {
+      success = generator.generate(workload, warm_up_path, target_lines / 2);
+      arc_welder_args warm_up_args = args;
+      warm_up_args.source_path = warm_up_path;
+      warm_up_args.target_path = warm_up_welded_path;
+      bench_result warm_up_result;
+      success = success && run_arc_welder(warm_up_args, warm_up_result);
+      if (success && welder_result.lines > warm_up_result.lines)
+      {
+        double allocations = static_cast<double>(welder_result.allocations) - static_cast<double>(warm_up_result.allocations);
+        welder_result.steady_state_allocations_per_line = allocations > 0 ? allocations / (welder_result.lines - warm_up_result.lines) : 0;
+      }
+      std::remove(warm_up_path.c_str());
+      std::remove(warm_up_welded_path.c_str());
+    }
+    for (int iteration = 0; iteration < iterations && success; iteration++)
+    {
+      bench_result result;
+      success = run_arc_interpolation(welded_path, interpolated_path, result);
+      if (iteration == 0 || result.seconds < interpolation_result.seconds)
+      {
+        interpolation_result = result;
+      }
+    }
+    if (!success)
+    {
+      std::cerr << "Unable to process the '" << workload_name << "' workload.\n";
+      break;
+    }
+    print_result(workload_name, "arc_welder", welder_result);
+    print_result(workload_name, "interpolation", interpolation_result);
+    if (threads == 1 && welder_result.steady_state_allocations_per_line > BENCH_MAX_STEADY_STATE_ALLOCATIONS_PER_LINE)
+    {
+      std::cerr << "The '" << workload_name << "' workload allocated " << welder_result.steady_state_allocations_per_line
+        << " times per line after warming up.  Welding a line must not allocate.\n";
+      success = false;
+    }
+
+    if (!keep_files)
+    {
+      std::remove(source_path.c_str());
+      std::remove(welded_path.c_str());
+      std::remove(interpolated_path.c_str());
+    }
+  }
+  delete p_logger;
+  return success ? 0 : 1;
+}
+
+static bool on_progress_bench(arc_welder_progress /*progress*/, logger* /*p_logger*/, int /*logger_type*/)
+{
+  return true;
+}
+
+static bool run_arc_welder(const arc_welder_args& args, bench_result& result)
+{
+  arc_welder welder(args);
+  reset_peak_rss();
+  unsigned long long start_allocations = get_allocation_count();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  arc_welder_results results = welder.process();
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  result.seconds = duration.count();
+  result.allocations = get_allocation_count() - start_allocations;
+  result.peak_rss_bytes = get_peak_rss_bytes();
+  result.source_bytes = results.progress.source_file_size;
+  result.lines = results.progress.lines_processed;
+  result.arcs = results.progress.arcs_created;
+  return results.success;
+}
+
+static bool run_arc_interpolation(const std::string& source_path, const std::string& target_path, bench_result& result)
+{
+  if (!count_lines_and_arcs(source_path, result.lines, result.arcs))
+  {
+    return false;
+  }
+  result.source_bytes = get_file_size(source_path);
+
+  arc_interpolation_args args;
+  marlin_2 firmware(args.firmware_args);
+  args.firmware_args = firmware.get_default_arguments_for_current_version();
+  args.source_path = source_path;
+  args.target_path = target_path;
+  arc_interpolation interpolator(args);
+
+  null_buffer discard;
+  std::streambuf* p_cout_buffer = std::cout.rdbuf(&discard);
+  reset_peak_rss();
+  unsigned long long start_allocations = get_allocation_count();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  interpolator.process();
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  result.seconds = duration.count();
+  result.allocations = get_allocation_count() - start_allocations;
+  result.peak_rss_bytes = get_peak_rss_bytes();
+  std::cout.rdbuf(p_cout_buffer);
+
+  return true;
+}
+
+static bool count_lines_and_arcs(const std::string& path, long& lines, long& arcs)
+{
+  line_reader reader;
+  if (!reader.open(path))
+  {
+    return false;
+  }
+  lines = 0;
+  arcs = 0;
+  const char* line;
+  long length;
+  while (reader.read_line(line, length))
+  {
+    lines++;
+    if (length > 2 && line[0] == 'G' && (line[1] == '2' || line[1] == '3') && line[2] == ' ')
+    {
+      arcs++;
+    }
+    reader.release(reader.get_position());
+  }
+  return true;
+}
+
+static long long get_file_size(const std::string& path)
+{
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+  {
+    return 0;
+  }
+  return static_cast<long long>(file.tellg());
+}
+
+static void reset_peak_rss()
+{
+#if defined(__linux__)
+  // Writing 5 resets the peak resident set size reported in /proc/self/status (VmHWM).
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs.is_open())
+  {
+    clear_refs << "5";
+  }
+#endif
+}
+
+static long long get_peak_rss_bytes()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    return static_cast<long long>(counters.PeakWorkingSetSize);
+  }
+  return 0;
+#else
+#if defined(__linux__)
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+    {
+      return std::atoll(line.c_str() + 6) * 1024;
+    }
+  }
+#endif
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return 0;
+  }
+#if defined(__APPLE__)
+  return static_cast<long long>(usage.ru_maxrss);
+#else
+  return static_cast<long long>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+static void print_result_header()
+{
+  std::cout << std::left << std::setw(20) << "Workload" << std::setw(15) << "Stage" << std::right
+    << std::setw(11) << "Source MB" << std::setw(10) << "Seconds" << std::setw(10) << "MB/s"
+    << std::setw(13) << "Lines/s" << std::setw(12) << "Arcs/s" << std::setw(13) << "Peak RSS MB"
+    << std::setw(13) << "Allocs/Line" << std::setw(20) << "Steady Allocs/Line" << "\n";
+}
+
+static void print_result(const std::string& workload, const std::string& stage, const bench_result& result)
+{
+  double megabytes = static_cast<double>(result.source_bytes) / 1048576.0;
+  double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+  std::cout << std::left << std::setw(20) << workload << std::setw(15) << stage << std::right << std::fixed
+    << std::setw(11) << std::setprecision(2) << megabytes
+    << std::setw(10) << std::setprecision(3) << result.seconds
+    << std::setw(10) << std::setprecision(2) << megabytes / seconds
+    << std::setw(13) << std::setprecision(0) << result.lines / seconds
+    << std::setw(12) << std::setprecision(0) << result.arcs / seconds
+    << std::setw(13) << std::setprecision(1) << static_cast<double>(result.peak_rss_bytes) / 1048576.0
+    << std::setw(13) << std::setprecision(2) << (result.lines > 0 ? static_cast<double>(result.allocations) / result.lines : 0.0);
+  if (result.steady_state_allocations_per_line < 0)
+  {
+    std::cout << std::setw(20) << "-";
+  }
+  else
+  {
+    std::cout << std::setw(20) << std::setprecision(4) << result.steady_state_allocations_per_line;
+  }
+  std::cout << "\n";
+}
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "arc_welder.h"
+#include "gcode_generator.h"
+#include "version.h"
+
+#define DEFAULT_BENCH_LINES 250000
+#define DEFAULT_BENCH_SEED 1
+#define DEFAULT_BENCH_ITERATIONS 3
+#define DEFAULT_BENCH_OUTPUT_DIRECTORY "."
+#define BENCH_WORKLOAD_ALL "ALL"
+// Once the welder has warmed up, welding a line must not allocate.  Only checked for the single threaded and pipelined
+// modes, since the threaded mode parses every line into a shard.
+#define BENCH_MAX_STEADY_STATE_ALLOCATIONS_PER_LINE 0
+
+// The measurements taken while running arc_welder::process or arc_interpolation::process on one workload.
+struct bench_result
+{
+	bench_result()
+	{
+		seconds = 0;
+		source_bytes = 0;
+		lines = 0;
+		arcs = 0;
+		peak_rss_bytes = 0;
+		allocations = 0;
+		steady_state_allocations_per_line = -1;
+	}
+	double seconds;
+	long long source_bytes;
+	long lines;
+	long arcs;
+	long long peak_rss_bytes;
+	unsigned long long allocations;
+	// The allocations per line made after warming up, or -1 if not measured.
+	double steady_state_allocations_per_line;
+};
+
+static bool on_progress_bench(arc_welder_progress progress, logger* p_logger, int logger_type);
+static bool run_arc_welder(const arc_welder_args& args, bench_result& result);
+static bool run_arc_interpolation(const std::string& source_path, const std::string& target_path, bench_result& result);
+static bool count_lines_and_arcs(const std::string& path, long& lines, long& arcs);
+static long long get_file_size(const std::string& path);
+static void reset_peak_rss();
+static long long get_peak_rss_bytes();
+static void print_result_header();
+static void print_result(const std::string& workload, const std::string& stage, const bench_result& result);
@@ -0,0 +1,488 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if _MSC_VER > 1200
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#include "gcode_generator.h"
+#include "utilities.h"
+#include <cmath>
+
+gcode_generator::gcode_generator(unsigned int seed) : random_generator_(seed)
+{
+  seed_ = seed;
+  p_file_ = NULL;
+  has_error_ = false;
+  lines_written_ = 0;
+  x_ = 0;
+  y_ = 0;
+  z_ = 0;
+  e_ = 0;
+  f_ = 0;
+  is_retracted_ = false;
+  tool_ = 0;
+}
+
+gcode_generator::~gcode_generator()
+{
+  if (p_file_ != NULL)
+  {
+    fclose(p_file_);
+  }
+}
+
+bool gcode_generator::requires_3d_arcs(workload_type workload)
+{
+  return workload == workload_spiral_vase || workload == workload_helix;
+}
+
+long gcode_generator::get_lines_written() const
+{
+  return lines_written_;
+}
+
+bool gcode_generator::generate(workload_type workload, const std::string& path, long target_lines)
+{
+  p_file_ = fopen(path.c_str(), "wb");
+  if (p_file_ == NULL)
+  {
+    return false;
+  }
+  // Start from the same state every time so that the output only depends on the arguments.
+  random_generator_.seed(seed_);
+  has_error_ = false;
+  lines_written_ = 0;
+  x_ = 0;
+  y_ = 0;
+  z_ = 0;
+  e_ = 0;
+  f_ = 0;
+  is_retracted_ = false;
+  tool_ = 0;
+  buffer_.clear();
+  buffer_.reserve(GCODE_GENERATOR_BUFFER_SIZE + 256);
+
+  write_header_(workload);
+  for (int layer = 0; lines_written_ < target_lines && !has_error_; layer++)
+  {
+    switch (workload)
+    {
+    case workload_concentric_circles:
+      write_concentric_circles_layer_(layer);
+      break;
+    case workload_spiral_vase:
+      write_spiral_vase_layer_(layer);
+      break;
+    case workload_gyroid_infill:
+      write_gyroid_infill_layer_(layer);
+      break;
+    case workload_organic_curves:
+      write_organic_curves_layer_(layer);
+      break;
+    case workload_multi_extruder:
+      write_multi_extruder_layer_(layer);
+      break;
+    case workload_helix:
+      write_helix_layer_(layer);
+      break;
+    }
+  }
+  write_footer_();
+  flush_();
+  if (fclose(p_file_) != 0)
+  {
+    has_error_ = true;
+  }
+  p_file_ = NULL;
+  return !has_error_;
+}
+
+void gcode_generator::write_header_(workload_type workload)
+{
+  std::string comment = "; generated by arc_welder_bench, workload: ";
+  comment += workload_type_names[workload];
+  write_line_(comment.c_str());
+  write_line_("M140 S60");
+  write_line_("M104 S210");
+  write_line_("G21 ; set units to millimeters");
+  write_line_("G90 ; use absolute coordinates");
+  write_line_("M82 ; use absolute distances for extrusion");
+  write_line_("G28 ; home all axes");
+  write_line_("G92 E0");
+  if (workload == workload_multi_extruder)
+  {
+    write_tool_change_(0);
+  }
+}
+
+void gcode_generator::write_footer_()
+{
+  retract_();
+  begin_line_("G0");
+  append_parameter_('Z', z_ + 10.0, 3);
+  end_line_();
+  write_line_("M104 S0");
+  write_line_("M140 S0");
+  write_line_("M84");
+}
+
+void gcode_generator::write_layer_change_(int layer, double z)
+{
+  char comment[32];
+  sprintf(comment, ";LAYER:%d", layer);
+  write_line_(comment);
+  retract_();
+  z_ = z;
+  begin_line_("G0");
+  append_parameter_('Z', z_, 3);
+  if (f_ != GCODE_GENERATOR_TRAVEL_FEEDRATE)
+  {
+    f_ = GCODE_GENERATOR_TRAVEL_FEEDRATE;
+    append_parameter_('F', f_, 0);
+  }
+  end_line_();
+}
+
+void gcode_generator::write_concentric_circles_layer_(int layer)
+{
+  // Perimeters of a round part, like a cylinder or a cam ring.
+  write_layer_change_(layer, GCODE_GENERATOR_FIRST_LAYER_Z + layer * GCODE_GENERATOR_LAYER_HEIGHT);
+  for (double radius = 5.0; radius <= 35.0; radius += 1.5)
+  {
+    write_circle_(GCODE_GENERATOR_BED_CENTER, GCODE_GENERATOR_BED_CENTER, radius, 0.4);
+  }
+}
+
+void gcode_generator::write_spiral_vase_layer_(int layer)
+{
+  // A single wall that rises continuously.  The radius changes slowly from layer to layer, like a vase.
+  char comment[32];
+  sprintf(comment, ";LAYER:%d", layer);
+  write_line_(comment);
+  double radius = 30.0 + 4.0 * std::sin(layer * 0.05);
+  double z_start = GCODE_GENERATOR_FIRST_LAYER_Z + layer * GCODE_GENERATOR_LAYER_HEIGHT;
+  int segments = static_cast<int>(std::ceil(2.0 * PI_DOUBLE * radius / 0.5));
+  if (layer == 0)
+  {
+    z_ = z_start;
+    travel_to_(GCODE_GENERATOR_BED_CENTER + radius, GCODE_GENERATOR_BED_CENTER);
+  }
+  for (int index = 1; index <= segments; index++)
+  {
+    double fraction = static_cast<double>(index) / segments;
+    double angle = 2.0 * PI_DOUBLE * fraction;
+    extrude_to_(
+      GCODE_GENERATOR_BED_CENTER + radius * std::cos(angle),
+      GCODE_GENERATOR_BED_CENTER + radius * std::sin(angle),
+      z_start + GCODE_GENERATOR_LAYER_HEIGHT * fraction
+    );
+  }
+}
+
+void gcode_generator::write_gyroid_infill_layer_(int layer)
+{
+  // Wavy infill lines.  The phase shifts every layer and the direction alternates, which looks a lot like gyroid infill.
+  write_layer_change_(layer, GCODE_GENERATOR_FIRST_LAYER_Z + layer * GCODE_GENERATOR_LAYER_HEIGHT);
+  const double half_size = 40.0;
+  const double spacing = 2.5;
+  const double amplitude = 1.2;
+  const double period = 10.0;
+  const double step = 0.5;
+  double phase = layer * 0.3;
+  bool is_along_x = (layer % 2) == 0;
+  bool is_reversed = false;
+  for (double offset = -half_size; offset <= half_size; offset += spacing)
+  {
+    int steps = static_cast<int>(2.0 * half_size / step);
+    for (int index = 0; index <= steps; index++)
+    {
+      double along = -half_size + (is_reversed ? steps - index : index) * step;
+      double across = offset + amplitude * std::sin(2.0 * PI_DOUBLE * along / period + phase);
+      double x = GCODE_GENERATOR_BED_CENTER + (is_along_x ? along : across);
+      double y = GCODE_GENERATOR_BED_CENTER + (is_along_x ? across : along);
+      if (index == 0)
+      {
+        travel_to_(x, y);
+      }
+      else
+      {
+        extrude_to_(x, y);
+      }
+    }
+    is_reversed = !is_reversed;
+  }
+}
+
+void gcode_generator::write_organic_curves_layer_(int layer)
+{
+  // Smooth closed curves made of very short segments, like the perimeters of a sculpted model.
+  write_layer_change_(layer, GCODE_GENERATOR_FIRST_LAYER_Z + layer * GCODE_GENERATOR_LAYER_HEIGHT);
+  const int num_blobs = 6;
+  const int num_harmonics = 4;
+  for (int blob = 0; blob < num_blobs; blob++)
+  {
+    // Every layer uses the same shape for each blob, so the shapes are read from their own generator.
+    std::mt19937 shape_generator(seed_ * 31 + blob);
+    double center_x = GCODE_GENERATOR_BED_CENTER - 40.0 + 80.0 * (shape_generator() / 4294967296.0);
+    double center_y = GCODE_GENERATOR_BED_CENTER - 40.0 + 80.0 * (shape_generator() / 4294967296.0);
+    double base_radius = 5.0 + 5.0 * (shape_generator() / 4294967296.0);
+    double amplitudes[num_harmonics];
+    double phases[num_harmonics];
+    for (int harmonic = 0; harmonic < num_harmonics; harmonic++)
+    {
+      amplitudes[harmonic] = base_radius * 0.12 * (shape_generator() / 4294967296.0) / (harmonic + 1);
+      phases[harmonic] = 2.0 * PI_DOUBLE * (shape_generator() / 4294967296.0);
+    }
+
+    int segments = static_cast<int>(std::ceil(2.0 * PI_DOUBLE * base_radius / 0.08));
+    for (int index = 0; index <= segments; index++)
+    {
+      double angle = 2.0 * PI_DOUBLE * index / segments;
+      double radius = base_radius;
+      for (int harmonic = 0; harmonic < num_harmonics; harmonic++)
+      {
+        radius += amplitudes[harmonic] * std::sin((harmonic + 2) * angle + phases[harmonic] + layer * 0.02 * (harmonic + 1));
+      }
+      // Meshes exported from sculpting tools are never perfectly smooth.
+      radius += random_(-0.002, 0.002);
+      double x = center_x + radius * std::cos(angle);
+      double y = center_y + radius * std::sin(angle);
+      if (index == 0)
+      {
+        travel_to_(x, y);
+      }
+      else
+      {
+        extrude_to_(x, y);
+      }
+    }
+  }
+}
+
+void gcode_generator::write_multi_extruder_layer_(int layer)
+{
+  // Two parts printed with different tools, with a tool change on every layer.
+  write_layer_change_(layer, GCODE_GENERATOR_FIRST_LAYER_Z + layer * GCODE_GENERATOR_LAYER_HEIGHT);
+  for (int tool = 0; tool < 2; tool++)
+  {
+    if (tool_ != tool)
+    {
+      write_tool_change_(tool);
+    }
+    double center_x = GCODE_GENERATOR_BED_CENTER + (tool == 0 ? -30.0 : 30.0);
+    for (double radius = 4.0; radius <= 20.0; radius += 2.0)
+    {
+      write_circle_(center_x, GCODE_GENERATOR_BED_CENTER, radius, 0.45);
+    }
+    // A few straight lines across each part, which can never be welded.
+    for (double offset = -15.0; offset <= 15.0; offset += 5.0)
+    {
+      travel_to_(center_x - 15.0, GCODE_GENERATOR_BED_CENTER + offset);
+      extrude_to_(center_x + 15.0, GCODE_GENERATOR_BED_CENTER + offset);
+    }
+  }
+}
+
+void gcode_generator::write_helix_layer_(int layer)
+{
+  // A steep coil, which can only be welded into 3D arcs.  Each layer is one turn.
+  char comment[32];
+  sprintf(comment, ";LAYER:%d", layer);
+  write_line_(comment);
+  const double radius = 12.0;
+  const double pitch = 1.0;
+  double z_start = GCODE_GENERATOR_FIRST_LAYER_Z + layer * pitch;
+  int segments = static_cast<int>(std::ceil(2.0 * PI_DOUBLE * radius / 0.3));
+  if (layer == 0)
+  {
+    z_ = z_start;
+    travel_to_(GCODE_GENERATOR_BED_CENTER + radius, GCODE_GENERATOR_BED_CENTER);
+  }
+  for (int index = 1; index <= segments; index++)
+  {
+    double fraction = static_cast<double>(index) / segments;
+    double angle = 2.0 * PI_DOUBLE * fraction;
+    extrude_to_(
+      GCODE_GENERATOR_BED_CENTER + radius * std::cos(angle),
+      GCODE_GENERATOR_BED_CENTER + radius * std::sin(angle),
+      z_start + pitch * fraction
+    );
+  }
+}
+
+void gcode_generator::write_circle_(double center_x, double center_y, double radius, double segment_length)
+{
+  int segments = static_cast<int>(std::ceil(2.0 * PI_DOUBLE * radius / segment_length));
+  if (segments < 12)
+  {
+    segments = 12;
+  }
+  // Slicers start each perimeter at a different point.
+  double start_angle = random_(0, 2.0 * PI_DOUBLE);
+  travel_to_(center_x + radius * std::cos(start_angle), center_y + radius * std::sin(start_angle));
+  for (int index = 1; index <= segments; index++)
+  {
+    double angle = start_angle + 2.0 * PI_DOUBLE * index / segments;
+    extrude_to_(center_x + radius * std::cos(angle), center_y + radius * std::sin(angle));
+  }
+}
+
+void gcode_generator::write_tool_change_(int tool)
+{
+  retract_();
+  char command[16];
+  sprintf(command, "T%d", tool);
+  write_line_(command);
+  write_line_("G92 E0");
+  e_ = 0;
+  tool_ = tool;
+}
+
+void gcode_generator::travel_to_(double x, double y)
+{
+  double distance = std::sqrt((x - x_) * (x - x_) + (y - y_) * (y - y_));
+  if (distance > 2.0)
+  {
+    retract_();
+  }
+  x_ = x;
+  y_ = y;
+  begin_line_("G0");
+  append_parameter_('X', x_, 3);
+  append_parameter_('Y', y_, 3);
+  if (f_ != GCODE_GENERATOR_TRAVEL_FEEDRATE)
+  {
+    f_ = GCODE_GENERATOR_TRAVEL_FEEDRATE;
+    append_parameter_('F', f_, 0);
+  }
+  end_line_();
+}
+
+void gcode_generator::extrude_to_(double x, double y)
+{
+  extrude_to_(x, y, z_);
+}
+
+void gcode_generator::extrude_to_(double x, double y, double z)
+{
+  unretract_();
+  double distance = std::sqrt((x - x_) * (x - x_) + (y - y_) * (y - y_) + (z - z_) * (z - z_));
+  bool has_z = z != z_;
+  x_ = x;
+  y_ = y;
+  z_ = z;
+  e_ += distance * GCODE_GENERATOR_E_PER_MM;
+  begin_line_("G1");
+  append_parameter_('X', x_, 3);
+  append_parameter_('Y', y_, 3);
+  if (has_z)
+  {
+    append_parameter_('Z', z_, 3);
+  }
+  append_parameter_('E', e_, 5);
+  if (f_ != GCODE_GENERATOR_PRINT_FEEDRATE)
+  {
+    f_ = GCODE_GENERATOR_PRINT_FEEDRATE;
+    append_parameter_('F', f_, 0);
+  }
+  end_line_();
+}
+
+void gcode_generator::retract_()
+{
+  if (is_retracted_)
+  {
+    return;
+  }
+  is_retracted_ = true;
+  e_ -= GCODE_GENERATOR_RETRACT_LENGTH;
+  f_ = GCODE_GENERATOR_RETRACT_FEEDRATE;
+  begin_line_("G1");
+  append_parameter_('E', e_, 5);
+  append_parameter_('F', f_, 0);
+  end_line_();
+}
+
+void gcode_generator::unretract_()
+{
+  if (!is_retracted_)
+  {
+    return;
+  }
+  is_retracted_ = false;
+  e_ += GCODE_GENERATOR_RETRACT_LENGTH;
+  f_ = GCODE_GENERATOR_RETRACT_FEEDRATE;
+  begin_line_("G1");
+  append_parameter_('E', e_, 5);
+  append_parameter_('F', f_, 0);
+  end_line_();
+}
+
+void gcode_generator::write_line_(const char* text)
+{
+  buffer_ += text;
+  end_line_();
+}
+
+void gcode_generator::begin_line_(const char* command)
+{
+  buffer_ += command;
+}
+
+void gcode_generator::append_parameter_(char name, double value, unsigned char precision)
+{
+  char text[FPCONV_BUFFER_LENGTH + 2];
+  char* p = text;
+  *p++ = ' ';
+  *p++ = name;
+  utilities::append_fixed(p, value, precision);
+  buffer_.append(text, p - text);
+}
+
+void gcode_generator::end_line_()
+{
+  buffer_ += '\n';
+  lines_written_++;
+  if (buffer_.size() >= GCODE_GENERATOR_BUFFER_SIZE)
+  {
+    flush_();
+  }
+}
+
+void gcode_generator::flush_()
+{
+  if (!buffer_.empty() && fwrite(buffer_.c_str(), 1, buffer_.size(), p_file_) != buffer_.size())
+  {
+    has_error_ = true;
+  }
+  buffer_.clear();
+}
+
+double gcode_generator::random_(double min, double max)
+{
+  // Scale the raw output, since the standard distributions are not guaranteed to be the same on every platform.
+  return min + (max - min) * (random_generator_() / 4294967296.0);
+}
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <cstdio>
+#include <random>
+
+#define GCODE_GENERATOR_LAYER_HEIGHT 0.2
+#define GCODE_GENERATOR_FIRST_LAYER_Z 0.3
+// The length of filament extruded per mm of travel for a 0.4mm nozzle at the layer height above.
+#define GCODE_GENERATOR_E_PER_MM 0.0333
+#define GCODE_GENERATOR_RETRACT_LENGTH 0.8
+#define GCODE_GENERATOR_PRINT_FEEDRATE 1800
+#define GCODE_GENERATOR_TRAVEL_FEEDRATE 9000
+#define GCODE_GENERATOR_RETRACT_FEEDRATE 2400
+#define GCODE_GENERATOR_BED_CENTER 110.0
+// Generated text is written to the file in blocks of this size.
+#define GCODE_GENERATOR_BUFFER_SIZE 1048576
+
+enum workload_type
+{
+	workload_concentric_circles = 0,
+	workload_spiral_vase = 1,
+	workload_gyroid_infill = 2,
+	workload_organic_curves = 3,
+	workload_multi_extruder = 4,
+	workload_helix = 5
+};
+#define NUM_WORKLOAD_TYPES 6
+static const std::string workload_type_names[NUM_WORKLOAD_TYPES] = {
+	"CONCENTRIC_CIRCLES", "SPIRAL_VASE", "GYROID_INFILL", "ORGANIC_CURVES", "MULTI_EXTRUDER", "HELIX"
+};
+
+// Writes synthetic gcode that resembles the output of a slicer.  The output only depends on the workload, the seed
+// and the number of lines requested, so every run (and every platform) benchmarks exactly the same file.
+class gcode_generator
+{
+public:
+	gcode_generator(unsigned int seed);
+	~gcode_generator();
+	/// <summary>
+	/// Writes a workload to a file.  Whole layers are written until at least target_lines lines have been written.
+	/// </summary>
+	/// <returns>False if the file could not be written.</returns>
+	bool generate(workload_type workload, const std::string& path, long target_lines);
+	/// <summary>
+	/// Returns true if the workload needs 3D arcs to be enabled in order to produce any arcs.
+	/// </summary>
+	static bool requires_3d_arcs(workload_type workload);
+	long get_lines_written() const;
+private:
+	gcode_generator(const gcode_generator& source);
+	gcode_generator& operator=(const gcode_generator& source);
+	void write_concentric_circles_layer_(int layer);
+	void write_spiral_vase_layer_(int layer);
+	void write_gyroid_infill_layer_(int layer);
+	void write_organic_curves_layer_(int layer);
+	void write_multi_extruder_layer_(int layer);
+	void write_helix_layer_(int layer);
+	void write_header_(workload_type workload);
+	void write_footer_();
+	void write_layer_change_(int layer, double z);
+	void write_circle_(double center_x, double center_y, double radius, double segment_length);
+	void write_tool_change_(int tool);
+	void travel_to_(double x, double y);
+	void extrude_to_(double x, double y);
+	void extrude_to_(double x, double y, double z);
+	void retract_();
+	void unretract_();
+	void write_line_(const char* text);
+	void begin_line_(const char* command);
+	void append_parameter_(char name, double value, unsigned char precision);
+	void end_line_();
+	void flush_();
+	double random_(double min, double max);
+	unsigned int seed_;
+	std::mt19937 random_generator_;
+	FILE* p_file_;
+	bool has_error_;
+	std::string buffer_;
+	long lines_written_;
+	double x_;
+	double y_;
+	double z_;
+	double e_;
+	double f_;
+	bool is_retracted_;
+	int tool_;
+};
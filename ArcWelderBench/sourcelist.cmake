@@ -0,0 +1,17 @@
+set(ArcWelderBenchSources ${ArcWelderBenchSources}
+    ArcWelderBench.h
+    ArcWelderBench.cpp
+    allocation_counter.h
+    allocation_counter.cpp
+    gcode_generator.h
+    gcode_generator.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/accuracy_segment_sink.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/arc_interpolation.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/firmware.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/marlin_1.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/marlin_2.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/prusa.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/repetier.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/segment_sink.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderInverseProcessor/smoothieware.cpp
+)
@@ -46,6 +46,10 @@ int main(int argc, char* argv[])
   std::string progress_type;
   int log_level_value;
   bool hide_progress = false;
+  bool is_batch = false;
+  std::string batch_glob;
+  int batch_workers = DEFAULT_BATCH_WORKERS;
+  std::vector<std::string> batch_source_paths;
 
   // Add info about the application
   std::string info = "Arc Welder: Anti-Stutter\nConverts G0/G1 commands to G2/G3 (arc) commands. Reduces the number of gcodes per second sent to a 3D printer, which can reduce stuttering.";
@@ -64,10 +68,14 @@ int main(int argc, char* argv[])
   TCLAP::CmdLine cmd(info, '=', GIT_TAGGED_VERSION);
   // Define Arguments
     // <SOURCE>
-  TCLAP::UnlabeledValueArg<std::string> source_arg("source", "The source gcode file to convert.", true, "", "path to source gcode file");
+  arg_description_stream << "The source gcode file to convert.  Use " << ARC_WELDER_STANDARD_STREAM_PATH << " to read from standard input, which allows the gcode to be converted while it is being generated.";
+  TCLAP::UnlabeledValueArg<std::string> source_arg("source", arg_description_stream.str(), true, "", "path to source gcode file");
 
   // <TARGET>
-  TCLAP::UnlabeledValueArg<std::string> target_arg("target", "The target gcode file containing the converted code. If this is not supplied, the source path will be used and the source file will be overwritten.", false, "", "path to target gcode file");
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The target gcode file containing the converted code. If this is not supplied, the source path will be used and the source file will be overwritten.  Use " << ARC_WELDER_STANDARD_STREAM_PATH << " to write to standard output, in which case all messages are written to standard error.  When reading from standard input, the default target is standard output.";
+  TCLAP::UnlabeledValueArg<std::string> target_arg("target", arg_description_stream.str(), false, "", "path to target gcode file");
 
   // -g --g90-influences-extruder
   arg_description_stream.clear();
@@ -146,6 +154,99 @@ int main(int argc, char* argv[])
   arg_description_stream << "The maximum length allowed for a generated G2/G3 command, not including any comments. 0 = no limit. Restrictions: Can be set to 0, or values > 30. Default Value: " << DEFAULT_MAX_GCODE_LENGTH;
   TCLAP::ValueArg<int> max_gcode_length_arg("c", "max-gcode-length", arg_description_stream.str(), false, DEFAULT_MAX_GCODE_LENGTH, "int");
 
+  // -f --exact-arc-fitting
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "If supplied, every candidate arc will be refit from scratch by searching all of its points, which is much slower but matches the output of previous versions. By default the best fit circle is updated incrementally as points are added. Default Value: " << DEFAULT_EXACT_ARC_FITTING;
+  TCLAP::SwitchArg exact_arc_fitting_arg("f", "exact-arc-fitting", arg_description_stream.str(), DEFAULT_EXACT_ARC_FITTING);
+
+  // -j --threads
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The number of worker threads used to weld the file. Values greater than 1 split the file into shards at layer changes and weld them in parallel. The output is identical to a single threaded run. Default Value: " << DEFAULT_THREADS;
+  TCLAP::ValueArg<int> threads_arg("j", "threads", arg_description_stream.str(), false, DEFAULT_THREADS, "int");
+
+  // --pipeline
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "If supplied, the file is read, parsed, welded and written by separate pipeline stages, and --threads sets the number of parser threads. The utilization of each stage is logged once the file is complete. The output is identical to a single threaded run. Default Value: " << DEFAULT_PIPELINE;
+  TCLAP::SwitchArg pipeline_arg("", "pipeline", arg_description_stream.str(), DEFAULT_PIPELINE);
+
+  // --batch
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "If supplied, many files are converted at once. The source is either a directory or a text file that lists one source path per line. The target, if supplied, is the directory the converted files are written to, else each source file is overwritten. A combined summary is logged once every file is complete.";
+  TCLAP::SwitchArg batch_arg("", "batch", arg_description_stream.str(), false);
+
+  // --batch-glob
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "Selects the files to convert when the batch source is a directory. * matches any run of characters and ? matches any single character. Default Value: " << DEFAULT_BATCH_GLOB;
+  TCLAP::ValueArg<std::string> batch_glob_arg("", "batch-glob", arg_description_stream.str(), false, DEFAULT_BATCH_GLOB, "string");
+
+  // --batch-workers
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The number of files converted at once in batch mode, each by its own worker thread. 0 uses one worker per hardware thread. Default Value: " << DEFAULT_BATCH_WORKERS;
+  TCLAP::ValueArg<int> batch_workers_arg("", "batch-workers", arg_description_stream.str(), false, DEFAULT_BATCH_WORKERS, "int");
+
+  // --cache-directory
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "If supplied, converted files are cached in this directory, which is created if it doesn't exist. When a file with the same contents has already been converted with the same settings, the cached file is copied to the target instead of converting the source again. The cache is not used when reading from standard input or writing to standard output.";
+  TCLAP::ValueArg<std::string> cache_directory_arg("", "cache-directory", arg_description_stream.str(), false, DEFAULT_CACHE_DIRECTORY, "path");
+
+  // --cache-max-megabytes
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The maximum size of the cache directory in megabytes. The least recently used files are removed once the cache is larger than this. Restrictions: Only values greater than 0 are allowed. Default Value: " << DEFAULT_CACHE_MAX_MEGABYTES;
+  TCLAP::ValueArg<int> cache_max_megabytes_arg("", "cache-max-megabytes", arg_description_stream.str(), false, DEFAULT_CACHE_MAX_MEGABYTES, "int");
+
+  // --index-path
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "If supplied, a layer index of the source file is read from this path, or is built and saved here if it is missing or was built from a different source file. The index lists the offset of every layer, and is used to split the file between threads at layer boundaries and to report the current layer with each progress update. The default extension is " << ARC_WELDER_INDEX_EXTENSION << ". The index is not used when reading from standard input.";
+  TCLAP::ValueArg<std::string> index_path_arg("", "index-path", arg_description_stream.str(), false, DEFAULT_INDEX_PATH, "path");
+
+  // --meatpack
+  std::vector<std::string> meatpack_mode_vector;
+  for (int index = 0; index < NUM_MEATPACK_MODES; index++)
+  {
+    meatpack_mode_vector.push_back(meatpack_mode_names[index]);
+  }
+  TCLAP::ValuesConstraint<std::string> meatpack_mode_constraint(meatpack_mode_vector);
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "Encodes the target for hosts that send gcode to Marlin or Prusa firmware with MeatPack. MINIMIZED removes comments, blank lines and spaces, leaving gcode that MeatPack packs efficiently. PACKED writes the packed bytes a MeatPack host would send, which can only be sent over serial, as is, by a host that does no processing of its own. The number of bytes that would be sent over serial is reported. Default Value: " << meatpack_mode_names[DEFAULT_MEATPACK_MODE];
+  TCLAP::ValueArg<std::string> meatpack_mode_arg("", "meatpack", arg_description_stream.str(), false, meatpack_mode_names[DEFAULT_MEATPACK_MODE], &meatpack_mode_constraint);
+
+  // --target-commands-per-second
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "If supplied, the resolution is loosened for moves that would need to be sent faster than this many commands per second to keep up with their feedrate, which lets more of the short, fast moves that cause stuttering be combined into arcs. The resolution is raised in proportion to how far over the target each move is, up to the max resolution, and slower moves still use the resolution. The max and percentile command rates of the source and target are reported. Restrictions: Only values greater than or equal to 0 are allowed, where 0 disables this feature. Default Value: " << DEFAULT_TARGET_COMMANDS_PER_SECOND;
+  TCLAP::ValueArg<double> target_commands_per_second_arg("", "target-commands-per-second", arg_description_stream.str(), false, DEFAULT_TARGET_COMMANDS_PER_SECOND, "float");
+
+  // --max-resolution-mm
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The largest resolution in mm that can be used when a target commands per second is supplied. Restrictions: Must be greater than or equal to the resolution. Default Value: " << DEFAULT_MAX_RESOLUTION_MM;
+  TCLAP::ValueArg<double> max_resolution_arg("", "max-resolution-mm", arg_description_stream.str(), false, DEFAULT_MAX_RESOLUTION_MM, "float");
+
+  // --feature-policy
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "Overrides the welding settings for one feature type, which are detected from slicer comments. May be supplied once per feature. Format: FEATURE[:SETTING=VALUE,...], for example outer_perimeter:resolution_mm=0.02 or infill:resolution_mm=0.1,allow_travel_arcs=true or bridge:enabled=false. Features: ";
+  for (int index = 0; index < NUM_FEATURE_TYPES; index++)
+  {
+    if (index > 0)
+    {
+      arg_description_stream << ", ";
+    }
+    arg_description_stream << feature_type_name[index];
+  }
+  arg_description_stream << ". Settings: enabled, resolution_mm, extrusion_rate_variance_percent, allow_travel_arcs. Any setting that isn't supplied uses the value of the matching argument.";
+  TCLAP::MultiArg<std::string> feature_policy_arg("", "feature-policy", arg_description_stream.str(), false, "string");
+
   // -p --progress-type
   std::vector<std::string> progress_type_vector;
   std::string progress_type_default_string = PROGRESS_TYPE_SIMPLE;
@@ -189,6 +290,19 @@ int main(int argc, char* argv[])
   cmd.add(default_e_precision_arg);
   cmd.add(extrusion_rate_variance_percent_arg);
   cmd.add(max_gcode_length_arg);
+  cmd.add(exact_arc_fitting_arg);
+  cmd.add(threads_arg);
+  cmd.add(pipeline_arg);
+  cmd.add(batch_arg);
+  cmd.add(batch_glob_arg);
+  cmd.add(batch_workers_arg);
+  cmd.add(cache_directory_arg);
+  cmd.add(cache_max_megabytes_arg);
+  cmd.add(index_path_arg);
+  cmd.add(meatpack_mode_arg);
+  cmd.add(target_commands_per_second_arg);
+  cmd.add(max_resolution_arg);
+  cmd.add(feature_policy_arg);
   cmd.add(g90_arg);
   cmd.add(progress_type_arg);
   cmd.add(log_level_arg);
@@ -201,11 +315,20 @@ int main(int argc, char* argv[])
     // Get the value parsed by each arg. 
     args.source_path = source_arg.getValue();
     args.target_path = target_arg.getValue();
+    is_batch = batch_arg.getValue();
+    batch_glob = batch_glob_arg.getValue();
+    batch_workers = batch_workers_arg.getValue();
 
-    if (args.target_path.size() == 0)
+    // In batch mode an empty target means every source file is overwritten.
+    if (args.target_path.size() == 0 && !is_batch)
     {
       args.target_path = args.source_path;
     }
+    if (args.target_path == ARC_WELDER_STANDARD_STREAM_PATH)
+    {
+      // Standard output carries the converted gcode, so send everything else to standard error.
+      std::cout.rdbuf(std::cerr.rdbuf());
+    }
 
     args.resolution_mm = resolution_arg.getValue();
     args.max_radius_mm = max_radius_arg.getValue();
@@ -220,12 +343,60 @@ int main(int argc, char* argv[])
     args.default_e_precision = static_cast<unsigned char>(default_e_precision_arg.getValue());
     args.extrusion_rate_variance_percent = extrusion_rate_variance_percent_arg.getValue();
     args.max_gcode_length = max_gcode_length_arg.getValue();
+    args.exact_arc_fitting = exact_arc_fitting_arg.getValue();
+    args.threads = threads_arg.getValue();
+    args.pipeline = pipeline_arg.getValue();
+    args.cache_directory = cache_directory_arg.getValue();
+    args.cache_max_megabytes = cache_max_megabytes_arg.getValue();
+    args.index_path = index_path_arg.getValue();
+    for (int index = 0; index < NUM_MEATPACK_MODES; index++)
+    {
+      if (meatpack_mode_arg.getValue() == meatpack_mode_names[index])
+      {
+        args.meatpack_mode = static_cast<arc_welder_meatpack_mode>(index);
+      }
+    }
+    args.target_commands_per_second = target_commands_per_second_arg.getValue();
+    args.max_resolution_mm = max_resolution_arg.getValue();
+    for (std::vector<std::string>::const_iterator it = feature_policy_arg.getValue().begin(); it != feature_policy_arg.getValue().end(); ++it)
+    {
+      arc_welder_feature_policy policy;
+      std::string error;
+      if (!arc_welder_feature_policy::try_parse(*it, policy, error))
+      {
+        throw TCLAP::ArgException(error, feature_policy_arg.toString());
+      }
+      args.feature_policies.push_back(policy);
+    }
     progress_type = progress_type_arg.getValue();
     log_level_string = log_level_arg.getValue();
     log_level_value = -1;
      
     // ensure the source file exists
-    if (!utilities::does_file_exist(args.source_path))
+    if (is_batch)
+    {
+      if (args.source_path == ARC_WELDER_STANDARD_STREAM_PATH || args.target_path == ARC_WELDER_STANDARD_STREAM_PATH)
+      {
+        throw TCLAP::ArgException("Standard input and output can't be used in batch mode.", batch_arg.toString());
+      }
+      if (args.index_path.size() > 0)
+      {
+        throw TCLAP::ArgException("A layer index can't be used in batch mode, since each file needs its own index.", index_path_arg.toString());
+      }
+      if (!arc_welder_batch::get_source_paths(args.source_path, batch_glob, batch_source_paths))
+      {
+        throw TCLAP::ArgException("The batch source is not a directory or a readable list of files.", source_arg.getName(), "File does not exist error");
+      }
+      if (args.target_path.size() > 0 && !utilities::is_directory(args.target_path))
+      {
+        throw TCLAP::ArgException("The batch target directory does not exist.", target_arg.getName(), "Directory does not exist error");
+      }
+      if (batch_workers < 0)
+      {
+        throw TCLAP::ArgException("The provided value is less than 0.", batch_workers_arg.toString());
+      }
+    }
+    else if (args.source_path != ARC_WELDER_STANDARD_STREAM_PATH && !utilities::does_file_exist(args.source_path))
     {
         throw TCLAP::ArgException("The source file does not exist at the specified path.", source_arg.getName(), "File does not exist error");
     }
@@ -302,6 +473,25 @@ int main(int argc, char* argv[])
     {
         throw TCLAP::ArgException("The provided value is less than or equal to 0.", max_radius_arg.toString());
     }
+    if (args.threads < 1)
+    {
+        throw TCLAP::ArgException("The provided value is less than 1.", threads_arg.toString());
+    }
+
+    if (args.cache_max_megabytes < 1)
+    {
+        throw TCLAP::ArgException("The provided value is less than 1.", cache_max_megabytes_arg.toString());
+    }
+
+    if (args.target_commands_per_second < 0)
+    {
+        throw TCLAP::ArgException("The provided value is negative.", target_commands_per_second_arg.toString());
+    }
+
+    if (args.target_commands_per_second > 0 && args.max_resolution_mm < args.resolution_mm)
+    {
+        throw TCLAP::ArgException("The provided value is less than the resolution.", max_resolution_arg.toString());
+    }
 
     if (args.extrusion_rate_variance_percent == 0)
     {
@@ -386,6 +576,21 @@ int main(int argc, char* argv[])
   // Set the box encoding
   args.box_encoding = args.box_encoding = utilities::box_drawing::ASCII;
 
+  if (is_batch)
+  {
+    arc_welder_batch batch(args, batch_source_paths, args.target_path, batch_workers, progress_type != PROGRESS_TYPE_NONE);
+    arc_welder_batch_results batch_results = batch.process();
+    log_messages.clear();
+    log_messages.str("");
+    log_messages << "\n" << batch_results.detail_str();
+    p_logger->log(0, log_levels::INFO, log_messages.str());
+    log_messages.clear();
+    log_messages.str("");
+    log_messages << "\n" << batch_results.str();
+    p_logger->log(0, log_levels::INFO, log_messages.str());
+    return 0;
+  }
+
   p_arc_welder = new arc_welder(args);
   
   arc_welder_results results = p_arc_welder->process();
@@ -413,6 +618,22 @@ int main(int argc, char* argv[])
     source_target_segment_statistics combined_stats = source_target_segment_statistics::add(results.progress.segment_statistics, results.progress.segment_retraction_statistics);
     log_messages << "\n" << combined_stats.str("Target File Extrusion Statistics", utilities::box_drawing::ASCII);
     p_logger->log(0, INFO, log_messages.str() );
+
+    if (results.progress.command_rate_summary.enabled)
+    {
+      log_messages.clear();
+      log_messages.str("");
+      log_messages << "\n" << results.progress.command_rate_summary.detail_str();
+      p_logger->log(0, INFO, log_messages.str());
+    }
+
+    if (progress_type == PROGRESS_TYPE_FULL && results.progress.stage_statistics.enabled)
+    {
+      log_messages.clear();
+      log_messages.str("");
+      log_messages << "\n" << results.progress.stage_statistics.detail_str();
+      p_logger->log(0, INFO, log_messages.str());
+    }
   
     
     
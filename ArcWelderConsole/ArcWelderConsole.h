@@ -24,6 +24,7 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "arc_welder.h"
+#include "arc_welder_batch.h"
 #include "version.h"
 static bool on_progress_full(arc_welder_progress progress, logger* p_logger, int logger_type);
 static bool on_progress_simple(arc_welder_progress progress, logger* p_logger, int logger_type);
@@ -0,0 +1,267 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Console Application
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Built using the 'Arc Welder: Anti Stutter' library
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "arc_welder_batch.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <set>
+#include <thread>
+#include <chrono>
+
+arc_welder_batch::arc_welder_batch(const arc_welder_args& args, const std::vector<std::string>& source_paths, const std::string& target_directory, int workers, bool log_each_file)
+{
+  args_ = args;
+  target_directory_ = target_directory;
+  workers_ = workers;
+  log_each_file_ = log_each_file;
+  next_file_index_ = 0;
+  files_finished_ = 0;
+  results_.box_encoding = args.box_encoding;
+  std::set<std::string> target_paths;
+  for (std::vector<std::string>::const_iterator it = source_paths.begin(); it != source_paths.end(); ++it)
+  {
+    arc_welder_batch_file_result file_result;
+    file_result.source_path = *it;
+    if (target_directory_.empty())
+    {
+      file_result.target_path = *it;
+    }
+    else
+    {
+      file_result.target_path = utilities::join_path(target_directory_, utilities::splitpath(*it).back());
+    }
+    if (!target_paths.insert(file_result.target_path).second)
+    {
+      // Two workers must never write the same file.
+      file_result.message = "Another file in the batch has the same target path.";
+    }
+    results_.files.push_back(file_result);
+  }
+}
+
+arc_welder_batch_results arc_welder_batch::process()
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int workers = workers_;
+  if (workers < 1)
+  {
+    workers = static_cast<int>(std::thread::hardware_concurrency());
+    if (workers < 1)
+    {
+      workers = 1;
+    }
+  }
+  if (static_cast<size_t>(workers) > results_.files.size())
+  {
+    workers = results_.files.size() > 0 ? static_cast<int>(results_.files.size()) : 1;
+  }
+  results_.workers = workers;
+
+  std::stringstream stream;
+  stream << "Converting " << results_.files.size() << " files with " << workers << (workers == 1 ? " worker." : " workers.");
+  args_.log->log(0, log_levels::INFO, stream.str());
+
+  if (workers == 1)
+  {
+    convert_files_();
+  }
+  else
+  {
+    std::vector<std::thread> threads;
+    for (int index = 0; index < workers; index++)
+    {
+      threads.push_back(std::thread(&arc_welder_batch::convert_files_, this));
+    }
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+    {
+      it->join();
+    }
+  }
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  results_.seconds = duration.count();
+  return results_;
+}
+
+bool arc_welder_batch::get_source_paths(const std::string& source, const std::string& glob, std::vector<std::string>& source_paths)
+{
+  source_paths.clear();
+  if (utilities::is_directory(source))
+  {
+    std::vector<std::string> file_names;
+    if (!utilities::get_directory_file_names(source, file_names))
+    {
+      return false;
+    }
+    for (std::vector<std::string>::iterator it = file_names.begin(); it != file_names.end(); ++it)
+    {
+      if (utilities::is_wildcard_match(*it, glob))
+      {
+        source_paths.push_back(utilities::join_path(source, *it));
+      }
+    }
+    return true;
+  }
+
+  std::ifstream list_file(source.c_str());
+  if (!list_file.is_open())
+  {
+    return false;
+  }
+  std::string line;
+  while (std::getline(list_file, line))
+  {
+    std::string path = utilities::trim(line);
+    if (!path.empty())
+    {
+      source_paths.push_back(path);
+    }
+  }
+  return true;
+}
+
+void arc_welder_batch::convert_files_()
+{
+  while (true)
+  {
+    size_t file_index;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (next_file_index_ >= results_.files.size())
+      {
+        return;
+      }
+      file_index = next_file_index_++;
+    }
+    // Only this worker touches the file's result until the batch finishes.
+    convert_file_(results_.files[file_index]);
+  }
+}
+
+void arc_welder_batch::convert_file_(arc_welder_batch_file_result& file_result)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  arc_welder_results results;
+  if (file_result.message.empty())
+  {
+    arc_welder_args args = args_;
+    args.source_path = file_result.source_path;
+    args.target_path = file_result.target_path;
+    args.callback = on_progress_;
+    arc_welder* p_arc_welder = new arc_welder(args);
+    results = p_arc_welder->process();
+    delete p_arc_welder;
+    file_result.success = results.success;
+    file_result.from_cache = results.from_cache;
+    file_result.message = results.message;
+    file_result.source_file_size = results.progress.source_file_size;
+    file_result.target_file_size = results.progress.target_file_size;
+    file_result.arcs_created = results.progress.arcs_created;
+  }
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+  file_result.seconds = duration.count();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  files_finished_++;
+  if (file_result.success)
+  {
+    results_.files_converted++;
+    results_.source_bytes += file_result.source_file_size;
+    results_.target_bytes += file_result.target_file_size;
+    results_.arcs_created += file_result.arcs_created;
+    results_.segment_statistics = source_target_segment_statistics::add(results_.segment_statistics, results.progress.segment_statistics);
+    results_.segment_statistics = source_target_segment_statistics::add(results_.segment_statistics, results.progress.segment_retraction_statistics);
+    results_.travel_statistics = source_target_segment_statistics::add(results_.travel_statistics, results.progress.travel_statistics);
+  }
+  else
+  {
+    results_.files_failed++;
+  }
+  if (log_each_file_ || !file_result.success)
+  {
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(2);
+    stream << "[" << files_finished_ << "/" << results_.files.size() << "] ";
+    if (file_result.success)
+    {
+      stream << (file_result.from_cache ? "Copied '" : "Converted '") << file_result.source_path << (file_result.from_cache ? "' from the cache in " : "' in ") << file_result.seconds << " seconds.";
+    }
+    else
+    {
+      stream << "Unable to convert '" << file_result.source_path << "': " << file_result.message;
+    }
+    args_.log->log(0, file_result.success ? log_levels::INFO : log_levels::ERROR, stream.str());
+  }
+}
+
+bool arc_welder_batch::on_progress_(arc_welder_progress /*progress*/, logger* /*p_logger*/, int /*logger_type*/)
+{
+  // Progress from several files at once isn't readable, so only finished files are reported.
+  return true;
+}
+
+std::string arc_welder_batch_results::str() const
+{
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(2);
+  stream << "Batch Results\n";
+  stream << std::setw(10) << "Seconds" << std::setw(14) << "Source" << std::setw(14) << "Target" << std::setw(10) << "Change" << "  File\n";
+  double file_seconds = 0;
+  for (std::vector<arc_welder_batch_file_result>::const_iterator it = files.begin(); it != files.end(); ++it)
+  {
+    file_seconds += it->seconds;
+    if (it->success)
+    {
+      stream << std::setw(10) << it->seconds << std::setw(14) << it->source_file_size << std::setw(14) << it->target_file_size;
+      stream << std::setw(9) << 100.0 * utilities::get_percent_change(static_cast<double>(it->source_file_size), static_cast<double>(it->target_file_size)) << "%";
+    }
+    else
+    {
+      stream << std::setw(10) << it->seconds << std::setw(38) << "FAILED";
+    }
+    stream << "  " << it->source_path << (it->from_cache ? " (cached)" : "") << "\n";
+  }
+  stream << "Converted " << files_converted << " of " << files.size() << " files";
+  if (files_failed > 0)
+  {
+    stream << " (" << files_failed << " failed)";
+  }
+  stream << " using " << workers << (workers == 1 ? " worker" : " workers") << " in " << seconds << " seconds (" << file_seconds << " seconds of conversion).\n";
+  stream << "Arcs created: " << arcs_created << "\n";
+  stream << "Source bytes: " << source_bytes << ", Target bytes: " << target_bytes << ", Bytes saved: " << source_bytes - target_bytes;
+  stream << " (" << 100.0 * utilities::get_percent_change(static_cast<double>(source_bytes), static_cast<double>(target_bytes)) << "%)";
+  return stream.str();
+}
+
+std::string arc_welder_batch_results::detail_str() const
+{
+  std::stringstream stream;
+  if (travel_statistics.total_count_source != travel_statistics.total_count_target)
+  {
+    stream << travel_statistics.str("Batch Travel Statistics", box_encoding) << "\n";
+  }
+  stream << segment_statistics.str("Batch Extrusion/Retraction Statistics", box_encoding);
+  return stream.str();
+}
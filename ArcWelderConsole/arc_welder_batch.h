@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Console Application
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Built using the 'Arc Welder: Anti Stutter' library
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "arc_welder.h"
+#include <string>
+#include <vector>
+#include <mutex>
+
+#define DEFAULT_BATCH_GLOB "*.gcode"
+// 0 uses one worker per hardware thread.
+#define DEFAULT_BATCH_WORKERS 0
+
+// The outcome of converting one file in a batch.
+struct arc_welder_batch_file_result
+{
+	arc_welder_batch_file_result()
+	{
+		success = false;
+		from_cache = false;
+		seconds = 0;
+		source_file_size = 0;
+		target_file_size = 0;
+		arcs_created = 0;
+	}
+	std::string source_path;
+	std::string target_path;
+	bool success;
+	bool from_cache;
+	std::string message;
+	// Wall clock time.  arc_welder_progress::seconds_elapsed is processor time, which is shared by every worker.
+	double seconds;
+	long source_file_size;
+	long target_file_size;
+	int arcs_created;
+};
+
+// The combined results of every file in a batch.
+struct arc_welder_batch_results
+{
+	arc_welder_batch_results() :
+		segment_statistics(segment_statistic_lengths, segment_statistic_lengths_count),
+		travel_statistics(segment_statistic_lengths, segment_statistic_lengths_count)
+	{
+		workers = 0;
+		seconds = 0;
+		files_converted = 0;
+		files_failed = 0;
+		source_bytes = 0;
+		target_bytes = 0;
+		arcs_created = 0;
+		box_encoding = utilities::box_drawing::BoxEncodingEnum::ASCII;
+	}
+	std::vector<arc_welder_batch_file_result> files;
+	// Extrusion and retraction statistics of every converted file.
+	source_target_segment_statistics segment_statistics;
+	source_target_segment_statistics travel_statistics;
+	int workers;
+	double seconds;
+	int files_converted;
+	int files_failed;
+	long long source_bytes;
+	long long target_bytes;
+	long long arcs_created;
+	utilities::box_drawing::BoxEncodingEnum box_encoding;
+	/// <summary>
+	/// Returns the time taken by each file followed by the totals.
+	/// </summary>
+	std::string str() const;
+	/// <summary>
+	/// Returns the combined segment statistics tables.  Travel statistics are only included if any travel moves were converted.
+	/// </summary>
+	std::string detail_str() const;
+};
+
+// Converts many files concurrently.  Each worker thread takes the next file from the list and converts it with its
+// own arc_welder, so a batch pays for process startup and argument parsing once instead of once per file.
+class arc_welder_batch
+{
+public:
+	/// <summary>
+	/// Creates a batch.  The source and target paths in args are ignored.
+	/// </summary>
+	/// <param name="target_directory">The directory the converted files are written to, using the source file names.  If empty, each source file is overwritten.</param>
+	/// <param name="workers">The number of files to convert at once.  0 uses one worker per hardware thread.</param>
+	/// <param name="log_each_file">Log a line each time a file finishes.</param>
+	arc_welder_batch(const arc_welder_args& args, const std::vector<std::string>& source_paths, const std::string& target_directory, int workers, bool log_each_file);
+	arc_welder_batch_results process();
+	/// <summary>
+	/// Gets the files to convert.  The source is either a directory, in which case the files matching the glob are used,
+	/// or a text file that lists one source path per line.
+	/// </summary>
+	/// <returns>False if the source could not be read.</returns>
+	static bool get_source_paths(const std::string& source, const std::string& glob, std::vector<std::string>& source_paths);
+private:
+	arc_welder_batch(const arc_welder_batch& source);
+	arc_welder_batch& operator=(const arc_welder_batch& source);
+	void convert_files_();
+	void convert_file_(arc_welder_batch_file_result& file_result);
+	static bool on_progress_(arc_welder_progress progress, logger* p_logger, int logger_type);
+	arc_welder_args args_;
+	std::string target_directory_;
+	int workers_;
+	bool log_each_file_;
+	arc_welder_batch_results results_;
+	// Guards next_file_index_, files_finished_ and the combined statistics in results_.
+	std::mutex mutex_;
+	size_t next_file_index_;
+	size_t files_finished_;
+};
@@ -1,3 +1,4 @@
 set(ArcWelderConsoleSources ${ArcWelderConsoleSources}
     ArcWelderConsole.cpp
+    arc_welder_batch.cpp
 )
\ No newline at end of file
@@ -223,6 +223,30 @@ int run_arc_straightener(int argc, char* argv[])
   std::string arg_name_mm_max_arc_error = firmware_arguments::get_argument_string(FIRMWARE_ARGUMENT_MM_MAX_ARC_ERROR, "", COMMAND_LINE_ARGUMENT_REPLACEMENT_STRING, COMMAND_LINE_ARGUMENT_REPLACEMENT_VALUE);
   TCLAP::ValueArg<double> mm_max_arc_error_arg("e", arg_name_mm_max_arc_error, arg_description_stream.str(), false, DEFAULT_MM_MAX_ARC_ERROR, "float");
 
+  // -j --threads
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The number of threads used to interpolate arcs. Values greater than 1 read the file in batches and interpolate the arcs in each batch on a separate thread, with one firmware instance per thread. The output is identical to a single threaded run. Default Value: " << DEFAULT_ARC_INTERPOLATION_THREADS;
+  TCLAP::ValueArg<int> threads_arg("j", "threads", arg_description_stream.str(), false, DEFAULT_ARC_INTERPOLATION_THREADS, "int");
+
+  // --compare
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "Compares firmware emulators instead of writing the target file.  The source is parsed once, every arc is interpolated by each firmware on its own thread, and a table of segment counts, segment lengths, output size and time is printed.  May be repeated.  Format: FIRMWARE_TYPE[:VERSION][:ARGUMENT=VALUE,...], for example " << firmware_type_names[MARLIN_2] << ":" << DEFAULT_FIRMWARE_VERSION_NAME << ":" << FIRMWARE_ARGUMENT_MM_PER_ARC_SEGMENT << "=0.5.  The version defaults to " << DEFAULT_FIRMWARE_VERSION_NAME << ", and any arguments that are not supplied use the defaults for that version.  The firmware settings supplied with the other arguments are only used to track the position.";
+  TCLAP::MultiArg<std::string> compare_arg("", "compare", arg_description_stream.str(), false, "FIRMWARE_TYPE[:VERSION][:ARGUMENT=VALUE,...]");
+
+  // --compare-output-directory
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "When comparing firmware, writes the output of each firmware to this directory as <source name>.<comparison>.gcode.  If not supplied, only the comparison table is printed.";
+  TCLAP::ValueArg<std::string> compare_output_directory_arg("", "compare-output-directory", arg_description_stream.str(), false, "", "path to output directory");
+
+  // --analyze-accuracy
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "Measures how far the interpolated segments stray from the true arcs, and prints histograms of the chord error and endpoint drift, the drift by the number of segments since the last " << FIRMWARE_ARGUMENT_N_ARC_CORRECTION << " correction, and the source lines with the worst segments.  When comparing firmware, a report is printed for each firmware.  Otherwise the arcs are interpolated on a single thread.";
+  TCLAP::SwitchArg analyze_accuracy_arg("", "analyze-accuracy", arg_description_stream.str());
+
   // -l --log-level
   std::vector<std::string> log_levels_vector;
   log_levels_vector.push_back("NOSET");
@@ -258,6 +282,10 @@ int run_arc_straightener(int argc, char* argv[])
   cmd.add(arc_segments_per_r_arg);
   cmd.add(print_firmware_defaults_arg);
   cmd.add(mm_max_arc_error_arg);
+  cmd.add(threads_arg);
+  cmd.add(compare_arg);
+  cmd.add(compare_output_directory_arg);
+  cmd.add(analyze_accuracy_arg);
 
   // First, we need to see if the user wants to print firmware defaults
   help_cmd.add(firmware_type_arg);
@@ -379,6 +407,30 @@ int run_arc_straightener(int argc, char* argv[])
     {
       args.target_path = args.source_path;
     }
+    args.threads = threads_arg.getValue();
+    if (args.threads < 1)
+    {
+        throw TCLAP::ArgException("The provided value is less than 1.", threads_arg.toString());
+    }
+
+    std::vector<std::string> comparison_strings = compare_arg.getValue();
+    for (std::vector<std::string>::iterator it = comparison_strings.begin(); it != comparison_strings.end(); ++it)
+    {
+      args.comparisons.push_back(parse_firmware_comparison(*it, compare_arg.toString()));
+    }
+    args.comparison_output_directory = compare_output_directory_arg.getValue();
+    args.analyze_accuracy = analyze_accuracy_arg.getValue();
+    if (args.comparison_output_directory.size() > 0)
+    {
+      if (args.comparisons.empty())
+      {
+        throw TCLAP::ArgException("The output directory can only be used when comparing firmware.", compare_output_directory_arg.toString());
+      }
+      if (!utilities::is_directory(args.comparison_output_directory))
+      {
+        throw TCLAP::ArgException("The output directory does not exist.", compare_output_directory_arg.toString());
+      }
+    }
 
     // ensure the source file exists
     if (!utilities::does_file_exist(args.source_path))
@@ -534,7 +586,8 @@ int run_arc_straightener(int argc, char* argv[])
   std::stringstream log_messages;
   std::string temp_file_path = "";
   log_messages << std::fixed << std::setprecision(DEFAULT_ARG_DOUBLE_PRECISION);
-  if (args.source_path == args.target_path)
+  bool is_comparing = !args.comparisons.empty();
+  if (!is_comparing && args.source_path == args.target_path)
   {
     overwrite_source_file = true;
     if (!utilities::get_temp_file_path_for_file(args.source_path, temp_file_path))
@@ -559,11 +612,27 @@ int run_arc_straightener(int argc, char* argv[])
     log_messages << "\tTarget File Path (overwrite) : " << args.target_path << "\n";
     log_messages << "\tTemporary File Path          : " << temp_file_path << "\n";
   }
-  else
+  else if (!is_comparing)
   {
     log_messages << "\tTarget File File             : " << args.target_path << "\n";
   }
 
+  if (is_comparing)
+  {
+    for (std::vector<arc_interpolation_comparison>::iterator it = args.comparisons.begin(); it != args.comparisons.end(); ++it)
+    {
+      log_messages << "\tCompare                      : " << it->name << "\n";
+    }
+    if (args.comparison_output_directory.size() > 0)
+    {
+      log_messages << "\tCompare Output Directory     : " << args.comparison_output_directory << "\n";
+    }
+  }
+  else
+  {
+    log_messages << "\tThreads                      : " << args.threads << "\n";
+  }
+  log_messages << "\tAnalyze Accuracy             : " << (args.analyze_accuracy ? "True" : "False") << "\n";
   log_messages << "\tLog Level                    : " << log_level_string << "\n";
 
 
@@ -583,7 +652,10 @@ int run_arc_straightener(int argc, char* argv[])
 
   log_messages.clear();
   log_messages.str("");
-  log_messages << "Target file at '" << args.target_path << "' created.";
+  if (!is_comparing)
+  {
+    log_messages << "Target file at '" << args.target_path << "' created.";
+  }
 
   if (overwrite_source_file)
   {
@@ -713,4 +785,107 @@ void print_firmware_defaults(std::string firmware_type_string, std::string firmw
     std::cout << "Showing arguments and defaults for " << firmware_type_string << " (" << firmware_version_string << ")\n";
     std::cout << "Available argument for firmware: " << args.firmware_args.get_available_arguments_string(COMMAND_LINE_ARGUMENT_SEPARATOR, COMMAND_LINE_ARGUMENT_PREFIX, COMMAND_LINE_ARGUMENT_REPLACEMENT_STRING, COMMAND_LINE_ARGUMENT_REPLACEMENT_VALUE) << "\n";
     std::cout << "Default " << args.firmware_args.get_arguments_description(COMMAND_LINE_ARGUMENT_SEPARATOR, COMMAND_LINE_ARGUMENT_PREFIX, COMMAND_LINE_ARGUMENT_REPLACEMENT_STRING, COMMAND_LINE_ARGUMENT_REPLACEMENT_VALUE);
-}
\ No newline at end of file
+}
+
+firmware_arguments get_default_firmware_arguments(firmware_types firmware_type, std::string firmware_version)
+{
+    firmware_arguments args;
+    args.firmware_type = firmware_type;
+    args.version = firmware_version;
+    marlin_1 marlin_1_firmware(args);
+    marlin_2 marlin_2_firmware(args);
+    repetier repetier_firmware(args);
+    prusa prusa_firmware(args);
+    smoothieware smoothieware_firmware(args);
+    switch (firmware_type)
+    {
+    case firmware_types::MARLIN_1:
+        marlin_1_firmware.set_arguments(args);
+        return marlin_1_firmware.get_default_arguments_for_current_version();
+    case firmware_types::MARLIN_2:
+        marlin_2_firmware.set_arguments(args);
+        return marlin_2_firmware.get_default_arguments_for_current_version();
+    case firmware_types::REPETIER:
+        repetier_firmware.set_arguments(args);
+        return repetier_firmware.get_default_arguments_for_current_version();
+    case firmware_types::PRUSA:
+        prusa_firmware.set_arguments(args);
+        return prusa_firmware.get_default_arguments_for_current_version();
+    case firmware_types::SMOOTHIEWARE:
+        smoothieware_firmware.set_arguments(args);
+        return smoothieware_firmware.get_default_arguments_for_current_version();
+    }
+    return args;
+}
+
+arc_interpolation_comparison parse_firmware_comparison(std::string text, std::string compare_arg_name)
+{
+    // FIRMWARE_TYPE[:VERSION][:ARGUMENT=VALUE,...]
+    std::string firmware_type_string = text;
+    std::string firmware_version_string = DEFAULT_FIRMWARE_VERSION_NAME;
+    std::string arguments_string = "";
+    size_t separator = text.find(':');
+    if (separator != std::string::npos)
+    {
+        firmware_type_string = text.substr(0, separator);
+        std::string remainder = text.substr(separator + 1);
+        separator = remainder.find(':');
+        if (separator != std::string::npos)
+        {
+            firmware_version_string = remainder.substr(0, separator);
+            arguments_string = remainder.substr(separator + 1);
+        }
+        else if (remainder.find('=') != std::string::npos)
+        {
+            arguments_string = remainder;
+        }
+        else
+        {
+            firmware_version_string = remainder;
+        }
+    }
+    firmware_type_string = utilities::trim(firmware_type_string);
+    std::transform(firmware_type_string.begin(), firmware_type_string.end(), firmware_type_string.begin(), ::toupper);
+    firmware_version_string = utilities::trim(firmware_version_string);
+    if (firmware_version_string.size() == 0)
+    {
+        firmware_version_string = DEFAULT_FIRMWARE_VERSION_NAME;
+    }
+
+    bool is_known_firmware_type = false;
+    for (int i = 0; i < NUM_FIRMWARE_TYPES; i++)
+    {
+        is_known_firmware_type = is_known_firmware_type || firmware_type_names[i] == firmware_type_string;
+    }
+    if (!is_known_firmware_type)
+    {
+        std::vector<std::string> firmware_types_vector(firmware_type_names, firmware_type_names + NUM_FIRMWARE_TYPES);
+        throw TCLAP::ArgException("Unknown firmware type '" + firmware_type_string + "' in '" + text + "'.  The available firmware types are: " + utilities::join(firmware_types_vector, ", "), compare_arg_name);
+    }
+    check_firmware_version_for_type(firmware_type_string, firmware_version_string, compare_arg_name);
+
+    arc_interpolation_comparison comparison;
+    comparison.name = utilities::trim(text);
+    comparison.firmware_args = get_default_firmware_arguments(static_cast<firmware_types>(get_firmware_type_from_string(firmware_type_string)), firmware_version_string);
+
+    std::stringstream arguments_stream(arguments_string);
+    std::string argument;
+    while (std::getline(arguments_stream, argument, ','))
+    {
+        if (utilities::trim(argument).size() == 0)
+        {
+            continue;
+        }
+        size_t equals = argument.find('=');
+        std::string error;
+        if (equals == std::string::npos)
+        {
+            throw TCLAP::ArgException("The firmware argument '" + argument + "' in '" + text + "' has no value.  Use ARGUMENT=VALUE.", compare_arg_name);
+        }
+        if (!comparison.firmware_args.try_set_argument(argument.substr(0, equals), argument.substr(equals + 1), error))
+        {
+            throw TCLAP::ArgException(error + "  Comparison: '" + text + "'.", compare_arg_name);
+        }
+    }
+    return comparison;
+}
@@ -34,10 +34,13 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "arc_interpolation.h"
 int run_arc_straightener(int argc, char* argv[]);
 static void check_firmware_version_for_type(std::string firmware_type_string, std::string firmware_version, std::string firmware_version_arg_name);
 static int get_firmware_type_from_string(std::string firmware_type);
 static void print_firmware_defaults(std::string firmware_type_string, std::string firmware_version_string, std::string firmware_version_arg_name);
+static firmware_arguments get_default_firmware_arguments(firmware_types firmware_type, std::string firmware_version);
+static arc_interpolation_comparison parse_firmware_comparison(std::string text, std::string compare_arg_name);
 
 /*
 static void TestInverseProcessor(std::string source_path, std::string target_path);
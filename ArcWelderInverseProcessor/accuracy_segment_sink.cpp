@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Inverse Processor (firmware simulator).  
+// Please see the copyright notices in the function definitions
+//
+// Converts G2/G3(arc) commands back to G0/G1 commands.  Intended to test firmware changes to improve arc support.
+// This reduces file size and the number of gcodes per second.
+// 
+// Based on arc interpolation implementations from:
+//    Marlin 1.x (see https://github.com/MarlinFirmware/Marlin/blob/1.0.x/LICENSE for the current license)
+//    Marlin 2.x (see https://github.com/MarlinFirmware/Marlin/blob/2.0.x/LICENSE for the current license)
+//    Prusa-Firmware (see https://github.com/prusa3d/Prusa-Firmware/blob/MK3/LICENSE for the current license)
+//    Smoothieware (see https://github.com/Smoothieware/Smoothieware for the current license)
+//    Repetier (see https://github.com/repetier/Repetier-Firmware for the current license)
+// 
+// Built using the 'Arc Welder: Anti Stutter' library
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "accuracy_segment_sink.h"
+#include "utilities.h"
+#include <cmath>
+#include <iomanip>
+
+// The upper bound of each histogram range except the last, which holds everything else.
+static const double accuracy_histogram_bounds_mm[ACCURACY_HISTOGRAM_BUCKETS - 1] = {
+  0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1
+};
+
+accuracy_segment_sink::accuracy_segment_sink(segment_sink& sink, int n_arc_correction) : sink_(sink)
+{
+  n_arc_correction_ = n_arc_correction > 1 ? n_arc_correction : 0;
+  line_number_ = 0;
+  is_measuring_arc_ = false;
+  segment_index_ = 0;
+  center_x_ = 0;
+  center_y_ = 0;
+  radius_ = 0;
+  previous_x_ = 0;
+  previous_y_ = 0;
+  num_segments_ = 0;
+  total_chord_error_mm_ = 0;
+  total_endpoint_drift_mm_ = 0;
+  max_chord_error_mm_ = 0;
+  max_endpoint_drift_mm_ = 0;
+  max_drift_by_interval_position_.resize(n_arc_correction_, 0);
+  total_drift_by_interval_position_.resize(n_arc_correction_, 0);
+  segments_by_interval_position_.resize(n_arc_correction_, 0);
+}
+
+void accuracy_segment_sink::set_line_number(int line_number)
+{
+  line_number_ = line_number;
+}
+
+void accuracy_segment_sink::begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise)
+{
+  is_measuring_arc_ = i != 0 || j != 0;
+  segment_index_ = 0;
+  center_x_ = start.x + i;
+  center_y_ = start.y + j;
+  radius_ = utilities::hypot(i, j);
+  previous_x_ = start.x;
+  previous_y_ = start.y;
+  sink_.begin_arc(start, target, i, j, r, is_clockwise);
+}
+
+void accuracy_segment_sink::add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state)
+{
+  if (is_measuring_arc_)
+  {
+    segment_index_++;
+    // The distance from the center changes along the segment as a convex function, so it is largest at one of the
+    // endpoints and smallest at the point closest to the center.  Those three distances bound the chord error.
+    double start_distance = utilities::hypot(previous_x_ - center_x_, previous_y_ - center_y_);
+    double end_distance = utilities::hypot(target.x - center_x_, target.y - center_y_);
+    double dx = target.x - previous_x_;
+    double dy = target.y - previous_y_;
+    double length_squared = dx * dx + dy * dy;
+    double closest_distance = start_distance < end_distance ? start_distance : end_distance;
+    if (length_squared > 0)
+    {
+      double t = ((center_x_ - previous_x_) * dx + (center_y_ - previous_y_) * dy) / length_squared;
+      if (t > 0 && t < 1)
+      {
+        closest_distance = utilities::hypot(previous_x_ + t * dx - center_x_, previous_y_ + t * dy - center_y_);
+      }
+    }
+    double farthest_distance = start_distance > end_distance ? start_distance : end_distance;
+    double chord_error_mm = std::fabs(farthest_distance - radius_);
+    if (std::fabs(closest_distance - radius_) > chord_error_mm)
+    {
+      chord_error_mm = std::fabs(closest_distance - radius_);
+    }
+    double endpoint_drift_mm = std::fabs(end_distance - radius_);
+
+    num_segments_++;
+    total_chord_error_mm_ += chord_error_mm;
+    total_endpoint_drift_mm_ += endpoint_drift_mm;
+    if (chord_error_mm > max_chord_error_mm_)
+    {
+      max_chord_error_mm_ = chord_error_mm;
+    }
+    if (endpoint_drift_mm > max_endpoint_drift_mm_)
+    {
+      max_endpoint_drift_mm_ = endpoint_drift_mm;
+    }
+    add_error_(chord_error_mm, chord_error_histogram_, worst_chord_errors_, line_number_, segment_index_);
+    add_error_(endpoint_drift_mm, endpoint_drift_histogram_, worst_endpoint_drifts_, line_number_, segment_index_);
+    if (n_arc_correction_ > 0)
+    {
+      int position = segment_index_ % n_arc_correction_;
+      segments_by_interval_position_[position]++;
+      total_drift_by_interval_position_[position] += endpoint_drift_mm;
+      if (endpoint_drift_mm > max_drift_by_interval_position_[position])
+      {
+        max_drift_by_interval_position_[position] = endpoint_drift_mm;
+      }
+    }
+    previous_x_ = target.x;
+    previous_y_ = target.y;
+  }
+  sink_.add_segment(current, target, state);
+}
+
+void accuracy_segment_sink::end_arc()
+{
+  is_measuring_arc_ = false;
+  sink_.end_arc();
+}
+
+void accuracy_segment_sink::add_error_(double error_mm, accuracy_histogram& histogram, std::vector<accuracy_location>& worst, int line_number, int segment_index)
+{
+  int bucket = 0;
+  while (bucket < ACCURACY_HISTOGRAM_BUCKETS - 1 && error_mm >= accuracy_histogram_bounds_mm[bucket])
+  {
+    bucket++;
+  }
+  histogram.counts[bucket]++;
+
+  if (worst.size() == ACCURACY_WORST_CASES && error_mm <= worst.back().error_mm)
+  {
+    return;
+  }
+  // Only the worst segment of each arc is kept, so that one bad arc can't fill the list.
+  for (std::vector<accuracy_location>::iterator it = worst.begin(); it != worst.end(); ++it)
+  {
+    if (it->line_number == line_number)
+    {
+      if (error_mm <= it->error_mm)
+      {
+        return;
+      }
+      worst.erase(it);
+      break;
+    }
+  }
+  accuracy_location location;
+  location.line_number = line_number;
+  location.segment_index = segment_index;
+  location.error_mm = error_mm;
+  std::vector<accuracy_location>::iterator insert_at = worst.begin();
+  while (insert_at != worst.end() && insert_at->error_mm >= error_mm)
+  {
+    ++insert_at;
+  }
+  worst.insert(insert_at, location);
+  if (worst.size() > ACCURACY_WORST_CASES)
+  {
+    worst.pop_back();
+  }
+}
+
+long long accuracy_segment_sink::get_num_segments() const
+{
+  return num_segments_;
+}
+
+double accuracy_segment_sink::get_max_chord_error_mm() const
+{
+  return max_chord_error_mm_;
+}
+
+double accuracy_segment_sink::get_max_endpoint_drift_mm() const
+{
+  return max_endpoint_drift_mm_;
+}
+
+double accuracy_segment_sink::get_mean_chord_error_mm() const
+{
+  return num_segments_ > 0 ? total_chord_error_mm_ / static_cast<double>(num_segments_) : 0;
+}
+
+double accuracy_segment_sink::get_mean_endpoint_drift_mm() const
+{
+  return num_segments_ > 0 ? total_endpoint_drift_mm_ / static_cast<double>(num_segments_) : 0;
+}
+
+void accuracy_segment_sink::append_histogram_(std::stringstream& stream, const accuracy_histogram& histogram, long long total)
+{
+  stream << "\t\t" << std::left << std::setw(22) << "Error (mm)" << std::right << std::setw(12) << "Segments" << std::setw(10) << "Percent" << "\r\n";
+  for (int bucket = 0; bucket < ACCURACY_HISTOGRAM_BUCKETS; bucket++)
+  {
+    std::stringstream range;
+    range << std::fixed << std::setprecision(4);
+    if (bucket == 0)
+    {
+      range << "< " << accuracy_histogram_bounds_mm[0];
+    }
+    else if (bucket == ACCURACY_HISTOGRAM_BUCKETS - 1)
+    {
+      range << ">= " << accuracy_histogram_bounds_mm[bucket - 1];
+    }
+    else
+    {
+      range << accuracy_histogram_bounds_mm[bucket - 1] << " - " << accuracy_histogram_bounds_mm[bucket];
+    }
+    double percent = total > 0 ? 100.0 * static_cast<double>(histogram.counts[bucket]) / static_cast<double>(total) : 0;
+    stream << "\t\t" << std::left << std::setw(22) << range.str() << std::right << std::setw(12) << histogram.counts[bucket]
+      << std::setw(9) << std::setprecision(2) << percent << "%\r\n";
+  }
+}
+
+void accuracy_segment_sink::append_worst_(std::stringstream& stream, const std::vector<accuracy_location>& worst)
+{
+  stream << "\t\t" << std::right << std::setw(10) << "Line" << std::setw(10) << "Segment" << std::setw(14) << "Error (mm)" << "\r\n";
+  for (std::vector<accuracy_location>::const_iterator it = worst.begin(); it != worst.end(); ++it)
+  {
+    stream << "\t\t" << std::setw(10) << it->line_number << std::setw(10) << it->segment_index << std::setw(14) << std::setprecision(6) << it->error_mm << "\r\n";
+  }
+}
+
+std::string accuracy_segment_sink::get_report() const
+{
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(6);
+  stream << "\tSegments Measured     : " << num_segments_ << "\r\n";
+  stream << "\tChord Error (mm)      : Max " << max_chord_error_mm_ << ", Mean " << get_mean_chord_error_mm() << "\r\n";
+  append_histogram_(stream, chord_error_histogram_, num_segments_);
+  stream << std::setprecision(6);
+  stream << "\tEndpoint Drift (mm)   : Max " << max_endpoint_drift_mm_ << ", Mean " << get_mean_endpoint_drift_mm() << "\r\n";
+  append_histogram_(stream, endpoint_drift_histogram_, num_segments_);
+  if (n_arc_correction_ > 0)
+  {
+    stream << "\tEndpoint Drift by Segments Since Correction (n_arc_correction=" << n_arc_correction_ << ")\r\n";
+    stream << "\t\t" << std::right << std::setw(10) << "Segments" << std::setw(14) << "Max (mm)" << std::setw(14) << "Mean (mm)" << "\r\n";
+    for (int position = 0; position < n_arc_correction_; position++)
+    {
+      double mean = segments_by_interval_position_[position] > 0 ? total_drift_by_interval_position_[position] / static_cast<double>(segments_by_interval_position_[position]) : 0;
+      stream << "\t\t" << std::setw(10) << position << std::setw(14) << std::setprecision(6) << max_drift_by_interval_position_[position] << std::setw(14) << mean << "\r\n";
+    }
+  }
+  stream << "\tWorst Chord Errors\r\n";
+  append_worst_(stream, worst_chord_errors_);
+  stream << "\tWorst Endpoint Drift\r\n";
+  append_worst_(stream, worst_endpoint_drifts_);
+  return stream.str();
+}
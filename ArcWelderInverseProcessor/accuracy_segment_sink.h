@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Inverse Processor (firmware simulator).  
+// Please see the copyright notices in the function definitions
+//
+// Converts G2/G3(arc) commands back to G0/G1 commands.  Intended to test firmware changes to improve arc support.
+// This reduces file size and the number of gcodes per second.
+// 
+// Based on arc interpolation implementations from:
+//    Marlin 1.x (see https://github.com/MarlinFirmware/Marlin/blob/1.0.x/LICENSE for the current license)
+//    Marlin 2.x (see https://github.com/MarlinFirmware/Marlin/blob/2.0.x/LICENSE for the current license)
+//    Prusa-Firmware (see https://github.com/prusa3d/Prusa-Firmware/blob/MK3/LICENSE for the current license)
+//    Smoothieware (see https://github.com/Smoothieware/Smoothieware for the current license)
+//    Repetier (see https://github.com/repetier/Repetier-Firmware for the current license)
+// 
+// Built using the 'Arc Welder: Anti Stutter' library
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "segment_sink.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The number of error ranges in the histograms.  The upper bounds of the ranges are in accuracy_segment_sink.cpp.
+#define ACCURACY_HISTOGRAM_BUCKETS 8
+// The number of worst segments that are kept for each metric.
+#define ACCURACY_WORST_CASES 10
+
+// Where a large error was found.
+struct accuracy_location
+{
+  accuracy_location()
+  {
+    line_number = 0;
+    segment_index = 0;
+    error_mm = 0;
+  }
+  // The source line containing the G2/G3 command.
+  int line_number;
+  // The position of the segment within the arc, starting at 1.
+  int segment_index;
+  double error_mm;
+};
+
+struct accuracy_histogram
+{
+  accuracy_histogram()
+  {
+    for (int index = 0; index < ACCURACY_HISTOGRAM_BUCKETS; index++)
+    {
+      counts[index] = 0;
+    }
+  }
+  long long counts[ACCURACY_HISTOGRAM_BUCKETS];
+};
+
+/// <summary>
+/// Measures how far the interpolated segments stray from the true arc, and passes every call on to another sink.
+/// The true arc is the circle around the start position plus I and J, with the radius of the start position, in the XY
+/// plane.  Two errors are measured for each segment:
+///   Chord error:  the largest distance between any point of the segment and the circle.  This includes the sagitta
+///                 of the chord as well as any drift of its endpoints.
+///   Endpoint drift:  the distance between the end of the segment and the circle, which is where the small angle
+///                    approximation errors build up between the n_arc_correction corrections.
+/// Both are calculated exactly from the segment endpoints, so no points are sampled.  Arcs without I and J (R form)
+/// are passed on but not measured, since none of the firmware emulators support them.
+/// </summary>
+class accuracy_segment_sink : public segment_sink
+{
+public:
+  /// <summary>
+  /// n_arc_correction should be the firmware's setting, or 0 if the firmware doesn't use one, and is used to report the
+  /// drift by the number of segments since the last correction.
+  /// </summary>
+  accuracy_segment_sink(segment_sink& sink, int n_arc_correction);
+  /// <summary>
+  /// Sets the source line reported for the segments of the following arcs.
+  /// </summary>
+  void set_line_number(int line_number);
+  virtual void begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise) override;
+  virtual void add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state) override;
+  virtual void end_arc() override;
+  long long get_num_segments() const;
+  double get_max_chord_error_mm() const;
+  double get_max_endpoint_drift_mm() const;
+  double get_mean_chord_error_mm() const;
+  double get_mean_endpoint_drift_mm() const;
+  /// <summary>
+  /// Returns the histograms, the drift by segments since the last correction, and the worst segments, formatted for
+  /// the console.
+  /// </summary>
+  std::string get_report() const;
+private:
+  static void add_error_(double error_mm, accuracy_histogram& histogram, std::vector<accuracy_location>& worst, int line_number, int segment_index);
+  static void append_histogram_(std::stringstream& stream, const accuracy_histogram& histogram, long long total);
+  static void append_worst_(std::stringstream& stream, const std::vector<accuracy_location>& worst);
+  segment_sink& sink_;
+  int n_arc_correction_;
+  int line_number_;
+  bool is_measuring_arc_;
+  int segment_index_;
+  double center_x_;
+  double center_y_;
+  double radius_;
+  // The end of the previous segment, or the start of the arc.
+  double previous_x_;
+  double previous_y_;
+  long long num_segments_;
+  double total_chord_error_mm_;
+  double total_endpoint_drift_mm_;
+  double max_chord_error_mm_;
+  double max_endpoint_drift_mm_;
+  accuracy_histogram chord_error_histogram_;
+  accuracy_histogram endpoint_drift_histogram_;
+  // The largest errors first.
+  std::vector<accuracy_location> worst_chord_errors_;
+  std::vector<accuracy_location> worst_endpoint_drifts_;
+  // Indexed by the number of segments since the last correction, where 0 is a corrected segment.
+  std::vector<double> max_drift_by_interval_position_;
+  std::vector<double> total_drift_by_interval_position_;
+  std::vector<long long> segments_by_interval_position_;
+};
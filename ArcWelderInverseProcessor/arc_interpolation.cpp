@@ -40,6 +40,66 @@
 #include "prusa.h"
 #include "smoothieware.h"
 #include "utilities.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+#include <cctype>
+#include <algorithm>
+
+// A batch of source lines, with the arcs captured as interpolation jobs.
+struct arc_interpolation_batch
+{
+  arc_interpolation_batch()
+  {
+    is_complete = false;
+    num_workers_remaining = 0;
+  }
+  std::vector<arc_interpolation_job> jobs;
+  bool is_complete;
+  std::exception_ptr exception;
+  // In comparison mode, the number of firmware workers that haven't interpolated this batch yet.
+  int num_workers_remaining;
+};
+
+// Batches waiting to be interpolated by the worker threads.  Batches are interpolated in any order, but are always
+// written in file order.
+struct arc_interpolation_batch_queue
+{
+  arc_interpolation_batch_queue()
+  {
+    is_finished = false;
+  }
+  std::mutex mutex;
+  std::condition_variable batch_added;
+  std::condition_variable batch_completed;
+  std::deque<arc_interpolation_batch*> pending_batches;
+  bool is_finished;
+};
+
+// Batches waiting to be interpolated by every firmware in comparison mode.  Each worker walks through all of the
+// batches in file order, and a batch is deleted once the last worker is done with it.
+struct arc_interpolation_comparison_queue
+{
+  arc_interpolation_comparison_queue()
+  {
+    first_batch_index = 0;
+    is_finished = false;
+  }
+  std::mutex mutex;
+  std::condition_variable batch_added;
+  std::condition_variable batch_completed;
+  std::deque<arc_interpolation_batch*> batches;
+  // The position of batches.front() within the file, counted in batches.
+  size_t first_batch_index;
+  bool is_finished;
+  // The first exception thrown by a worker.  The reader stops once this is set.
+  std::exception_ptr exception;
+};
 
 
 gcode_position_args arc_interpolation::get_args_(bool g90_g91_influences_extruder, int buffer_size)
@@ -78,30 +138,37 @@ gcode_position_args arc_interpolation::get_args_(bool g90_g91_influences_extrude
 arc_interpolation::arc_interpolation()
 {
   p_current_firmware_ = NULL;
+  p_source_position_ = NULL;
+  num_arc_commands_ = 0;
+  num_threaded_arc_segments_generated_ = 0;
 }
 
 arc_interpolation::arc_interpolation(arc_interpolation_args args) 
 {
   args_ = args;
-  switch (args.firmware_args.firmware_type)
+  num_arc_commands_ = 0;
+  num_threaded_arc_segments_generated_ = 0;
+  p_current_firmware_ = create_firmware_(args.firmware_args);
+  // Initialize the source position
+  p_source_position_ = new gcode_position(get_args_(p_current_firmware_->get_g90_g91_influences_extruder(), DEFAULT_GCODE_BUFFER_SIZE));
+}
+
+firmware* arc_interpolation::create_firmware_(firmware_arguments& args)
+{
+  switch (args.firmware_type)
   {
     case firmware_types::MARLIN_1:
-      p_current_firmware_ = new marlin_1(args.firmware_args);
-      break;
+      return new marlin_1(args);
     case firmware_types::MARLIN_2:
-      p_current_firmware_ = new marlin_2(args.firmware_args);
-      break;
+      return new marlin_2(args);
     case firmware_types::REPETIER:
-      p_current_firmware_ = new repetier(args.firmware_args);
-      break;
+      return new repetier(args);
     case firmware_types::PRUSA:
-      p_current_firmware_ = new prusa(args.firmware_args);
-      break;
+      return new prusa(args);
     case firmware_types::SMOOTHIEWARE:
-      p_current_firmware_ = new smoothieware(args.firmware_args);
+      return new smoothieware(args);
   }
-  // Initialize the source position
-  p_source_position_ = new gcode_position(get_args_(p_current_firmware_->get_g90_g91_influences_extruder(), DEFAULT_GCODE_BUFFER_SIZE));
+  return NULL;
 }
 
 arc_interpolation::~arc_interpolation()
@@ -119,21 +186,15 @@ void arc_interpolation::process()
   // Create a stringstream we can use for messaging.
   std::stringstream stream;
 
-  // Create a current and target position variable for arc processing
-  firmware_state state;
-  firmware_position current;
-  firmware_position target;
-  // I, J, and R parameter values
-  double i=0, j=0, r=0;
-  // bool values for is_clockwise and is_relative
-  bool is_clockwise = false, is_relative = false;
-  // e absolute offset, in case we are outputting absolute e
-  double offset_absolute_e = 0;
-
-  int read_lines_before_clock_check = 5000;
   //std::cout << "stabilization::process_file - Processing file.\r\n";
   stream << "Decompressing gcode file.";
   stream << "Source File: " << args_.source_path << "\n";
+  if (!args_.comparisons.empty())
+  {
+    std::cout << stream.str();
+    compare_();
+    return;
+  }
   stream << "Target File: " << args_.target_path << "\n";
   std::cout << stream.str();
   const clock_t start_clock = clock();
@@ -154,99 +215,64 @@ void arc_interpolation::process()
     {
       // Add the gcode file header
         output_file_ << p_current_firmware_->get_gcode_header_comment()<<"\n";
-      parsed_command cmd;
-      // Communicate every second
-      while (std::getline(gcode_file, line))
+      // The accuracy is measured with a single sink, so it is only available on a single thread.
+      if (args_.threads > 1 && !args_.analyze_accuracy)
       {
-        lines_processed_++;
-
-        cmd.clear();
-        parser.try_parse_gcode(line.c_str(), cmd);
-        bool has_gcode = false;
-        if (cmd.gcode.length() > 0)
-        {
-          has_gcode = true;
-          gcodes_processed++;
-        }
-        else
+        process_threaded_(gcode_file);
+      }
+      else
+      {
+        parsed_command cmd;
+        arc_interpolation_job job;
+        gcode_segment_sink gcode_sink(output_buffer_);
+        accuracy_segment_sink accuracy_sink(gcode_sink, get_n_arc_correction_(args_.firmware_args));
+        segment_sink& sink = args_.analyze_accuracy ? static_cast<segment_sink&>(accuracy_sink) : gcode_sink;
+        // Communicate every second
+        while (std::getline(gcode_file, line))
         {
-          lines_with_no_commands++;
-        }
+          lines_processed_++;
 
-        p_source_position_->update(cmd, lines_processed_, gcodes_processed, -1);
-
-        if (cmd.command == "G2" || cmd.command == "G3")
-        {
-          // increment the number of arc commands encountered
-          num_arc_commands_++;
-          // Get the current and previous positions
-          position* p_cur_pos = p_source_position_->get_current_position_ptr();
-          position* p_pre_pos = p_source_position_->get_previous_position_ptr();
-          // create the current and target positions
-          current.x = p_pre_pos->get_gcode_x();
-          current.y = p_pre_pos->get_gcode_y();
-          current.z = p_pre_pos->get_gcode_z();
-          current.e = p_pre_pos->get_current_extruder().get_offset_e();
-          current.f = p_pre_pos->f;
-          // set the current firmware position
-          p_current_firmware_->set_current_position(current);
-
-          target.x = p_cur_pos->get_gcode_x();
-          target.y = p_cur_pos->get_gcode_y();
-          target.z = p_cur_pos->get_gcode_z();
-          target.e = p_cur_pos->get_current_extruder().get_offset_e();
-          target.f = p_cur_pos->f;
-
-          state.is_extruder_relative = p_pre_pos->is_extruder_relative;
-          state.is_relative = p_pre_pos->is_relative;
-          // set the current firmware state
-          p_current_firmware_->set_current_state(state);
-          
-          // get I, J, and R
-          i = 0;
-          j = 0;
-          r = 0;
-          for (unsigned int index = 0; index < cmd.parameters.size(); index++)
+          cmd.clear();
+          parser.try_parse_gcode(line.c_str(), cmd);
+          bool has_gcode = false;
+          if (cmd.gcode.length() > 0)
           {
-            parsed_command_parameter p = cmd.parameters[index];
-            if (p.name == "I")
-            {
-              i = p.double_value;
-            }
-            else if (p.name == "J")
-            {
-              j = p.double_value;
-            }
-            else if (p.name == "R")
-            {
-              r = p.double_value;
-            }
+            has_gcode = true;
+            gcodes_processed++;
+          }
+          else
+          {
+            lines_with_no_commands++;
           }
 
-          // If r is 0, calculate the radius
-          if(r==0)
+          p_source_position_->update(cmd, lines_processed_, gcodes_processed, -1);
+
+          if (cmd.opcode == gcode_opcode_g2 || cmd.opcode == gcode_opcode_g3)
           {
-            r = utilities::hypot(i, j);
+            // increment the number of arc commands encountered
+            num_arc_commands_++;
+            get_arc_job_(cmd, job);
+            accuracy_sink.set_line_number(job.line_number);
+            // run the callback and capture any created gcode commands
+            interpolate_arc_(p_current_firmware_, job, output_buffer_, sink);
           }
-          
-          is_clockwise = cmd.command == "G2" ? 1 : 0;
-          is_relative = p_cur_pos->is_extruder_relative;
-          offset_absolute_e = p_pre_pos->get_current_extruder().get_offset_e();
-
-          // run the callback and capture any created gcode commands
-          std::string gcodes = p_current_firmware_->interpolate_arc(target, i, j, r, is_clockwise);
-          if (gcodes.length() > 0)
+          else
           {
-            // there are gcodes to write, write them!
-            output_file_ << gcodes << "\n";
+            // Nothing to do with the current line, just write it to disk.
+            output_buffer_.append(line);
+            output_buffer_.push_back('\n');
           }
+          if (output_buffer_.size() >= ARC_INTERPOLATION_OUTPUT_BUFFER_SIZE)
+          {
+            flush_output_buffer_();
+          }
+
         }
-        else
+        flush_output_buffer_();
+        if (args_.analyze_accuracy)
         {
-          // Nothing to do with the current line, just write it to disk.
-          output_file_ << line << "\n";
+          accuracy_report_ = accuracy_sink.get_report();
         }
-
       }
       output_file_.close();
     }
@@ -270,11 +296,536 @@ void arc_interpolation::process()
   stream << "Completed file processing\r\n";
   stream << "\tLines Processed       : " << lines_processed_ << "\r\n";
   stream << "\tArc Commands Processed: " << num_arc_commands_ << "\r\n";
-  stream << "\tArc Segments Generated: " << p_current_firmware_->get_num_arc_segments_generated() << "\r\n";
+  stream << "\tArc Segments Generated: " << p_current_firmware_->get_num_arc_segments_generated() + num_threaded_arc_segments_generated_ << "\r\n";
+  stream << "\tThreads               : " << (args_.threads > 1 && !args_.analyze_accuracy ? args_.threads : 1) << "\r\n";
   stream << "\tTotal Seconds         : " << total_seconds << "\r\n";
+  if (args_.analyze_accuracy)
+  {
+    stream << "Interpolation Accuracy\r\n" << accuracy_report_;
+  }
   std::cout << stream.str();
 }
 
+void arc_interpolation::get_arc_job_(parsed_command& cmd, arc_interpolation_job& job)
+{
+  // Get the current and previous positions
+  position* p_cur_pos = p_source_position_->get_current_position_ptr();
+  position* p_pre_pos = p_source_position_->get_previous_position_ptr();
+  job.is_arc = true;
+  job.line_number = lines_processed_;
+  // create the current and target positions
+  job.current.x = p_pre_pos->get_gcode_x();
+  job.current.y = p_pre_pos->get_gcode_y();
+  job.current.z = p_pre_pos->get_gcode_z();
+  job.current.e = p_pre_pos->get_current_extruder().get_offset_e();
+  job.current.f = p_pre_pos->f;
+
+  job.target.x = p_cur_pos->get_gcode_x();
+  job.target.y = p_cur_pos->get_gcode_y();
+  job.target.z = p_cur_pos->get_gcode_z();
+  job.target.e = p_cur_pos->get_current_extruder().get_offset_e();
+  job.target.f = p_cur_pos->f;
+
+  job.state.is_extruder_relative = p_pre_pos->is_extruder_relative;
+  job.state.is_relative = p_pre_pos->is_relative;
+
+  // get I, J, and R
+  job.i = 0;
+  job.j = 0;
+  job.r = 0;
+  for (unsigned int index = 0; index < cmd.parameters.size(); index++)
+  {
+    const parsed_command_parameter& p = cmd.parameters[index];
+    if (p.name == "I")
+    {
+      job.i = p.double_value;
+    }
+    else if (p.name == "J")
+    {
+      job.j = p.double_value;
+    }
+    else if (p.name == "R")
+    {
+      job.r = p.double_value;
+    }
+  }
+
+  // If r is 0, calculate the radius
+  if (job.r == 0)
+  {
+    job.r = utilities::hypot(job.i, job.j);
+  }
+
+  job.is_clockwise = cmd.opcode == gcode_opcode_g2;
+}
+
+void arc_interpolation::interpolate_arc_(firmware* p_firmware, arc_interpolation_job& job, std::string& gcode)
+{
+  gcode_segment_sink sink(gcode);
+  interpolate_arc_(p_firmware, job, gcode, sink);
+}
+
+void arc_interpolation::interpolate_arc_(firmware* p_firmware, arc_interpolation_job& job, std::string& gcode, segment_sink& sink)
+{
+  // set the current firmware position and state
+  p_firmware->set_current_position(job.current);
+  p_firmware->set_current_state(job.state);
+  // The segments are formatted straight into the output, and arcs that produce no segments are dropped, just like the
+  // firmware would.
+  size_t original_length = gcode.length();
+  p_firmware->interpolate_arc(job.target, job.i, job.j, job.r, job.is_clockwise, sink);
+  if (gcode.length() > original_length)
+  {
+    gcode.push_back('\n');
+  }
+}
+
+void arc_interpolation::flush_output_buffer_()
+{
+  output_file_.write(output_buffer_.c_str(), output_buffer_.length());
+  output_buffer_.clear();
+}
+
+void arc_interpolation::interpolate_batches_(arc_interpolation_batch_queue* p_queue, firmware* p_firmware)
+{
+  while (true)
+  {
+    arc_interpolation_batch* p_batch;
+    {
+      std::unique_lock<std::mutex> lock(p_queue->mutex);
+      while (p_queue->pending_batches.empty() && !p_queue->is_finished)
+      {
+        p_queue->batch_added.wait(lock);
+      }
+      if (p_queue->pending_batches.empty())
+      {
+        return;
+      }
+      p_batch = p_queue->pending_batches.front();
+      p_queue->pending_batches.pop_front();
+    }
+
+    try
+    {
+      for (std::vector<arc_interpolation_job>::iterator it = p_batch->jobs.begin(); it != p_batch->jobs.end(); ++it)
+      {
+        if (it->is_arc)
+        {
+          // Replace the source line with the interpolated segments.
+          it->gcode.clear();
+          interpolate_arc_(p_firmware, *it, it->gcode);
+        }
+      }
+    }
+    catch (...)
+    {
+      p_batch->exception = std::current_exception();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(p_queue->mutex);
+      p_batch->is_complete = true;
+    }
+    p_queue->batch_completed.notify_all();
+  }
+}
+
+void arc_interpolation::process_threaded_(std::ifstream& gcode_file)
+{
+  // Each arc only depends on the start position and state that the reader captures, so the reader tracks the position
+  // on its own while every worker interpolates with its own firmware instance.
+  size_t max_pending_batches = static_cast<size_t>(args_.threads) * ARC_INTERPOLATION_MAX_PENDING_BATCHES_PER_THREAD;
+  std::exception_ptr exception;
+  arc_interpolation_batch_queue queue;
+  std::vector<firmware*> worker_firmware;
+  std::vector<std::thread> workers;
+  for (int index = 0; index < args_.threads; index++)
+  {
+    worker_firmware.push_back(create_firmware_(args_.firmware_args));
+    workers.push_back(std::thread(&arc_interpolation::interpolate_batches_, this, &queue, worker_firmware.back()));
+  }
+  // Batches that have been queued but not yet written, in file order.
+  std::deque<arc_interpolation_batch*> batches;
+  gcode_parser parser;
+  parsed_command cmd;
+  int gcodes_processed = 0;
+  bool is_reading = true;
+  while (is_reading)
+  {
+    arc_interpolation_batch* p_batch = new arc_interpolation_batch();
+    is_reading = !exception && read_batch_(gcode_file, parser, cmd, gcodes_processed, *p_batch);
+
+    // Queue the batch for interpolation
+    {
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      queue.pending_batches.push_back(p_batch);
+      batches.push_back(p_batch);
+    }
+    queue.batch_added.notify_one();
+
+    // Write any batches that are complete, and wait for the oldest batch if too many are waiting to be written.
+    // Once reading is complete, wait for everything.
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    while (!batches.empty() && (batches.front()->is_complete || batches.size() > max_pending_batches || !is_reading))
+    {
+      arc_interpolation_batch* p_oldest_batch = batches.front();
+      while (!p_oldest_batch->is_complete)
+      {
+        queue.batch_completed.wait(lock);
+      }
+      batches.pop_front();
+      lock.unlock();
+      if (p_oldest_batch->exception && !exception)
+      {
+        exception = p_oldest_batch->exception;
+      }
+      if (!exception)
+      {
+        for (std::vector<arc_interpolation_job>::const_iterator it = p_oldest_batch->jobs.begin(); it != p_oldest_batch->jobs.end(); ++it)
+        {
+          output_buffer_.append(it->gcode);
+        }
+        flush_output_buffer_();
+      }
+      delete p_oldest_batch;
+      lock.lock();
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.is_finished = true;
+  }
+  queue.batch_added.notify_all();
+  for (size_t index = 0; index < workers.size(); index++)
+  {
+    workers[index].join();
+    num_threaded_arc_segments_generated_ += worker_firmware[index]->get_num_arc_segments_generated();
+    delete worker_firmware[index];
+  }
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+}
+
+bool arc_interpolation::read_batch_(std::ifstream& gcode_file, gcode_parser& parser, parsed_command& cmd, int& gcodes_processed, arc_interpolation_batch& batch)
+{
+  batch.jobs.reserve(ARC_INTERPOLATION_BATCH_LINES);
+  while (batch.jobs.size() < ARC_INTERPOLATION_BATCH_LINES)
+  {
+    batch.jobs.push_back(arc_interpolation_job());
+    arc_interpolation_job& job = batch.jobs.back();
+    if (!std::getline(gcode_file, job.gcode))
+    {
+      batch.jobs.pop_back();
+      return false;
+    }
+    lines_processed_++;
+    cmd.clear();
+    parser.try_parse_gcode(job.gcode.c_str(), cmd);
+    job.gcode.push_back('\n');
+    if (cmd.gcode.length() > 0)
+    {
+      gcodes_processed++;
+    }
+    p_source_position_->update(cmd, lines_processed_, gcodes_processed, -1);
+    if (cmd.opcode == gcode_opcode_g2 || cmd.opcode == gcode_opcode_g3)
+    {
+      num_arc_commands_++;
+      get_arc_job_(cmd, job);
+    }
+  }
+  return true;
+}
+
+std::string arc_interpolation::get_comparison_target_path_(const arc_interpolation_comparison& comparison) const
+{
+  // Name the file after the source and the comparison, replacing anything that isn't safe in a file name.
+  std::vector<std::string> source_path_parts = utilities::splitpath(args_.source_path);
+  std::string source_name = source_path_parts.empty() ? "output" : source_path_parts.back();
+  size_t extension_start = source_name.rfind('.');
+  if (extension_start != std::string::npos && extension_start > 0)
+  {
+    source_name = source_name.substr(0, extension_start);
+  }
+  std::string comparison_name = comparison.name;
+  for (std::string::iterator it = comparison_name.begin(); it != comparison_name.end(); ++it)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(*it)) && *it != '.' && *it != '-' && *it != '_')
+    {
+      *it = '_';
+    }
+  }
+  return utilities::join_path(args_.comparison_output_directory, source_name + "." + comparison_name + ".gcode");
+}
+
+void arc_interpolation::compare_batches_(arc_interpolation_comparison_queue* p_queue, size_t comparison_index)
+{
+  arc_interpolation_comparison_result& result = comparison_results_[comparison_index];
+  firmware_arguments firmware_args = args_.comparisons[comparison_index].firmware_args;
+  firmware* p_firmware = NULL;
+  std::ofstream output_file;
+  std::string gcode;
+  gcode_segment_sink gcode_sink(gcode);
+  accuracy_segment_sink accuracy_sink(gcode_sink, get_n_arc_correction_(firmware_args));
+  segment_statistics_sink statistics_sink(args_.analyze_accuracy ? static_cast<segment_sink&>(accuracy_sink) : gcode_sink);
+  bool is_failed = false;
+  try
+  {
+    p_firmware = create_firmware_(firmware_args);
+    gcode.append(p_firmware->get_gcode_header_comment()).push_back('\n');
+    if (!result.target_path.empty())
+    {
+      output_file.open(result.target_path.c_str());
+      if (!output_file.is_open())
+      {
+        throw std::runtime_error("Unable to open '" + result.target_path + "' for writing.");
+      }
+    }
+  }
+  catch (...)
+  {
+    is_failed = true;
+    std::unique_lock<std::mutex> lock(p_queue->mutex);
+    if (!p_queue->exception)
+    {
+      p_queue->exception = std::current_exception();
+    }
+  }
+
+  size_t batch_index = 0;
+  while (true)
+  {
+    arc_interpolation_batch* p_batch;
+    {
+      std::unique_lock<std::mutex> lock(p_queue->mutex);
+      while (batch_index >= p_queue->first_batch_index + p_queue->batches.size() && !p_queue->is_finished)
+      {
+        p_queue->batch_added.wait(lock);
+      }
+      if (batch_index >= p_queue->first_batch_index + p_queue->batches.size())
+      {
+        break;
+      }
+      p_batch = p_queue->batches[batch_index - p_queue->first_batch_index];
+    }
+
+    // A worker that failed still has to mark its batches as done so that the reader and the other workers can finish.
+    if (!is_failed)
+    {
+      try
+      {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (std::vector<arc_interpolation_job>::iterator it = p_batch->jobs.begin(); it != p_batch->jobs.end(); ++it)
+        {
+          if (it->is_arc)
+          {
+            accuracy_sink.set_line_number(it->line_number);
+            interpolate_arc_(p_firmware, *it, gcode, statistics_sink);
+          }
+          else
+          {
+            gcode.append(it->gcode);
+          }
+        }
+        result.bytes_generated += static_cast<long long>(gcode.length());
+        if (output_file.is_open())
+        {
+          output_file.write(gcode.c_str(), gcode.length());
+        }
+        gcode.clear();
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+      catch (...)
+      {
+        is_failed = true;
+        std::unique_lock<std::mutex> lock(p_queue->mutex);
+        if (!p_queue->exception)
+        {
+          p_queue->exception = std::current_exception();
+        }
+      }
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(p_queue->mutex);
+      p_batch->num_workers_remaining--;
+      while (!p_queue->batches.empty() && p_queue->batches.front()->num_workers_remaining == 0)
+      {
+        delete p_queue->batches.front();
+        p_queue->batches.pop_front();
+        p_queue->first_batch_index++;
+      }
+    }
+    p_queue->batch_completed.notify_all();
+    batch_index++;
+  }
+
+  if (output_file.is_open())
+  {
+    output_file.close();
+  }
+  result.num_arcs = statistics_sink.get_num_arcs();
+  result.num_segments = statistics_sink.get_num_segments();
+  result.min_segment_mm = statistics_sink.get_min_segment_mm();
+  result.max_segment_mm = statistics_sink.get_max_segment_mm();
+  if (args_.analyze_accuracy)
+  {
+    result.max_chord_error_mm = accuracy_sink.get_max_chord_error_mm();
+    result.max_endpoint_drift_mm = accuracy_sink.get_max_endpoint_drift_mm();
+    result.accuracy_report = accuracy_sink.get_report();
+  }
+  if (p_firmware != NULL)
+  {
+    delete p_firmware;
+  }
+}
+
+void arc_interpolation::compare_()
+{
+  const clock_t start_clock = clock();
+  std::ifstream gcode_file;
+  gcode_file.open(args_.source_path.c_str());
+  if (!gcode_file.is_open())
+  {
+    std::cout << "Unable to open the gcode file for processing.\n";
+    return;
+  }
+  gcode_file.sync_with_stdio(false);
+
+  comparison_results_.clear();
+  for (std::vector<arc_interpolation_comparison>::const_iterator it = args_.comparisons.begin(); it != args_.comparisons.end(); ++it)
+  {
+    arc_interpolation_comparison_result result;
+    result.name = it->name;
+    if (!args_.comparison_output_directory.empty())
+    {
+      result.target_path = get_comparison_target_path_(*it);
+    }
+    comparison_results_.push_back(result);
+  }
+
+  // The file is parsed and the position is tracked once, and every batch is shared by one worker per firmware.  The
+  // reader waits if the slowest worker falls too far behind.
+  size_t max_pending_batches = args_.comparisons.size() * ARC_INTERPOLATION_MAX_PENDING_BATCHES_PER_THREAD;
+  int num_workers = static_cast<int>(args_.comparisons.size());
+  arc_interpolation_comparison_queue queue;
+  std::vector<std::thread> workers;
+  for (size_t index = 0; index < args_.comparisons.size(); index++)
+  {
+    workers.push_back(std::thread(&arc_interpolation::compare_batches_, this, &queue, index));
+  }
+
+  gcode_parser parser;
+  parsed_command cmd;
+  int gcodes_processed = 0;
+  bool is_reading = true;
+  while (is_reading)
+  {
+    arc_interpolation_batch* p_batch = new arc_interpolation_batch();
+    p_batch->num_workers_remaining = num_workers;
+    is_reading = read_batch_(gcode_file, parser, cmd, gcodes_processed, *p_batch);
+    {
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      queue.batches.push_back(p_batch);
+      while (queue.batches.size() > max_pending_batches && !queue.exception)
+      {
+        queue.batch_completed.wait(lock);
+      }
+      is_reading = is_reading && !queue.exception;
+    }
+    queue.batch_added.notify_all();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.is_finished = true;
+  }
+  queue.batch_added.notify_all();
+  for (size_t index = 0; index < workers.size(); index++)
+  {
+    workers[index].join();
+  }
+  gcode_file.close();
+  if (queue.exception)
+  {
+    std::rethrow_exception(queue.exception);
+  }
+
+  const clock_t end_clock = clock();
+  const double total_seconds = (static_cast<double>(end_clock) - static_cast<double>(start_clock)) / CLOCKS_PER_SEC;
+
+  size_t name_width = 8;
+  for (std::vector<arc_interpolation_comparison_result>::const_iterator it = comparison_results_.begin(); it != comparison_results_.end(); ++it)
+  {
+    name_width = std::max(name_width, it->name.length());
+  }
+  std::stringstream stream;
+  stream << "Completed firmware comparison\r\n";
+  stream << "\tLines Processed       : " << lines_processed_ << "\r\n";
+  stream << "\tArc Commands Processed: " << num_arc_commands_ << "\r\n";
+  stream << "\tTotal Seconds         : " << total_seconds << "\r\n";
+  stream << std::left << std::setw(static_cast<int>(name_width)) << "Firmware" << std::right
+    << std::setw(12) << "Segments"
+    << std::setw(12) << "Min mm"
+    << std::setw(12) << "Max mm"
+    << std::setw(16) << "Bytes"
+    << std::setw(12) << "Seconds";
+  if (args_.analyze_accuracy)
+  {
+    stream << std::setw(14) << "Max Chord mm" << std::setw(14) << "Max Drift mm";
+  }
+  stream << "\r\n";
+  stream << std::fixed;
+  for (std::vector<arc_interpolation_comparison_result>::const_iterator it = comparison_results_.begin(); it != comparison_results_.end(); ++it)
+  {
+    stream << std::left << std::setw(static_cast<int>(name_width)) << it->name << std::right
+      << std::setw(12) << it->num_segments
+      << std::setprecision(4)
+      << std::setw(12) << it->min_segment_mm
+      << std::setw(12) << it->max_segment_mm
+      << std::setw(16) << it->bytes_generated
+      << std::setprecision(3)
+      << std::setw(12) << it->seconds;
+    if (args_.analyze_accuracy)
+    {
+      stream << std::setprecision(6) << std::setw(14) << it->max_chord_error_mm << std::setw(14) << it->max_endpoint_drift_mm;
+    }
+    stream << "\r\n";
+  }
+  if (args_.analyze_accuracy)
+  {
+    for (std::vector<arc_interpolation_comparison_result>::const_iterator it = comparison_results_.begin(); it != comparison_results_.end(); ++it)
+    {
+      stream << "Interpolation Accuracy for " << it->name << "\r\n" << it->accuracy_report;
+    }
+  }
+  for (std::vector<arc_interpolation_comparison_result>::const_iterator it = comparison_results_.begin(); it != comparison_results_.end(); ++it)
+  {
+    if (!it->target_path.empty())
+    {
+      stream << "Output for " << it->name << ": " << it->target_path << "\r\n";
+    }
+  }
+  std::cout << stream.str();
+}
+
+const std::vector<arc_interpolation_comparison_result>& arc_interpolation::get_comparison_results() const
+{
+  return comparison_results_;
+}
+
+std::string arc_interpolation::get_accuracy_report() const
+{
+  return accuracy_report_;
+}
+
+int arc_interpolation::get_n_arc_correction_(firmware_arguments& args)
+{
+  return args.is_argument_used(FIRMWARE_ARGUMENT_N_ARC_CORRECTION) ? args.n_arc_correction : 0;
+}
+
 std::string arc_interpolation::get_firmware_arguments_description(std::string separator, std::string argument_prefix, std::string replacement_string, std::string replacement_value) const
 {
   return p_current_firmware_->get_arguments_description(separator, argument_prefix, replacement_string, replacement_value);
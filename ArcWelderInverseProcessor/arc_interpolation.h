@@ -37,8 +37,91 @@
 #include <cstring>
 #include <fstream>
 #include "gcode_position.h"
+#include "accuracy_segment_sink.h"
+#include <vector>
 
 #define DEFAULT_GCODE_BUFFER_SIZE 50
+#define DEFAULT_ARC_INTERPOLATION_THREADS 1
+#define DEFAULT_ARC_INTERPOLATION_ANALYZE_ACCURACY false
+// The number of source lines in each batch that is handed to an interpolation thread.
+#define ARC_INTERPOLATION_BATCH_LINES 4096
+// The reader stops and writes the oldest batch once this many batches per thread are waiting to be written.
+#define ARC_INTERPOLATION_MAX_PENDING_BATCHES_PER_THREAD 4
+// The output buffer is written to the target file once it holds at least this many bytes.
+#define ARC_INTERPOLATION_OUTPUT_BUFFER_SIZE 65536
+
+// Everything needed to interpolate one G2/G3 command, captured by the reader so that the arc can be interpolated on any
+// thread.  For lines that aren't arcs, gcode holds the line to copy to the target.
+struct arc_interpolation_job
+{
+	arc_interpolation_job()
+	{
+		is_arc = false;
+		i = 0;
+		j = 0;
+		r = 0;
+		is_clockwise = false;
+		line_number = 0;
+	}
+	bool is_arc;
+	firmware_position current;
+	firmware_position target;
+	firmware_state state;
+	double i;
+	double j;
+	double r;
+	bool is_clockwise;
+	int line_number;
+	// The source line including the line break, which is replaced with the interpolated G1 commands once an arc is
+	// interpolated.
+	std::string gcode;
+};
+
+struct arc_interpolation_batch;
+struct arc_interpolation_batch_queue;
+struct arc_interpolation_comparison_queue;
+
+// One firmware emulator, with its own version and settings, to run in comparison mode.
+struct arc_interpolation_comparison
+{
+	/// <summary>
+	/// The name shown in the comparison table and used for the output file name.
+	/// </summary>
+	std::string name;
+	firmware_arguments firmware_args;
+};
+
+// The totals for one firmware emulator in comparison mode.
+struct arc_interpolation_comparison_result
+{
+	arc_interpolation_comparison_result()
+	{
+		num_arcs = 0;
+		num_segments = 0;
+		min_segment_mm = 0;
+		max_segment_mm = 0;
+		bytes_generated = 0;
+		seconds = 0;
+		max_chord_error_mm = 0;
+		max_endpoint_drift_mm = 0;
+	}
+	std::string name;
+	long long num_arcs;
+	long long num_segments;
+	double min_segment_mm;
+	double max_segment_mm;
+	// The size of the output, including the header and the lines that were copied from the source.
+	long long bytes_generated;
+	// The time spent interpolating and formatting, not including the time spent waiting for the reader.
+	double seconds;
+	// Empty unless an output directory was supplied.
+	std::string target_path;
+	// The accuracy is only measured when analyze_accuracy is set.
+	double max_chord_error_mm;
+	double max_endpoint_drift_mm;
+	std::string accuracy_report;
+};
+
 struct arc_interpolation_args
 {
 	arc_interpolation_args()
@@ -46,6 +129,8 @@ struct arc_interpolation_args
 		
 		source_path = "";
 		target_path = "";
+		threads = DEFAULT_ARC_INTERPOLATION_THREADS;
+		analyze_accuracy = DEFAULT_ARC_INTERPOLATION_ANALYZE_ACCURACY;
 	}
 	/// <summary>
 	/// Firmware arguments.  Not all options will apply to all firmware types.
@@ -59,6 +144,27 @@ struct arc_interpolation_args
 	/// Optional: the path to the target file.  If left blank the source file will be overwritten by the target.
 	/// </summary>
 	std::string target_path;
+	/// <summary>
+	/// Optional: the number of threads used to interpolate arcs.  Values greater than 1 interpolate batches of lines in
+	/// parallel, each thread with its own firmware instance, and write them in file order.
+	/// </summary>
+	int threads;
+	/// <summary>
+	/// Optional: when not empty, the source is parsed once and every arc is interpolated by each of these firmware
+	/// emulators, each on its own thread.  A comparison table is printed instead of writing the target file, and
+	/// firmware_args and threads are ignored.
+	/// </summary>
+	std::vector<arc_interpolation_comparison> comparisons;
+	/// <summary>
+	/// Optional: in comparison mode, the output of each firmware is written to this directory as
+	/// &lt;source name&gt;.&lt;comparison name&gt;.gcode.  Leave blank to only print the table.
+	/// </summary>
+	std::string comparison_output_directory;
+	/// <summary>
+	/// Optional: measures how far the interpolated segments stray from the true arcs (see accuracy_segment_sink) and
+	/// prints a report for each firmware.  The arcs are interpolated on a single thread, unless comparing firmware.
+	/// </summary>
+	bool analyze_accuracy;
 	
 };
 
@@ -75,16 +181,59 @@ class arc_interpolation
 		/// </summary>
 		/// <returns></returns>
 		std::string get_firmware_arguments_description(std::string separator = "", std::string argument_prefix = "", std::string replacement_string = "", std::string replacement_value = "") const;
+		/// <summary>
+		/// The results of the last comparison, in the same order as the comparisons.
+		/// </summary>
+		const std::vector<arc_interpolation_comparison_result>& get_comparison_results() const;
+		/// <summary>
+		/// The accuracy report from the last run without comparisons, if analyze_accuracy was set.
+		/// </summary>
+		std::string get_accuracy_report() const;
 	private:
 			arc_interpolation_args args_;
 			gcode_position_args get_args_(bool g90_g91_influences_extruder, int buffer_size);
+			static firmware* create_firmware_(firmware_arguments& args);
+			/// <summary>
+			/// Captures the arc in the current source position, which must be a G2 or G3 command, as an interpolation job.
+			/// </summary>
+			void get_arc_job_(parsed_command& cmd, arc_interpolation_job& job);
+			/// <summary>
+			/// Interpolates the arc, appending the G1 commands and a line break to gcode.
+			/// </summary>
+			static void interpolate_arc_(firmware* p_firmware, arc_interpolation_job& job, std::string& gcode);
+			/// <summary>
+			/// Interpolates the arc with a sink that formats the segments into gcode, appending a line break if any segments
+			/// were added.
+			/// </summary>
+			static void interpolate_arc_(firmware* p_firmware, arc_interpolation_job& job, std::string& gcode, segment_sink& sink);
+			void interpolate_batches_(arc_interpolation_batch_queue* p_queue, firmware* p_firmware);
+			void process_threaded_(std::ifstream& gcode_file);
+			/// <summary>
+			/// Reads up to ARC_INTERPOLATION_BATCH_LINES lines into the batch, tracking the position and capturing the arcs.
+			/// Returns false once the end of the file is reached.
+			/// </summary>
+			bool read_batch_(std::ifstream& gcode_file, gcode_parser& parser, parsed_command& cmd, int& gcodes_processed, arc_interpolation_batch& batch);
+			void compare_();
+			void compare_batches_(arc_interpolation_comparison_queue* p_queue, size_t comparison_index);
+			std::string get_comparison_target_path_(const arc_interpolation_comparison& comparison) const;
+			/// <summary>
+			/// The n_arc_correction setting to report the drift by, or 0 if the firmware doesn't use it.
+			/// </summary>
+			static int get_n_arc_correction_(firmware_arguments& args);
+			void flush_output_buffer_();
 			std::string source_path_;
 			std::string target_path_;
 			gcode_position* p_source_position_;
 			std::ofstream output_file_;
+			// Lines are gathered here and written to the output file in large blocks.
+			std::string output_buffer_;
 			int lines_processed_ = 0;
 			firmware* p_current_firmware_;
 			int num_arc_commands_;
+			// The number of segments generated by the interpolation threads, which each have their own firmware.
+			int num_threaded_arc_segments_generated_;
+			std::vector<arc_interpolation_comparison_result> comparison_results_;
+			std::string accuracy_report_;
   
 };
 
@@ -37,14 +37,37 @@
 firmware::firmware() {
   version_index_ = -1;
   num_arc_segments_generated_ = 0;
+  p_segment_sink_ = NULL;
 };
 
 firmware::firmware(firmware_arguments args) : args_(args) {
   version_index_ = -1;
   num_arc_segments_generated_ = 0;
+  p_segment_sink_ = NULL;
 };
 
+firmware::~firmware()
+{
+}
+
 std::string firmware::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise)
+{
+  std::string gcode;
+  gcode_segment_sink sink(gcode);
+  interpolate_arc(target, i, j, r, is_clockwise, sink);
+  return gcode;
+}
+
+void firmware::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise, segment_sink& sink)
+{
+  p_segment_sink_ = &sink;
+  sink.begin_arc(position_, target, i, j, r, is_clockwise);
+  interpolate_arc_segments(target, i, j, r, is_clockwise);
+  sink.end_arc();
+  p_segment_sink_ = NULL;
+}
+
+void firmware::interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise)
 {
   throw "Function not yet implemented";
 }
@@ -69,53 +92,10 @@ int firmware::get_num_arc_segments_generated()
   return num_arc_segments_generated_;
 }
 
-std::string firmware::g1_command(firmware_position& target)
+void firmware::add_segment(firmware_position& target)
 {
   num_arc_segments_generated_++;
-  std::string gcode = "G1 ";
-  gcode.reserve(96);
-
-  bool has_x = position_.x != target.x;
-  bool has_y = position_.y != target.y;
-  bool has_z = position_.z != target.z;
-  bool has_e = position_.e != target.e;
-  bool has_f = position_.f != target.f;
-  bool is_first_parameter = true;
-  if (has_x)
-  {
-    gcode += is_first_parameter ? "X" : " X";
-    gcode += utilities::dtos(state_.is_relative ? target.x - position_.x : target.x, 3);
-    is_first_parameter = false;
-  }
-
-  if (has_y)
-  {
-    gcode += is_first_parameter ? "Y" : " Y";
-    gcode += utilities::dtos(state_.is_relative ? target.y - position_.y : target.y, 3);
-    is_first_parameter = false;
-  }
-
-  if (has_z)
-  {
-    gcode += is_first_parameter ? "Z" : " Z";
-    gcode += utilities::dtos(state_.is_relative ? target.z - position_.z : target.z, 3);
-    is_first_parameter = false;
-  }
-
-  if (has_e)
-  {
-    gcode += is_first_parameter ? "E" : " E";
-    gcode += utilities::dtos(state_.is_extruder_relative ? target.e - position_.e : target.e, 5);
-    is_first_parameter = false;
-  }
-
-  if (has_f)
-  {
-    gcode += is_first_parameter ? "F" : " F";
-    gcode += utilities::dtos(target.f, 0);
-  }
-  
-  return gcode;
+  p_segment_sink_->add_segment(position_, target, state_);
 }
 
 bool firmware::is_valid_version(std::string version)
@@ -37,8 +37,10 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cstdlib>
 #include <utilities.h>
 #include "version.h"
+#include "segment_sink.h"
 
 #define DEFAULT_FIRMWARE_TYPE firmware_types::MARLIN_2
 #define LATEST_FIRMWARE_VERSION_NAME "LATEST_RELEASE"
@@ -61,30 +63,6 @@
 // This currently is only used in Smoothieware.   The maximum error for line segments that divide arcs.  Set to 0 to disable.
 #define DEFAULT_MM_MAX_ARC_ERROR 0
 
-struct firmware_state {
-  firmware_state() {
-    is_relative = false;
-    is_extruder_relative = false;
-  }
-  bool is_relative;
-  bool is_extruder_relative;
-};
-
-struct firmware_position {
-  firmware_position() {
-    x = 0;
-    y = 0;
-    z = 0;
-    e = 0;
-    f = 0;
-  }
-  double x;
-  double y;
-  double z;
-  double e;
-  double f;
-};
-
 // parameter name defines
 #define FIRMWARE_ARGUMENT_MM_PER_ARC_SEGMENT "mm_per_arc_segment"
 #define FIRMWARE_ARGUMENT_ARC_SEGMENT_PER_R "arc_segments_per_r"
@@ -406,6 +384,93 @@ public:
       return argument_prefix + utilities::replace(argument_name, replacement_string, replacement_value);
   }
 
+  /// <summary>
+  /// Sets an argument from text, for example "mm_per_arc_segment" and "0.5".  Dashes may be used in place of
+  /// underscores in the name.  Returns false and fills in error if the argument is unknown, doesn't apply to this
+  /// firmware version, or the value can't be parsed.
+  /// </summary>
+  bool try_set_argument(std::string argument_name, std::string value, std::string& error)
+  {
+    argument_name = utilities::replace(utilities::trim(argument_name), "-", "_");
+    value = utilities::trim(value);
+    if (std::find(all_arguments_.begin(), all_arguments_.end(), argument_name) == all_arguments_.end())
+    {
+      error = "Unknown firmware argument '" + argument_name + "'.";
+      return false;
+    }
+    if (!is_argument_used(argument_name))
+    {
+      error = "The argument '" + argument_name + "' does not apply to this firmware version.  Only the following parameters are supported: " + get_available_arguments_string(",");
+      return false;
+    }
+    bool is_valid = false;
+    if (argument_name == FIRMWARE_ARGUMENT_G90_G91_INFLUENCES_EXTRUDER)
+    {
+      std::string upper_value = value;
+      std::transform(upper_value.begin(), upper_value.end(), upper_value.begin(), ::toupper);
+      is_valid = upper_value == "TRUE" || upper_value == "FALSE";
+      g90_g91_influences_extruder = upper_value == "TRUE";
+    }
+    else if (argument_name == FIRMWARE_ARGUMENT_MIN_ARC_SEGMENTS || argument_name == FIRMWARE_ARGUMENT_MIN_CIRCLE_SEGMENTS || argument_name == FIRMWARE_ARGUMENT_N_ARC_CORRECTION)
+    {
+      char* end = NULL;
+      long int_value = std::strtol(value.c_str(), &end, 10);
+      is_valid = value.length() > 0 && *end == '\0';
+      if (argument_name == FIRMWARE_ARGUMENT_MIN_ARC_SEGMENTS)
+      {
+        min_arc_segments = static_cast<int>(int_value);
+      }
+      else if (argument_name == FIRMWARE_ARGUMENT_MIN_CIRCLE_SEGMENTS)
+      {
+        min_circle_segments = static_cast<int>(int_value);
+      }
+      else
+      {
+        n_arc_correction = static_cast<int>(int_value);
+      }
+    }
+    else
+    {
+      char* end = NULL;
+      double double_value = std::strtod(value.c_str(), &end);
+      is_valid = value.length() > 0 && *end == '\0';
+      if (argument_name == FIRMWARE_ARGUMENT_MM_PER_ARC_SEGMENT)
+      {
+        mm_per_arc_segment = double_value;
+      }
+      else if (argument_name == FIRMWARE_ARGUMENT_ARC_SEGMENT_PER_R)
+      {
+        arc_segments_per_r = double_value;
+      }
+      else if (argument_name == FIRMWARE_ARGUMENT_MIN_MM_PER_ARC_SEGMENT)
+      {
+        min_mm_per_arc_segment = double_value;
+      }
+      else if (argument_name == FIRMWARE_ARGUMENT_ARC_SEGMENTS_PER_SEC)
+      {
+        arc_segments_per_sec = double_value;
+      }
+      else if (argument_name == FIRMWARE_ARGUMENT_MM_MAX_ARC_ERROR)
+      {
+        mm_max_arc_error = double_value;
+      }
+      else if (argument_name == FIRMWARE_ARGUMENT_MIN_ARC_SEGMENT_MM)
+      {
+        min_arc_segment_mm = double_value;
+      }
+      else
+      {
+        max_arc_segment_mm = double_value;
+      }
+    }
+    if (!is_valid)
+    {
+      error = "The value '" + value + "' is not valid for the firmware argument '" + argument_name + "'.";
+      return false;
+    }
+    return true;
+  }
+
   private:
     std::vector<std::string> all_arguments_;
     std::vector<std::string> used_arguments_;
@@ -435,6 +500,8 @@ public:
 
   firmware(firmware_arguments args);
 
+  virtual ~firmware();
+
   /// <summary>
   /// Generate G1 gcode strings separated by line breaks representing the supplied G2/G3 command.
   /// </summary>
@@ -447,7 +514,18 @@ public:
   /// <param name="is_relative">If this is true, the extruder is currently in relative mode.  Else it is in absolute mode.</param>
   /// <param name="offest_absolute_e">This is the absolute offset for absolute E coordinates if the extruder is not in relative mode.</param>
   /// <returns></returns>
-  virtual std::string interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise);
+  std::string interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise);
+
+  /// <summary>
+  /// Interpolates the supplied G2/G3 command, sending each segment to the sink rather than formatting it into a string.
+  /// </summary>
+  /// <param name="target">The target printer position</param>
+  /// <param name="i">Specifies the X offset for the arc's center.</param>
+  /// <param name="j">Specifies the Y offset for the arc's center.</param>
+  /// <param name="r">Specifies the radius of the arc.</param>
+  /// <param name="is_clockwise">If true, this is a G2 command.  If false, this is a G3 command.</param>
+  /// <param name="sink">Receives the segments.</param>
+  void interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise, segment_sink& sink);
 
   /// <summary>
   /// Sets the current position.  Should be called before interpolate_arc.
@@ -460,13 +538,6 @@ public:
   /// </summary>
   /// <param name="state">The state to set</param>
   void set_current_state(firmware_state& state);
-  /// <summary>
-  /// Create a G1 command from the current position and offsets.
-  /// </summary>
-  /// <param name="target">The position of the printer after the G1 command is completed.</param>
-  /// <returns>The G1 command</returns>
-  virtual std::string g1_command(firmware_position& target);
-
   /// <summary>
   /// Checks a string to see if it is a valid version.
   /// </summary>
@@ -529,6 +600,18 @@ protected:
   std::vector<std::string> version_names_;
   int version_index_;
   int num_arc_segments_generated_;
+  segment_sink* p_segment_sink_;
+
+  /// <summary>
+  /// Interpolates the arc from the current position, calling add_segment for each segment.
+  /// </summary>
+  virtual void interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise);
+
+  /// <summary>
+  /// Sends a segment from the current position and offsets to the sink.
+  /// </summary>
+  /// <param name="target">The position of the printer after the segment is completed.</param>
+  void add_segment(firmware_position& target);
 
   virtual firmware_arguments arguments_changed(firmware_arguments current_args, firmware_arguments new_args);
 };
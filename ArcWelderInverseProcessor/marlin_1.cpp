@@ -42,7 +42,7 @@ marlin_1::marlin_1(firmware_arguments args) : firmware(args) {
 
 marlin_1::~marlin_1()
 {
-	delete current_position;
+	delete[] current_position;
 }
 
 void marlin_1::apply_arguments()
@@ -85,11 +85,8 @@ firmware_arguments marlin_1::get_default_arguments_for_current_version() const
 	return default_args;
 }
 
-std::string marlin_1::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise)
+void marlin_1::interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise)
 {
-	// Clear the current list of gcodes
-	gcodes_.clear();
-
 	// Setup the current position
 	current_position[X_AXIS] = static_cast<float>(position_.x);
 	current_position[Y_AXIS] = static_cast<float>(position_.y);
@@ -110,8 +107,6 @@ std::string marlin_1::interpolate_arc(firmware_position& target, double i, doubl
 	uint8_t marlin_isclockwise = is_clockwise ? 1 : 0;
 
 	(this->*plan_arc_)(marlin_target, marlin_offset, marlin_isclockwise);
-
-	return gcodes_;
 }
 
 /// <summary>
@@ -312,12 +307,7 @@ bool marlin_1::buffer_line_kinematic(const float(&cart)[MARLIN_XYZE], double fr_
 	target.z = cart[AxisEnum::Z_AXIS];
 	target.e = cart[AxisEnum::E_AXIS];
 	target.f = fr_mm_s;
-	if (gcodes_.size() > 0)
-	{
-		gcodes_ += "\n";
-	}
-	// Generate the gcode
-	gcodes_ += g1_command(target);
+	add_segment(target);
 
 	// update the current position
 	set_current_position(target);
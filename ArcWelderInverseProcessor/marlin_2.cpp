@@ -41,7 +41,7 @@ marlin_2::marlin_2(firmware_arguments args) : firmware(args) {
 
 marlin_2::~marlin_2()
 {
-  delete current_position;
+  delete[] current_position;
 }
 
 void marlin_2::apply_arguments()
@@ -99,11 +99,8 @@ firmware_arguments marlin_2::get_default_arguments_for_current_version() const
   return default_args;
 }
 
-std::string marlin_2::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise)
+void marlin_2::interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise)
 {
-  // Clear the current list of gcodes
-  gcodes_.clear();
-
   // Setup the current position
   current_position[X_AXIS] = static_cast<float>(position_.x);
   current_position[Y_AXIS] = static_cast<float>(position_.y);
@@ -124,8 +121,6 @@ std::string marlin_2::interpolate_arc(firmware_position& target, double i, doubl
   uint8_t marlin_isclockwise = is_clockwise ? 1 : 0;
 
   (this->*plan_arc_)(marlin_target, marlin_offset, marlin_isclockwise, 0);
-
-  return gcodes_;
 }
 
 /// <summary>
@@ -597,12 +592,7 @@ bool marlin_2::buffer_line(const float(&cart)[MARLIN_2_XYZE], double fr_mm_s, in
   target.z = cart[AxisEnum::Z_AXIS];
   target.e = cart[AxisEnum::E_AXIS];
   target.f = fr_mm_s;
-  if (gcodes_.size() > 0)
-  {
-    gcodes_ += "\n";
-  }
-  // Generate the gcode
-  gcodes_ += g1_command(target);
+  add_segment(target);
 
   return true;
 }
@@ -55,12 +55,11 @@ public:
   
   marlin_2(firmware_arguments args);
   virtual ~marlin_2();
-  virtual std::string interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise) override;
+  virtual void interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise) override;
   virtual firmware_arguments get_default_arguments_for_current_version() const override;
   virtual void apply_arguments() override;
 private:
   marlin_2_firmware_versions marlin_2_version_;
-  std::string gcodes_;
   float* current_position;
   float feedrate_mm_s;
   /// <summary>
@@ -97,10 +97,8 @@ firmware_arguments prusa::get_default_arguments_for_current_version() const
   return default_args;
 }
 
-std::string prusa::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise)
+void prusa::interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise)
 {
-  // Clear the current list of gcodes
-  gcodes_.clear();
   // Set up the necessary values to call mc_arc
   float prusa_position[4];
   prusa_position[X_AXIS] = static_cast<float>(position_.x);
@@ -125,8 +123,6 @@ std::string prusa::interpolate_arc(firmware_position& target, double i, double j
   uint8_t prusa_isclockwise = is_clockwise ? 1 : 0;
   
   (this->*mc_arc_)(prusa_position, prusa_target, prusa_offset, prusa_f, prusa_radius, prusa_isclockwise, 0);
-
-  return gcodes_;
 }
 
 /// <summary>
@@ -455,12 +451,7 @@ void prusa::plan_buffer_line(float x, float y, float z, const float& e, float fe
   target.z = z;
   target.e = e;
   target.f = feed_rate;
-  if (gcodes_.size() > 0)
-  {
-    gcodes_ += "\n";
-  }
-  // Generate the gcode
-  gcodes_ += g1_command(target);
+  add_segment(target);
 
   // update the current position
   set_current_position(target);
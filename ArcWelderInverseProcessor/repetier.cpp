@@ -90,10 +90,8 @@ repetier::~repetier()
 {
 }
 
-std::string repetier::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise)
+void repetier::interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise)
 {
-  // Clear the current list of gcodes
-  gcodes_.clear();
   // Set up the necessary values to call mc_arc
   float repetier_position[4];
   repetier_position[X_AXIS] = static_cast<float>(position_.x);
@@ -119,8 +117,6 @@ std::string repetier::interpolate_arc(firmware_position& target, double i, doubl
 
   feedrate = repetier_f;
   (this->*arc_)(repetier_position, repetier_target, repetier_offset, repetier_radius, repetier_isclockwise);
-
-  return gcodes_;
 }
 
 /// <summary>
@@ -448,12 +444,7 @@ void repetier::moveToReal(float x, float y, float z, float e)
   target.z = z;
   target.e = e;
   target.f = feedrate;
-  if (gcodes_.size() > 0)
-  {
-    gcodes_ += "\n";
-  }
-  // Generate the gcode
-  gcodes_ += g1_command(target);
+  add_segment(target);
 
   // update the current position
   set_current_position(target);
@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Inverse Processor (firmware simulator).  
+// Please see the copyright notices in the function definitions
+//
+// Converts G2/G3(arc) commands back to G0/G1 commands.  Intended to test firmware changes to improve arc support.
+// This reduces file size and the number of gcodes per second.
+// 
+// Based on arc interpolation implementations from:
+//    Marlin 1.x (see https://github.com/MarlinFirmware/Marlin/blob/1.0.x/LICENSE for the current license)
+//    Marlin 2.x (see https://github.com/MarlinFirmware/Marlin/blob/2.0.x/LICENSE for the current license)
+//    Prusa-Firmware (see https://github.com/prusa3d/Prusa-Firmware/blob/MK3/LICENSE for the current license)
+//    Smoothieware (see https://github.com/Smoothieware/Smoothieware for the current license)
+//    Repetier (see https://github.com/repetier/Repetier-Firmware for the current license)
+// 
+// Built using the 'Arc Welder: Anti Stutter' library
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "segment_sink.h"
+#include "utilities.h"
+#include <cmath>
+
+segment_sink::~segment_sink()
+{
+}
+
+void segment_sink::begin_arc(const firmware_position& /*start*/, const firmware_position& /*target*/, double /*i*/, double /*j*/, double /*r*/, bool /*is_clockwise*/)
+{
+}
+
+void segment_sink::end_arc()
+{
+}
+
+gcode_segment_sink::gcode_segment_sink(std::string& gcode) : gcode_(gcode)
+{
+  is_first_segment_ = true;
+}
+
+void gcode_segment_sink::begin_arc(const firmware_position& /*start*/, const firmware_position& /*target*/, double /*i*/, double /*j*/, double /*r*/, bool /*is_clockwise*/)
+{
+  is_first_segment_ = true;
+}
+
+void gcode_segment_sink::add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state)
+{
+  if (!is_first_segment_)
+  {
+    gcode_.push_back('\n');
+  }
+  is_first_segment_ = false;
+  append_g1_command(current, target, state, gcode_);
+}
+
+void gcode_segment_sink::append_g1_command(const firmware_position& current, const firmware_position& target, const firmware_state& state, std::string& gcode)
+{
+  char buffer[FIRMWARE_G1_BUFFER_LENGTH];
+  char* p = buffer;
+  *p++ = 'G';
+  *p++ = '1';
+  *p++ = ' ';
+
+  bool has_x = current.x != target.x;
+  bool has_y = current.y != target.y;
+  bool has_z = current.z != target.z;
+  bool has_e = current.e != target.e;
+  bool has_f = current.f != target.f;
+  bool is_first_parameter = true;
+  if (has_x)
+  {
+    *p++ = 'X';
+    utilities::append_fixed(p, state.is_relative ? target.x - current.x : target.x, 3);
+    is_first_parameter = false;
+  }
+
+  if (has_y)
+  {
+    if (!is_first_parameter) *p++ = ' ';
+    *p++ = 'Y';
+    utilities::append_fixed(p, state.is_relative ? target.y - current.y : target.y, 3);
+    is_first_parameter = false;
+  }
+
+  if (has_z)
+  {
+    if (!is_first_parameter) *p++ = ' ';
+    *p++ = 'Z';
+    utilities::append_fixed(p, state.is_relative ? target.z - current.z : target.z, 3);
+    is_first_parameter = false;
+  }
+
+  if (has_e)
+  {
+    if (!is_first_parameter) *p++ = ' ';
+    *p++ = 'E';
+    utilities::append_fixed(p, state.is_extruder_relative ? target.e - current.e : target.e, 5);
+    is_first_parameter = false;
+  }
+
+  if (has_f)
+  {
+    if (!is_first_parameter) *p++ = ' ';
+    *p++ = 'F';
+    utilities::append_fixed(p, target.f, 0);
+  }
+  
+  gcode.append(buffer, p - buffer);
+}
+
+binary_segment_sink::binary_segment_sink()
+{
+}
+
+void binary_segment_sink::begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise)
+{
+  binary_segment_arc arc;
+  arc.start = start;
+  arc.target = target;
+  arc.i = i;
+  arc.j = j;
+  arc.r = r;
+  arc.is_clockwise = is_clockwise;
+  arc.first_segment = segments_.size();
+  arc.num_segments = 0;
+  arcs_.push_back(arc);
+}
+
+void binary_segment_sink::add_segment(const firmware_position& /*current*/, const firmware_position& target, const firmware_state& /*state*/)
+{
+  segments_.push_back(target);
+  if (!arcs_.empty())
+  {
+    arcs_.back().num_segments++;
+  }
+}
+
+void binary_segment_sink::clear()
+{
+  arcs_.clear();
+  segments_.clear();
+}
+
+const std::vector<binary_segment_arc>& binary_segment_sink::get_arcs() const
+{
+  return arcs_;
+}
+
+const std::vector<firmware_position>& binary_segment_sink::get_segments() const
+{
+  return segments_;
+}
+
+segment_statistics_sink::segment_statistics_sink(segment_sink& sink) : sink_(sink)
+{
+  num_arcs_ = 0;
+  num_segments_ = 0;
+  min_segment_mm_ = 0;
+  max_segment_mm_ = 0;
+}
+
+void segment_statistics_sink::begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise)
+{
+  num_arcs_++;
+  previous_ = start;
+  sink_.begin_arc(start, target, i, j, r, is_clockwise);
+}
+
+void segment_statistics_sink::add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state)
+{
+  double dx = target.x - previous_.x;
+  double dy = target.y - previous_.y;
+  double dz = target.z - previous_.z;
+  double length_mm = std::sqrt(dx * dx + dy * dy + dz * dz);
+  if (num_segments_ == 0 || length_mm < min_segment_mm_)
+  {
+    min_segment_mm_ = length_mm;
+  }
+  if (num_segments_ == 0 || length_mm > max_segment_mm_)
+  {
+    max_segment_mm_ = length_mm;
+  }
+  num_segments_++;
+  previous_ = target;
+  sink_.add_segment(current, target, state);
+}
+
+void segment_statistics_sink::end_arc()
+{
+  sink_.end_arc();
+}
+
+long long segment_statistics_sink::get_num_arcs() const
+{
+  return num_arcs_;
+}
+
+long long segment_statistics_sink::get_num_segments() const
+{
+  return num_segments_;
+}
+
+double segment_statistics_sink::get_min_segment_mm() const
+{
+  return min_segment_mm_;
+}
+
+double segment_statistics_sink::get_max_segment_mm() const
+{
+  return max_segment_mm_;
+}
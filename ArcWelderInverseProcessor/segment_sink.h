@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Inverse Processor (firmware simulator).  
+// Please see the copyright notices in the function definitions
+//
+// Converts G2/G3(arc) commands back to G0/G1 commands.  Intended to test firmware changes to improve arc support.
+// This reduces file size and the number of gcodes per second.
+// 
+// Based on arc interpolation implementations from:
+//    Marlin 1.x (see https://github.com/MarlinFirmware/Marlin/blob/1.0.x/LICENSE for the current license)
+//    Marlin 2.x (see https://github.com/MarlinFirmware/Marlin/blob/2.0.x/LICENSE for the current license)
+//    Prusa-Firmware (see https://github.com/prusa3d/Prusa-Firmware/blob/MK3/LICENSE for the current license)
+//    Smoothieware (see https://github.com/Smoothieware/Smoothieware for the current license)
+//    Repetier (see https://github.com/repetier/Repetier-Firmware for the current license)
+// 
+// Built using the 'Arc Welder: Anti Stutter' library
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+
+// Large enough to hold a G1 command with every parameter at the maximum formatted number length.
+#define FIRMWARE_G1_BUFFER_LENGTH 160
+
+struct firmware_state {
+  firmware_state() {
+    is_relative = false;
+    is_extruder_relative = false;
+  }
+  bool is_relative;
+  bool is_extruder_relative;
+};
+
+struct firmware_position {
+  firmware_position() {
+    x = 0;
+    y = 0;
+    z = 0;
+    e = 0;
+    f = 0;
+  }
+  double x;
+  double y;
+  double z;
+  double e;
+  double f;
+};
+
+/// <summary>
+/// Receives the segments that a firmware emulator generates while interpolating an arc.
+/// </summary>
+class segment_sink
+{
+public:
+  virtual ~segment_sink();
+  /// <summary>
+  /// Called before the first segment of each arc with the arc exactly as it was commanded.
+  /// </summary>
+  /// <param name="start">The position before the arc.</param>
+  /// <param name="target">The position at the end of the arc.</param>
+  /// <param name="i">The X offset of the center from the start.</param>
+  /// <param name="j">The Y offset of the center from the start.</param>
+  /// <param name="r">The radius of the arc.</param>
+  /// <param name="is_clockwise">True for G2, false for G3.</param>
+  virtual void begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise);
+  /// <summary>
+  /// Called for each segment, in order.
+  /// </summary>
+  /// <param name="current">The firmware's current position, which is the arc start for firmware that doesn't track
+  /// the position between segments.  Axes that match the current position are left out of G1 commands.</param>
+  /// <param name="target">The end of the segment.</param>
+  /// <param name="state">The axis modes.</param>
+  virtual void add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state) = 0;
+  /// <summary>
+  /// Called after the last segment of each arc.
+  /// </summary>
+  virtual void end_arc();
+};
+
+/// <summary>
+/// Formats each segment as a G1 command, directly into the end of the supplied string.  The commands of an arc are
+/// separated by line breaks, and no line break is added after the last one.
+/// </summary>
+class gcode_segment_sink : public segment_sink
+{
+public:
+  gcode_segment_sink(std::string& gcode);
+  virtual void begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise) override;
+  virtual void add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state) override;
+  /// <summary>
+  /// Appends a G1 command for the segment to gcode without creating any intermediate strings.
+  /// </summary>
+  static void append_g1_command(const firmware_position& current, const firmware_position& target, const firmware_state& state, std::string& gcode);
+private:
+  std::string& gcode_;
+  bool is_first_segment_;
+};
+
+struct binary_segment_arc
+{
+  firmware_position start;
+  firmware_position target;
+  double i;
+  double j;
+  double r;
+  bool is_clockwise;
+  // The index of the first segment of the arc within the collected segments.
+  size_t first_segment;
+  size_t num_segments;
+};
+
+/// <summary>
+/// Collects the end point of every segment, and the arcs they belong to, without any text formatting.
+/// </summary>
+class binary_segment_sink : public segment_sink
+{
+public:
+  binary_segment_sink();
+  virtual void begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise) override;
+  virtual void add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state) override;
+  void clear();
+  const std::vector<binary_segment_arc>& get_arcs() const;
+  const std::vector<firmware_position>& get_segments() const;
+private:
+  std::vector<binary_segment_arc> arcs_;
+  std::vector<firmware_position> segments_;
+};
+
+/// <summary>
+/// Tracks the number and length of the segments and passes every call on to another sink.
+/// </summary>
+class segment_statistics_sink : public segment_sink
+{
+public:
+  segment_statistics_sink(segment_sink& sink);
+  virtual void begin_arc(const firmware_position& start, const firmware_position& target, double i, double j, double r, bool is_clockwise) override;
+  virtual void add_segment(const firmware_position& current, const firmware_position& target, const firmware_state& state) override;
+  virtual void end_arc() override;
+  long long get_num_arcs() const;
+  long long get_num_segments() const;
+  // The shortest and longest xyz segment lengths, which are both 0 until a segment is added.
+  double get_min_segment_mm() const;
+  double get_max_segment_mm() const;
+private:
+  segment_sink& sink_;
+  // The end of the previous segment, or the start of the arc.
+  firmware_position previous_;
+  long long num_arcs_;
+  long long num_segments_;
+  double min_segment_mm_;
+  double max_segment_mm_;
+};
@@ -86,11 +86,8 @@ firmware_arguments smoothieware::get_default_arguments_for_current_version() con
   return default_args;
 }
 
-std::string smoothieware::interpolate_arc(firmware_position& target, double i, double j, double r, bool is_clockwise)
+void smoothieware::interpolate_arc_segments(firmware_position& target, double i, double j, double r, bool is_clockwise)
 {
-  // Clear the current list of gcodes
-  gcodes_.clear();
-
   // Setup the current position
   machine_position[X_AXIS] = static_cast<float>(position_.x);
   machine_position[Y_AXIS] = static_cast<float>(position_.y);
@@ -112,8 +109,6 @@ std::string smoothieware::interpolate_arc(firmware_position& target, double i, d
   uint8_t smoothieware_isclockwise = is_clockwise ? 1 : 0;
 
   (this->*append_arc_)(&gcode_, smoothieware_target, smoothieware_offset, radius, smoothieware_isclockwise);
-
-  return gcodes_;
 }
 // Append an arc to the queue ( cutting it into segments as needed )
 bool smoothieware::append_arc_2021_06_19(SmoothiewareGcode* gcode, const float target[], const float offset[], float radius, bool is_clockwise)
@@ -295,12 +290,7 @@ bool smoothieware::append_milestone(const float target[], double rate_mm_s)
   gcode_target.z = target[AxisEnum::Z_AXIS];
   gcode_target.e = target[AxisEnum::E_AXIS];
   gcode_target.f = rate_mm_min;
-  if (gcodes_.size() > 0)
-  {
-    gcodes_ += "\n";
-  }
-  // Generate the gcode
-  gcodes_ += g1_command(gcode_target);
+  add_segment(gcode_target);
 
   return true;
   return true;
@@ -1,4 +1,6 @@
 set(ArcWelderInverseProcessorSources ${ArcWelderInverseProcessorSources}
+    accuracy_segment_sink.cpp
+    accuracy_segment_sink.h
     arc_interpolation.h
     arc_interpolation.cpp
     arc_interpolation_structs.h
@@ -15,6 +17,8 @@ set(ArcWelderInverseProcessorSources ${ArcWelderInverseProcessorSources}
     prusa.h
     repetier.cpp
     repetier.h
+    segment_sink.cpp
+    segment_sink.h
     smoothieware.cpp
     smoothieware.h
 )
\ No newline at end of file
@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if _MSC_VER > 1200
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#include "ArcWelderSerialSimulator.h"
+#include "logger.h"
+#include "utilities.h"
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <tclap/CmdLine.h>
+#include <tclap/tclap_version.h>
+
+int main(int argc, char* argv[])
+{
+  std::string info = "Arc Welder Serial Simulator\nSimulates sending a gcode file and its welded version to a printer over a serial link, and reports how long the printer spends waiting for the host.";
+  info.append("\nVersion: ").append(GIT_TAGGED_VERSION);
+  info.append(", Branch: ").append(GIT_BRANCH);
+  info.append(", BuildDate: ").append(BUILD_DATE);
+  info.append("\n").append("Copyright(C) ").append(COPYRIGHT_DATE).append(" - ").append(AUTHOR);
+  info.append("\n").append("Includes TCLAP v").append(TCLAP_VERSION_STRING).append(". ").append(TCLAP_COPYRIGHT_STRING);
+
+  std::stringstream arg_description_stream;
+  TCLAP::CmdLine cmd(info, '=', GIT_TAGGED_VERSION);
+
+  // <SOURCE>
+  TCLAP::UnlabeledValueArg<std::string> source_arg("source", "The source gcode file to simulate.", true, "", "path to source");
+
+  // <WELDED>
+  TCLAP::UnlabeledValueArg<std::string> welded_arg("welded", "The welded version of the source file. If this is not supplied, the source is welded to a temporary file first.", false, "", "path to welded file");
+
+  // -b --baud
+  arg_description_stream << "The baud rate of the serial link. Default Value: " << DEFAULT_SERIAL_BAUD_RATE;
+  TCLAP::ValueArg<long> baud_arg("b", "baud", arg_description_stream.str(), false, DEFAULT_SERIAL_BAUD_RATE, "int");
+
+  // --no-line-numbers
+  TCLAP::SwitchArg no_line_numbers_arg("", "no-line-numbers", "If supplied, the host does not add line numbers to each line.", false);
+
+  // --no-checksums
+  TCLAP::SwitchArg no_checksums_arg("", "no-checksums", "If supplied, the host does not add a checksum to each line.", false);
+
+  // --ok-latency-ms
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The time in milliseconds between the firmware queueing a command and the host sending the next line, not counting the time taken to send the 'ok'. This covers the USB polling interval and the time the host takes to respond. Default Value: " << DEFAULT_SERIAL_OK_LATENCY_MS;
+  TCLAP::ValueArg<double> ok_latency_arg("", "ok-latency-ms", arg_description_stream.str(), false, DEFAULT_SERIAL_OK_LATENCY_MS, "float");
+
+  // --planner-buffer
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The number of moves the firmware can plan ahead (BLOCK_BUFFER_SIZE in Marlin). Default Value: " << DEFAULT_SERIAL_PLANNER_BUFFER_SIZE;
+  TCLAP::ValueArg<int> planner_buffer_arg("", "planner-buffer", arg_description_stream.str(), false, DEFAULT_SERIAL_PLANNER_BUFFER_SIZE, "int");
+
+  // --mm-per-arc-segment
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The length of the segments the firmware divides arcs into (MM_PER_ARC_SEGMENT in Marlin). Default Value: " << DEFAULT_SERIAL_MM_PER_ARC_SEGMENT;
+  TCLAP::ValueArg<double> mm_per_arc_segment_arg("", "mm-per-arc-segment", arg_description_stream.str(), false, DEFAULT_SERIAL_MM_PER_ARC_SEGMENT, "float");
+
+  // -i --interval
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The length of each interval in the timeline, in seconds of print time. Default Value: " << DEFAULT_SERIAL_INTERVAL_SECONDS;
+  TCLAP::ValueArg<double> interval_arg("i", "interval", arg_description_stream.str(), false, DEFAULT_SERIAL_INTERVAL_SECONDS, "float");
+
+  // -t --timeline
+  TCLAP::ValueArg<std::string> timeline_arg("t", "timeline", "If supplied, the commands per second and stall time of every interval of both files are written to this path as CSV.", false, "", "path");
+
+  // -r --resolution-mm
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The resolution used when welding the source. Ignored when the welded file is supplied. Default Value: " << DEFAULT_RESOLUTION_MM;
+  TCLAP::ValueArg<double> resolution_arg("r", "resolution-mm", arg_description_stream.str(), false, DEFAULT_RESOLUTION_MM, "float");
+
+  // -m --max-gcode-length
+  arg_description_stream.clear();
+  arg_description_stream.str("");
+  arg_description_stream << "The maximum gcode length used when welding the source, where 0 is unlimited. Ignored when the welded file is supplied. Default Value: " << DEFAULT_MAX_GCODE_LENGTH;
+  TCLAP::ValueArg<int> max_gcode_length_arg("m", "max-gcode-length", arg_description_stream.str(), false, DEFAULT_MAX_GCODE_LENGTH, "int");
+
+  // -g --g90-influences-extruder
+  TCLAP::SwitchArg g90_arg("g", "g90-influences-extruder", "If supplied, G90/G91 also set the extruder to absolute/relative mode.", DEFAULT_G90_G91_INFLUENCES_EXTRUDER);
+
+  cmd.add(source_arg);
+  cmd.add(welded_arg);
+  cmd.add(baud_arg);
+  cmd.add(no_line_numbers_arg);
+  cmd.add(no_checksums_arg);
+  cmd.add(ok_latency_arg);
+  cmd.add(planner_buffer_arg);
+  cmd.add(mm_per_arc_segment_arg);
+  cmd.add(interval_arg);
+  cmd.add(timeline_arg);
+  cmd.add(resolution_arg);
+  cmd.add(max_gcode_length_arg);
+  cmd.add(g90_arg);
+
+  serial_simulator_args simulator_args;
+  std::string source_path;
+  std::string welded_path;
+  std::string timeline_path;
+  double resolution_mm;
+  int max_gcode_length;
+  try
+  {
+    cmd.parse(argc, argv);
+    source_path = source_arg.getValue();
+    welded_path = welded_arg.getValue();
+    timeline_path = timeline_arg.getValue();
+    resolution_mm = resolution_arg.getValue();
+    max_gcode_length = max_gcode_length_arg.getValue();
+    simulator_args.baud_rate = baud_arg.getValue();
+    simulator_args.line_numbers = !no_line_numbers_arg.getValue();
+    simulator_args.checksums = !no_checksums_arg.getValue();
+    simulator_args.ok_latency_ms = ok_latency_arg.getValue();
+    simulator_args.planner_buffer_size = planner_buffer_arg.getValue();
+    simulator_args.mm_per_arc_segment = mm_per_arc_segment_arg.getValue();
+    simulator_args.interval_seconds = interval_arg.getValue();
+    simulator_args.g90_g91_influences_extruder = g90_arg.getValue();
+    if (!utilities::does_file_exist(source_path))
+    {
+      throw TCLAP::ArgException("The source file does not exist at the specified path.", source_arg.getName(), "File does not exist error");
+    }
+    if (!welded_path.empty() && !utilities::does_file_exist(welded_path))
+    {
+      throw TCLAP::ArgException("The welded file does not exist at the specified path.", welded_arg.getName(), "File does not exist error");
+    }
+    if (simulator_args.baud_rate < 1)
+    {
+      throw TCLAP::ArgException("The provided value is less than 1.", baud_arg.toString());
+    }
+    if (simulator_args.ok_latency_ms < 0)
+    {
+      throw TCLAP::ArgException("The provided value is less than 0.", ok_latency_arg.toString());
+    }
+    if (simulator_args.planner_buffer_size < 1)
+    {
+      throw TCLAP::ArgException("The provided value is less than 1.", planner_buffer_arg.toString());
+    }
+    if (simulator_args.mm_per_arc_segment <= 0)
+    {
+      throw TCLAP::ArgException("The provided value is less than or equal to 0.", mm_per_arc_segment_arg.toString());
+    }
+    if (simulator_args.interval_seconds <= 0)
+    {
+      throw TCLAP::ArgException("The provided value is less than or equal to 0.", interval_arg.toString());
+    }
+    if (resolution_mm <= 0)
+    {
+      throw TCLAP::ArgException("The provided value is less than or equal to 0.", resolution_arg.toString());
+    }
+    if (max_gcode_length < 0)
+    {
+      throw TCLAP::ArgException("The provided value is less than 0.", max_gcode_length_arg.toString());
+    }
+  }
+  catch (TCLAP::ArgException& e)
+  {
+    cmd.getOutput()->failure(cmd, e);
+    return 1;
+  }
+
+  bool is_welded_temporary = welded_path.empty();
+  if (is_welded_temporary)
+  {
+    if (!utilities::get_temp_file_path_for_file(source_path, welded_path))
+    {
+      std::cerr << "Unable to create a temporary file path for the welded file.\n";
+      return 1;
+    }
+    std::vector<std::string> log_names;
+    log_names.push_back(ARC_WELDER_LOGGER_NAME);
+    std::vector<int> log_levels;
+    log_levels.push_back((int)log_levels::ERROR);
+    logger* p_logger = new logger(log_names, log_levels);
+    p_logger->set_log_level(log_levels::ERROR);
+    arc_welder_args args(source_path, welded_path, p_logger);
+    args.resolution_mm = resolution_mm;
+    args.max_gcode_length = max_gcode_length;
+    args.g90_g91_influences_extruder = simulator_args.g90_g91_influences_extruder;
+    args.callback = on_progress_serial_simulator;
+    std::cout << "Welding the source file with a resolution of " << resolution_mm << "mm.\n";
+    bool welded = weld_file(args);
+    delete p_logger;
+    if (!welded)
+    {
+      std::cerr << "Unable to weld the source file.\n";
+      std::remove(welded_path.c_str());
+      return 1;
+    }
+  }
+
+  serial_simulator simulator(simulator_args);
+  serial_simulator_results source_results;
+  serial_simulator_results welded_results;
+  bool success = simulator.simulate(source_path, source_results);
+  if (!success)
+  {
+    std::cerr << "Unable to read the source file.\n";
+  }
+  else if (!(success = simulator.simulate(welded_path, welded_results)))
+  {
+    std::cerr << "Unable to read the welded file.\n";
+  }
+  if (is_welded_temporary)
+  {
+    std::remove(welded_path.c_str());
+  }
+  if (!success)
+  {
+    return 1;
+  }
+
+  print_results(simulator_args, source_results, welded_results);
+  if (!timeline_path.empty() && !write_timeline(timeline_path, source_results, welded_results))
+  {
+    std::cerr << "Unable to write the timeline to '" << timeline_path << "'.\n";
+    return 1;
+  }
+  return 0;
+}
+
+static bool on_progress_serial_simulator(arc_welder_progress /*progress*/, logger* /*p_logger*/, int /*logger_type*/)
+{
+  return true;
+}
+
+static bool weld_file(const arc_welder_args& args)
+{
+  arc_welder welder(args);
+  arc_welder_results results = welder.process();
+  return results.success;
+}
+
+static long count_stalled_intervals(const serial_simulator_results& results)
+{
+  long count = 0;
+  for (std::vector<serial_simulator_interval>::const_iterator it = results.timeline.begin(); it != results.timeline.end(); ++it)
+  {
+    if (it->stall_seconds > 0)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+static void print_results(const serial_simulator_args& args, const serial_simulator_results& source_results, const serial_simulator_results& welded_results)
+{
+  std::cout << "Serial Simulation - " << args.baud_rate << " baud";
+  std::cout << (args.line_numbers ? ", line numbers" : "") << (args.checksums ? ", checksums" : "");
+  std::cout << std::fixed << std::setprecision(1) << ", " << args.ok_latency_ms << "ms ok latency";
+  std::cout << ", " << args.planner_buffer_size << " planner blocks";
+  std::cout << std::setprecision(3) << ", " << args.mm_per_arc_segment << "mm arc segments\n";
+  std::cout << std::left << std::setw(32) << "" << std::right << std::setw(16) << "Source" << std::setw(16) << "Welded" << "\n";
+  std::cout << std::left << std::setw(32) << "Lines Sent" << std::right << std::setw(16) << source_results.lines << std::setw(16) << welded_results.lines << "\n";
+  std::cout << std::left << std::setw(32) << "Bytes Sent" << std::right << std::setw(16) << source_results.bytes << std::setw(16) << welded_results.bytes << "\n";
+  std::cout << std::left << std::setw(32) << "Planner Blocks" << std::right << std::setw(16) << source_results.planner_blocks << std::setw(16) << welded_results.planner_blocks << "\n";
+  std::cout << std::setprecision(1);
+  std::cout << std::left << std::setw(32) << "Print Time (s)" << std::right << std::setw(16) << source_results.seconds << std::setw(16) << welded_results.seconds << "\n";
+  std::cout << std::left << std::setw(32) << "Time Moving (s)" << std::right << std::setw(16) << source_results.move_seconds << std::setw(16) << welded_results.move_seconds << "\n";
+  std::cout << std::left << std::setw(32) << "Stall Time (s)" << std::right << std::setw(16) << source_results.stall_seconds << std::setw(16) << welded_results.stall_seconds << "\n";
+  std::cout << std::left << std::setw(32) << "Stall Time (%)" << std::right << std::setw(16) << source_results.get_stall_percent() << std::setw(16) << welded_results.get_stall_percent() << "\n";
+  std::cout << std::left << std::setw(32) << "Stalls" << std::right << std::setw(16) << source_results.stalls << std::setw(16) << welded_results.stalls << "\n";
+  std::cout << std::left << std::setw(32) << "Intervals With Stalls" << std::right << std::setw(16) << count_stalled_intervals(source_results) << std::setw(16) << count_stalled_intervals(welded_results) << "\n";
+  std::cout << std::left << std::setw(32) << "Average Commands/s" << std::right << std::setw(16) << source_results.get_commands_per_second() << std::setw(16) << welded_results.get_commands_per_second() << "\n";
+  std::cout << std::left << std::setw(32) << "Peak Commands/s" << std::right << std::setw(16) << source_results.peak_commands_per_second << std::setw(16) << welded_results.peak_commands_per_second << "\n";
+}
+
+static bool write_timeline(const std::string& path, const serial_simulator_results& source_results, const serial_simulator_results& welded_results)
+{
+  std::ofstream file(path.c_str(), std::ios::out);
+  if (!file.is_open())
+  {
+    return false;
+  }
+  file << "file,start_seconds,commands,bytes,stall_seconds\n";
+  const serial_simulator_results* results[2] = { &source_results, &welded_results };
+  const char* names[2] = { "source", "welded" };
+  file << std::fixed;
+  for (int index = 0; index < 2; index++)
+  {
+    for (std::vector<serial_simulator_interval>::const_iterator it = results[index]->timeline.begin(); it != results[index]->timeline.end(); ++it)
+    {
+      file << names[index] << "," << std::setprecision(3) << it->start_seconds << "," << it->commands << "," << it->bytes << "," << std::setprecision(6) << it->stall_seconds << "\n";
+    }
+  }
+  file.close();
+  return !file.fail();
+}
@@ -0,0 +1,301 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "serial_simulator.h"
+#include "gcode_parser.h"
+#include "gcode_position.h"
+#include "line_reader.h"
+#include "utilities.h"
+#include <cstdio>
+
+double serial_simulator_results::get_commands_per_second() const
+{
+  return seconds > 0 ? static_cast<double>(commands) / seconds : 0;
+}
+
+double serial_simulator_results::get_stall_percent() const
+{
+  return seconds > 0 ? stall_seconds / seconds * 100.0 : 0;
+}
+
+serial_simulator::serial_simulator(const serial_simulator_args& args)
+{
+  args_ = args;
+  bytes_per_second_ = static_cast<double>(args_.baud_rate) / SERIAL_BITS_PER_BYTE;
+  time_ = 0;
+  machine_free_time_ = 0;
+  has_moved_ = false;
+}
+
+int serial_simulator::get_line_bytes_(const char* p_text, size_t length, long line_number, bool line_numbers, bool checksums)
+{
+  // The line is followed by a newline.
+  int bytes = static_cast<int>(length) + 1;
+  unsigned char checksum = 0;
+  if (line_numbers)
+  {
+    char prefix[32];
+    int prefix_length = snprintf(prefix, sizeof(prefix), "N%ld ", line_number);
+    bytes += prefix_length;
+    for (int index = 0; index < prefix_length; index++)
+    {
+      checksum ^= static_cast<unsigned char>(prefix[index]);
+    }
+  }
+  if (checksums)
+  {
+    for (size_t index = 0; index < length; index++)
+    {
+      checksum ^= static_cast<unsigned char>(p_text[index]);
+    }
+    // "*" followed by the checksum
+    bytes += checksum < 10 ? 2 : (checksum < 100 ? 3 : 4);
+  }
+  return bytes;
+}
+
+serial_simulator_interval& serial_simulator::get_interval_(double time, serial_simulator_results& results)
+{
+  size_t index = static_cast<size_t>(time / args_.interval_seconds);
+  while (results.timeline.size() <= index)
+  {
+    serial_simulator_interval interval;
+    interval.start_seconds = static_cast<double>(results.timeline.size()) * args_.interval_seconds;
+    results.timeline.push_back(interval);
+  }
+  return results.timeline[index];
+}
+
+void serial_simulator::add_stall_(double start, double end, serial_simulator_results& results)
+{
+  results.stall_seconds += end - start;
+  results.stalls++;
+  // Split the stall between the intervals it covers.
+  get_interval_(end, results);
+  size_t index = static_cast<size_t>(start / args_.interval_seconds);
+  for (; index < results.timeline.size() && start < end; index++)
+  {
+    serial_simulator_interval& interval = results.timeline[index];
+    double interval_end = interval.start_seconds + args_.interval_seconds;
+    double stall_end = end < interval_end ? end : interval_end;
+    if (stall_end > start)
+    {
+      interval.stall_seconds += stall_end - start;
+      start = stall_end;
+    }
+  }
+}
+
+void serial_simulator::add_block_(double duration, serial_simulator_results& results)
+{
+  // Blocks are removed from the planner once they have been executed.
+  while (!planner_.empty() && planner_.front() <= time_)
+  {
+    planner_.pop_front();
+  }
+  // Wait for room in the planner.
+  if (planner_.size() >= static_cast<size_t>(args_.planner_buffer_size))
+  {
+    time_ = planner_.front();
+    planner_.pop_front();
+  }
+  double start = machine_free_time_;
+  if (time_ > machine_free_time_)
+  {
+    // The printer finished everything in the planner before this block arrived.
+    if (has_moved_)
+    {
+      add_stall_(machine_free_time_, time_, results);
+    }
+    start = time_;
+  }
+  machine_free_time_ = start + duration;
+  planner_.push_back(machine_free_time_);
+  results.planner_blocks++;
+  results.move_seconds += duration;
+  has_moved_ = true;
+}
+
+void serial_simulator::synchronize_()
+{
+  // The command waits for every move to finish, so the time it takes to send the next line isn't a stall.
+  if (machine_free_time_ > time_)
+  {
+    time_ = machine_free_time_;
+  }
+  machine_free_time_ = time_;
+  planner_.clear();
+}
+
+bool serial_simulator::simulate(const std::string& path, serial_simulator_results& results)
+{
+  results = serial_simulator_results();
+  time_ = 0;
+  machine_free_time_ = 0;
+  planner_.clear();
+  has_moved_ = false;
+
+  line_reader reader;
+  if (!reader.open(path))
+  {
+    return false;
+  }
+  gcode_position_args position_args;
+  position_args.g90_influences_extruder = args_.g90_g91_influences_extruder;
+  position_args.position_buffer_size = 2;
+  position_args.home_x_none = true;
+  position_args.home_y_none = true;
+  position_args.home_z_none = true;
+  gcode_position positions(position_args);
+  gcode_parser parser;
+  parsed_command cmd;
+  const double ok_seconds = SERIAL_OK_BYTES / bytes_per_second_ + args_.ok_latency_ms / 1000.0;
+  const char* line;
+  long line_length;
+  long file_line_number = 0;
+  long long line_position = 0;
+  while (reader.read_line(line, line_length))
+  {
+    // Only the current line is referenced, so the earlier lines can be released.
+    reader.release(line_position);
+    line_position = reader.get_position();
+    file_line_number++;
+    cmd.clear();
+    parser.try_parse_source_line(line, static_cast<size_t>(line_length), cmd);
+    positions.update(cmd, file_line_number, results.commands, -1);
+    // Hosts strip comments and whitespace, and don't send empty lines.
+    const char* p_text = cmd.gcode.data();
+    size_t length = cmd.gcode.length();
+    while (length > 0 && (*p_text == ' ' || *p_text == '\t'))
+    {
+      p_text++;
+      length--;
+    }
+    while (length > 0 && (p_text[length - 1] == ' ' || p_text[length - 1] == '\t' || p_text[length - 1] == '\r'))
+    {
+      length--;
+    }
+    if (length == 0)
+    {
+      continue;
+    }
+    results.lines++;
+    int bytes = get_line_bytes_(p_text, length, results.lines, args_.line_numbers, args_.checksums);
+    results.bytes += bytes;
+    time_ += bytes / bytes_per_second_;
+    if (cmd.command.length() > 0)
+    {
+      results.commands++;
+    }
+    serial_simulator_interval& interval = get_interval_(time_, results);
+    interval.commands++;
+    interval.bytes += bytes;
+
+    const position* p_cur_pos = positions.get_current_position_ptr();
+    const position* p_pre_pos = positions.get_previous_position_ptr();
+    switch (cmd.opcode)
+    {
+    case gcode_opcode_g0:
+    case gcode_opcode_g1:
+    case gcode_opcode_g2:
+    case gcode_opcode_g3:
+    {
+      if (p_pre_pos->x_null || p_pre_pos->y_null || p_pre_pos->z_null)
+      {
+        break;
+      }
+      double feedrate = p_cur_pos->f_null || p_cur_pos->f <= 0 ? DEFAULT_SERIAL_FEEDRATE_MM_PER_MIN : p_cur_pos->f;
+      double mm_per_second = feedrate / 60.0;
+      double i = 0;
+      double j = 0;
+      if (cmd.opcode == gcode_opcode_g2 || cmd.opcode == gcode_opcode_g3)
+      {
+        for (std::vector<parsed_command_parameter>::const_iterator it = cmd.parameters.begin(); it != cmd.parameters.end(); ++it)
+        {
+          if (it->name == "I")
+          {
+            i = it->double_value;
+          }
+          else if (it->name == "J")
+          {
+            j = it->double_value;
+          }
+        }
+      }
+      if (i != 0 || j != 0)
+      {
+        // get_arc_distance takes the offset from the center to the start, which is the opposite of I and J.
+        double length_mm = utilities::get_arc_distance(p_pre_pos->x, p_pre_pos->y, p_pre_pos->z, p_cur_pos->x, p_cur_pos->y, p_cur_pos->z, -i, -j, utilities::hypot(i, j), cmd.opcode == gcode_opcode_g2);
+        int segments = static_cast<int>(length_mm / args_.mm_per_arc_segment);
+        if (segments < 1)
+        {
+          segments = 1;
+        }
+        for (int segment = 0; segment < segments; segment++)
+        {
+          add_block_(length_mm / segments / mm_per_second, results);
+        }
+        break;
+      }
+      double length_mm = utilities::get_cartesian_distance(p_pre_pos->x, p_pre_pos->y, p_pre_pos->z, p_cur_pos->x, p_cur_pos->y, p_cur_pos->z);
+      if (length_mm == 0)
+      {
+        // Retractions only move the extruder.
+        length_mm = utilities::abs(p_cur_pos->get_current_extruder().e_relative);
+      }
+      if (length_mm > 0)
+      {
+        add_block_(length_mm / mm_per_second, results);
+      }
+      break;
+    }
+    case gcode_opcode_g28:
+    case gcode_opcode_g29:
+    case gcode_opcode_m400:
+    // The time spent heating isn't known, so waiting for a temperature is treated like M400.
+    case gcode_opcode_m109:
+    case gcode_opcode_m116:
+    case gcode_opcode_m190:
+    case gcode_opcode_m191:
+    case GCODE_OPCODE('G', 4):
+      synchronize_();
+      break;
+    }
+    time_ += ok_seconds;
+  }
+  bool success = !reader.has_error();
+  reader.close();
+  // The print ends once the last move finishes.
+  results.seconds = machine_free_time_ > time_ ? machine_free_time_ : time_;
+  for (std::vector<serial_simulator_interval>::const_iterator it = results.timeline.begin(); it != results.timeline.end(); ++it)
+  {
+    double commands_per_second = it->commands / args_.interval_seconds;
+    if (commands_per_second > results.peak_commands_per_second)
+    {
+      results.peak_commands_per_second = commands_per_second;
+    }
+  }
+  return success;
+}
@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arc Welder: Anti-Stutter Library
+//
+// Compresses many G0/G1 commands into G2/G3(arc) commands where possible, ensuring the tool paths stay within the specified resolution.
+// This reduces file size and the number of gcodes per second.
+//
+// Uses the 'Gcode Processor Library' for gcode parsing, position processing, logging, and other various functionality.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address:
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+
+// Marlin's defaults: BLOCK_BUFFER_SIZE and MM_PER_ARC_SEGMENT
+#define DEFAULT_SERIAL_BAUD_RATE 115200
+#define DEFAULT_SERIAL_OK_LATENCY_MS 1.0
+#define DEFAULT_SERIAL_PLANNER_BUFFER_SIZE 16
+#define DEFAULT_SERIAL_MM_PER_ARC_SEGMENT 1.0
+#define DEFAULT_SERIAL_INTERVAL_SECONDS 1.0
+// Used until the gcode sets a feedrate.
+#define DEFAULT_SERIAL_FEEDRATE_MM_PER_MIN 1500.0
+// A start bit, 8 data bits and a stop bit (8N1).
+#define SERIAL_BITS_PER_BYTE 10
+// The firmware acknowledges every line with "ok\n".
+#define SERIAL_OK_BYTES 3
+
+struct serial_simulator_args
+{
+	serial_simulator_args()
+	{
+		baud_rate = DEFAULT_SERIAL_BAUD_RATE;
+		line_numbers = true;
+		checksums = true;
+		ok_latency_ms = DEFAULT_SERIAL_OK_LATENCY_MS;
+		planner_buffer_size = DEFAULT_SERIAL_PLANNER_BUFFER_SIZE;
+		mm_per_arc_segment = DEFAULT_SERIAL_MM_PER_ARC_SEGMENT;
+		interval_seconds = DEFAULT_SERIAL_INTERVAL_SECONDS;
+		g90_g91_influences_extruder = false;
+	}
+	long baud_rate;
+	// Hosts that check for transmission errors add "N<line number> " before each line and "*<checksum>" after it.
+	bool line_numbers;
+	bool checksums;
+	// The time between the firmware queueing a command and the host sending the next line, not counting the time
+	// spent sending the "ok", which includes the USB polling interval and the time the host takes to respond.
+	double ok_latency_ms;
+	// The number of moves the firmware can plan ahead.
+	int planner_buffer_size;
+	// The length of each segment the firmware divides an arc into.
+	double mm_per_arc_segment;
+	// The length of each interval in the timeline.
+	double interval_seconds;
+	bool g90_g91_influences_extruder;
+};
+
+// The commands received and the time the printer spent waiting for moves during one interval of the print.
+struct serial_simulator_interval
+{
+	serial_simulator_interval()
+	{
+		start_seconds = 0;
+		commands = 0;
+		bytes = 0;
+		stall_seconds = 0;
+	}
+	double start_seconds;
+	long commands;
+	long long bytes;
+	double stall_seconds;
+};
+
+struct serial_simulator_results
+{
+	serial_simulator_results()
+	{
+		lines = 0;
+		commands = 0;
+		bytes = 0;
+		planner_blocks = 0;
+		seconds = 0;
+		move_seconds = 0;
+		stall_seconds = 0;
+		stalls = 0;
+		peak_commands_per_second = 0;
+	}
+	long lines;
+	long commands;
+	long long bytes;
+	long planner_blocks;
+	// The time taken to print the file, including the time spent waiting for the host.
+	double seconds;
+	// The time spent moving, which is how long the print would take if the host was never the bottleneck.
+	double move_seconds;
+	// The time the planner was empty while waiting for the next move to arrive.
+	double stall_seconds;
+	long stalls;
+	double peak_commands_per_second;
+	std::vector<serial_simulator_interval> timeline;
+	double get_commands_per_second() const;
+	double get_stall_percent() const;
+};
+
+// Simulates a host sending gcode to the firmware over a serial link, one line at a time.  The host sends the next line
+// once the "ok" for the previous line arrives, and the firmware only sends the "ok" once every planner block of the
+// command has been added to the planner, so a full planner holds up the host.  Moves run at their feedrate without
+// acceleration, and arcs are divided into segments the way Marlin divides them.  When a move arrives after the planner
+// has emptied, the printer stalls until it does.  This is what causes the stuttering that arc welding reduces.
+class serial_simulator
+{
+public:
+	serial_simulator(const serial_simulator_args& args);
+	/// <summary>
+	/// Simulates sending a gcode file to the printer.
+	/// </summary>
+	/// <returns>False if the file could not be read.</returns>
+	bool simulate(const std::string& path, serial_simulator_results& results);
+private:
+	void add_block_(double duration, serial_simulator_results& results);
+	void synchronize_();
+	void add_stall_(double start, double end, serial_simulator_results& results);
+	serial_simulator_interval& get_interval_(double time, serial_simulator_results& results);
+	static int get_line_bytes_(const char* p_text, size_t length, long line_number, bool line_numbers, bool checksums);
+	serial_simulator_args args_;
+	double bytes_per_second_;
+	// The time the firmware has finished queueing the current command.
+	double time_;
+	// The times at which each block in the planner finishes.
+	std::deque<double> planner_;
+	// The time the last block in the planner finishes.
+	double machine_free_time_;
+	bool has_moved_;
+};
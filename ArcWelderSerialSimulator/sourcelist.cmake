@@ -0,0 +1,6 @@
+set(ArcWelderSerialSimulatorSources ${ArcWelderSerialSimulatorSources}
+    ArcWelderSerialSimulator.h
+    ArcWelderSerialSimulator.cpp
+    serial_simulator.h
+    serial_simulator.cpp
+)
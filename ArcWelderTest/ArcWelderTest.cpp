@@ -27,12 +27,20 @@
 
 int main(int argc, char* argv[])
 {
+	if (argc > 1 && std::string(argv[1]) == REGRESSION_TESTS_ARGUMENT)
+	{
+		return run_regression_tests(argc > 2 ? argv[2] : ".");
+	}
+	if (argc > 1 && std::string(argv[1]) == EQUIVALENCE_TESTS_ARGUMENT)
+	{
+		return run_equivalence_tests(argc > 2 ? argv[2] : ".");
+	}
 	run_tests(argc, argv);
 }
 
 int run_tests(int argc, char* argv[])
 {
-
+#ifdef _MSC_VER
 	_CrtMemState state1, state2, state3;
 	// This line will take a snapshot
 	// of the memory allocated at this point.
@@ -42,10 +50,13 @@ int run_tests(int argc, char* argv[])
 	_CrtSetReportFile(_CRT_ERROR, _CRTDBG_FILE_STDOUT);
 	_CrtSetReportMode(_CRT_ASSERT, _CRTDBG_MODE_FILE);
 	_CrtSetReportFile(_CRT_ASSERT, _CRTDBG_FILE_STDOUT);
+#endif
 
 	//std::string filename = argv[1];
 	unsigned int num_runs = 1;
+#ifdef _MSC_VER
 	_CrtMemCheckpoint(&state1);
+#endif
 
 	auto start = std::chrono::high_resolution_clock::now();
 	for (unsigned int index = 0; index < num_runs; index++)
@@ -93,10 +104,12 @@ int run_tests(int argc, char* argv[])
 
 	}
 	auto end = std::chrono::high_resolution_clock::now();
+#ifdef _MSC_VER
 	_CrtMemCheckpoint(&state2);
 	if (_CrtMemDifference(&state3, &state1, &state2)) {
 		_CrtMemDumpStatistics(&state3);
 	}
+#endif
 	//_CrtMemDumpAllObjectsSince(&state);
 	std::chrono::duration<double> diff = end - start;
 	std::cout << "Tests completed in " << diff.count() << " seconds";
@@ -108,6 +121,647 @@ int run_tests(int argc, char* argv[])
 	return 0;
 }
 
+int run_regression_tests(std::string output_directory)
+{
+	bool success = true;
+	success = TestIncrementalArcFitting(output_directory) && success;
+	success = TestFeaturePolicies(output_directory) && success;
+	success = TestCircleFit() && success;
+	std::cout << (success ? "All regression tests passed." : "One or more regression tests failed.") << std::endl;
+	return success ? 0 : 1;
+}
+
+int run_equivalence_tests(std::string output_directory)
+{
+	bool success = true;
+	success = TestWeldingModeEquivalence(output_directory) && success;
+	success = TestMeatPackEquivalence(output_directory) && success;
+	success = TestResultCacheEquivalence(output_directory) && success;
+	std::cout << (success ? "All equivalence tests passed." : "One or more equivalence tests failed.") << std::endl;
+	return success ? 0 : 1;
+}
+
+static bool TestWeldingModeEquivalence(std::string output_directory)
+{
+	// The threaded and pipelined modes split the work differently, and a streamed source is read as it arrives, but
+	// each must write exactly the same file as the serial mode.  The tagged files check that the slicer sections are
+	// carried across shards.
+	std::vector<std::string> logger_names;
+	logger_names.push_back("arc_welder.gcode_conversion");
+	std::vector<int> logger_levels;
+	logger_levels.push_back((int)log_levels::ERROR);
+	logger* p_logger = new logger(logger_names, logger_levels);
+	p_logger->set_log_level(log_levels::ERROR);
+
+	bool success = true;
+	gcode_generator generator(REGRESSION_TEST_SEED);
+	for (int index = 0; index < NUM_WORKLOAD_TYPES; index++)
+	{
+		workload_type workload = static_cast<workload_type>(index);
+		std::string file_name = output_directory + "/equivalence_" + workload_type_names[index];
+		std::string source_path = file_name + ".gcode";
+		if (!generator.generate(workload, source_path, REGRESSION_TEST_LINES))
+		{
+			std::cout << "TestWeldingModeEquivalence: Unable to write '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		arc_welder_args args(source_path, file_name, p_logger);
+		args.allow_3d_arcs = gcode_generator::requires_3d_arcs(workload);
+		success = check_welding_modes_match(workload_type_names[index], args) && success;
+		std::remove(source_path.c_str());
+	}
+
+	feature_policy_test_case test_cases[] = {
+		{ "cura", ";TYPE:WALL-OUTER", "", ";TYPE:WALL-INNER", "", "outer_perimeter:enabled=false" },
+		{ "prusa_slicer", ";TYPE:Bridge infill", "", ";TYPE:External perimeter", "", "bridge:resolution_mm=0.01" }
+	};
+	for (unsigned int index = 0; success && index < sizeof(test_cases) / sizeof(test_cases[0]); index++)
+	{
+		const feature_policy_test_case& test_case = test_cases[index];
+		std::string file_name = output_directory + "/equivalence_" + test_case.name;
+		std::string source_path = file_name + ".gcode";
+		arc_welder_feature_policy policy;
+		std::string error;
+		if (!write_feature_policy_test_file(source_path, test_case) || !arc_welder_feature_policy::try_parse(test_case.policy, policy, error))
+		{
+			std::cout << "TestWeldingModeEquivalence: Unable to write '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		arc_welder_args args(source_path, file_name, p_logger);
+		args.feature_policies.push_back(policy);
+		success = check_welding_modes_match(test_case.name, args) && success;
+		std::remove(source_path.c_str());
+	}
+	delete p_logger;
+	return success;
+}
+
+static bool check_welding_modes_match(std::string name, arc_welder_args args)
+{
+	// args.target_path is used as the prefix of each mode's target.
+	std::string file_name = args.target_path;
+	std::string serial_path = file_name + ".serial.gcode";
+	std::string threaded_path = file_name + ".threaded.gcode";
+	std::string pipelined_path = file_name + ".pipelined.gcode";
+	std::string streamed_path = file_name + ".streamed.gcode";
+	std::string source_path = args.source_path;
+	arc_welder_results serial, threaded, pipelined, streamed;
+
+	args.target_path = serial_path;
+	bool welded = weld_test_file(args, serial);
+	args.target_path = threaded_path;
+	args.threads = EQUIVALENCE_TEST_THREADS;
+	welded = welded && weld_test_file(args, threaded);
+	args.target_path = pipelined_path;
+	args.threads = 1;
+	args.pipeline = true;
+	welded = welded && weld_test_file(args, pipelined);
+	// The streamed source is read from standard input, so point it at the source file.
+	args.source_path = ARC_WELDER_STANDARD_STREAM_PATH;
+	args.target_path = streamed_path;
+	args.pipeline = false;
+	welded = welded && freopen(source_path.c_str(), "rb", stdin) != NULL && weld_test_file(args, streamed);
+
+	std::string serial_gcode, threaded_gcode, pipelined_gcode, streamed_gcode;
+	bool passed = welded
+		&& read_test_file(serial_path, serial_gcode)
+		&& read_test_file(threaded_path, threaded_gcode)
+		&& read_test_file(pipelined_path, pipelined_gcode)
+		&& read_test_file(streamed_path, streamed_gcode)
+		&& !serial_gcode.empty()
+		&& threaded_gcode == serial_gcode
+		&& pipelined_gcode == serial_gcode
+		&& streamed_gcode == serial_gcode
+		&& threaded.progress.arcs_created == serial.progress.arcs_created
+		&& pipelined.progress.arcs_created == serial.progress.arcs_created
+		&& streamed.progress.arcs_created == serial.progress.arcs_created;
+	std::cout << "TestWeldingModeEquivalence: " << name << (passed ? " passed" : " FAILED")
+		<< " - arcs (serial/threaded/pipelined/streamed): " << serial.progress.arcs_created << "/" << threaded.progress.arcs_created
+		<< "/" << pipelined.progress.arcs_created << "/" << streamed.progress.arcs_created
+		<< ", bytes: " << serial_gcode.length() << "/" << threaded_gcode.length() << "/" << pipelined_gcode.length()
+		<< "/" << streamed_gcode.length() << std::endl;
+	std::remove(serial_path.c_str());
+	std::remove(threaded_path.c_str());
+	std::remove(pipelined_path.c_str());
+	std::remove(streamed_path.c_str());
+	return passed;
+}
+
+static bool TestMeatPackEquivalence(std::string output_directory)
+{
+	// The minimized target must hold the same commands as the normal target, and the packed target must unpack into
+	// exactly the minimized target.  The packed target is decoded the way the firmware decodes it, so the encoder is
+	// not used to check itself.
+	std::vector<std::string> logger_names;
+	logger_names.push_back("arc_welder.gcode_conversion");
+	std::vector<int> logger_levels;
+	logger_levels.push_back((int)log_levels::ERROR);
+	logger* p_logger = new logger(logger_names, logger_levels);
+	p_logger->set_log_level(log_levels::ERROR);
+
+	bool success = true;
+	gcode_generator generator(REGRESSION_TEST_SEED);
+	for (int index = 0; index < NUM_WORKLOAD_TYPES; index++)
+	{
+		workload_type workload = static_cast<workload_type>(index);
+		std::string file_name = output_directory + "/meatpack_" + workload_type_names[index];
+		std::string source_path = file_name + ".gcode";
+		std::string plain_path = file_name + ".none.gcode";
+		std::string minimized_path = file_name + ".minimized.gcode";
+		std::string packed_path = file_name + ".packed.gcode";
+		std::string pipelined_path = file_name + ".packed_pipelined.gcode";
+		if (!generator.generate(workload, source_path, REGRESSION_TEST_LINES))
+		{
+			std::cout << "TestMeatPackEquivalence: Unable to write '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		arc_welder_args args(source_path, plain_path, p_logger);
+		args.allow_3d_arcs = gcode_generator::requires_3d_arcs(workload);
+		arc_welder_results plain, minimized, packed, pipelined;
+		bool welded = weld_test_file(args, plain);
+		args.target_path = minimized_path;
+		args.meatpack_mode = meatpack_mode_minimized;
+		welded = welded && weld_test_file(args, minimized);
+		args.target_path = packed_path;
+		args.meatpack_mode = meatpack_mode_packed;
+		welded = welded && weld_test_file(args, packed);
+		args.target_path = pipelined_path;
+		args.pipeline = true;
+		welded = welded && weld_test_file(args, pipelined);
+
+		std::string plain_gcode, minimized_gcode, packed_gcode, pipelined_gcode, unpacked_gcode;
+		bool passed = welded
+			&& read_test_file(plain_path, plain_gcode)
+			&& read_test_file(minimized_path, minimized_gcode)
+			&& read_test_file(packed_path, packed_gcode)
+			&& read_test_file(pipelined_path, pipelined_gcode)
+			&& !minimized_gcode.empty()
+			&& get_gcode_without_spaces(minimized_gcode) == get_gcode_without_spaces(plain_gcode)
+			&& unpack_meatpack(packed_gcode, unpacked_gcode)
+			&& unpacked_gcode == minimized_gcode
+			&& pipelined_gcode == packed_gcode
+			&& minimized.progress.transmitted_bytes == static_cast<long long>(packed_gcode.length());
+		std::cout << "TestMeatPackEquivalence: " << workload_type_names[index] << (passed ? " passed" : " FAILED")
+			<< " - bytes (none/minimized/packed/unpacked): " << plain_gcode.length() << "/" << minimized_gcode.length()
+			<< "/" << packed_gcode.length() << "/" << unpacked_gcode.length()
+			<< ", estimated packed bytes: " << minimized.progress.transmitted_bytes << std::endl;
+		success = passed && success;
+		std::remove(source_path.c_str());
+		std::remove(plain_path.c_str());
+		std::remove(minimized_path.c_str());
+		std::remove(packed_path.c_str());
+		std::remove(pipelined_path.c_str());
+	}
+	delete p_logger;
+	return success;
+}
+
+static bool TestResultCacheEquivalence(std::string output_directory)
+{
+	// The first cached conversion must weld the file and store it, and the second must copy the stored file.  Both
+	// must write exactly the same file, and report the same results, as a conversion without the cache.
+	std::vector<std::string> logger_names;
+	logger_names.push_back("arc_welder.gcode_conversion");
+	std::vector<int> logger_levels;
+	logger_levels.push_back((int)log_levels::ERROR);
+	logger* p_logger = new logger(logger_names, logger_levels);
+	p_logger->set_log_level(log_levels::ERROR);
+
+	bool success = true;
+	std::string cache_directory = output_directory + "/equivalence_cache";
+	gcode_generator generator(REGRESSION_TEST_SEED);
+	for (int index = 0; index < NUM_WORKLOAD_TYPES; index++)
+	{
+		workload_type workload = static_cast<workload_type>(index);
+		std::string file_name = output_directory + "/cache_" + workload_type_names[index];
+		std::string source_path = file_name + ".gcode";
+		std::string uncached_path = file_name + ".uncached.gcode";
+		std::string added_path = file_name + ".added.gcode";
+		std::string cached_path = file_name + ".cached.gcode";
+		if (!generator.generate(workload, source_path, REGRESSION_TEST_LINES))
+		{
+			std::cout << "TestResultCacheEquivalence: Unable to write '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		arc_welder_args args(source_path, uncached_path, p_logger);
+		args.allow_3d_arcs = gcode_generator::requires_3d_arcs(workload);
+		arc_welder_results uncached, added, cached;
+		bool welded = weld_test_file(args, uncached);
+		args.cache_directory = cache_directory;
+		args.target_path = added_path;
+		welded = welded && weld_test_file(args, added);
+		args.target_path = cached_path;
+		welded = welded && weld_test_file(args, cached);
+
+		std::string uncached_gcode, added_gcode, cached_gcode;
+		bool passed = welded
+			&& !uncached.from_cache
+			&& !added.from_cache
+			&& cached.from_cache
+			&& read_test_file(uncached_path, uncached_gcode)
+			&& read_test_file(added_path, added_gcode)
+			&& read_test_file(cached_path, cached_gcode)
+			&& added_gcode == uncached_gcode
+			&& cached_gcode == uncached_gcode
+			&& added.progress.arcs_created == uncached.progress.arcs_created
+			&& cached.progress.arcs_created == uncached.progress.arcs_created
+			&& cached.progress.target_file_size == uncached.progress.target_file_size;
+		std::cout << "TestResultCacheEquivalence: " << workload_type_names[index] << (passed ? " passed" : " FAILED")
+			<< " - from cache (added/cached): " << added.from_cache << "/" << cached.from_cache
+			<< ", arcs (uncached/added/cached): " << uncached.progress.arcs_created << "/" << added.progress.arcs_created
+			<< "/" << cached.progress.arcs_created << std::endl;
+		success = passed && success;
+
+		// Remove the entry so that the next run of the tests starts with an empty cache.
+		arc_welder_cache cache(cache_directory, args.cache_max_megabytes * 1048576LL);
+		std::string key;
+		if (cache.get_key(source_path, args, key))
+		{
+			std::remove(utilities::join_path(cache_directory, key + ARC_WELDER_CACHE_TARGET_EXTENSION).c_str());
+			std::remove(utilities::join_path(cache_directory, key + ARC_WELDER_CACHE_RESULTS_EXTENSION).c_str());
+		}
+		std::remove(source_path.c_str());
+		std::remove(uncached_path.c_str());
+		std::remove(added_path.c_str());
+		std::remove(cached_path.c_str());
+	}
+	delete p_logger;
+	return success;
+}
+
+static std::string get_gcode_without_spaces(const std::string& gcode)
+{
+	// Removes comments, blank lines and every space, tab and carriage return.
+	std::string result;
+	bool in_comment = false;
+	bool is_line_empty = true;
+	for (std::string::const_iterator it = gcode.begin(); it != gcode.end(); ++it)
+	{
+		char c = *it;
+		if (c == '\n')
+		{
+			if (!is_line_empty)
+			{
+				result.push_back('\n');
+			}
+			in_comment = false;
+			is_line_empty = true;
+		}
+		else if (c == ';')
+		{
+			in_comment = true;
+		}
+		else if (!in_comment && c != ' ' && c != '\t' && c != '\r')
+		{
+			result.push_back(c);
+			is_line_empty = false;
+		}
+	}
+	return result;
+}
+
+static bool unpack_meatpack(const std::string& packed, std::string& unpacked)
+{
+	// Follows the firmware:  two signal bytes are followed by a command, and while packing is enabled each byte holds
+	// two characters from the packing table, or flags that the next byte holds a character in full.
+	unpacked.clear();
+	bool is_packing = false;
+	bool is_no_spaces = false;
+	int signal_byte_count = 0;
+	bool is_command_next = false;
+	int full_width_count = 0;
+	char buffered_char = 0;
+	for (std::string::const_iterator it = packed.begin(); it != packed.end(); ++it)
+	{
+		unsigned char c = static_cast<unsigned char>(*it);
+		if (c == MEATPACK_SIGNAL_BYTE)
+		{
+			if (signal_byte_count > 0)
+			{
+				is_command_next = true;
+				signal_byte_count = 0;
+			}
+			else
+			{
+				signal_byte_count++;
+			}
+			continue;
+		}
+		if (is_command_next)
+		{
+			is_command_next = false;
+			if (c == MEATPACK_COMMAND_ENABLE_PACKING)
+				is_packing = true;
+			else if (c == MEATPACK_COMMAND_DISABLE_PACKING)
+				is_packing = false;
+			else if (c == MEATPACK_COMMAND_ENABLE_NO_SPACES)
+				is_no_spaces = true;
+			else if (c == MEATPACK_COMMAND_DISABLE_NO_SPACES)
+				is_no_spaces = false;
+			else
+				return false;
+			continue;
+		}
+		// A single signal byte is just data.
+		int num_bytes = signal_byte_count > 0 ? 2 : 1;
+		unsigned char bytes[2] = { MEATPACK_SIGNAL_BYTE, c };
+		signal_byte_count = 0;
+		for (int byte_index = 2 - num_bytes; byte_index < 2; byte_index++)
+		{
+			unsigned char value = bytes[byte_index];
+			if (!is_packing)
+			{
+				unpacked.push_back(static_cast<char>(value));
+			}
+			else if (full_width_count > 0)
+			{
+				unpacked.push_back(static_cast<char>(value));
+				if (buffered_char != 0)
+				{
+					unpacked.push_back(buffered_char);
+					buffered_char = 0;
+				}
+				full_width_count--;
+			}
+			else
+			{
+				const char table[] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', is_no_spaces ? 'E' : ' ', '\n', 'G', 'X' };
+				unsigned char low = value & 0x0F;
+				unsigned char high = value >> 4;
+				if (low == MEATPACK_FULL_WIDTH_NIBBLE)
+				{
+					full_width_count++;
+					if (high == MEATPACK_FULL_WIDTH_NIBBLE)
+						full_width_count++;
+					else
+						buffered_char = table[high];
+				}
+				else
+				{
+					unpacked.push_back(table[low]);
+					// A newline ends the byte.
+					if (table[low] != '\n')
+					{
+						if (high == MEATPACK_FULL_WIDTH_NIBBLE)
+							full_width_count++;
+						else
+							unpacked.push_back(table[high]);
+					}
+				}
+			}
+		}
+	}
+	// Packing must be disabled again at the end, and no character may be missing.
+	return !is_packing && !is_no_spaces && full_width_count == 0 && signal_byte_count == 0;
+}
+
+static bool weld_test_file(const arc_welder_args& args, arc_welder_results& results)
+{
+	arc_welder arc_welder_obj(args);
+	results = arc_welder_obj.process();
+	return results.success;
+}
+
+static bool read_test_file(std::string path, std::string& contents)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+		return false;
+	std::ostringstream stream;
+	stream << file.rdbuf();
+	contents = stream.str();
+	return true;
+}
+
+static bool TestIncrementalArcFitting(std::string output_directory)
+{
+	// The incremental fit is the default, and the exact search is the reference.  The incremental fit only tests a
+	// few circles before ending an arc, so on every workload it must compress nearly as many points into nearly as
+	// few arcs as the exact search, and must produce a file that is nearly as small.
+	std::vector<std::string> logger_names;
+	logger_names.push_back("arc_welder.gcode_conversion");
+	std::vector<int> logger_levels;
+	logger_levels.push_back((int)log_levels::ERROR);
+	logger* p_logger = new logger(logger_names, logger_levels);
+	p_logger->set_log_level(log_levels::ERROR);
+
+	bool success = true;
+	gcode_generator generator(REGRESSION_TEST_SEED);
+	for (int index = 0; index < NUM_WORKLOAD_TYPES; index++)
+	{
+		workload_type workload = static_cast<workload_type>(index);
+		std::string file_name = output_directory + "/regression_" + workload_type_names[index];
+		std::string source_path = file_name + ".gcode";
+		std::string exact_path = file_name + ".exact.gcode";
+		std::string incremental_path = file_name + ".incremental.gcode";
+		if (!generator.generate(workload, source_path, REGRESSION_TEST_LINES))
+		{
+			std::cout << "TestIncrementalArcFitting: Unable to write '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		bool allow_3d_arcs = gcode_generator::requires_3d_arcs(workload);
+		arc_welder_progress exact;
+		arc_welder_progress incremental;
+		if (
+			!weld_regression_test_file(source_path, exact_path, allow_3d_arcs, true, p_logger, exact) ||
+			!weld_regression_test_file(source_path, incremental_path, allow_3d_arcs, false, p_logger, incremental)
+		)
+		{
+			std::cout << "TestIncrementalArcFitting: Unable to weld '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		// The exact file's header has one extra line recording the exact_arc_fitting setting, so the sizes are compared
+		// without it.
+		long exact_header_bytes = static_cast<long>(std::string("; exact_arc_fitting=True\n").length());
+		double tolerance = REGRESSION_TEST_TOLERANCE_PERCENT / 100.0;
+		bool passed = incremental.points_compressed >= exact.points_compressed * (1.0 - tolerance)
+			&& incremental.arcs_created <= exact.arcs_created * (1.0 + tolerance)
+			&& incremental.target_file_size <= (exact.target_file_size - exact_header_bytes) * (1.0 + tolerance);
+		std::cout << "TestIncrementalArcFitting: " << workload_type_names[index] << (passed ? " passed" : " FAILED")
+			<< " - arcs (exact/incremental): " << exact.arcs_created << "/" << incremental.arcs_created
+			<< ", points compressed: " << exact.points_compressed << "/" << incremental.points_compressed
+			<< ", bytes: " << exact.target_file_size << "/" << incremental.target_file_size << std::endl;
+		success = passed && success;
+		std::remove(source_path.c_str());
+		std::remove(exact_path.c_str());
+		std::remove(incremental_path.c_str());
+	}
+	delete p_logger;
+	return success;
+}
+
+static bool weld_regression_test_file(std::string source_path, std::string target_path, bool allow_3d_arcs, bool exact_arc_fitting, logger* p_logger, arc_welder_progress& progress)
+{
+	arc_welder_args args(source_path, target_path, p_logger);
+	args.allow_3d_arcs = allow_3d_arcs;
+	args.exact_arc_fitting = exact_arc_fitting;
+	arc_welder arc_welder_obj(args);
+	arc_welder_results results = arc_welder_obj.process();
+	progress = results.progress;
+	return results.success;
+}
+
+static bool TestFeaturePolicies(std::string output_directory)
+{
+	// Each file tags two features the way a slicer does.  Disabling the first feature must leave its circles unwelded
+	// while the second feature is still welded.
+	std::vector<std::string> logger_names;
+	logger_names.push_back("arc_welder.gcode_conversion");
+	std::vector<int> logger_levels;
+	logger_levels.push_back((int)log_levels::ERROR);
+	logger* p_logger = new logger(logger_names, logger_levels);
+	p_logger->set_log_level(log_levels::ERROR);
+
+	feature_policy_test_case test_cases[] = {
+		// Cura marks sections with a comment line.
+		{ "cura", ";TYPE:WALL-OUTER", "", ";TYPE:WALL-INNER", "", "outer_perimeter:enabled=false" },
+		// PrusaSlicer marks sections with a comment line too, but uses different names.
+		{ "prusa_slicer", ";TYPE:Bridge infill", "", ";TYPE:External perimeter", "", "bridge:enabled=false" },
+		// Simplify3D separates the semicolon from the section name with a space.
+		{ "simplify_3d", "; feature outer perimeter", "", "; feature infill", "", "outer_perimeter:enabled=false" },
+		// Slic3r with verbose gcode marks every line, and separates the comment from the gcode with spaces.
+		{ "slic3r", "", " ; infill(bridge)", "", " ; perimeter", "bridge:enabled=false" }
+	};
+	bool success = true;
+	for (unsigned int index = 0; index < sizeof(test_cases) / sizeof(test_cases[0]); index++)
+	{
+		const feature_policy_test_case& test_case = test_cases[index];
+		std::string file_name = output_directory + "/feature_policy_" + test_case.name;
+		std::string source_path = file_name + ".gcode";
+		std::string default_path = file_name + ".default.gcode";
+		std::string policy_path = file_name + ".policy.gcode";
+		if (!write_feature_policy_test_file(source_path, test_case))
+		{
+			std::cout << "TestFeaturePolicies: Unable to write '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		arc_welder_feature_policy policy;
+		std::string error;
+		if (!arc_welder_feature_policy::try_parse(test_case.policy, policy, error))
+		{
+			std::cout << "TestFeaturePolicies: Unable to parse '" << test_case.policy << "': " << error << std::endl;
+			success = false;
+			break;
+		}
+		std::vector<arc_welder_feature_policy> no_policies;
+		std::vector<arc_welder_feature_policy> policies;
+		policies.push_back(policy);
+		arc_welder_progress without_policy;
+		arc_welder_progress with_policy;
+		if (
+			!weld_feature_policy_test_file(source_path, default_path, no_policies, p_logger, without_policy) ||
+			!weld_feature_policy_test_file(source_path, policy_path, policies, p_logger, with_policy)
+		)
+		{
+			std::cout << "TestFeaturePolicies: Unable to weld '" << source_path << "'." << std::endl;
+			success = false;
+			break;
+		}
+		// Each feature is printed as FEATURE_POLICY_TEST_LAYERS circles, and every circle is welded into arcs.
+		bool passed = with_policy.arcs_created > 0
+			&& with_policy.arcs_created * 2 <= without_policy.arcs_created
+			&& with_policy.points_compressed < without_policy.points_compressed;
+		std::cout << "TestFeaturePolicies: " << test_case.name << (passed ? " passed" : " FAILED")
+			<< " - arcs (default/" << test_case.policy << "): " << without_policy.arcs_created << "/" << with_policy.arcs_created << std::endl;
+		success = passed && success;
+		std::remove(source_path.c_str());
+		std::remove(default_path.c_str());
+		std::remove(policy_path.c_str());
+	}
+	delete p_logger;
+	return success;
+}
+
+static bool write_feature_policy_test_file(std::string path, const feature_policy_test_case& test_case)
+{
+	std::ofstream gcode_file(path.c_str());
+	if (!gcode_file.is_open())
+		return false;
+	gcode_file << std::fixed << std::setprecision(3);
+	gcode_file << "G21\nG90\nM83\n";
+	for (int layer = 0; layer < FEATURE_POLICY_TEST_LAYERS; layer++)
+	{
+		gcode_file << "G1 Z" << 0.2 * (layer + 1) << " F1200\n";
+		for (int feature = 0; feature < 2; feature++)
+		{
+			const std::string& section_comment = feature == 0 ? test_case.first_section_comment : test_case.second_section_comment;
+			const std::string& line_comment = feature == 0 ? test_case.first_line_comment : test_case.second_line_comment;
+			double radius = feature == 0 ? 20.0 : 10.0;
+			if (section_comment.length() != 0)
+			{
+				gcode_file << section_comment << "\n";
+			}
+			gcode_file << "G0 X" << 100.0 + radius << " Y100.000" << line_comment << "\n";
+			for (int segment = 1; segment <= FEATURE_POLICY_TEST_SEGMENTS; segment++)
+			{
+				double angle = 2.0 * PI_DOUBLE * segment / FEATURE_POLICY_TEST_SEGMENTS;
+				gcode_file << "G1 X" << 100.0 + radius * std::cos(angle) << " Y" << 100.0 + radius * std::sin(angle)
+					<< std::setprecision(5) << " E" << 2.0 * PI_DOUBLE * radius / FEATURE_POLICY_TEST_SEGMENTS * 0.05
+					<< std::setprecision(3) << line_comment << "\n";
+			}
+		}
+	}
+	return gcode_file.good();
+}
+
+static bool weld_feature_policy_test_file(std::string source_path, std::string target_path, const std::vector<arc_welder_feature_policy>& feature_policies, logger* p_logger, arc_welder_progress& progress)
+{
+	arc_welder_args args(source_path, target_path, p_logger);
+	args.feature_policies = feature_policies;
+	arc_welder arc_welder_obj(args);
+	arc_welder_results results = arc_welder_obj.process();
+	progress = results.progress;
+	return results.success;
+}
+
+static bool TestCircleFit()
+{
+	// Points on half of a circle, with the middle point pushed outward and its neighbors pushed inward.  The circle
+	// through the first, middle and last points misses the neighbors, but the fitted circle is within the resolution
+	// of every point.
+	const double center_x = 100, center_y = 100, radius = 20, resolution_mm = 0.05;
+	coordinate_buffer coordinates;
+	for (int index = 0; index <= CIRCLE_FIT_TEST_SEGMENTS; index++)
+	{
+		double offset = 0;
+		if (index == CIRCLE_FIT_TEST_SEGMENTS / 2)
+		{
+			offset = 0.04;
+		}
+		else if (index > 0 && index < CIRCLE_FIT_TEST_SEGMENTS)
+		{
+			offset = index % 2 == 0 ? 0.01 : -0.03;
+		}
+		double angle = PI_DOUBLE * index / CIRCLE_FIT_TEST_SEGMENTS;
+		coordinates.push_back(point(center_x + (radius + offset) * std::cos(angle), center_y + (radius + offset) * std::sin(angle), 0.2));
+	}
+
+	circle midpoint_circle;
+	bool midpoint_fits = circle::try_create_circle(coordinates.get_point(0), coordinates.get_point(CIRCLE_FIT_TEST_SEGMENTS / 2), coordinates.get_point(CIRCLE_FIT_TEST_SEGMENTS), DEFAULT_MAX_RADIUS_MM, midpoint_circle)
+		&& !midpoint_circle.is_over_deviation(coordinates, resolution_mm, DEFAULT_XYZ_TOLERANCE, false);
+	circle fit_circle;
+	bool fit_found = circle::try_create_circle(coordinates, DEFAULT_MAX_RADIUS_MM, resolution_mm, DEFAULT_XYZ_TOLERANCE, false, false, fit_circle);
+	circle exact_circle;
+	bool exact_found = circle::try_create_circle(coordinates, DEFAULT_MAX_RADIUS_MM, resolution_mm, DEFAULT_XYZ_TOLERANCE, false, true, exact_circle);
+	double center_error = utilities::get_cartesian_distance(fit_circle.center.x, fit_circle.center.y, center_x, center_y);
+	bool passed = !midpoint_fits && fit_found && exact_found && center_error < resolution_mm
+		&& utilities::abs(fit_circle.radius - radius) < resolution_mm;
+	std::cout << "TestCircleFit: " << (passed ? "passed" : "FAILED")
+		<< " - midpoint circle fits: " << (midpoint_fits ? "yes" : "no")
+		<< ", fit found: " << (fit_found ? "yes" : "no")
+		<< ", exact found: " << (exact_found ? "yes" : "no")
+		<< ", center error: " << center_error
+		<< ", radius: " << fit_circle.radius << std::endl;
+	return passed;
+}
+
 static gcode_position_args get_single_extruder_position_args()
 {
 	gcode_position_args posArgs = gcode_position_args();
@@ -23,7 +23,10 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include <stdlib.h>
+#include <cstdio>
+#ifdef _MSC_VER
 #include <crtdbg.h>
+#endif
 #include <assert.h>
 #include <iostream>
 #include <fstream>
@@ -31,15 +34,67 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <cmath>
 #include "gcode_position.h"
 #include "gcode_parser.h"
 #include <sstream>
 #include "arc_welder.h"
+#include "arc_welder_cache.h"
 #include "array_list.h"
 #include "logger.h"
+#include "gcode_generator.h"
 #include <exception>
 
+// Runs the regression tests instead of the ad-hoc tests.  The next argument, if any, is the directory that receives
+// the generated files.
+#define REGRESSION_TESTS_ARGUMENT "--regression"
+// Runs the tests that check that every welding mode writes the same file.  The next argument, if any, is the
+// directory that receives the generated files.
+#define EQUIVALENCE_TESTS_ARGUMENT "--equivalence"
+// The number of lines generated for each regression test workload.
+#define REGRESSION_TEST_LINES 25000
+#define REGRESSION_TEST_SEED 1
+// How much worse than the exact search the incremental fit may compress each regression test workload.
+#define REGRESSION_TEST_TOLERANCE_PERCENT 1.0
+// The number of layers in each feature policy test file.  Every layer prints one circle for each of two features.
+#define FEATURE_POLICY_TEST_LAYERS 20
+// The number of segments in each feature policy test circle.
+#define FEATURE_POLICY_TEST_SEGMENTS 72
+// The number of segments in the circle fit test's half circle.
+#define CIRCLE_FIT_TEST_SEGMENTS 40
+// The number of threads used by the threaded welding mode in the equivalence tests.
+#define EQUIVALENCE_TEST_THREADS 4
+
+// A gcode file that tags two features the way a particular slicer does, and a policy that changes the first feature.
+struct feature_policy_test_case
+{
+	std::string name;
+	// A comment line that starts each feature's section, if the slicer writes one.
+	std::string first_section_comment;
+	// A comment appended to each of the feature's lines, if the slicer writes one.
+	std::string first_line_comment;
+	std::string second_section_comment;
+	std::string second_line_comment;
+	std::string policy;
+};
+
 int run_tests(int argc, char* argv[]);
+int run_regression_tests(std::string output_directory);
+int run_equivalence_tests(std::string output_directory);
+static bool TestIncrementalArcFitting(std::string output_directory);
+static bool weld_regression_test_file(std::string source_path, std::string target_path, bool allow_3d_arcs, bool exact_arc_fitting, logger* p_logger, arc_welder_progress& progress);
+static bool TestFeaturePolicies(std::string output_directory);
+static bool write_feature_policy_test_file(std::string path, const feature_policy_test_case& test_case);
+static bool TestCircleFit();
+static bool TestWeldingModeEquivalence(std::string output_directory);
+static bool check_welding_modes_match(std::string name, arc_welder_args args);
+static bool TestMeatPackEquivalence(std::string output_directory);
+static bool TestResultCacheEquivalence(std::string output_directory);
+static std::string get_gcode_without_spaces(const std::string& gcode);
+static bool unpack_meatpack(const std::string& packed, std::string& unpacked);
+static bool weld_test_file(const arc_welder_args& args, arc_welder_results& results);
+static bool read_test_file(std::string path, std::string& contents);
+static bool weld_feature_policy_test_file(std::string source_path, std::string target_path, const std::vector<arc_welder_feature_policy>& feature_policies, logger* p_logger, arc_welder_progress& progress);
 static gcode_position_args get_single_extruder_position_args();
 static gcode_position_args get_5_shared_extruder_position_args();
 static gcode_position_args get_5_extruder_position_args();
@@ -0,0 +1,5 @@
+set(ArcWelderTestSources ${ArcWelderTestSources}
+    ArcWelderTest.h
+    ArcWelderTest.cpp
+    ${CMAKE_SOURCE_DIR}/ArcWelderBench/gcode_generator.cpp
+)
@@ -95,6 +95,15 @@ public:
 	}
 
 	void push_back(T object)
+	{
+		append() = object;
+	}
+
+	/// <summary>
+	/// Adds an item to the back of the list and returns it.  The item still holds whatever was last stored in its slot,
+	/// so the caller must overwrite it, but any memory the old item owned can be reused.
+	/// </summary>
+	T& append()
 	{
 		if (count_ == max_size_)
 		{
@@ -107,8 +116,8 @@ public:
 			}
 		}
 		int pos = get_index_position(count_);
-		items_[pos] = object;
 		count_++;
+		return items_[pos];
 	}
 
 	T& pop_front()
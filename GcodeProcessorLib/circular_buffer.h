@@ -99,7 +99,16 @@ public:
 		return index_position;
 	}
 
-	void push_front(T object)
+	void push_front(const T& object)
+	{
+		push_front_slot() = object;
+	}
+
+	/// <summary>
+	/// Adds a slot to the front of the buffer and returns its item, which still holds whatever was stored there before.
+	/// This lets the caller overwrite the item in place instead of constructing and copying a new one.
+	/// </summary>
+	T& push_front_slot()
 	{
 		//front_index_ = (front_index_ - 1 + max_size_) % max_size_;
 		front_index_ -= 1;
@@ -111,10 +120,10 @@ public:
 		{
 			count_++;
 		}
-		items_[front_index_] = object;
+		return items_[front_index_];
 	}
 
-	void push_back(T object)
+	void push_back(const T& object)
 	{
 		int pos = get_index_position(count_);
 		items_[pos] = object;
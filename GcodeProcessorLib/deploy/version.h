@@ -0,0 +1,13 @@
+
+// In version.h.in
+#ifndef VERSION_GENERATED_H
+	#define VERSION_GENERATED_H
+	#define GIT_BRANCH "master"
+	#define GIT_COMMIT_HASH "feb305b"
+	#define GIT_TAGGED_VERSION ""
+	#define GIT_TAG ""
+	#define BUILD_DATE "2026-10-17T07:29:25Z"
+	#define COPYRIGHT_DATE "2026"
+	#define AUTHOR "Brad Hochgesang"
+#endif
+// end of version.h.in
@@ -20,6 +20,7 @@
 // FormerLurker@pm.me
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #include "gcode_comment_processor.h"
+#include <cctype>
 
 gcode_comment_processor::gcode_comment_processor()
 {
@@ -36,7 +37,20 @@ comment_process_type gcode_comment_processor::get_comment_process_type()
 	return processing_type_;
 }
 
-void gcode_comment_processor::update(position& pos)
+const std::string& gcode_comment_processor::trim_comment(const std::string& comment)
+{
+	// Slicers separate the comment from the semicolon and the gcode with spaces, e.g. 'G1 X1 Y1 E1 ; perimeter'.
+	std::string::size_type start = 0;
+	std::string::size_type end = comment.length();
+	while (start < end && std::isspace(static_cast<unsigned char>(comment[start])))
+		start++;
+	while (end > start && std::isspace(static_cast<unsigned char>(comment[end - 1])))
+		end--;
+	trimmed_comment_.assign(comment, start, end - start);
+	return trimmed_comment_;
+}
+
+void gcode_comment_processor::update(position& pos, const std::string& comment)
 {
 	if (processing_type_ == comment_process_type_off)
 		return;
@@ -47,15 +61,15 @@ void gcode_comment_processor::update(position& pos)
 		return;
 	}		
 
-	if (processing_type_ == comment_process_type_unknown || processing_type_ == comment_process_type_slic3r_pe)
+	if (comment.length() != 0 && (processing_type_ == comment_process_type_unknown || processing_type_ == comment_process_type_slic3r_pe))
 	{
-		if (update_feature_for_slic3r_pe_comment(pos, pos.command.comment))
+		if (update_feature_for_slic3r_pe_comment(pos, trim_comment(comment)))
 			processing_type_ = comment_process_type_slic3r_pe;
 	}
 	
 }
 
-bool gcode_comment_processor::update_feature_for_slic3r_pe_comment(position& pos, std::string &comment) const
+bool gcode_comment_processor::update_feature_for_slic3r_pe_comment(position& pos, const std::string &comment) const
 {
 	if (comment == "perimeter" || comment == "move to first perimeter point")
 	{
@@ -111,34 +125,41 @@ void gcode_comment_processor::update_feature_from_section(position& pos) const
 	case(section_type_gap_fill_section):
 		pos.feature_type_tag = feature_type_gap_fill_feature;
 		break;
+	case(section_type_bridge_section):
+		pos.feature_type_tag = feature_type_bridge_feature;
+		break;
 	case(section_type_no_section):
 		// Do Nothing
 		break;
 	}
 }
 
-void gcode_comment_processor::update(std::string & comment)
+void gcode_comment_processor::update(const std::string & comment)
 {
+	if (processing_type_ == comment_process_type_off || comment.length() == 0)
+		return;
+
+	const std::string& trimmed_comment = trim_comment(comment);
 	switch(processing_type_)
 	{
 	case comment_process_type_off:
 		break;
 	case comment_process_type_unknown:
-		update_unknown_section(comment);
+		update_unknown_section(trimmed_comment);
 		break;
 	case comment_process_type_cura:
-		update_cura_section(comment);
+		update_cura_section(trimmed_comment);
 		break;
 	case comment_process_type_slic3r_pe:
-		update_slic3r_pe_section(comment);
+		update_slic3r_pe_section(trimmed_comment);
 		break;
 	case comment_process_type_simplify_3d:
-		update_simplify_3d_section(comment);
+		update_simplify_3d_section(trimmed_comment);
 		break;
 	}
 }
 
-void gcode_comment_processor::update_unknown_section(std::string & comment)
+void gcode_comment_processor::update_unknown_section(const std::string & comment)
 {
 	if (comment.length() == 0)
 		return;
@@ -161,7 +182,7 @@ void gcode_comment_processor::update_unknown_section(std::string & comment)
 	}
 }
 
-bool gcode_comment_processor::update_cura_section(std::string &comment)
+bool gcode_comment_processor::update_cura_section(const std::string &comment)
 {
 	if (comment == "TYPE:WALL-OUTER")
 	{
@@ -183,7 +204,7 @@ bool gcode_comment_processor::update_cura_section(std::string &comment)
 		current_section_ = section_type_solid_infill_section;
 		return true;
 	}
-	if (comment.rfind("LAYER:", 0) != std::string::npos || comment.rfind(";MESH:NONMESH", 0) != std::string::npos)
+	if (comment.rfind("LAYER:", 0) != std::string::npos || comment.rfind("MESH:NONMESH", 0) != std::string::npos)
 	{
 		current_section_ = section_type_no_section;
 		return false;
@@ -193,10 +214,21 @@ bool gcode_comment_processor::update_cura_section(std::string &comment)
 		current_section_ = section_type_skirt_section;
 		return true;
 	}
+	if (comment == "TYPE:PRIME-TOWER")
+	{
+		current_section_ = section_type_prime_pillar_section;
+		return true;
+	}
+	if (comment.rfind("TYPE:", 0) != std::string::npos)
+	{
+		// Supports and any other types end the previous section.  PrusaSlicer also writes TYPE comments, so these do
+		// not identify the slicer.
+		current_section_ = section_type_no_section;
+	}
 	return false;
 }
 
-bool gcode_comment_processor::update_simplify_3d_section(std::string &comment)
+bool gcode_comment_processor::update_simplify_3d_section(const std::string &comment)
 {
 	// Apparently simplify 3d added the word 'feature' to the their feature comments
 	// at some point to make my life more difficult :P
@@ -293,7 +325,7 @@ bool gcode_comment_processor::update_simplify_3d_section(std::string &comment)
 	return false;
 }
 
-bool gcode_comment_processor::update_slic3r_pe_section(std::string &comment)
+bool gcode_comment_processor::update_slic3r_pe_section(const std::string &comment)
 {
 	if (comment == "CP TOOLCHANGE WIPE")
 	{
@@ -305,6 +337,59 @@ bool gcode_comment_processor::update_slic3r_pe_section(std::string &comment)
 		current_section_ = section_type_no_section;
 		return true;
 	}
+	if (comment.rfind("TYPE:", 0) != std::string::npos)
+	{
+		return update_slic3r_pe_type_section(comment);
+	}
+	return false;
+}
+
+bool gcode_comment_processor::update_slic3r_pe_type_section(const std::string &comment)
+{
+	// PrusaSlicer (and SuperSlicer) mark each extrusion role with a TYPE comment, e.g. ';TYPE:External perimeter'.
+	if (comment == "TYPE:External perimeter")
+	{
+		current_section_ = section_type_outer_perimeter_section;
+		return true;
+	}
+	if (comment == "TYPE:Perimeter")
+	{
+		current_section_ = section_type_inner_perimeter_section;
+		return true;
+	}
+	if (comment == "TYPE:Internal infill")
+	{
+		current_section_ = section_type_infill_section;
+		return true;
+	}
+	if (comment == "TYPE:Solid infill" || comment == "TYPE:Top solid infill")
+	{
+		current_section_ = section_type_solid_infill_section;
+		return true;
+	}
+	// Overhang perimeters are printed over air, like bridges.
+	if (comment == "TYPE:Bridge infill" || comment == "TYPE:Internal bridge infill" || comment == "TYPE:Overhang perimeter")
+	{
+		current_section_ = section_type_bridge_section;
+		return true;
+	}
+	if (comment == "TYPE:Gap fill")
+	{
+		current_section_ = section_type_gap_fill_section;
+		return true;
+	}
+	if (comment == "TYPE:Skirt" || comment == "TYPE:Skirt/Brim")
+	{
+		current_section_ = section_type_skirt_section;
+		return true;
+	}
+	if (comment == "TYPE:Wipe tower")
+	{
+		current_section_ = section_type_prime_pillar_section;
+		return true;
+	}
+	// Supports, ironing, custom gcode and any other types end the previous section.
+	current_section_ = section_type_no_section;
 	return false;
 }
 
@@ -58,7 +58,8 @@ enum section_type
 	section_type_skirt_section, 
 	section_type_solid_infill_section, 
 	section_type_ooze_shield_section,
-	section_type_prime_pillar_section
+	section_type_prime_pillar_section,
+	section_type_bridge_section
 };
 
 class gcode_comment_processor
@@ -68,23 +69,27 @@ public:
 	
 	gcode_comment_processor();
 	~gcode_comment_processor();
-	void update(position& pos);
-	void update(std::string & comment);
+	void update(position& pos, const std::string& comment);
+	void update(const std::string & comment);
 	comment_process_type get_comment_process_type();
 
 private:
 	section_type current_section_;
 	comment_process_type processing_type_;
+	// Holds the comment without surrounding whitespace.  It is reused so that trimming does not allocate for every line.
+	std::string trimmed_comment_;
+	const std::string& trim_comment(const std::string& comment);
 	void update_feature_from_section(position& pos) const;
 	bool update_feature_from_section_from_section(position& pos) const;
 	bool update_feature_from_section_for_cura(position& pos) const;
 	bool update_feature_from_section_for_simplify_3d(position& pos) const;
 	bool update_feature_from_section_for_slice3r_pe(position& pos) const;
-	void update_feature_for_unknown_slicer_comment(position& pos, std::string &comment);
-	bool update_feature_for_slic3r_pe_comment(position& pos, std::string &comment) const;
-	void update_unknown_section(std::string & comment);
-	bool update_cura_section(std::string &comment);
-	bool update_simplify_3d_section(std::string &comment);
-	bool update_slic3r_pe_section(std::string &comment);
+	void update_feature_for_unknown_slicer_comment(position& pos, const std::string &comment);
+	bool update_feature_for_slic3r_pe_comment(position& pos, const std::string &comment) const;
+	void update_unknown_section(const std::string & comment);
+	bool update_cura_section(const std::string &comment);
+	bool update_simplify_3d_section(const std::string &comment);
+	bool update_slic3r_pe_section(const std::string &comment);
+	bool update_slic3r_pe_type_section(const std::string &comment);
 };
 
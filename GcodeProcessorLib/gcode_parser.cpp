@@ -26,69 +26,6 @@
 #include <iostream>
 gcode_parser::gcode_parser()
 {
-	// doesn't work in the ancient version of c++ I am forced to use :(
-	// or at least I don't know how to us a newer one with python 2.7
-	// help...
-	/* 
-	std::vector<std::string> text_only_function_names = { "M117" }; // "M117" is an example of a command that would work here.
-
-	std::vector<std::string> parsable_command_names = {
-		"G0","G1","G2","G3","G10","G11","G20","G21","G28","G29","G80","G90","G91","G92","M82","M83","M104","M105","M106","M109","M114","M116","M140","M141","M190","M191","M207","M208","M240","M400","T"
-	};
-	*/
-	// Have to resort to barbarity.
-	// Text only function names
-	std::vector<std::string> text_only_function_names;
-	text_only_function_names.push_back(("M117"));
-	// parsable_command_names
-	std::vector<std::string> parsable_command_names;
-	parsable_command_names.push_back("G0");
-	parsable_command_names.push_back("G1");
-	parsable_command_names.push_back("G2");
-	parsable_command_names.push_back("G3");
-	parsable_command_names.push_back("G10");
-	parsable_command_names.push_back("G11");
-	parsable_command_names.push_back("G20");
-	parsable_command_names.push_back("G21");
-	parsable_command_names.push_back("G28");
-	parsable_command_names.push_back("G29");
-	parsable_command_names.push_back("G80");
-	parsable_command_names.push_back("G90");
-	parsable_command_names.push_back("G91");
-	parsable_command_names.push_back("G92");
-	parsable_command_names.push_back("M82");
-	parsable_command_names.push_back("M83");
-	parsable_command_names.push_back("M104");
-	parsable_command_names.push_back("M105");
-	parsable_command_names.push_back("M106");
-	parsable_command_names.push_back("M109");
-	parsable_command_names.push_back("M114");
-	parsable_command_names.push_back("M116");
-	parsable_command_names.push_back("M140");
-	parsable_command_names.push_back("M141");
-	parsable_command_names.push_back("M190");
-	parsable_command_names.push_back("M191");
-	parsable_command_names.push_back("M207");
-	parsable_command_names.push_back("M208");
-	parsable_command_names.push_back("M218");
-	parsable_command_names.push_back("M240");
-	parsable_command_names.push_back("M400");
-	parsable_command_names.push_back("M563");
-	parsable_command_names.push_back("T");
-	parsable_command_names.push_back("@OCTOLAPSE");
-
-	for (unsigned int index = 0; index < text_only_function_names.size(); index++)
-	{
-		std::string functionName = text_only_function_names[index];
-		text_only_functions_.insert(functionName);
-	}
-
-	for (unsigned int index = 0; index < parsable_command_names.size(); index++)
-	{
-		std::string commandName = parsable_command_names[index];
-		parsable_commands_.insert(commandName);
-	}
-
 }
 
 gcode_parser::gcode_parser(const gcode_parser &source)
@@ -98,8 +35,55 @@ gcode_parser::gcode_parser(const gcode_parser &source)
 
 gcode_parser::~gcode_parser()
 {
-	text_only_functions_.clear();
-	parsable_commands_.clear();
+}
+
+bool gcode_parser::is_text_only_command(int opcode)
+{
+	return opcode == gcode_opcode_m117;
+}
+
+bool gcode_parser::is_parsable_command(int opcode)
+{
+	switch (opcode)
+	{
+	case gcode_opcode_g0:
+	case gcode_opcode_g1:
+	case gcode_opcode_g2:
+	case gcode_opcode_g3:
+	case gcode_opcode_g10:
+	case gcode_opcode_g11:
+	case gcode_opcode_g20:
+	case gcode_opcode_g21:
+	case gcode_opcode_g28:
+	case gcode_opcode_g29:
+	case gcode_opcode_g80:
+	case gcode_opcode_g90:
+	case gcode_opcode_g91:
+	case gcode_opcode_g92:
+	case gcode_opcode_m82:
+	case gcode_opcode_m83:
+	case gcode_opcode_m104:
+	case gcode_opcode_m105:
+	case gcode_opcode_m106:
+	case gcode_opcode_m109:
+	case gcode_opcode_m114:
+	case gcode_opcode_m116:
+	case gcode_opcode_m140:
+	case gcode_opcode_m141:
+	case gcode_opcode_m190:
+	case gcode_opcode_m191:
+	case gcode_opcode_m207:
+	case gcode_opcode_m208:
+	case gcode_opcode_m218:
+	case gcode_opcode_m240:
+	case gcode_opcode_m400:
+	case gcode_opcode_m563:
+	case gcode_opcode_t:
+	case gcode_opcode_at_octolapse:
+		return true;
+	default:
+		return false;
+	}
 }
 
 parsed_command gcode_parser::parse_gcode(const char * gcode)
@@ -121,14 +105,29 @@ bool gcode_parser::try_parse_gcode(const char* gcode, parsed_command& command)
 {
 	  return try_parse_gcode(gcode, command, true)	 ;
 }
+
+bool gcode_parser::try_parse_gcode(const char* gcode, parsed_command& command, bool preserve_format)
+{
+	return try_parse_gcode_(gcode, command, preserve_format, false);
+}
+
+bool gcode_parser::try_parse_source_line(const char* line, size_t length, parsed_command& command)
+{
+	// The parser needs a null terminated line, so parse a copy, and then point the gcode back at the source line.
+	source_line_.assign(line, length);
+	bool result = try_parse_gcode_(source_line_.c_str(), command, true, true);
+	command.gcode.set_view(line, command.gcode.length());
+	return result;
+}
+
 // Superfast gcode parser - v2
-bool gcode_parser::try_parse_gcode(const char * gcode, parsed_command & command, bool preserve_format)
+bool gcode_parser::try_parse_gcode_(const char * gcode, parsed_command & command, bool preserve_format, bool reference_source)
 {
 	// Create a command
 	char * p_gcode = const_cast<char *>(gcode);
 	char * p = const_cast<char *>(gcode);
 	command.is_empty = true;
-	command.is_known_command = try_extract_gcode_command(&p, &(command.command));
+	command.is_known_command = try_extract_gcode_command(&p, &(command.command), &(command.opcode));
 	if (!command.is_known_command)
 	{
 		while (true)
@@ -141,47 +140,59 @@ bool gcode_parser::try_parse_gcode(const char * gcode, parsed_command & command,
 				command.is_empty = false;
 				break;
 			}
-			else if (preserve_format) {
-				command.gcode.push_back(c);
-			}
 			p_gcode++;
 		}
 		command.command = "";
+		command.opcode = gcode_opcode_unknown;
 	}
 	else
 		command.is_empty = false;
 
-	bool has_seen_character = false;
+	bool is_text_only_parameter = is_text_only_command(command.opcode);
 
-	bool is_text_only_parameter = text_only_functions_.find(command.command) != text_only_functions_.end();
-
-	while (true)
+	if (preserve_format)
 	{
-		char cur_char = *p_gcode;
-		if (cur_char == '\0' || cur_char == ';')
-			break;
-		else if (cur_char > 32 || (cur_char == ' ' && has_seen_character))
+		// The gcode is everything before the comment, so there is no need to copy it character by character.
+		while (*p_gcode != '\0' && *p_gcode != ';')
 		{
-			if (!preserve_format && !is_text_only_parameter && (cur_char >= 'a' && cur_char <= 'z'))
-				command.gcode.push_back(cur_char - 32);
-			else
-				command.gcode.push_back(cur_char);
-			has_seen_character = true;
+			p_gcode++;
 		}
-		else if (preserve_format)
+		if (reference_source)
+		{
+			command.gcode.set_view(gcode, static_cast<size_t>(p_gcode - gcode));
+		}
+		else
 		{
-			command.gcode.push_back(cur_char);
+			command.gcode.assign(gcode, static_cast<size_t>(p_gcode - gcode));
 		}
-		p_gcode++;
 	}
-	if (!preserve_format){
-		command.gcode = utilities::rtrim(command.gcode);
+	else
+	{
+		bool has_seen_character = false;
+		std::string formatted_gcode;
+		while (true)
+		{
+			char cur_char = *p_gcode;
+			if (cur_char == '\0' || cur_char == ';')
+				break;
+			else if (cur_char > 32 || (cur_char == ' ' && has_seen_character))
+			{
+				if (!is_text_only_parameter && (cur_char >= 'a' && cur_char <= 'z'))
+					formatted_gcode.push_back(cur_char - 32);
+				else
+					formatted_gcode.push_back(cur_char);
+				has_seen_character = true;
+			}
+			p_gcode++;
+		}
+		formatted_gcode = utilities::rtrim(formatted_gcode);
+		command.gcode.assign(formatted_gcode.c_str(), formatted_gcode.length());
 	}
 
-	if (command.is_known_command && parsable_commands_.find(command.command) != parsable_commands_.end())
+	if (command.is_known_command && is_parsable_command(command.opcode))
 	{
 
-		if (command.command.length() > 0 && command.command == "@OCTOLAPSE")
+		if (command.opcode == gcode_opcode_at_octolapse)
 		{
 			
 			parsed_command_parameter octolapse_parameter;
@@ -209,7 +220,7 @@ bool gcode_parser::try_parse_gcode(const char * gcode, parsed_command & command,
 		else if (
 			is_text_only_parameter ||
 			(
-				command.command.length() > 0 && command.command[0] == '@'
+				command.opcode == gcode_opcode_at_command
 			)
 		){
 			//std::cout << "GcodeParser.try_parse_gcode - Text only parameter found.\r\n";
@@ -223,7 +234,7 @@ bool gcode_parser::try_parse_gcode(const char * gcode, parsed_command & command,
 		}
 		else
 		{
-			if (command.command[0] == 'T')
+			if (command.opcode == gcode_opcode_t)
 			{
 				//std::cout << "GcodeParser.try_parse_gcode - T parameter found.\r\n";
 				parsed_command_parameter param;
@@ -259,11 +270,15 @@ bool gcode_parser::try_parse_gcode(const char * gcode, parsed_command & command,
 	
 }
 
-bool gcode_parser::try_extract_gcode_command(char ** p_p_gcode, std::string * p_command)
+bool gcode_parser::try_extract_gcode_command(char ** p_p_gcode, std::string * p_command, int * p_opcode)
 {
 	char * p = *p_p_gcode;
 	char gcode_word;
 	bool found_command = false;
+	// Build the opcode as the address is extracted
+	int number = 0;
+	int sub_code = -1;
+	*p_opcode = gcode_opcode_unknown;
 
 	// Ignore Leading Spaces
 	while (*p == ' ')
@@ -274,6 +289,10 @@ bool gcode_parser::try_extract_gcode_command(char ** p_p_gcode, std::string * p_
 	if (*p == '@')
 	{
 		found_command = gcode_parser::try_extract_at_command(&p, p_command);
+		if (found_command)
+		{
+			*p_opcode = *p_command == "@OCTOLAPSE" ? gcode_opcode_at_octolapse : gcode_opcode_at_command;
+		}
 	}
 	else
 	{
@@ -299,6 +318,10 @@ bool gcode_parser::try_extract_gcode_command(char ** p_p_gcode, std::string * p_
 				if (*p != ' ')
 				{
 					found_command = true;
+					if (number <= GCODE_OPCODE_MAX_NUMBER)
+					{
+						number = number * 10 + (*p - '0');
+					}
 					(*p_command).push_back(*p++);
 				}
 				else if (found_command)
@@ -324,16 +347,25 @@ bool gcode_parser::try_extract_gcode_command(char ** p_p_gcode, std::string * p_
 			if (*p == '.') {
 				(*p_command).push_back(*p++);
 				found_command = false;
+				sub_code = 0;
 				while ((*p >= '0' && *p <= '9') || *p == ' ') {
 					if (*p != ' ')
 					{
 						found_command = true;
+						if (sub_code < GCODE_OPCODE_MAX_SUB_CODE)
+						{
+							sub_code = sub_code * 10 + (*p - '0');
+						}
 						(*p_command).push_back(*p++);
 					}
 					else
 						++p;
 				}
 			}
+			if (found_command && number <= GCODE_OPCODE_MAX_NUMBER && sub_code < GCODE_OPCODE_MAX_SUB_CODE)
+			{
+				*p_opcode = GCODE_OPCODE(gcode_word, number) | (sub_code + 1);
+			}
 		}
 		else
 		{
@@ -370,6 +402,10 @@ bool gcode_parser::try_extract_gcode_command(char ** p_p_gcode, std::string * p_
 			{
 				found_command = true;
 			}
+			if (found_command)
+			{
+				*p_opcode = gcode_opcode_t;
+			}
 		}
 	}
 	*p_p_gcode = p;
@@ -24,7 +24,6 @@
 #define GCODE_PARSER_H
 #include <string>
 #include <vector>
-#include <set>
 #include "parsed_command.h"
 #include "parsed_command_parameter.h"
 static const std::string GCODE_WORDS = "GMT";
@@ -36,16 +35,21 @@ public:
 	~gcode_parser();
 	bool try_parse_gcode(const char * gcode, parsed_command & command);
 	bool try_parse_gcode(const char* gcode, parsed_command& command, bool preserve_format);
+	/// <summary>
+	/// Parses a source line that is not null terminated, preserving its format.  The parsed gcode references the line
+	/// instead of copying it, so the line must outlive the command and any copies of it.
+	/// </summary>
+	bool try_parse_source_line(const char* line, size_t length, parsed_command& command);
 	parsed_command parse_gcode(const char * gcode);
 	parsed_command parse_gcode(const char* gcode, bool preserve_format);
+	static bool is_text_only_command(int opcode);
+	static bool is_parsable_command(int opcode);
 private:
 	gcode_parser(const gcode_parser &source);
-	// Variables and lookups
-	std::set<std::string> text_only_functions_;
-	std::set<std::string> parsable_commands_;
 	// Functions
+	bool try_parse_gcode_(const char* gcode, parsed_command& command, bool preserve_format, bool reference_source);
 	bool try_extract_double(char ** p_p_gcode, double * p_double, unsigned char * p_precision) const;
-	static bool try_extract_gcode_command(char ** p_p_gcode, std::string * p_command);
+	static bool try_extract_gcode_command(char ** p_p_gcode, std::string * p_command, int * p_opcode);
 	static bool try_extract_text_parameter(char ** p_p_gcode, std::string * p_parameter);
 	bool try_extract_parameter(char ** p_p_gcode, parsed_command_parameter * parameter) const;
 	static bool try_extract_t_parameter(char ** p_p_gcode, parsed_command_parameter * parameter);
@@ -54,5 +58,8 @@ private:
 	bool try_extract_comment(char ** p_p_gcode, std::string * p_comment);
 	static bool try_extract_at_command(char ** p_p_gcode, std::string * p_command);
 	bool try_extract_octolapse_parameter(char ** p_p_gcode, parsed_command_parameter * p_parameter);
+	// A null terminated copy of the source line being parsed.  It is reused, so it only allocates when a line is longer
+	// than any before it.
+	std::string source_line_;
 };
 #endif
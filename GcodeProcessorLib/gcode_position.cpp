@@ -228,7 +228,6 @@ gcode_position::gcode_position() : positions_(50), initial_position_(1)
 	e_axis_default_mode_ = "absolute";
 	xyz_axis_default_mode_ = "absolute";
 	units_default_ = "millimeters";
-	gcode_functions_ = get_gcode_functions();
 
 	is_bound_ = false;
 	snapshot_x_min_ = 0;
@@ -307,7 +306,6 @@ gcode_position::gcode_position(gcode_position_args args) : positions_(args.posit
 	e_axis_default_mode_ = args.e_axis_default_mode;
 	xyz_axis_default_mode_ = args.xyz_axis_default_mode;
 	units_default_ = args.units_default;
-	gcode_functions_ = get_gcode_functions();
 
 	is_bound_ = args.is_bound_;
 	snapshot_x_min_ = args.snapshot_x_min;
@@ -335,8 +333,8 @@ gcode_position::gcode_position(gcode_position_args args) : positions_(args.posit
 	initial_pos.current_tool = current_extruder;
 	for (int index = 0; index < args.num_extruders; index++)
 	{
-		initial_pos.p_extruders[index].x_firmware_offset = args.x_firmware_offsets[index];
-		initial_pos.p_extruders[index].y_firmware_offset = args.y_firmware_offsets[index];
+		initial_pos.extruders[index].x_firmware_offset = args.x_firmware_offsets[index];
+		initial_pos.extruders[index].y_firmware_offset = args.y_firmware_offsets[index];
 	}
 	positions_.initialize(initial_pos);
 	initial_position_ = initial_pos;	
@@ -420,15 +418,17 @@ void gcode_position::add_position(position& pos)
 	positions_.push_front(pos);
 }
 
-void gcode_position::add_position(parsed_command& cmd)
+void gcode_position::add_position()
 {
-
-	position current_position = positions_[0];
+	// Copy the previous position into the next slot of the buffer, which avoids constructing a new position.
+	position* p_previous_position = &positions_[0];
+	position& current_position = positions_.push_front_slot();
+	if (&current_position != p_previous_position)
+	{
+		current_position = *p_previous_position;
+	}
 	current_position.reset_state();
-	current_position.command = cmd;
 	current_position.is_empty = false;
-	positions_.push_front(current_position);
-
 }
 
 position gcode_position::get_position(int index)
@@ -462,35 +462,33 @@ position * gcode_position::get_previous_position_ptr()
 	return get_position_ptr(1);
 }
 
-void gcode_position::update(parsed_command& command, const long file_line_number, const long gcode_number, const long file_position)
+void gcode_position::update(const parsed_command& command, const long file_line_number, const long gcode_number, const long file_position)
 {
-	
-	/*if (command.is_empty)
-	{
-		// process any comment sections
-		comment_processor_.update(command.comment);
-		return;
-	}*/
-	
-	add_position(command);
+	add_position();
 	position * p_current_pos = get_current_position_ptr();
 	position * p_previous_pos = get_previous_position_ptr();
 	p_current_pos->file_line_number = file_line_number;
 	p_current_pos->gcode_number = gcode_number;
 	p_current_pos->file_position = file_position;
-	comment_processor_.update(*p_current_pos);
+	STAGE_TIMER_START(comment_start);
+	if (command.is_empty)
+	{
+		// process any comment sections, e.g. ';TYPE:WALL-OUTER'
+		comment_processor_.update(command.comment);
+	}
+	comment_processor_.update(*p_current_pos, command.comment);
+	STAGE_TIMER_STOP(comment_start, comment_timing_);
 
 	if (!command.is_known_command || command.is_empty)
 		return;
 
-	// Does our function exist in our functions map?
-	gcode_functions_iterator_ = gcode_functions_.find(command.command);
+	// Is there a function for this command?
+	const pos_function_type func = get_gcode_function(command.opcode);
 
-	if (gcode_functions_iterator_ != gcode_functions_.end())
+	if (func != NULL)
 	{
 		p_current_pos->gcode_ignored = false;
 		// Execute the function to process this gcode
-		const pos_function_type func = gcode_functions_iterator_->second;
 		(this->*func)(p_current_pos, command);
 		// calculate z and e relative distances
 		p_current_pos->get_current_extruder().e_relative = (p_current_pos->get_current_extruder().e - p_previous_pos->get_extruder(p_current_pos->current_tool).e);
@@ -695,6 +693,13 @@ void gcode_position::undo_update()
 	positions_.pop_front();
 }
 
+void gcode_position::restore(const position& current_position, const gcode_comment_processor& comment_processor)
+{
+	positions_.clear();
+	positions_.push_front(current_position);
+	comment_processor_ = comment_processor;
+}
+
 position* gcode_position::undo_update(int num_updates)
 {
 	if (num_updates < 1)
@@ -712,29 +717,50 @@ position* gcode_position::undo_update(int num_updates)
 }
 
 // Private Members
-std::map<std::string, gcode_position::pos_function_type> gcode_position::get_gcode_functions()
+gcode_position::pos_function_type gcode_position::get_gcode_function(int opcode)
 {
-	std::map<std::string, pos_function_type> newMap;
-	newMap.insert(std::make_pair("G0", &gcode_position::process_g0_g1));
-	newMap.insert(std::make_pair("G1", &gcode_position::process_g0_g1));
-	newMap.insert(std::make_pair("G2", &gcode_position::process_g2));
-	newMap.insert(std::make_pair("G3", &gcode_position::process_g3));
-	newMap.insert(std::make_pair("G10", &gcode_position::process_g10));
-	newMap.insert(std::make_pair("G11", &gcode_position::process_g11));
-	newMap.insert(std::make_pair("G20", &gcode_position::process_g20));
-	newMap.insert(std::make_pair("G21", &gcode_position::process_g21));
-	newMap.insert(std::make_pair("G28", &gcode_position::process_g28));
-	newMap.insert(std::make_pair("G90", &gcode_position::process_g90));
-	newMap.insert(std::make_pair("G91", &gcode_position::process_g91));
-	newMap.insert(std::make_pair("G92", &gcode_position::process_g92));
-	newMap.insert(std::make_pair("M82", &gcode_position::process_m82));
-	newMap.insert(std::make_pair("M83", &gcode_position::process_m83));
-	newMap.insert(std::make_pair("M207", &gcode_position::process_m207));
-	newMap.insert(std::make_pair("M208", &gcode_position::process_m208));
-	newMap.insert(std::make_pair("M218", &gcode_position::process_m218));
-	newMap.insert(std::make_pair("M563", &gcode_position::process_m563));
-	newMap.insert(std::make_pair("T", &gcode_position::process_t));
-	return newMap;
+	switch (opcode)
+	{
+	case gcode_opcode_g0:
+	case gcode_opcode_g1:
+		return &gcode_position::process_g0_g1;
+	case gcode_opcode_g2:
+		return &gcode_position::process_g2;
+	case gcode_opcode_g3:
+		return &gcode_position::process_g3;
+	case gcode_opcode_g10:
+		return &gcode_position::process_g10;
+	case gcode_opcode_g11:
+		return &gcode_position::process_g11;
+	case gcode_opcode_g20:
+		return &gcode_position::process_g20;
+	case gcode_opcode_g21:
+		return &gcode_position::process_g21;
+	case gcode_opcode_g28:
+		return &gcode_position::process_g28;
+	case gcode_opcode_g90:
+		return &gcode_position::process_g90;
+	case gcode_opcode_g91:
+		return &gcode_position::process_g91;
+	case gcode_opcode_g92:
+		return &gcode_position::process_g92;
+	case gcode_opcode_m82:
+		return &gcode_position::process_m82;
+	case gcode_opcode_m83:
+		return &gcode_position::process_m83;
+	case gcode_opcode_m207:
+		return &gcode_position::process_m207;
+	case gcode_opcode_m208:
+		return &gcode_position::process_m208;
+	case gcode_opcode_m218:
+		return &gcode_position::process_m218;
+	case gcode_opcode_m563:
+		return &gcode_position::process_m563;
+	case gcode_opcode_t:
+		return &gcode_position::process_t;
+	default:
+		return NULL;
+	}
 }
 
 void gcode_position::update_position(
@@ -856,7 +882,7 @@ void gcode_position::update_position(
 
 }
 
-void gcode_position::process_g0_g1(position* pos, parsed_command& cmd)
+void gcode_position::process_g0_g1(position* pos, const parsed_command& cmd)
 {
 	bool update_x = false;
 	bool update_y = false;
@@ -900,7 +926,7 @@ void gcode_position::process_g0_g1(position* pos, parsed_command& cmd)
 	update_position(pos, x, update_x, y, update_y, z, update_z, e, update_e, f, update_f, false, true);
 }
 
-void gcode_position::process_g2(position* pos, parsed_command& cmd)
+void gcode_position::process_g2(position* pos, const parsed_command& cmd)
 {
 	bool update_x = false;
 	bool update_y = false;
@@ -944,12 +970,12 @@ void gcode_position::process_g2(position* pos, parsed_command& cmd)
 	update_position(pos, x, update_x, y, update_y, z, update_z, e, update_e, f, update_f, false, true);
 }
 
-void gcode_position::process_g3(position* pos, parsed_command& cmd)
+void gcode_position::process_g3(position* pos, const parsed_command& cmd)
 {
 	return process_g2(pos, cmd);
 }
 
-void gcode_position::process_g10(position* pos, parsed_command& cmd)
+void gcode_position::process_g10(position* pos, const parsed_command& cmd)
 {
 	// Take 0 based extruder parameter in account
 	int p = 0;
@@ -1040,22 +1066,22 @@ void gcode_position::process_g10(position* pos, parsed_command& cmd)
 	// Todo: add firmware retract here
 }
 
-void gcode_position::process_g11(position* pos, parsed_command& cmd)
+void gcode_position::process_g11(position* pos, const parsed_command& cmd)
 {
 	// Todo: Fix G11
 }
 
-void gcode_position::process_g20(position* pos, parsed_command& cmd)
+void gcode_position::process_g20(position* pos, const parsed_command& cmd)
 {
 
 }
 
-void gcode_position::process_g21(position* pos, parsed_command& cmd)
+void gcode_position::process_g21(position* pos, const parsed_command& cmd)
 {
 
 }
 
-void gcode_position::process_g28(position* pos, parsed_command& cmd)
+void gcode_position::process_g28(position* pos, const parsed_command& cmd)
 {
 	bool has_x = false;
 	bool has_y = false;
@@ -1119,7 +1145,7 @@ void gcode_position::process_g28(position* pos, parsed_command& cmd)
 	// todo: set error flag on else
 }
 
-void gcode_position::process_g90(position* pos, parsed_command& cmd)
+void gcode_position::process_g90(position* pos, const parsed_command& cmd)
 {
 	// Set xyz to absolute mode
 	if (pos->is_relative_null)
@@ -1138,7 +1164,7 @@ void gcode_position::process_g90(position* pos, parsed_command& cmd)
 
 }
 
-void gcode_position::process_g91(position* pos, parsed_command& cmd)
+void gcode_position::process_g91(position* pos, const parsed_command& cmd)
 {
 	// Set XYZ axis to relative mode
 	if (pos->is_relative_null)
@@ -1156,7 +1182,7 @@ void gcode_position::process_g91(position* pos, parsed_command& cmd)
 	}
 }
 
-void gcode_position::process_g92(position* pos, parsed_command& cmd)
+void gcode_position::process_g92(position* pos, const parsed_command& cmd)
 {
 	// Set position offset
 	bool update_x = false;
@@ -1259,7 +1285,7 @@ void gcode_position::process_g92(position* pos, parsed_command& cmd)
 	}
 }
 
-void gcode_position::process_m82(position* pos, parsed_command& cmd)
+void gcode_position::process_m82(position* pos, const parsed_command& cmd)
 {
 	// Set extrder mode to absolute
 	if (pos->is_extruder_relative_null)
@@ -1268,7 +1294,7 @@ void gcode_position::process_m82(position* pos, parsed_command& cmd)
 	pos->is_extruder_relative = false;
 }
 
-void gcode_position::process_m83(position* pos, parsed_command& cmd)
+void gcode_position::process_m83(position* pos, const parsed_command& cmd)
 {
 	// Set extrder mode to relative
 	if (pos->is_extruder_relative_null)
@@ -1277,17 +1303,17 @@ void gcode_position::process_m83(position* pos, parsed_command& cmd)
 	pos->is_extruder_relative = true;
 }
 
-void gcode_position::process_m207(position* pos, parsed_command& cmd)
+void gcode_position::process_m207(position* pos, const parsed_command& cmd)
 {
 	// Todo: impemente firmware retract
 }
 
-void gcode_position::process_m208(position* pos, parsed_command& cmd)
+void gcode_position::process_m208(position* pos, const parsed_command& cmd)
 {
 	// Todo: implement firmware retract
 }
 
-void gcode_position::process_m218(position* pos, parsed_command& cmd)
+void gcode_position::process_m218(position* pos, const parsed_command& cmd)
 {
 	
 	// Set hotend offsets
@@ -1373,12 +1399,12 @@ void gcode_position::process_m218(position* pos, parsed_command& cmd)
 	}
 }
 
-void gcode_position::process_m563(position* pos, parsed_command& cmd)
+void gcode_position::process_m563(position* pos, const parsed_command& cmd)
 {
 	// Todo:  Work on this command, which defines tools and will affect which tool is selected.
 }
 
-void gcode_position::process_t(position* pos, parsed_command& cmd)
+void gcode_position::process_t(position* pos, const parsed_command& cmd)
 {
 	for (unsigned int index = 0; index < cmd.parameters.size(); index++)
 	{
@@ -1407,4 +1433,9 @@ void gcode_position::process_t(position* pos, parsed_command& cmd)
 gcode_comment_processor* gcode_position::get_gcode_comment_processor()
 {
 	return &comment_processor_;
+}
+
+const stage_timer_statistic& gcode_position::get_comment_timing() const
+{
+	return comment_timing_;
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 #include "gcode_parser.h"
 #include "position.h"
 #include "gcode_comment_processor.h"
+#include "stage_timer.h"
 struct gcode_position_args {
 	gcode_position_args() {
 		position_buffer_size = 50;
@@ -130,14 +131,18 @@ struct gcode_position_args {
 class gcode_position
 {
 public:
-	typedef void(gcode_position::*pos_function_type)(position*, parsed_command&);
+	typedef void(gcode_position::*pos_function_type)(position*, const parsed_command&);
 	gcode_position(gcode_position_args args);
 	gcode_position();
 	virtual ~gcode_position();
 
-	void update(parsed_command &command, long file_line_number, long gcode_number, const long file_position);
+	void update(const parsed_command& command, long file_line_number, long gcode_number, const long file_position);
 	void update_position(position *position, double x, bool update_x, double y, bool update_y, double z, bool update_z, double e, bool update_e, double f, bool update_f, bool force, bool is_g1_g0) const;
 	void undo_update();
+	/// <summary>
+	/// Discards the position history and continues from the supplied position and comment processor state.
+	/// </summary>
+	void restore(const position& current_position, const gcode_comment_processor& comment_processor);
 	position * undo_update(int num_updates);
 	int get_num_positions();
 	int get_max_positions();
@@ -150,12 +155,16 @@ public:
 	position * get_previous_position_ptr();
 	gcode_comment_processor* get_gcode_comment_processor();
 	bool get_g90_91_influences_extruder();
+	/// <summary>
+	/// The time spent processing comments during update.  Always empty unless STAGE_TIMING is defined.
+	/// </summary>
+	const stage_timer_statistic& get_comment_timing() const;
 private:
 	gcode_position(const gcode_position &source);
 	position initial_position_;
 	int position_buffer_size_;
 	circular_buffer<position> positions_;
-	void add_position(parsed_command &);
+	void add_position();
 	void add_position(position &);
 	bool autodetect_position_;
 	double priming_height_;
@@ -191,31 +200,29 @@ private:
 	bool shared_extruder_;
 	bool zero_based_extruder_;
 
-	std::map<std::string, pos_function_type> gcode_functions_;
-	std::map<std::string, pos_function_type>::iterator gcode_functions_iterator_;
-	
-	std::map<std::string, pos_function_type> get_gcode_functions();
+	static pos_function_type get_gcode_function(int opcode);
 	/// Process Gcode Command Functions
-	void process_g0_g1(position*, parsed_command&);
-	void process_g2(position*, parsed_command&);
-	void process_g3(position*, parsed_command&);
-	void process_g10(position*, parsed_command&);
-	void process_g11(position*, parsed_command&);
-	void process_g20(position*, parsed_command&);
-	void process_g21(position*, parsed_command&);
-	void process_g28(position*, parsed_command&);
-	void process_g90(position*, parsed_command&);
-	void process_g91(position*, parsed_command&);
-	void process_g92(position*, parsed_command&);
-	void process_m82(position*, parsed_command&);
-	void process_m83(position*, parsed_command&);
-	void process_m207(position*, parsed_command&);
-	void process_m208(position*, parsed_command&);
-	void process_m218(position*, parsed_command&);
-	void process_m563(position*, parsed_command&);
-	void process_t(position*, parsed_command&);
+	void process_g0_g1(position*, const parsed_command&);
+	void process_g2(position*, const parsed_command&);
+	void process_g3(position*, const parsed_command&);
+	void process_g10(position*, const parsed_command&);
+	void process_g11(position*, const parsed_command&);
+	void process_g20(position*, const parsed_command&);
+	void process_g21(position*, const parsed_command&);
+	void process_g28(position*, const parsed_command&);
+	void process_g90(position*, const parsed_command&);
+	void process_g91(position*, const parsed_command&);
+	void process_g92(position*, const parsed_command&);
+	void process_m82(position*, const parsed_command&);
+	void process_m83(position*, const parsed_command&);
+	void process_m207(position*, const parsed_command&);
+	void process_m208(position*, const parsed_command&);
+	void process_m218(position*, const parsed_command&);
+	void process_m563(position*, const parsed_command&);
+	void process_t(position*, const parsed_command&);
 
 	gcode_comment_processor comment_processor_;
+	stage_timer_statistic comment_timing_;
 	void delete_retraction_lengths_();
 	void delete_z_lift_heights_();
 	void set_num_extruders(int num_extruders);
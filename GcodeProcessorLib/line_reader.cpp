@@ -0,0 +1,423 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Gcode Processor Library
+//
+// Tools for parsing gcode and calculating printer state from parsed gcode commands.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "line_reader.h"
+#include <cstring>
+#include <limits>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+line_reader::line_reader() : released_position_(0)
+{
+	data_ = NULL;
+	size_ = 0;
+	position_ = 0;
+	is_open_ = false;
+	is_memory_mapped_ = false;
+	is_streaming_ = false;
+	is_end_of_stream_ = false;
+	has_error_ = false;
+	released_map_size_ = 0;
+	p_file_ = NULL;
+	block_offset_ = 0;
+#ifdef _WIN32
+	file_handle_ = INVALID_HANDLE_VALUE;
+	mapping_handle_ = NULL;
+#else
+	file_descriptor_ = -1;
+#endif
+}
+
+line_reader::~line_reader()
+{
+	close();
+}
+
+bool line_reader::open(const std::string& path)
+{
+	close();
+	if (try_map_file_(path))
+	{
+		is_memory_mapped_ = true;
+	}
+	else
+	{
+		// Read the file a block at a time instead.
+		p_file_ = fopen(path.c_str(), "rb");
+		if (p_file_ == NULL)
+		{
+			return false;
+		}
+	}
+	is_open_ = true;
+	return true;
+}
+
+bool line_reader::open_standard_input()
+{
+	close();
+#ifdef _WIN32
+	// Keep the line endings intact, just like a file.
+	_setmode(_fileno(stdin), _O_BINARY);
+#endif
+	is_streaming_ = true;
+	is_open_ = true;
+	return true;
+}
+
+void line_reader::close()
+{
+	unmap_file_();
+	if (p_file_ != NULL)
+	{
+		fclose(p_file_);
+		p_file_ = NULL;
+	}
+	std::deque<std::vector<char> >().swap(blocks_);
+	std::deque<long long>().swap(block_offsets_);
+	std::vector<char>().swap(spare_block_);
+	data_ = NULL;
+	size_ = 0;
+	position_ = 0;
+	is_open_ = false;
+	is_memory_mapped_ = false;
+	is_streaming_ = false;
+	is_end_of_stream_ = false;
+	has_error_ = false;
+	released_position_ = 0;
+	released_map_size_ = 0;
+	block_offset_ = 0;
+}
+
+bool line_reader::is_open() const
+{
+	return is_open_;
+}
+
+bool line_reader::is_memory_mapped() const
+{
+	return is_memory_mapped_;
+}
+
+bool line_reader::is_streaming() const
+{
+	return is_streaming_;
+}
+
+bool line_reader::has_error() const
+{
+	return has_error_;
+}
+
+long long line_reader::get_position() const
+{
+	return block_offset_ + position_;
+}
+
+long long line_reader::get_size() const
+{
+	return block_offset_ + size_;
+}
+
+void line_reader::release(long long position)
+{
+	released_position_.store(position, std::memory_order_relaxed);
+}
+
+bool line_reader::read_line(const char*& line, long& length)
+{
+	const char* p_end = find_line_end_();
+	while (p_end == NULL && !is_memory_mapped_ && try_read_block_())
+	{
+		p_end = find_line_end_();
+	}
+	if (position_ >= size_)
+	{
+		return false;
+	}
+	if (is_memory_mapped_ && position_ - released_map_size_ >= 2 * LINE_READER_RELEASE_SIZE)
+	{
+		release_mapped_pages_();
+	}
+	const char* p_start = data_ + position_;
+	if (p_end == NULL)
+	{
+		// This is the last line, and it has no line ending.
+		p_end = data_ + size_;
+		position_ = size_;
+	}
+	else
+	{
+		position_ = static_cast<long long>(p_end - data_) + 1;
+#ifdef _WIN32
+		// Match the text mode reads used previously, which drop the carriage return from \r\n line endings.
+		if (p_end > p_start && *(p_end - 1) == '\r')
+		{
+			p_end--;
+		}
+#endif
+	}
+	line = p_start;
+	length = static_cast<long>(p_end - p_start);
+	return true;
+}
+
+const char* line_reader::find_line_end_() const
+{
+	if (position_ >= size_)
+	{
+		return NULL;
+	}
+	return static_cast<const char*>(memchr(data_ + position_, '\n', static_cast<size_t>(size_ - position_)));
+}
+
+bool line_reader::try_read_block_()
+{
+	if (is_end_of_stream_)
+	{
+		return false;
+	}
+	long long capacity = blocks_.empty() ? 0 : static_cast<long long>(blocks_.back().size());
+	if (size_ == capacity)
+	{
+		// The block is full.  Start a new one, and copy the unfinished line to the front of it so that the line is
+		// contiguous.  The old block is kept until its lines are released.
+		release_blocks_();
+		long long partial_length = size_ - position_;
+		long long block_size = LINE_READER_BLOCK_SIZE;
+		while (block_size < partial_length * 2)
+		{
+			block_size *= 2;
+		}
+		if (spare_block_.size() == static_cast<size_t>(block_size))
+		{
+			blocks_.push_back(std::vector<char>());
+			blocks_.back().swap(spare_block_);
+		}
+		else
+		{
+			blocks_.push_back(std::vector<char>(static_cast<size_t>(block_size)));
+		}
+		block_offsets_.push_back(block_offset_ + position_);
+		char* p_block = &blocks_.back()[0];
+		if (partial_length > 0)
+		{
+			memcpy(p_block, data_ + position_, static_cast<size_t>(partial_length));
+		}
+		block_offset_ += position_;
+		data_ = p_block;
+		size_ = partial_length;
+		position_ = 0;
+		capacity = block_size;
+	}
+	long bytes_read = read_source_(&blocks_.back()[0] + size_, static_cast<long>(capacity - size_));
+	if (bytes_read <= 0)
+	{
+		is_end_of_stream_ = true;
+		has_error_ = bytes_read < 0;
+		return false;
+	}
+	size_ += bytes_read;
+	return true;
+}
+
+void line_reader::release_blocks_()
+{
+	// Every block but the current one can be released once the position after its last byte has been released.
+	long long released_position = released_position_.load(std::memory_order_relaxed);
+	while (blocks_.size() > 1 && block_offsets_[1] <= released_position)
+	{
+		if (spare_block_.empty())
+		{
+			spare_block_.swap(blocks_.front());
+		}
+		blocks_.pop_front();
+		block_offsets_.pop_front();
+	}
+}
+
+long line_reader::read_source_(char* p_buffer, long length)
+{
+	if (p_file_ == NULL)
+	{
+		return read_standard_input_(p_buffer, length);
+	}
+	size_t bytes_read = fread(p_buffer, 1, static_cast<size_t>(length), p_file_);
+	if (bytes_read == 0 && ferror(p_file_) != 0)
+	{
+		return -1;
+	}
+	return static_cast<long>(bytes_read);
+}
+
+#ifdef _WIN32
+long line_reader::read_standard_input_(char* p_buffer, long length)
+{
+	return _read(_fileno(stdin), p_buffer, static_cast<unsigned int>(length));
+}
+
+bool line_reader::try_map_file_(const std::string& path)
+{
+	HANDLE file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file_handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0 || static_cast<unsigned long long>(file_size.QuadPart) > static_cast<unsigned long long>(std::numeric_limits<size_t>::max()))
+	{
+		CloseHandle(file_handle);
+		return false;
+	}
+	HANDLE mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping_handle == NULL)
+	{
+		CloseHandle(file_handle);
+		return false;
+	}
+	void* p_view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (p_view == NULL)
+	{
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		return false;
+	}
+	file_handle_ = file_handle;
+	mapping_handle_ = mapping_handle;
+	data_ = static_cast<const char*>(p_view);
+	size_ = static_cast<long long>(file_size.QuadPart);
+	return true;
+}
+
+void line_reader::release_mapped_pages_()
+{
+	// Keep the most recent pages, since they will probably be read again soon.
+	long long release_size = released_position_.load(std::memory_order_relaxed) - LINE_READER_RELEASE_SIZE;
+	release_size -= release_size % LINE_READER_RELEASE_SIZE;
+	if (release_size > released_map_size_)
+	{
+		// The pages aren't locked, so unlocking them removes them from the working set.  They are read from the file
+		// again if they are needed.
+		VirtualUnlock(const_cast<char*>(data_) + released_map_size_, static_cast<size_t>(release_size - released_map_size_));
+		released_map_size_ = release_size;
+	}
+}
+
+void line_reader::unmap_file_()
+{
+	if (is_memory_mapped_ && data_ != NULL)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_handle_ != NULL)
+	{
+		CloseHandle(mapping_handle_);
+		mapping_handle_ = NULL;
+	}
+	if (file_handle_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_handle_);
+		file_handle_ = INVALID_HANDLE_VALUE;
+	}
+}
+#else
+long line_reader::read_standard_input_(char* p_buffer, long length)
+{
+	// read returns as soon as any data is available, unlike fread, which waits until the buffer is full.
+	while (true)
+	{
+		ssize_t bytes_read = ::read(STDIN_FILENO, p_buffer, static_cast<size_t>(length));
+		if (bytes_read < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		return static_cast<long>(bytes_read);
+	}
+}
+
+bool line_reader::try_map_file_(const std::string& path)
+{
+	int file_descriptor = ::open(path.c_str(), O_RDONLY);
+	if (file_descriptor < 0)
+	{
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(file_descriptor, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size == 0 || static_cast<unsigned long long>(file_stat.st_size) > static_cast<unsigned long long>(std::numeric_limits<size_t>::max()))
+	{
+		::close(file_descriptor);
+		return false;
+	}
+	void* p_map = mmap(NULL, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	if (p_map == MAP_FAILED)
+	{
+		::close(file_descriptor);
+		return false;
+	}
+#ifdef MADV_SEQUENTIAL
+	madvise(p_map, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+#endif
+	file_descriptor_ = file_descriptor;
+	data_ = static_cast<const char*>(p_map);
+	size_ = static_cast<long long>(file_stat.st_size);
+	return true;
+}
+
+void line_reader::release_mapped_pages_()
+{
+	// Keep the most recent pages, since they will probably be read again soon.
+	long long release_size = released_position_.load(std::memory_order_relaxed) - LINE_READER_RELEASE_SIZE;
+	release_size -= release_size % LINE_READER_RELEASE_SIZE;
+	if (release_size > released_map_size_)
+	{
+		// The mapping is read only, so the dropped pages are read from the file again if they are needed.
+		madvise(const_cast<char*>(data_) + released_map_size_, static_cast<size_t>(release_size - released_map_size_), MADV_DONTNEED);
+		released_map_size_ = release_size;
+	}
+}
+
+void line_reader::unmap_file_()
+{
+	if (is_memory_mapped_ && data_ != NULL)
+	{
+		munmap(const_cast<char*>(data_), static_cast<size_t>(size_));
+	}
+	if (file_descriptor_ >= 0)
+	{
+		::close(file_descriptor_);
+		file_descriptor_ = -1;
+	}
+}
+#endif
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Gcode Processor Library
+//
+// Tools for parsing gcode and calculating printer state from parsed gcode commands.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <cstdio>
+
+// The size of each read when the source file can't be memory mapped, or when reading standard input.
+#define LINE_READER_BLOCK_SIZE 1048576
+// Released pages of a mapped file are dropped from memory once at least this many bytes can be dropped.
+#define LINE_READER_RELEASE_SIZE 1048576
+
+// Reads a gcode file one line at a time without copying the lines.  The file is memory mapped read only when possible,
+// else it is read a block at a time.  Each line is returned as a pointer and a length, and is not null terminated.
+// Every line stays valid until release is called with a position after the start of the line, which allows parsed
+// commands to reference the source text instead of owning a copy, while keeping memory use bounded.  Standard input can
+// be read the same way, in which case each read returns as soon as some data is available so that lines can be
+// processed while the writer is still running.
+class line_reader
+{
+public:
+	line_reader();
+	~line_reader();
+	bool open(const std::string& path);
+	/// <summary>
+	/// Reads lines from standard input as they arrive.  Blocks are reused once their lines are released, just like a
+	/// file that can't be mapped.
+	/// </summary>
+	bool open_standard_input();
+	void close();
+	bool is_open() const;
+	bool is_memory_mapped() const;
+	bool is_streaming() const;
+	/// <summary>
+	/// Returns true if a read failed.  The lines read before the failure are still returned.
+	/// </summary>
+	bool has_error() const;
+	/// <summary>
+	/// Gets the next line, not including the line ending.  The line is not null terminated.
+	/// </summary>
+	/// <returns>False when there are no more lines.</returns>
+	bool read_line(const char*& line, long& length);
+	/// <summary>
+	/// Tells the reader that no line starting before the position is referenced anymore, so the memory holding those
+	/// lines can be reused.  This may be called from a different thread than the one reading lines.
+	/// </summary>
+	void release(long long position);
+	/// <summary>
+	/// Returns the offset of the first character that has not been read, which matches std::istream::tellg after std::getline.
+	/// </summary>
+	long long get_position() const;
+	/// <summary>
+	/// Returns the size of a mapped file, else the number of bytes read so far.
+	/// </summary>
+	long long get_size() const;
+private:
+	line_reader(const line_reader& source);
+	line_reader& operator=(const line_reader& source);
+	bool try_map_file_(const std::string& path);
+	void unmap_file_();
+	void release_mapped_pages_();
+	void release_blocks_();
+	const char* find_line_end_() const;
+	bool try_read_block_();
+	long read_source_(char* p_buffer, long length);
+	long read_standard_input_(char* p_buffer, long length);
+	const char* data_;
+	long long size_;
+	long long position_;
+	bool is_open_;
+	bool is_memory_mapped_;
+	bool is_streaming_;
+	bool is_end_of_stream_;
+	bool has_error_;
+	// Set by release, and read by the thread reading lines.
+	std::atomic<long long> released_position_;
+	// Mapped pages before this offset have been dropped from memory.
+	long long released_map_size_;
+	// Used when the file can't be mapped.
+	FILE* p_file_;
+	// Used when the file can't be mapped or when streaming.  data_ points into the last block, and the earlier blocks
+	// are kept until their lines are released.
+	std::deque<std::vector<char> > blocks_;
+	// The stream offset of the first byte in each block.
+	std::deque<long long> block_offsets_;
+	// A released block that is reused for the next read, so that steady state reading doesn't allocate.
+	std::vector<char> spare_block_;
+	// The offset in the file or stream of data_[0].
+	long long block_offset_;
+#ifdef _WIN32
+	void* file_handle_;
+	void* mapping_handle_;
+#else
+	int file_descriptor_;
+#endif
+};
@@ -0,0 +1,254 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Gcode Processor Library
+//
+// Tools for parsing gcode and calculating printer state from parsed gcode commands.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "meatpack_encoder.h"
+#include <cstring>
+
+// The commands that take a text argument, which must keep its spaces.
+static const int text_commands[] = { 0, 1, 23, 28, 30, 32, 33, 117, 118, 862, 928 };
+static const int num_text_commands = sizeof(text_commands) / sizeof(text_commands[0]);
+
+// The packing table in no spaces mode, where 'E' replaces ' '.
+static inline unsigned char get_nibble(char c)
+{
+	if (c >= '0' && c <= '9')
+	{
+		return static_cast<unsigned char>(c - '0');
+	}
+	switch (c)
+	{
+	case '.':
+		return 0x0A;
+	case 'E':
+		return 0x0B;
+	case '\n':
+		return 0x0C;
+	case 'G':
+		return 0x0D;
+	case 'X':
+		return 0x0E;
+	}
+	return MEATPACK_FULL_WIDTH_NIBBLE;
+}
+
+static inline bool is_whitespace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool is_text_command(const char* p_line, const char* p_end)
+{
+	if (p_line == p_end || (*p_line != 'M' && *p_line != 'm'))
+	{
+		return false;
+	}
+	int number = 0;
+	bool has_number = false;
+	for (const char* p_cur = p_line + 1; p_cur < p_end && *p_cur >= '0' && *p_cur <= '9'; p_cur++)
+	{
+		number = number * 10 + (*p_cur - '0');
+		has_number = true;
+	}
+	if (!has_number)
+	{
+		return false;
+	}
+	for (int index = 0; index < num_text_commands; index++)
+	{
+		if (text_commands[index] == number)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+meatpack_encoder::meatpack_encoder()
+{
+	pack_ = false;
+	packed_bytes_ = 0;
+}
+
+meatpack_encoder::meatpack_encoder(bool pack)
+{
+	pack_ = pack;
+	packed_bytes_ = 0;
+}
+
+void meatpack_encoder::append_command_(unsigned char command, std::string& output)
+{
+	output.push_back(static_cast<char>(MEATPACK_SIGNAL_BYTE));
+	output.push_back(static_cast<char>(MEATPACK_SIGNAL_BYTE));
+	output.push_back(static_cast<char>(command));
+}
+
+void meatpack_encoder::begin(std::string& output)
+{
+	partial_line_.clear();
+	packed_bytes_ = 0;
+	std::string commands;
+	append_command_(MEATPACK_COMMAND_ENABLE_PACKING, commands);
+	append_command_(MEATPACK_COMMAND_ENABLE_NO_SPACES, commands);
+	packed_bytes_ += commands.length();
+	if (pack_)
+	{
+		output.append(commands);
+	}
+}
+
+void meatpack_encoder::end(std::string& output)
+{
+	if (!partial_line_.empty())
+	{
+		encode_line_(partial_line_.c_str(), partial_line_.c_str() + partial_line_.length(), output);
+		partial_line_.clear();
+	}
+	std::string commands;
+	append_command_(MEATPACK_COMMAND_DISABLE_NO_SPACES, commands);
+	append_command_(MEATPACK_COMMAND_DISABLE_PACKING, commands);
+	packed_bytes_ += commands.length();
+	if (pack_)
+	{
+		output.append(commands);
+	}
+}
+
+long long meatpack_encoder::get_packed_bytes() const
+{
+	return packed_bytes_;
+}
+
+void meatpack_encoder::encode(const std::string& text, std::string& output)
+{
+	const char* p_cur = text.c_str();
+	const char* p_end = p_cur + text.length();
+	while (p_cur < p_end)
+	{
+		const char* p_newline = static_cast<const char*>(memchr(p_cur, '\n', p_end - p_cur));
+		if (p_newline == NULL)
+		{
+			partial_line_.append(p_cur, p_end - p_cur);
+			return;
+		}
+		if (partial_line_.empty())
+		{
+			encode_line_(p_cur, p_newline, output);
+		}
+		else
+		{
+			partial_line_.append(p_cur, p_newline - p_cur);
+			encode_line_(partial_line_.c_str(), partial_line_.c_str() + partial_line_.length(), output);
+			partial_line_.clear();
+		}
+		p_cur = p_newline + 1;
+	}
+}
+
+void meatpack_encoder::encode_line_(const char* p_line, const char* p_end, std::string& output)
+{
+	if (!minimize_line(p_line, p_end, line_))
+	{
+		return;
+	}
+	if (pack_)
+	{
+		size_t start_length = output.length();
+		pack_line(line_, output);
+		packed_bytes_ += output.length() - start_length;
+	}
+	else
+	{
+		output.append(line_);
+		output.push_back('\n');
+		packed_bytes_ += get_packed_length(line_);
+	}
+}
+
+bool meatpack_encoder::minimize_line(const char* p_line, const char* p_end, std::string& line)
+{
+	line.clear();
+	const char* p_comment = static_cast<const char*>(memchr(p_line, ';', p_end - p_line));
+	if (p_comment != NULL)
+	{
+		p_end = p_comment;
+	}
+	while (p_line < p_end && is_whitespace(*p_line))
+	{
+		p_line++;
+	}
+	while (p_end > p_line && is_whitespace(p_end[-1]))
+	{
+		p_end--;
+	}
+	if (is_text_command(p_line, p_end))
+	{
+		line.assign(p_line, p_end - p_line);
+	}
+	else
+	{
+		for (const char* p_cur = p_line; p_cur < p_end; p_cur++)
+		{
+			if (!is_whitespace(*p_cur))
+			{
+				line.push_back(*p_cur);
+			}
+		}
+	}
+	return !line.empty();
+}
+
+void meatpack_encoder::pack_line(const std::string& line, std::string& output)
+{
+	// The newline is always the last character.  When it falls at the start of a byte, the firmware ignores the
+	// other half of the byte.
+	const size_t length = line.length() + 1;
+	for (size_t index = 0; index < length; index += 2)
+	{
+		char first = index < line.length() ? line[index] : '\n';
+		char second = index + 1 < line.length() ? line[index + 1] : '\n';
+		unsigned char first_nibble = get_nibble(first);
+		unsigned char second_nibble = get_nibble(second);
+		// The first character is in the low nibble, and full width characters follow in the same order.
+		output.push_back(static_cast<char>(first_nibble | (second_nibble << 4)));
+		if (first_nibble == MEATPACK_FULL_WIDTH_NIBBLE)
+		{
+			output.push_back(first);
+		}
+		if (second_nibble == MEATPACK_FULL_WIDTH_NIBBLE && index + 1 < length)
+		{
+			output.push_back(second);
+		}
+	}
+}
+
+long long meatpack_encoder::get_packed_length(const std::string& line)
+{
+	long long bytes = static_cast<long long>(line.length() + 2) / 2;
+	for (std::string::const_iterator it = line.begin(); it != line.end(); ++it)
+	{
+		if (get_nibble(*it) == MEATPACK_FULL_WIDTH_NIBBLE)
+		{
+			bytes++;
+		}
+	}
+	return bytes;
+}
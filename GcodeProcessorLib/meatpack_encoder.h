@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Gcode Processor Library
+//
+// Tools for parsing gcode and calculating printer state from parsed gcode commands.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+
+// MeatPack packs the characters that make up most gcode (digits, '.', ' ', '\n', 'G' and 'X') into 4 bits each, so
+// two of them fit in one byte.  Any other character is sent in full after the byte that holds its neighbour.  It is
+// supported over serial by Marlin and Prusa firmware, and is enabled by sending a signal byte twice followed by a
+// command.  In no spaces mode, spaces are stripped by the host and 'E' takes the place of ' ' in the packing table.
+#define MEATPACK_SIGNAL_BYTE 0xFF
+#define MEATPACK_COMMAND_ENABLE_PACKING 0xFB
+#define MEATPACK_COMMAND_DISABLE_PACKING 0xFA
+#define MEATPACK_COMMAND_ENABLE_NO_SPACES 0xF7
+#define MEATPACK_COMMAND_DISABLE_NO_SPACES 0xF6
+// A nibble with this value means the character is sent in full.
+#define MEATPACK_FULL_WIDTH_NIBBLE 0x0F
+
+// Converts gcode text into the minimized form sent by a MeatPack host: comments, blank lines and spaces (except within
+// the text of commands like M117) are removed.  The minimized text is either written as is, which is still valid
+// gcode for Marlin and Prusa firmware, or packed.  Text can be passed in pieces, and a partial line is held until the
+// rest of it arrives.
+class meatpack_encoder
+{
+public:
+	meatpack_encoder();
+	meatpack_encoder(bool pack);
+	/// <summary>
+	/// Appends the commands that enable packing and no spaces mode when packing, and resets the counters.
+	/// </summary>
+	void begin(std::string& output);
+	/// <summary>
+	/// Minimizes (and packs) every complete line within the text, and appends the result to the output.
+	/// </summary>
+	void encode(const std::string& text, std::string& output);
+	/// <summary>
+	/// Encodes any partial line that is left, and appends the command that disables packing when packing.
+	/// </summary>
+	void end(std::string& output);
+	/// <summary>
+	/// Returns the number of bytes sent over serial for the text encoded so far when it is packed, including the
+	/// signal bytes.
+	/// </summary>
+	long long get_packed_bytes() const;
+	/// <summary>
+	/// Removes comments, whitespace and (except for commands that take text) spaces from a line.
+	/// </summary>
+	/// <returns>False if nothing is left.</returns>
+	static bool minimize_line(const char* p_line, const char* p_end, std::string& line);
+	/// <summary>
+	/// Packs a minimized line, followed by a newline, in no spaces mode.
+	/// </summary>
+	static void pack_line(const std::string& line, std::string& output);
+	/// <summary>
+	/// Returns the number of bytes pack_line would append for a minimized line.
+	/// </summary>
+	static long long get_packed_length(const std::string& line);
+private:
+	void encode_line_(const char* p_line, const char* p_end, std::string& output);
+	static void append_command_(unsigned char command, std::string& output);
+	bool pack_;
+	long long packed_bytes_;
+	std::string partial_line_;
+	std::string line_;
+};
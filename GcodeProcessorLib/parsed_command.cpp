@@ -24,13 +24,78 @@
 #include <sstream>
 #include <iomanip>
 #include <stdlib.h>
+
+gcode_text::gcode_text()
+{
+	data_ = "";
+	length_ = 0;
+	is_owned_ = false;
+}
+
+gcode_text::gcode_text(const gcode_text& source)
+{
+	data_ = "";
+	length_ = 0;
+	is_owned_ = false;
+	*this = source;
+}
+
+gcode_text& gcode_text::operator=(const gcode_text& source)
+{
+	if (this == &source)
+	{
+		return *this;
+	}
+	if (source.is_owned_)
+	{
+		assign(source.data_, source.length_);
+	}
+	else
+	{
+		set_view(source.data_, source.length_);
+	}
+	return *this;
+}
+
+void gcode_text::set_view(const char* data, size_t length)
+{
+	data_ = data;
+	length_ = length;
+	is_owned_ = false;
+}
+
+void gcode_text::assign(const char* data, size_t length)
+{
+	owned_.assign(data, length);
+	data_ = owned_.c_str();
+	length_ = owned_.length();
+	is_owned_ = true;
+}
+
+void gcode_text::clear()
+{
+	owned_.clear();
+	data_ = "";
+	length_ = 0;
+	is_owned_ = false;
+}
+
+std::string operator+(const std::string& lhs, const gcode_text& rhs)
+{
+	std::string result;
+	result.reserve(lhs.length() + rhs.length());
+	result.append(lhs);
+	result.append(rhs.data(), rhs.length());
+	return result;
+}
+
 parsed_command::parsed_command()
 {
 	
 	command.reserve(8);
-	gcode.reserve(128);
 	comment.reserve(128);
 	parameters.reserve(6);
+	opcode = gcode_opcode_unknown;
 	is_known_command = false;
 	is_empty = true;
 }
@@ -39,6 +104,7 @@ void parsed_command::clear()
 {
 	
 	command.clear();
+	opcode = gcode_opcode_unknown;
 	gcode.clear();
 	comment.clear();
 	parameters.clear();
@@ -84,8 +150,8 @@ std::string parsed_command::to_string()
 {
 	if (comment.size() > 0)
 	{
-		return gcode + ";" + comment;
+		return gcode.str() + ";" + comment;
 	}
-	return gcode;
+	return gcode.str();
 }
 
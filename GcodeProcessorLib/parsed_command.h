@@ -26,12 +26,95 @@
 #include <vector>
 #include "parsed_command_parameter.h"
 
+// An opcode packs a command's letter and number into an int so that commands can be compared and switched on without
+// string comparisons.  The letter is stored in the high byte and the number in the next two bytes.  The low byte
+// holds the sub-code + 1 for commands like G29.1, and is 0 when there is no sub-code.  Numbers that don't fit, and
+// unknown commands, have an opcode of gcode_opcode_unknown.
+#define GCODE_OPCODE(letter, number) ((static_cast<int>(letter) << 24) | ((number) << 8))
+#define GCODE_OPCODE_MAX_NUMBER 65535
+#define GCODE_OPCODE_MAX_SUB_CODE 254
+enum gcode_opcode
+{
+	gcode_opcode_unknown = 0,
+	gcode_opcode_g0 = GCODE_OPCODE('G', 0),
+	gcode_opcode_g1 = GCODE_OPCODE('G', 1),
+	gcode_opcode_g2 = GCODE_OPCODE('G', 2),
+	gcode_opcode_g3 = GCODE_OPCODE('G', 3),
+	gcode_opcode_g10 = GCODE_OPCODE('G', 10),
+	gcode_opcode_g11 = GCODE_OPCODE('G', 11),
+	gcode_opcode_g20 = GCODE_OPCODE('G', 20),
+	gcode_opcode_g21 = GCODE_OPCODE('G', 21),
+	gcode_opcode_g28 = GCODE_OPCODE('G', 28),
+	gcode_opcode_g29 = GCODE_OPCODE('G', 29),
+	gcode_opcode_g80 = GCODE_OPCODE('G', 80),
+	gcode_opcode_g90 = GCODE_OPCODE('G', 90),
+	gcode_opcode_g91 = GCODE_OPCODE('G', 91),
+	gcode_opcode_g92 = GCODE_OPCODE('G', 92),
+	gcode_opcode_m82 = GCODE_OPCODE('M', 82),
+	gcode_opcode_m83 = GCODE_OPCODE('M', 83),
+	gcode_opcode_m104 = GCODE_OPCODE('M', 104),
+	gcode_opcode_m105 = GCODE_OPCODE('M', 105),
+	gcode_opcode_m106 = GCODE_OPCODE('M', 106),
+	gcode_opcode_m109 = GCODE_OPCODE('M', 109),
+	gcode_opcode_m114 = GCODE_OPCODE('M', 114),
+	gcode_opcode_m116 = GCODE_OPCODE('M', 116),
+	gcode_opcode_m117 = GCODE_OPCODE('M', 117),
+	gcode_opcode_m140 = GCODE_OPCODE('M', 140),
+	gcode_opcode_m141 = GCODE_OPCODE('M', 141),
+	gcode_opcode_m190 = GCODE_OPCODE('M', 190),
+	gcode_opcode_m191 = GCODE_OPCODE('M', 191),
+	gcode_opcode_m207 = GCODE_OPCODE('M', 207),
+	gcode_opcode_m208 = GCODE_OPCODE('M', 208),
+	gcode_opcode_m218 = GCODE_OPCODE('M', 218),
+	gcode_opcode_m240 = GCODE_OPCODE('M', 240),
+	gcode_opcode_m400 = GCODE_OPCODE('M', 400),
+	gcode_opcode_m563 = GCODE_OPCODE('M', 563),
+	// T has no number, since the tool is a parameter.
+	gcode_opcode_t = GCODE_OPCODE('T', 0),
+	// @ commands are text, so only @OCTOLAPSE gets its own opcode.
+	gcode_opcode_at_command = GCODE_OPCODE('@', 0),
+	gcode_opcode_at_octolapse = GCODE_OPCODE('@', 1)
+};
+
+// The gcode text of a parsed command.  The text either references the source line, which must outlive the command,
+// or owns a copy of it.  Referencing the source avoids copying every line when the source is held in memory (see
+// line_reader).  Copies of a referencing gcode_text reference the same source.
+class gcode_text
+{
+public:
+	gcode_text();
+	gcode_text(const gcode_text& source);
+	gcode_text& operator=(const gcode_text& source);
+	/// <summary>
+	/// Reference text that is owned by the caller.
+	/// </summary>
+	void set_view(const char* data, size_t length);
+	/// <summary>
+	/// Copy the text.
+	/// </summary>
+	void assign(const char* data, size_t length);
+	void clear();
+	const char* data() const { return data_; }
+	size_t length() const { return length_; }
+	bool empty() const { return length_ == 0; }
+	std::string str() const { return std::string(data_, length_); }
+private:
+	const char* data_;
+	size_t length_;
+	std::string owned_;
+	bool is_owned_;
+};
+
+std::string operator+(const std::string& lhs, const gcode_text& rhs);
+
 struct parsed_command
 {
 public:
 	parsed_command();
 	std::string command;
-	std::string gcode;
+	// One of the gcode_opcode values for known commands, else the packed letter and number (see GCODE_OPCODE).
+	int opcode;
+	gcode_text gcode;
 	std::string comment;
 	bool is_empty;
 	bool is_known_command;
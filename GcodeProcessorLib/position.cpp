@@ -24,25 +24,7 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream>
-std::string position::to_string(bool rewrite, bool verbose, std::string additional_comment)
-{
-	if (verbose)
-	{
-		std::stringstream stream;
-		stream << std::fixed << std::setprecision(5);
-		stream << "," << get_current_extruder().e << "," << get_current_extruder().get_offset_e() << "," << get_current_extruder().e_relative;
-		command.comment.append(stream.str());
-	}
-	command.comment.append(additional_comment);
-
-	if (rewrite)
-	{
-		return command.rewrite_gcode_string();
-	}
-	
-	return command.to_string();
-}
-
+#include <exception>
 void position::set_xyz_axis_mode(const std::string& xyz_axis_default_mode)
 {
 	if (xyz_axis_default_mode == "relative" || xyz_axis_default_mode == "force-relative")
@@ -102,7 +84,6 @@ bool position::can_take_snapshot()
 
 position::position()
 {
-	has_been_deleted = false;
 	is_empty = true;
 	feature_type_tag = 0;
 	f = 0;
@@ -154,14 +135,11 @@ position::position()
 	gcode_ignored = true;
 	is_in_bounds = true;
 	current_tool = -1;
-	p_extruders = NULL;
 	num_extruders = 0;
-	set_num_extruders(num_extruders);
 }
 
 position::position(int extruder_count)
 { 
-	has_been_deleted = false;
 	is_empty = true;
 	feature_type_tag = 0;
 	f = 0;
@@ -213,178 +191,30 @@ position::position(int extruder_count)
 	gcode_ignored = true;
 	is_in_bounds = true;
 	current_tool = 0;
-	p_extruders = NULL;
-	set_num_extruders(extruder_count);
-	
-}
-
-position::position(const position &pos)
-{
-	has_been_deleted = false;
-	is_empty = pos.is_empty;
-	feature_type_tag = pos.feature_type_tag;
-	f = pos.f;
-	f_null = pos.f_null;
-	x = pos.x;
-	x_null = pos.x_null;
-	x_offset = pos.x_offset;
-	x_firmware_offset = pos.x_firmware_offset;
-	x_homed = pos.x_homed;
-	y = pos.y;
-	y_null = pos.y_null;
-	y_offset = pos.y_offset;
-	y_firmware_offset = pos.y_firmware_offset;
-	y_homed = pos.y_homed;
-	z = pos.z;
-	z_null = pos.z_null;
-	z_offset = pos.z_offset;
-	z_firmware_offset = pos.z_firmware_offset;
-	z_homed = pos.z_homed;
-	is_relative = pos.is_relative;
-	is_relative_null = pos.is_relative_null;
-	is_extruder_relative = pos.is_extruder_relative;
-	is_extruder_relative_null = pos.is_extruder_relative_null;
-	is_metric = pos.is_metric;
-	is_metric_null = pos.is_metric_null;
-	last_extrusion_height = pos.last_extrusion_height;
-	last_extrusion_height_null = pos.last_extrusion_height_null;
-	layer = pos.layer;
-	height = pos.height;
-	height_increment = pos.height_increment;
-	height_increment_change_count = pos.height_increment_change_count;
-	is_printer_primed = pos.is_printer_primed;
-	has_definite_position = pos.has_definite_position;
-	z_relative = pos.z_relative;
-	is_in_position = pos.is_in_position;
-	in_path_position = pos.in_path_position;
-	is_zhop = pos.is_zhop;
-	is_layer_change = pos.is_layer_change;
-	is_height_change = pos.is_height_change;
-	is_height_increment_change = pos.is_height_increment_change;
-	is_xy_travel = pos.is_xy_travel;
-	is_xyz_travel = pos.is_xyz_travel;
-	has_xy_position_changed = pos.has_xy_position_changed;
-	has_position_changed = pos.has_position_changed;
-	has_received_home_command = pos.has_received_home_command;
-	file_line_number = pos.file_line_number;
-	gcode_number = pos.gcode_number;
-	file_position = pos.file_position;
-	gcode_ignored = pos.gcode_ignored;
-	is_in_bounds = pos.is_in_bounds;
-	current_tool = pos.current_tool;
-	p_extruders = NULL;
-	command = pos.command;
 	num_extruders = 0;
-	set_num_extruders(pos.num_extruders);
-	for(int index=0; index < pos.num_extruders; index++)
-	{
-		p_extruders[index] = pos.p_extruders[index];
-	}
-}
-
-position::~position()
-{
-	if (has_been_deleted)
-		return;
-	has_been_deleted = true;
-	delete_extruders();
-}
-
-position& position::operator=(const position& pos) {
-	is_empty = pos.is_empty;
-	feature_type_tag = pos.feature_type_tag;
-	f = pos.f;
-	f_null = pos.f_null;
-	x = pos.x;
-	x_null = pos.x_null;
-	x_offset = pos.x_offset;
-	x_firmware_offset = pos.x_firmware_offset;
-	x_homed = pos.x_homed;
-	y = pos.y;
-	y_null = pos.y_null;
-	y_offset = pos.y_offset;
-	y_firmware_offset = pos.y_firmware_offset;
-	y_homed = pos.y_homed;
-	z = pos.z;
-	z_null = pos.z_null;
-	z_offset = pos.z_offset;
-	z_firmware_offset = pos.z_firmware_offset;
-	z_homed = pos.z_homed;
-	is_relative = pos.is_relative;
-	is_relative_null = pos.is_relative_null;
-	is_extruder_relative = pos.is_extruder_relative;
-	is_extruder_relative_null = pos.is_extruder_relative_null;
-	is_metric = pos.is_metric;
-	is_metric_null = pos.is_metric_null;
-	last_extrusion_height = pos.last_extrusion_height;
-	last_extrusion_height_null = pos.last_extrusion_height_null;
-	layer = pos.layer;
-	height = pos.height;
-	height_increment = pos.height_increment;
-	height_increment_change_count = pos.height_increment_change_count;
-	is_printer_primed = pos.is_printer_primed;
-	has_definite_position = pos.has_definite_position;
-	z_relative = pos.z_relative;
-	is_in_position = pos.is_in_position;
-	in_path_position = pos.in_path_position;
-	is_zhop = pos.is_zhop;
-	is_layer_change = pos.is_layer_change;
-	is_height_change = pos.is_height_change;
-	is_height_increment_change = pos.is_height_increment_change;
-	is_xy_travel = pos.is_xy_travel;
-	is_xyz_travel = pos.is_xyz_travel;
-	has_xy_position_changed = pos.has_xy_position_changed;
-	has_position_changed = pos.has_position_changed;
-	has_received_home_command = pos.has_received_home_command;
-	file_line_number = pos.file_line_number;
-	file_position = pos.file_position;
-	gcode_number = pos.gcode_number;
-	gcode_ignored = pos.gcode_ignored;
-	is_in_bounds = pos.is_in_bounds;
-	current_tool = pos.current_tool;
-	command = pos.command;
-	if (pos.num_extruders != num_extruders)
-	{
-		set_num_extruders(pos.num_extruders);
-	}
-	
+	set_num_extruders(extruder_count);
 	
-	for (int index = 0; index < pos.num_extruders; index++)
-	{
-		p_extruders[index] = pos.p_extruders[index];
-	}
-	return *this;
 }
 
 bool position::is_travel()
 {
 	return is_xyz_travel || is_xy_travel;
 }
+
 void position::set_num_extruders(int num_extruders_)
 {
 	if (num_extruders_ == num_extruders)
 		return;
-	delete_extruders();
-	num_extruders = num_extruders_;
-	if (num_extruders_ > 0)
-	{
-		p_extruders = new extruder[num_extruders_];
-	}
-	else
+	if (num_extruders_ <= 0 || num_extruders_ > POSITION_MAX_EXTRUDERS)
 	{
 		throw std::exception();
 	}
-}
-
-void position::delete_extruders()
-{
-	if (p_extruders != NULL)
+	num_extruders = num_extruders_;
+	for (int index = 0; index < num_extruders_; index++)
 	{
-		delete[] p_extruders;
-		p_extruders = NULL;
+		extruders[index] = extruder();
 	}
 }
-
 double position::get_gcode_x() const
 {
 	return x - x_offset + x_firmware_offset;
@@ -400,23 +230,43 @@ double position::get_gcode_z() const
 	return z - z_offset + z_firmware_offset;
 }
 
-extruder& position::get_current_extruder() const
+extruder& position::get_current_extruder()
+{
+	return extruders[get_current_extruder_index()];
+}
+
+const extruder& position::get_current_extruder() const
+{
+	return extruders[get_current_extruder_index()];
+}
+
+extruder& position::get_extruder(int index)
+{
+	return extruders[get_extruder_index(index)];
+}
+
+const extruder& position::get_extruder(int index) const
+{
+	return extruders[get_extruder_index(index)];
+}
+
+int position::get_current_extruder_index() const
 {
 	int tool_number = current_tool;
 	if (current_tool > num_extruders-1)
 		tool_number = num_extruders - 1;
 	else if (current_tool < 0)
 		tool_number = 0;
-	return p_extruders[tool_number];
+	return tool_number;
 }
 
-extruder& position::get_extruder(int index) const
+int position::get_extruder_index(int index) const
 {
 	if (index >= num_extruders)
 		index = num_extruders - 1;
 	else if (index < 0)
 		index = 0;
-	return p_extruders[index];
+	return index;
 }
 
 void position::reset_state()
@@ -432,7 +282,7 @@ void position::reset_state()
 	
 	//is_in_bounds = true; // I dont' think we want to reset this every time since it's only calculated if the current position
 	// changes.
-	p_extruders[current_tool].e_relative = 0;
+	extruders[current_tool].e_relative = 0;
 	z_relative = 0;
 	feature_type_tag = 0;
 }
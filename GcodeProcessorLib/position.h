@@ -23,20 +23,18 @@
 #ifndef POSITION_H
 #define POSITION_H
 #include <string>
-#include "parsed_command.h"
 #include "extruder.h"
 
+// The maximum number of extruders a position can track.
+#define POSITION_MAX_EXTRUDERS 16
 
+// A position is trivially copyable, so it can be copied without allocating.  The extruders are stored inline, and
+// the command that produced the position isn't stored.  Use file_line_number or gcode_number to refer to it.
 struct position
 {
 	position();
 	position(int extruder_count);
-	position(const position &pos); // Copy Constructor
-	virtual ~position();
-	position& operator=(const position& pos);
-	std::string to_string(bool rewrite, bool verbose, std::string additional_comment);
 	void reset_state();
-	parsed_command command;
 	int feature_type_tag;
 	double f;
 	bool f_null;
@@ -89,12 +87,14 @@ struct position
 	bool is_empty;
 	int current_tool;
 	int num_extruders;
-	bool has_been_deleted;
-	extruder * p_extruders;
-	extruder& get_current_extruder() const;
-	extruder& get_extruder(int index) const;
+	extruder extruders[POSITION_MAX_EXTRUDERS];
+	extruder& get_current_extruder();
+	const extruder& get_current_extruder() const;
+	extruder& get_extruder(int index);
+	const extruder& get_extruder(int index) const;
+	int get_current_extruder_index() const;
+	int get_extruder_index(int index) const;
 	void set_num_extruders(int num_extruders_);
-	void delete_extruders();
 	double get_gcode_x() const;
 	double get_gcode_y() const;
 	double get_gcode_z() const;
@@ -9,14 +9,20 @@ set(GcodeProcessorLibSources ${GcodeProcessorLibSources}
     gcode_parser.h
     gcode_position.cpp
     gcode_position.h
+    line_reader.cpp
+    line_reader.h
     logger.cpp
     logger.h
+    meatpack_encoder.cpp
+    meatpack_encoder.h
     parsed_command.cpp
     parsed_command.h
     parsed_command_parameter.cpp
     parsed_command_parameter.h
     position.cpp
     position.h
+    spsc_queue.h
+    stage_timer.h
     utilities.cpp
     utilities.h
     fpconv.h
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Gcode Processor Library
+//
+// Tools for parsing gcode and calculating printer state from parsed gcode commands.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Keeps the producer and consumer indexes on separate cache lines.
+#define SPSC_QUEUE_CACHE_LINE_SIZE 64
+
+// A bounded queue that is safe without locks as long as exactly one thread pushes and exactly one thread pops.
+// try_push and try_pop never block, so the caller decides how to wait when the queue is full or empty.
+template <typename T>
+class spsc_queue
+{
+public:
+	spsc_queue(size_t capacity) : items_(capacity + 1)
+	{
+		head_.store(0, std::memory_order_relaxed);
+		tail_.store(0, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Adds an item to the back of the queue.  Only call this from the producer thread.
+	/// </summary>
+	/// <returns>False if the queue is full.</returns>
+	bool try_push(const T& item)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t next_tail = next_index_(tail);
+		if (next_tail == head_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		items_[tail] = item;
+		tail_.store(next_tail, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Removes the item at the front of the queue.  Only call this from the consumer thread.
+	/// </summary>
+	/// <returns>False if the queue is empty.</returns>
+	bool try_pop(T& item)
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		item = items_[head];
+		head_.store(next_index_(head), std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const
+	{
+		return items_.size() - 1;
+	}
+
+private:
+	spsc_queue(const spsc_queue& source);
+	spsc_queue& operator=(const spsc_queue& source);
+	size_t next_index_(size_t index) const
+	{
+		return index + 1 == items_.size() ? 0 : index + 1;
+	}
+	// One slot is always left empty so that a full queue can be told apart from an empty one.
+	std::vector<T> items_;
+	char head_padding_[SPSC_QUEUE_CACHE_LINE_SIZE];
+	// Written only by the consumer.
+	std::atomic<size_t> head_;
+	char tail_padding_[SPSC_QUEUE_CACHE_LINE_SIZE];
+	// Written only by the producer.
+	std::atomic<size_t> tail_;
+	char end_padding_[SPSC_QUEUE_CACHE_LINE_SIZE];
+};
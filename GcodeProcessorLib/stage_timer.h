@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Gcode Processor Library
+//
+// Tools for parsing gcode and calculating printer state from parsed gcode commands.
+//
+// Copyright(C) 2021 - Brad Hochgesang
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This program is free software : you can redistribute it and/or modify
+// it under the terms of the GNU Affero General Public License as published
+// by the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+// GNU Affero General Public License for more details.
+//
+//
+// You can contact the author at the following email address: 
+// FormerLurker@pm.me
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+// Low overhead timing for the hot paths.  Build with -DSTAGE_TIMING=ON (which defines STAGE_TIMING) to enable it.
+// Otherwise STAGE_TIMER_START and STAGE_TIMER_STOP expand to nothing and the statistics stay at zero.
+// The time stamp counter is read directly on x86/x64, which takes a few nanoseconds.  Other platforms use
+// std::chrono::steady_clock.
+#include <chrono>
+#include <thread>
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define STAGE_TIMER_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STAGE_TIMER_RDTSC
+#endif
+
+// The length of time used to measure the time stamp counter frequency.
+#define STAGE_TIMER_CALIBRATION_MILLISECONDS 20
+
+#ifdef STAGE_TIMING
+#define STAGE_TIMER_START(name) const unsigned long long name = stage_timer::now()
+#define STAGE_TIMER_STOP(name, statistic) (statistic).add(stage_timer::now() - (name))
+// Use this when one timed block handles many items, so that the number of calls is the number of items.
+#define STAGE_TIMER_STOP_CALLS(name, statistic, num_calls) (statistic).add(stage_timer::now() - (name), num_calls)
+#else
+#define STAGE_TIMER_START(name)
+#define STAGE_TIMER_STOP(name, statistic)
+#define STAGE_TIMER_STOP_CALLS(name, statistic, num_calls)
+#endif
+
+class stage_timer
+{
+public:
+	static unsigned long long now()
+	{
+#ifdef STAGE_TIMER_RDTSC
+		return __rdtsc();
+#else
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	/// <summary>
+	/// Returns the length of one tick.  The time stamp counter frequency is measured the first time this is called.
+	/// </summary>
+	static double get_seconds_per_tick()
+	{
+		static const double seconds_per_tick = calibrate_();
+		return seconds_per_tick;
+	}
+private:
+	static double calibrate_()
+	{
+#ifdef STAGE_TIMER_RDTSC
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		unsigned long long start_ticks = now();
+		std::this_thread::sleep_for(std::chrono::milliseconds(STAGE_TIMER_CALIBRATION_MILLISECONDS));
+		unsigned long long end_ticks = now();
+		std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		if (end_ticks > start_ticks)
+		{
+			return duration.count() / static_cast<double>(end_ticks - start_ticks);
+		}
+#endif
+		return 1e-9;
+	}
+};
+
+// The total number of ticks spent in a stage, and the number of times it was entered.
+struct stage_timer_statistic
+{
+	stage_timer_statistic()
+	{
+		ticks = 0;
+		calls = 0;
+	}
+	void add(unsigned long long elapsed_ticks)
+	{
+		ticks += elapsed_ticks;
+		calls++;
+	}
+	void add(unsigned long long elapsed_ticks, long long num_calls)
+	{
+		ticks += elapsed_ticks;
+		calls += num_calls;
+	}
+	void add(const stage_timer_statistic& other)
+	{
+		ticks += other.ticks;
+		calls += other.calls;
+	}
+	double get_seconds() const
+	{
+		// Don't calibrate the timer for a stage that was never timed.
+		if (ticks == 0)
+		{
+			return 0;
+		}
+		return static_cast<double>(ticks) * stage_timer::get_seconds_per_tick();
+	}
+	unsigned long long ticks;
+	long long calls;
+};
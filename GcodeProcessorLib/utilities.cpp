@@ -21,6 +21,16 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "utilities.h"
+#include <cctype>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
 
 namespace utilities {
 	// Box Drawing Consts
@@ -486,6 +496,110 @@ bool utilities::does_file_exist(const std::string& file_path)
 	return false;
 }
 
+bool utilities::is_directory(const std::string& path)
+{
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	struct stat path_stat;
+	return stat(path.c_str(), &path_stat) == 0 && S_ISDIR(path_stat.st_mode);
+#endif
+}
+
+bool utilities::get_directory_file_names(const std::string& directory_path, std::vector<std::string>& file_names)
+{
+	file_names.clear();
+#ifdef _WIN32
+	WIN32_FIND_DATAA find_data;
+	HANDLE find_handle = FindFirstFileA(join_path(directory_path, "*").c_str(), &find_data);
+	if (find_handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	do
+	{
+		if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+		{
+			file_names.push_back(find_data.cFileName);
+		}
+	} while (FindNextFileA(find_handle, &find_data));
+	FindClose(find_handle);
+#else
+	DIR* p_directory = opendir(directory_path.c_str());
+	if (p_directory == NULL)
+	{
+		return false;
+	}
+	struct dirent* p_entry;
+	while ((p_entry = readdir(p_directory)) != NULL)
+	{
+		std::string file_name = p_entry->d_name;
+		struct stat file_stat;
+		// d_type isn't filled in by every file system, so stat each entry.
+		if (stat(join_path(directory_path, file_name).c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode))
+		{
+			file_names.push_back(file_name);
+		}
+	}
+	closedir(p_directory);
+#endif
+	std::sort(file_names.begin(), file_names.end());
+	return true;
+}
+
+std::string utilities::join_path(const std::string& directory_path, const std::string& file_name)
+{
+	if (directory_path.empty() || directory_path[directory_path.length() - 1] == PATH_SEPARATOR_ || directory_path[directory_path.length() - 1] == '/')
+	{
+		return directory_path + file_name;
+	}
+	return directory_path + PATH_SEPARATOR_ + file_name;
+}
+
+bool utilities::is_wildcard_match(const std::string& text, const std::string& pattern)
+{
+	// Greedy matching that backtracks to the most recent *, which is linear for patterns with a single *.
+	size_t text_index = 0, pattern_index = 0;
+	size_t star_index = std::string::npos, star_text_index = 0;
+	while (text_index < text.length())
+	{
+		if (pattern_index < pattern.length() && pattern[pattern_index] == '*')
+		{
+			star_index = pattern_index++;
+			star_text_index = text_index;
+			continue;
+		}
+		if (pattern_index < pattern.length())
+		{
+			char p = pattern[pattern_index];
+			char t = text[text_index];
+#ifdef _WIN32
+			p = static_cast<char>(std::tolower(static_cast<unsigned char>(p)));
+			t = static_cast<char>(std::tolower(static_cast<unsigned char>(t)));
+#endif
+			if (p == '?' || p == t)
+			{
+				text_index++;
+				pattern_index++;
+				continue;
+			}
+		}
+		if (star_index == std::string::npos)
+		{
+			return false;
+		}
+		// Let the last * absorb one more character and try again.
+		pattern_index = star_index + 1;
+		text_index = ++star_text_index;
+	}
+	while (pattern_index < pattern.length() && pattern[pattern_index] == '*')
+	{
+		pattern_index++;
+	}
+	return pattern_index == pattern.length();
+}
+
 double utilities::hypot(double x, double y)
 {
 	if (x < 0) x = -x;
@@ -679,9 +793,9 @@ void* utilities::memcpy(void* dest, const void* src, size_t n)
 
 std::string utilities::dtos(double x, unsigned char precision)
 {
-	static char buffer[FPCONV_BUFFER_LENGTH];
+	char buffer[FPCONV_BUFFER_LENGTH];
 	char* p = buffer;
-	buffer[fpconv_dtos(x, buffer, precision)] = '\0';
+	append_fixed(p, x, precision);
 	/* This is code that can be used to compare the output of the
 		 modified fpconv_dtos function to the ofstream output
 		 Note:  It currently only fails for some checks where the original double does not store
@@ -695,8 +809,14 @@ std::string utilities::dtos(double x, unsigned char precision)
 		std::cout << std::fixed << "Failed to convert: " << std::setprecision(24) << x << " Precision:" << std::setprecision(0) << static_cast <int> (precision) << " String:" << std::string(buffer) << " Stream:" << stream.str() << std::endl;
 	}
 	*/
-	return buffer;
+	return std::string(buffer, p - buffer);
 }
+
+void utilities::append_fixed(char*& out, double x, unsigned char precision)
+{
+	out += fpconv_dtos(x, out, precision);
+}
+
 /*
 bool case_insensitive_compare_char(char& c1, char& c2)
 {
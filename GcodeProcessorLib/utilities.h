@@ -109,6 +109,16 @@ namespace utilities{
 
 	bool get_temp_file_path_for_file(const std::string& file_path, std::string& temp_file_path);
 
+	bool is_directory(const std::string& path);
+
+	// Gets the names (not the paths) of the regular files in a directory, sorted by name.
+	bool get_directory_file_names(const std::string& directory_path, std::vector<std::string>& file_names);
+
+	std::string join_path(const std::string& directory_path, const std::string& file_name);
+
+	// Matches * (any run of characters) and ? (any single character).  Case is ignored on Windows, like the shell does.
+	bool is_wildcard_match(const std::string& text, const std::string& pattern);
+
 	double hypot(double x, double y);
 	
 	float hypotf(float x, float y);
@@ -181,6 +191,13 @@ namespace utilities{
 	void* memcpy(void* dest, const void* src, size_t n);
 
 	std::string dtos(double x, unsigned char precision);
+
+	/// <summary>
+	/// Writes x with a fixed number of decimals to out and advances out past the written characters.
+	/// No terminator is written, and at least FPCONV_BUFFER_LENGTH characters must be available at out.
+	/// Nothing is allocated and no shared state is used, so this is safe to call from any thread.
+	/// </summary>
+	void append_fixed(char*& out, double x, unsigned char precision);
 	
 	std::string replace(std::string subject, const std::string& search, const std::string& replace);
 
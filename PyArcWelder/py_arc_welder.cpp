@@ -48,7 +48,7 @@ PyObject* py_arc_welder::build_py_progress(const arc_welder_progress& progress,
   if (pyTravelMessage == NULL)
     return NULL;
   double total_travel_count_reduction_percent = progress.travel_statistics.get_total_count_reduction_percent();
-  PyObject* py_progress = Py_BuildValue("{s:d,s:d,s:d,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:f,s:f,s:f,s:f,s:i,s:i,s:f,s:f,s:f,s:i,s:i,s:f}",
+  PyObject* py_progress = Py_BuildValue("{s:d,s:d,s:d,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:f,s:f,s:f,s:f,s:i,s:i,s:f,s:f,s:f,s:i,s:i,s:f,s:i,s:i,s:L,s:d,s:d,s:d,s:d,s:d}",
     "percent_complete",
     progress.percent_complete,												//1
     "seconds_elapsed",
@@ -98,7 +98,23 @@ PyObject* py_arc_welder::build_py_progress(const arc_welder_progress& progress,
     "target_file_total_travel_count",
     progress.travel_statistics.total_count_target,    //24
     "total_travel_count_reduction_percent",
-    total_travel_count_reduction_percent              //25
+    total_travel_count_reduction_percent,             //25
+    "layer",
+    progress.layer,                                   //26
+    "num_layers",
+    progress.num_layers,                              //27
+    "transmitted_bytes",
+    progress.transmitted_bytes,                       //28
+    "transmitted_reduction_percent",
+    progress.transmitted_reduction_percent,           //29
+    "source_max_commands_per_second",
+    progress.command_rate_summary.max_source,         //30
+    "target_max_commands_per_second",
+    progress.command_rate_summary.max_target,         //31
+    "source_p95_commands_per_second",
+    progress.command_rate_summary.get_percentile(95, true),  //32
+    "target_p95_commands_per_second",
+    progress.command_rate_summary.get_percentile(95, false)  //33
 
   );
 
@@ -106,32 +122,104 @@ PyObject* py_arc_welder::build_py_progress(const arc_welder_progress& progress,
   {
     return NULL;
   }
+  PyObject* py_stage_statistics = build_py_stage_statistics(progress.stage_statistics);
+  if (py_stage_statistics == NULL)
+  {
+    Py_DECREF(py_progress);
+    return NULL;
+  }
   // Due to a CRAZY issue, I have to add this item after building the py_progress object,
   // else it crashes in python 2.7.  Looking forward to retiring this backwards 
   // compatible code...
   PyDict_SetItemString(py_progress, "segment_statistics_text", pyMessage);
   PyDict_SetItemString(py_progress, "segment_travel_statistics_text", pyTravelMessage);
   PyDict_SetItemString(py_progress, "guid", pyGuid);
+  PyDict_SetItemString(py_progress, "stage_statistics", py_stage_statistics);
+  Py_DECREF(py_stage_statistics);
   return py_progress;
 }
 
+PyObject* py_arc_welder::build_py_stage_statistics(const arc_welder_stage_statistics& statistics)
+{
+  PyObject* py_stages = PyDict_New();
+  if (py_stages == NULL)
+    return NULL;
+  for (int index = 0; index < NUM_ARC_WELDER_STAGES; index++)
+  {
+    const stage_timer_statistic& stage = statistics.stages[index];
+    PyObject* py_stage = Py_BuildValue("{s:d,s:L}", "seconds", stage.get_seconds(), "calls", stage.calls);
+    if (py_stage == NULL)
+    {
+      Py_DECREF(py_stages);
+      return NULL;
+    }
+    PyDict_SetItemString(py_stages, arc_welder_stage_names[index].c_str(), py_stage);
+    Py_DECREF(py_stage);
+  }
+
+  // A list of (label, count) tuples, in bucket order.
+  PyObject* py_histogram = PyList_New(ARC_FIT_ATTEMPT_BUCKETS);
+  if (py_histogram == NULL)
+  {
+    Py_DECREF(py_stages);
+    return NULL;
+  }
+  for (int index = 0; index < ARC_FIT_ATTEMPT_BUCKETS; index++)
+  {
+    std::string label = arc_welder_stage_statistics::get_arc_fit_attempt_bucket_label(index);
+    PyObject* py_bucket = Py_BuildValue("(s,i)", label.c_str(), statistics.arc_fit_attempt_counts[index]);
+    if (py_bucket == NULL)
+    {
+      Py_DECREF(py_stages);
+      Py_DECREF(py_histogram);
+      return NULL;
+    }
+    // Steals the reference to py_bucket
+    PyList_SetItem(py_histogram, index, py_bucket);
+  }
+
+  PyObject* py_statistics = Py_BuildValue("{s:O,s:O,s:d,s:i,s:L,s:d,s:i,s:O}",
+    "enabled",
+    statistics.enabled ? Py_True : Py_False,
+    "stages",
+    py_stages,
+    "disk_seconds",
+    statistics.disk_seconds,
+    "arcs",
+    statistics.arcs,
+    "arc_fit_attempts",
+    statistics.arc_fit_attempts,
+    "average_arc_fit_attempts",
+    statistics.get_average_arc_fit_attempts(),
+    "max_arc_fit_attempts",
+    statistics.max_arc_fit_attempts,
+    "arc_fit_attempt_histogram",
+    py_histogram
+  );
+  Py_DECREF(py_stages);
+  Py_DECREF(py_histogram);
+  return py_statistics;
+}
+
 bool py_arc_welder::on_progress_(const arc_welder_progress& progress)
 {
+  // This is called while the GIL is released, so it must be held while any python objects are used.
+  PyGILState_STATE gstate = PyGILState_Ensure();
   PyObject* py_dict = py_arc_welder::build_py_progress(progress, guid_, false);
   if (py_dict == NULL)
   {
+    PyGILState_Release(gstate);
     return false;
   }
   PyObject* func_args = Py_BuildValue("(O)", py_dict);
   if (func_args == NULL)
   {
     Py_DECREF(py_dict);
+    PyGILState_Release(gstate);
     return false;	// This was returning true, I think it was a typo.  Making a note just in case.
   }
 
-  PyGILState_STATE gstate = PyGILState_Ensure();
   PyObject* pContinueProcessing = PyObject_CallObject(py_progress_callback_, func_args);
-  PyGILState_Release(gstate);
   Py_DECREF(func_args);
   Py_DECREF(py_dict);
   bool continue_processing;
@@ -152,6 +240,7 @@ bool py_arc_welder::on_progress_(const arc_welder_progress& progress)
     }
     Py_DECREF(pContinueProcessing);
   }
+  PyGILState_Release(gstate);
 
   return continue_processing;
 }
@@ -417,6 +506,195 @@ bool py_gcode_arc_args::parse_args(PyObject* py_args, py_logger* p_py_logger, py
     args.allow_travel_arcs = PyLong_AsLong(py_allow_travel_arcs) > 0;
   }
 #pragma endregion allow_travel_arcs
+#pragma region exact_arc_fitting
+  // extract exact_arc_fitting
+  PyObject* py_exact_arc_fitting = PyDict_GetItemString(py_args, "exact_arc_fitting");
+  if (py_exact_arc_fitting == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'exact_arc_fitting' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.exact_arc_fitting = PyLong_AsLong(py_exact_arc_fitting) > 0;
+  }
+#pragma endregion exact_arc_fitting
+#pragma region threads
+  // Extract threads
+  PyObject* py_threads = PyDict_GetItemString(py_args, "threads");
+  if (py_threads == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'threads' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.threads = (int)gcode_arc_converter::PyIntOrLong_AsLong(py_threads);
+    if (args.threads < 1)
+    {
+      args.threads = DEFAULT_THREADS;
+    }
+  }
+#pragma endregion threads
+#pragma region pipeline
+  // Extract pipeline
+  PyObject* py_pipeline = PyDict_GetItemString(py_args, "pipeline");
+  if (py_pipeline == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'pipeline' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.pipeline = PyLong_AsLong(py_pipeline) > 0;
+  }
+#pragma endregion pipeline
+#pragma region cache_directory
+  // Extract cache_directory
+  PyObject* py_cache_directory = PyDict_GetItemString(py_args, "cache_directory");
+  if (py_cache_directory == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'cache_directory' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.cache_directory = gcode_arc_converter::PyUnicode_SafeAsString(py_cache_directory);
+  }
+#pragma endregion cache_directory
+#pragma region cache_max_megabytes
+  // Extract cache_max_megabytes
+  PyObject* py_cache_max_megabytes = PyDict_GetItemString(py_args, "cache_max_megabytes");
+  if (py_cache_max_megabytes == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'cache_max_megabytes' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.cache_max_megabytes = gcode_arc_converter::PyIntOrLong_AsLong(py_cache_max_megabytes);
+    if (args.cache_max_megabytes < 1)
+    {
+      args.cache_max_megabytes = DEFAULT_CACHE_MAX_MEGABYTES;
+    }
+  }
+#pragma endregion cache_max_megabytes
+#pragma region index_path
+  // Extract index_path
+  PyObject* py_index_path = PyDict_GetItemString(py_args, "index_path");
+  if (py_index_path == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'index_path' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.index_path = gcode_arc_converter::PyUnicode_SafeAsString(py_index_path);
+  }
+#pragma endregion index_path
+#pragma region meatpack_mode
+  // Extract meatpack_mode
+  PyObject* py_meatpack_mode = PyDict_GetItemString(py_args, "meatpack_mode");
+  if (py_meatpack_mode == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'meatpack_mode' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    std::string meatpack_mode = gcode_arc_converter::PyUnicode_SafeAsString(py_meatpack_mode);
+    for (int index = 0; index < NUM_MEATPACK_MODES; index++)
+    {
+      if (meatpack_mode == meatpack_mode_names[index])
+      {
+        args.meatpack_mode = static_cast<arc_welder_meatpack_mode>(index);
+      }
+    }
+  }
+#pragma endregion meatpack_mode
+#pragma region target_commands_per_second
+  // Extract target_commands_per_second
+  PyObject* py_target_commands_per_second = PyDict_GetItemString(py_args, "target_commands_per_second");
+  if (py_target_commands_per_second == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'target_commands_per_second' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.target_commands_per_second = gcode_arc_converter::PyFloatOrInt_AsDouble(py_target_commands_per_second);
+    if (args.target_commands_per_second < 0)
+    {
+      args.target_commands_per_second = DEFAULT_TARGET_COMMANDS_PER_SECOND;
+    }
+  }
+#pragma endregion target_commands_per_second
+#pragma region max_resolution_mm
+  // Extract max_resolution_mm
+  PyObject* py_max_resolution_mm = PyDict_GetItemString(py_args, "max_resolution_mm");
+  if (py_max_resolution_mm == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'max_resolution_mm' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else
+  {
+    args.max_resolution_mm = gcode_arc_converter::PyFloatOrInt_AsDouble(py_max_resolution_mm);
+  }
+  // The max resolution can never be tighter than the resolution.
+  if (args.max_resolution_mm < args.resolution_mm)
+  {
+    args.max_resolution_mm = args.resolution_mm;
+  }
+#pragma endregion max_resolution_mm
+#pragma region feature_policies
+  // Extract feature_policies, a list of strings like "outer_perimeter:resolution_mm=0.02"
+  PyObject* py_feature_policies = PyDict_GetItemString(py_args, "feature_policies");
+  if (py_feature_policies == NULL)
+  {
+    // The parameter is optional, so the default is used without a warning.
+    std::string message = "ParseArgs - The 'feature_policies' parameter was not supplied, using the default.";
+    p_py_logger->log(GCODE_CONVERSION, DEBUG, message);
+  }
+  else if (!PySequence_Check(py_feature_policies))
+  {
+    std::string message = "ParseArgs - The 'feature_policies' parameter must be a list of strings.";
+    p_py_logger->log(GCODE_CONVERSION, WARNING, message);
+  }
+  else
+  {
+    Py_ssize_t num_policies = PySequence_Size(py_feature_policies);
+    for (Py_ssize_t index = 0; index < num_policies; index++)
+    {
+      PyObject* py_feature_policy = PySequence_GetItem(py_feature_policies, index);
+      if (py_feature_policy == NULL)
+      {
+        continue;
+      }
+      arc_welder_feature_policy policy;
+      std::string error;
+      if (arc_welder_feature_policy::try_parse(gcode_arc_converter::PyUnicode_SafeAsString(py_feature_policy), policy, error))
+      {
+        args.feature_policies.push_back(policy);
+      }
+      else
+      {
+        std::string message = "ParseArgs - Skipping an invalid feature policy: " + error;
+        p_py_logger->log(GCODE_CONVERSION, WARNING, message);
+      }
+      Py_DECREF(py_feature_policy);
+    }
+  }
+#pragma endregion feature_policies
 #pragma region g90_g91_influences_extruder
   // Extract G90/G91 influences extruder
   // g90_influences_extruder
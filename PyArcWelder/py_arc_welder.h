@@ -62,6 +62,11 @@ public:
 		
 	}
 	static PyObject* build_py_progress(const arc_welder_progress& progress, std::string guid, bool include_detailed_statistics);
+	/// <summary>
+	/// Returns a dict with the stage timings and the number of try_create_arc calls per arc.  Only enabled when STAGE_TIMING
+	/// is defined.
+	/// </summary>
+	static PyObject* build_py_stage_statistics(const arc_welder_stage_statistics& statistics);
 protected:
 	std::string guid_;
 	virtual bool on_progress_(const arc_welder_progress& progress);
@@ -201,7 +201,11 @@ extern "C"
 		args.box_encoding = utilities::box_drawing::HTML;
 		py_arc_welder arc_welder_obj(args);
 		arc_welder_results results;
+		// Release the GIL so that other python threads can run during the conversion.  The progress callback and the
+		// logger reacquire it whenever they call into python.
+		Py_BEGIN_ALLOW_THREADS
 		results = arc_welder_obj.process();
+		Py_END_ALLOW_THREADS
 		
 		message = "py_gcode_arc_converter.ConvertFile - Arc Conversion Complete.";
 		p_py_logger->log(GCODE_CONVERSION, log_levels::INFO, message);
@@ -213,11 +217,13 @@ extern "C"
 			p_progress = Py_None;
 
 		PyObject* p_results = Py_BuildValue(
-			"{s:i,s:i,s:s,s:O}",
+			"{s:i,s:i,s:i,s:s,s:O}",
 			"success",
 			(long int)(results.success ? 1 : 0),
 			"is_cancelled",
 			(long int)(results.cancelled ? 1 : 0),
+			"from_cache",
+			(long int)(results.from_cache ? 1 : 0),
 			"message",
 			results.message.c_str(),
 			"progress",
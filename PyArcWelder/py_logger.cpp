@@ -142,10 +142,14 @@ void py_logger::log(const int logger_type, const int log_level, const std::strin
 		current_log_level = gcode_conversion_log_level;
 		break;
 	default:
+	{
 		std::cout << "Logging.arc_welder_log - unknown logger_type.\r\n";
+		PyGILState_STATE state = PyGILState_Ensure();
 		PyErr_SetString(PyExc_ValueError, "Logging.arc_welder_log - unknown logger_type.");
+		PyGILState_Release(state);
 		return;
 	}
+	}
 
 	if (!check_log_levels_real_time)
 	{
@@ -157,6 +161,9 @@ void py_logger::log(const int logger_type, const int log_level, const std::strin
 		}
 	}
 
+	// Files are processed while the GIL is released, so acquire it before using any python objects.
+	PyGILState_STATE state = PyGILState_Ensure();
+
 	PyObject* pyFunctionName = NULL;
 
 	PyObject* error_type = NULL;
@@ -200,6 +207,7 @@ void py_logger::log(const int logger_type, const int log_level, const std::strin
 			std::cout << "An unknown log level of '" << log_level << " 'was supplied for the message: " << message.c_str() << "\r\n";
 			PyErr_Format(PyExc_ValueError,
 				"An unknown log level was supplied for the message %s.", message.c_str());
+			PyGILState_Release(state);
 			return;
 		}
 	}
@@ -211,13 +219,12 @@ void py_logger::log(const int logger_type, const int log_level, const std::strin
 		std::cout << "Unable to convert the log message '" << message.c_str() << "' to a PyString/Unicode message.\r\n";
 		PyErr_Format(PyExc_ValueError,
 			"Unable to convert the log message '%s' to a PyString/Unicode message.", message.c_str());
+		PyGILState_Release(state);
 		return;
 	}
-	PyGILState_STATE state = PyGILState_Ensure();
 	PyObject* ret_val = PyObject_CallMethodObjArgs(py_logger, pyFunctionName, pyMessage, NULL);
 	// We need to decref our message so that the GC can remove it.  Maybe?
 	Py_DECREF(pyMessage);
-	PyGILState_Release(state);
 	if (ret_val == NULL)
 	{
 		if (!PyErr_Occurred())
@@ -249,4 +256,5 @@ void py_logger::log(const int logger_type, const int log_level, const std::strin
 		}
 	}
 	Py_XDECREF(ret_val);
+	PyGILState_Release(state);
 }
@@ -0,0 +1,182 @@
+# Tests for the PyArcWelder extension.
+#
+# Usage: python test_py_arc_welder.py <directory containing PyArcWelder>
+#
+# The extension logs through the octoprint_arc_welder.log module, which is part of the OctoPrint plugin.  A minimal
+# stand-in is written to a temporary directory so that the extension can be imported without the plugin.
+import logging
+import math
+import os
+import shutil
+import sys
+import tempfile
+import threading
+import time
+import unittest
+
+LOG_MODULE_SOURCE = """
+import logging
+
+
+class LoggingConfigurator(object):
+    def __init__(self, root_logger_name, log_entry_prefix, log_file_prefix):
+        self.root_logger_name = root_logger_name
+
+    def get_logger(self, name):
+        return logging.getLogger(name)
+"""
+
+# The number of G1 moves in the generated file.  Enough that the conversion takes a noticeable fraction of a second.
+CONVERSION_TEST_MOVES = 300000
+# The counter thread sleeps between increments, so it needs the GIL back this often.
+COUNTER_SLEEP_SECONDS = 0.001
+# When the GIL is held for the whole conversion the counter can only advance while a progress callback runs, which
+# happens twice a second.  Require far more increments than that.
+MIN_COUNTER_INCREMENTS_PER_SECOND = 50
+
+
+def write_log_module(directory):
+    package_directory = os.path.join(directory, "octoprint_arc_welder")
+    os.mkdir(package_directory)
+    with open(os.path.join(package_directory, "__init__.py"), "w") as init_file:
+        init_file.write("")
+    with open(os.path.join(package_directory, "log.py"), "w") as log_file:
+        log_file.write(LOG_MODULE_SOURCE)
+
+
+def write_circles(path, moves):
+    # Concentric circles made of short segments, which are welded into arcs.
+    segments_per_circle = 100
+    with open(path, "w") as gcode_file:
+        gcode_file.write("G21\nG90\nM83\nG1 Z0.2 F1200\n")
+        for move in range(moves):
+            circle = move // segments_per_circle
+            radius = 5.0 + (circle % 50) * 0.4
+            angle = 2.0 * math.pi * (move % segments_per_circle) / segments_per_circle
+            e = 2.0 * math.pi * radius / segments_per_circle * 0.05
+            gcode_file.write(
+                "G1 X{0:.3f} Y{1:.3f} E{2:.5f}\n".format(100.0 + radius * math.cos(angle), 100.0 + radius * math.sin(angle), e)
+            )
+
+
+def get_baseline_convert_file_args(source_path, target_path, on_progress_received):
+    # The arguments that released versions of the plugin supply.  Every argument added since then is optional.
+    return {
+        "guid": "test_py_arc_welder",
+        "source_path": source_path,
+        "target_path": target_path,
+        "on_progress_received": on_progress_received,
+        "resolution_mm": 0.05,
+        "allow_dynamic_precision": False,
+        "default_xyz_precision": 3,
+        "default_e_precision": 5,
+        "extrusion_rate_variance_percent": 0.05,
+        "path_tolerance_percent": 0.05,
+        "max_radius_mm": 9999,
+        "mm_per_arc_segment": 0,
+        "min_arc_segments": 0,
+        "max_gcode_length": 0,
+        "allow_3d_arcs": False,
+        "allow_travel_arcs": False,
+        "g90_g91_influences_extruder": False,
+        "log_level": logging.ERROR,
+    }
+
+
+def get_convert_file_args(source_path, target_path, on_progress_received):
+    # Every argument, including the optional ones.
+    args = get_baseline_convert_file_args(source_path, target_path, on_progress_received)
+    args.update({
+        "exact_arc_fitting": False,
+        "threads": 1,
+        "pipeline": False,
+        "cache_directory": "",
+        "cache_max_megabytes": 0,
+        "index_path": "",
+        "meatpack_mode": "NONE",
+        "target_commands_per_second": 0,
+        "max_resolution_mm": 0.05,
+        "feature_policies": [],
+    })
+    return args
+
+
+class ConvertFileTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.directory = tempfile.mkdtemp()
+        write_log_module(cls.directory)
+        sys.path.insert(0, cls.directory)
+        logging.basicConfig(level=logging.ERROR)
+        import PyArcWelder
+        cls.converter = PyArcWelder
+        cls.source_path = os.path.join(cls.directory, "source.gcode")
+        cls.target_path = os.path.join(cls.directory, "target.gcode")
+        write_circles(cls.source_path, CONVERSION_TEST_MOVES)
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.directory, ignore_errors=True)
+
+    def test_other_threads_run_during_conversion(self):
+        # ConvertFile releases the GIL while welding, so a python thread keeps running during the conversion.
+        state = {"counter": 0, "running": True, "progress_callbacks": 0}
+
+        def count():
+            while state["running"]:
+                state["counter"] += 1
+                time.sleep(COUNTER_SLEEP_SECONDS)
+
+        def on_progress_received(progress):
+            state["progress_callbacks"] += 1
+            return True
+
+        counter_thread = threading.Thread(target=count)
+        counter_thread.start()
+        try:
+            args = get_convert_file_args(self.source_path, self.target_path, on_progress_received)
+            start_time = time.time()
+            start_counter = state["counter"]
+            results = self.converter.ConvertFile(args)
+            end_counter = state["counter"]
+            seconds = time.time() - start_time
+        finally:
+            state["running"] = False
+            counter_thread.join()
+
+        self.assertTrue(results["success"], results["message"])
+        self.assertGreater(results["progress"]["arcs_created"], 0)
+        increments = end_counter - start_counter
+        self.assertGreaterEqual(
+            increments,
+            max(10, int(seconds * MIN_COUNTER_INCREMENTS_PER_SECOND)),
+            "The counter thread only advanced {0} times during a {1:.2f} second conversion with {2} progress callbacks."
+            .format(increments, seconds, state["progress_callbacks"])
+        )
+
+    def test_optional_args_may_be_omitted(self):
+        # Omitting the optional arguments must not leave a python exception pending.  A pending exception either makes
+        # ConvertFile raise a SystemError, or is printed through sys.excepthook by the next log call.
+        def on_progress_received(progress):
+            return True
+
+        reported_exceptions = []
+        original_excepthook = sys.excepthook
+        sys.excepthook = lambda exception_type, exception, traceback: reported_exceptions.append(repr(exception))
+        try:
+            args = get_baseline_convert_file_args(self.source_path, self.target_path, on_progress_received)
+            results = self.converter.ConvertFile(args)
+        finally:
+            sys.excepthook = original_excepthook
+
+        self.assertEqual([], reported_exceptions)
+        self.assertTrue(results["success"], results["message"])
+        self.assertGreater(results["progress"]["arcs_created"], 0)
+        with open(self.source_path) as source_file, open(self.target_path) as target_file:
+            self.assertLess(len(target_file.read()), len(source_file.read()))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) > 1:
+        sys.path.insert(0, sys.argv.pop(1))
+    unittest.main()